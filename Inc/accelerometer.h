@@ -2,6 +2,7 @@
  * accelerometer.h
  *
  * Interface for accelerometer processing module.
+ * The filter, gravity and magnitude types come from the step core (step_core.h).
  *
  * Created on: May 8, 2025
  * Author: eaz11 & gjo77
@@ -11,22 +12,44 @@
 #define ACCELEROMETER_H_
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "app.h"
+#include "step_core.h"
 
-#define BUFFER_SIZE 20
+#define ACCEL_MAX_SAMPLE_RATE_HZ  60   // Highest sampling task rate any profile uses
 
-// Holds a circular buffer of recent values for averaging
+// Output data rate codes for CTRL1_XL[7:4]
+#define ACCEL_ODR_12HZ5   0x10
+#define ACCEL_ODR_26HZ    0x20
+#define ACCEL_ODR_52HZ    0x30
+#define ACCEL_ODR_104HZ   0x40
+#define ACCEL_ODR_416HZ   0x60
+
+// Optional oversampling front-end: read the FIFO at ACCEL_CIC_ODR_HZ and CIC-decimate
+// to the profile's sampling rate. Needs the IMU on hi2c1 for burst reads.
+#ifndef ACCEL_CIC_FRONTEND
+#define ACCEL_CIC_FRONTEND  0
+#endif
+#define ACCEL_CIC_ODR_HZ    416
+
+// Slowest ODR that still delivers a fresh sample to every task run at SAMPLE_HZ
+#define ACCEL_ODR_FOR_HZ(SAMPLE_HZ) \
+    ((SAMPLE_HZ) <= 12 ? ACCEL_ODR_12HZ5 : (SAMPLE_HZ) <= 26 ? ACCEL_ODR_26HZ : \
+     (SAMPLE_HZ) <= 52 ? ACCEL_ODR_52HZ : ACCEL_ODR_104HZ)
+
+// CIC front-end counters (cycles are SysTick cycles spent in the three decimators)
 typedef struct {
-    int16_t buffer[BUFFER_SIZE];
-    uint8_t index;
-} AveragingFilter;
+    uint8_t ratio;
+    uint32_t inputs;
+    uint32_t outputs;
+    uint32_t cycles;
+} CicStats;
 
-// Holds filtered acceleration values and their squared magnitude
+// Filter and gravity tracker state (retained across warm resets)
 typedef struct {
-    int16_t acc_x_filtered;
-    int16_t acc_y_filtered;
-    int16_t acc_z_filtered;
-    uint64_t magnitude_square;
-} FilteredAcceleration;
+    TriAxisFilter filter;
+    int32_t gravity[3];
+} AccelerometerState;
 
 // Initializes accelerometer and filtering
 void accelerometer_init(void);
@@ -37,14 +60,48 @@ FilteredAcceleration accelerometer_execute(void);
 // Returns the most recent filtered result
 FilteredAcceleration accelerometer_get_latest(void);
 
-// Initializes an averaging filter
-void filter_init(AveragingFilter *filter);
+// Returns the timebase time (µs) of the sample behind the latest filtered result
+uint64_t accelerometer_get_sample_time_us(void);
+
+// Returns true once the filtered output has settled after start-up
+bool accelerometer_is_ready(void);
+
+// Returns how many samples start-up took to reach ready (0 if not ready or restored)
+uint8_t accelerometer_get_warmup_samples(void);
+
+// Returns the pipeline instance; step_detection.c runs its detector stage
+StepCore* accelerometer_get_core(void);
+
+// Applies a performance profile's ODR and power mode, and derives the filter length,
+// settle count and gravity time constant for the sampling rate. The filtered output
+// is carried over unchanged so the step detector sees no transient.
+void accelerometer_set_profile(uint8_t odr, bool high_performance, uint16_t sample_hz);
+
+// Enables/disables the MCU sampling pipeline; re-enabling reseeds the filters
+void accelerometer_set_processing(bool enable);
+
+// Returns false while the MCU pipeline is idle
+bool accelerometer_is_processing(void);
+
+// Enables/disables the IMU's embedded step counter (keeps ODR at or above 26 Hz while on).
+// WHO_AM_I picks the enable bits: LSM6DS3 (0x69) or LSM6DSL (0x6A). Returns false, writing
+// nothing, if WHO_AM_I cannot be read or names neither part
+bool accelerometer_pedometer_enable(bool enable);
+
+// Returns the IMU's WHO_AM_I as read when the pedometer was first switched (0 = not read yet)
+uint8_t accelerometer_get_imu_id(void);
+
+// Returns the CIC front-end counters (all zero unless ACCEL_CIC_FRONTEND is set)
+CicStats accelerometer_get_cic_stats(void);
+
+// Reads the embedded step counter (free-running, wraps at 65536)
+uint16_t accelerometer_pedometer_read(void);
 
-// Adds a new value to the filter and returns the average
-int16_t filter_apply(AveragingFilter *filter, int16_t new_value);
+// Copies the current filter state (used by warm restart)
+void accelerometer_save_state(AccelerometerState *state);
 
-// Computes squared magnitude of a 3D vector
-uint64_t magnitude_squared(int16_t x, int16_t y, int16_t z);
+// Restores filter state and recomputes the latest filtered result from it
+void accelerometer_restore_state(const AccelerometerState *state);
 
 // Reads a 16-bit signed axis value from register pair
 int16_t get_acceleration_axis(uint8_t low_reg, uint8_t high_reg);
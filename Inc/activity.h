@@ -0,0 +1,57 @@
+/*
+ * activity.h
+ *
+ * Motion gating for the acquisition pipeline. A cheap threshold on the dynamic
+ * (gravity-removed) magnitude decides whether the wearer is moving; while
+ * stationary the accelerometer runs at a reduced rate and filtering, step
+ * detection and display refresh are suspended.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef ACTIVITY_H_
+#define ACTIVITY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ACTIVITY_STILL_THRESHOLD      300  // Dynamic raw units below which a sample counts as still
+#define ACTIVITY_WAKE_THRESHOLD       600  // Dynamic raw units above which motion is declared
+#define ACTIVITY_STILL_TIME_MS      10000  // Continuous stillness before dropping to low rate
+#define ACTIVITY_STATIONARY_SAMPLE_HZ  12  // Sampling rate kept while stationary (slots are decimated to it)
+
+typedef enum {
+    ACTIVITY_ACTIVE = 0,
+    ACTIVITY_STATIONARY,
+    NUM_ACTIVITY_STATES
+} activity_state_t;
+
+// Resets to the active state and clears the time accounting
+void activity_init(void);
+
+// Sets the accelerometer task rate the stationary decimation is derived from
+void activity_set_sample_rate(uint16_t sample_hz);
+
+// Feeds one processed sample's dynamic magnitude (squared); returns true if the state changed
+bool activity_update(uint64_t dynamic_square);
+
+// The per-sample check activity_update() makes in the active state, without its state or timers
+bool activity_sample_is_still(uint64_t dynamic_square);
+
+// Returns the current activity state
+activity_state_t activity_get_state(void);
+
+// Returns true while stationary (pipeline suspended)
+bool activity_is_stationary(void);
+
+// Called once per accelerometer slot; returns true if this slot should take a sample
+bool activity_sample_due(void);
+
+// Returns total time spent in a state since init (ms)
+uint32_t activity_get_time_ms(activity_state_t state);
+
+// Returns number of accelerometer slots skipped while stationary
+uint32_t activity_get_skipped_samples(void);
+
+#endif /* ACTIVITY_H_ */
@@ -0,0 +1,81 @@
+/*
+ * adaptive_threshold.h
+ *
+ * Step detection bands that follow the wearer's own signal. The detector
+ * sees the highest and lowest filtered vertical acceleration since its last
+ * evaluation; an envelope follows the highs and another the lows (a quick
+ * attack, a slower release, shifts only), and the upper (count) and lower
+ * (re-arm) bands sit at half of each envelope either side of zero, never
+ * inside the noise floor. A calibration run releases faster for
+ * ADAPT_CALIBRATE_MS while walking; the caller saves the envelopes as the
+ * starting point for later boots. All state lives in an AdaptiveTracker owned
+ * by the caller (no HAL, no statics).
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef ADAPTIVE_THRESHOLD_H_
+#define ADAPTIVE_THRESHOLD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ADAPT_TIME_CONSTANT_MS             2000  // Envelope release while tracking: a walker who eases off is followed within a few steps
+#define ADAPT_CALIBRATE_TIME_CONSTANT_MS    750  // Calibration: ~13 time constants fit in the run
+#define ADAPT_CALIBRATE_MS                10000  // Length of a calibration run
+#define ADAPT_CALIBRATE_MIN_SAMPLES          20  // Moving evaluations needed for a run to be saved
+#define ADAPT_ATTACK_SHIFT                    1  // An envelope climbs half way to a higher extreme at once
+
+#define ADAPT_BAND_GAIN_Q4                    8  // Bands at half of each envelope
+#define ADAPT_MIN_BAND                      200  // Neither band comes closer to zero than a still wearer's filtered noise
+#define ADAPT_MAX_BAND                     4000  // Caps the bands after a burst of knocks
+#define ADAPT_QUIET_LEVEL                   200  // Quiet evaluations long after the last step count as a pause...
+#define ADAPT_PAUSE_MS                     2000  // ...and are kept out of the envelopes
+
+// Tracker state; one per detector instance (Q8 envelopes, bands in raw units)
+typedef struct {
+    int32_t peak_q8;           // Envelope of the highs
+    int32_t trough_q8;         // Envelope of the lows, as a depth below zero
+    uint16_t upper;            // A step counts above +upper...
+    uint16_t lower;            // ...and the detector re-arms below -lower
+    uint8_t track_shift;
+    uint8_t calibrate_shift;
+    bool calibrating;
+    bool calibrated;
+    uint32_t calibrate_start_ms;
+    uint16_t calibrate_samples;
+    uint32_t updates;
+    uint32_t frozen;
+} AdaptiveTracker;
+
+// Snapshot of the tracker (raw vertical units unless noted)
+typedef struct {
+    uint16_t peak;
+    uint16_t trough;
+    uint16_t upper;
+    uint16_t lower;
+    uint32_t updates;          // Evaluations folded into the envelopes
+    uint32_t frozen;           // Evaluations skipped during pauses
+    bool calibrating;
+    bool calibrated;           // Seeded from (or produced) a saved calibration
+} AdaptiveStats;
+
+// Derives the release shifts for the detector evaluation rate; the envelopes are kept
+void adaptive_configure(AdaptiveTracker *tracker, uint16_t step_hz);
+
+// Restarts the envelopes from a saved calibration (peak/trough, 0 = none), otherwise with
+// both bands on the noise floor
+void adaptive_reset(AdaptiveTracker *tracker, uint16_t calibrated_peak, uint16_t calibrated_trough);
+
+// Folds one evaluation's extremes in; 'frozen' (a pause between walks) skips the update.
+// Returns true once when a calibration run finishes with enough movement to be saved
+bool adaptive_update(AdaptiveTracker *tracker, int16_t high, int16_t low, bool frozen, uint32_t now_ms);
+
+// Starts a calibration run; the wearer should walk normally until it ends
+void adaptive_calibrate_start(AdaptiveTracker *tracker, uint32_t now_ms);
+
+// Returns a snapshot of the tracker
+AdaptiveStats adaptive_get_stats(const AdaptiveTracker *tracker);
+
+#endif /* ADAPTIVE_THRESHOLD_H_ */
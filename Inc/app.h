@@ -11,11 +11,14 @@
 #define APP_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #define TICK_FREQUENCY_HZ 1000
 #define HZ_TO_TICKS(FREQ_HZ) (TICK_FREQUENCY_HZ / (FREQ_HZ))
+#define MS_TO_TICKS(MS)      ((MS) * TICK_FREQUENCY_HZ / 1000)
 
-// Task frequencies (Hz)
+// Task frequencies (Hz); display, step and accelerometer rates are start-up defaults
+// that the active performance profile (profile.c) replaces at runtime
 #define TASK_BUTTON_FREQUENCY_HZ       50
 #define TASK_DISPLAY_FREQUENCY_HZ       4
 #define TASK_JOYSTICK_FREQUENCY_HZ      4
@@ -23,7 +26,7 @@
 #define TASK_STEP_FREQUENCY_HZ          6
 #define TASK_TEST_FREQUENCY_HZ          4
 #define TASK_BUZZER_FREQUENCY_HZ       50
-#define TASK_ACCELEROMETER_FREQUENCY_HZ 60  // Should equal STEP_FREQUENCY * BUFFER_SIZE
+#define TASK_ACCELEROMETER_FREQUENCY_HZ 60
 #define TASK_LED_FREQUENCY_HZ           4
 
 // Task periods (ticks)
@@ -37,7 +40,17 @@
 #define TASK_ACCELEROMETER_PERIOD_TICKS HZ_TO_TICKS(TASK_ACCELEROMETER_FREQUENCY_HZ)
 #define TASK_LED_PERIOD_TICKS           HZ_TO_TICKS(TASK_LED_FREQUENCY_HZ)
 
-// Entry point for app
+// Initialises every module and starts the task schedules from the current tick
+void app_init(void);
+
+// Runs one scheduler pass (every task whose time has come); returns true if any task ran
+bool app_step(void);
+
+// Returns the earliest tick at which app_step() will run a task or fire a software timer.
+// Nothing changes before then except button sampling, so a driver with its own clock can skip straight to it
+uint32_t app_next_deadline(void);
+
+// Entry point for app: app_init() followed by app_step() forever, sleeping between ticks when idle
 void app_main(void);
 
 #endif /* APP_H_ */
@@ -0,0 +1,59 @@
+/*
+ * bench.h
+ *
+ * On-target microbenchmarks for the firmware's hot kernels. Each kernel runs
+ * over a fixed synthetic input set on private state (its own StepCore, so the
+ * live pipeline is untouched) and is timed with the SysTick cycle stamp. A
+ * check of the batch filter against the scalar one runs first, one window length
+ * per call, then one kernel per call, so a full pass is spread over several
+ * serial task runs.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BENCH_SAMPLES          256  // Samples per kernel run (inputs cycle through BENCH_INPUT_SAMPLES)
+#define BENCH_INPUT_SAMPLES     64  // Synthetic accelerometer samples generated at start
+#define BENCH_BUS_SAMPLES       16  // The axis read goes over I2C, so it runs fewer samples
+#define BENCH_FORMAT_SAMPLES    32  // Each format sample is the four main-screen lines (snprintf)
+
+typedef enum {
+    BENCH_FILTER_APPLY = 0,     // One averaging filter update (one axis)
+    BENCH_FILTER_BATCH,         // One tri-axis filter update (all three axes), run as a batch
+    BENCH_MAGNITUDE,            // Squared magnitude of a vector
+    BENCH_AXIS_READ,            // get_acceleration_axis(): two I2C byte reads plus decode
+    BENCH_PIPELINE,             // Gravity tracking + filters + magnitudes for one sample
+    BENCH_DETECT_FIXED,         // Fixed-threshold hysteresis check
+    BENCH_DETECT_ADAPTIVE,      // Adaptive bands (envelopes of the vertical extremes) and hysteresis
+    BENCH_JOYSTICK,             // X, Y and potentiometer percentage math
+    BENCH_FORMAT,               // display_format_*(): the main screen's four lines
+    NUM_BENCH_KERNELS
+} bench_kernel_t;
+
+// One kernel's result; cycles are net of the timer's own overhead
+typedef struct {
+    const char *name;
+    uint32_t samples;
+    uint32_t cycles;
+} BenchResult;
+
+// Generates the inputs, measures the timer overhead and queues the filter check and every kernel
+void bench_start(void);
+
+// Returns true while check passes or kernels are still queued
+bool bench_is_running(void);
+
+// Runs the next queued step: one window length of the tri-axis filter check (returns false,
+// result untouched) or one kernel (returns true with its result). Returns false once all have run
+bool bench_run_next(BenchResult *result);
+
+// Outputs compared by the tri-axis filter check so far, and how many differed from the scalar filter
+uint32_t bench_filter_check(uint32_t *mismatches);
+
+#endif /* BENCH_H_ */
@@ -13,11 +13,12 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "soft_timer.h"
 
 #define DOUBLE_PRESS_THRESHOLD_MS 500
 
 typedef struct {
-    uint32_t lastPressTime;
+    SoftTimer window;       // Runs for DOUBLE_PRESS_THRESHOLD_MS after each press
     uint8_t pressCount;
 } DoublePressTracker;
 
@@ -3,6 +3,7 @@
  *
  * Interface for buzzer control module:
  * - Plays melody when step goal is reached
+ * - Interrupt-driven melody sequencer on TIM16 with volume control
  * - Provides manual PWM control if needed
  *
  * Created on: Apr 4, 2025
@@ -15,9 +16,40 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-// Call from main loop to run buzzer state machine
+typedef enum {
+    BUZZER_MELODY_GOAL = 0,     // Step goal reached
+    BUZZER_MELODY_CONFIRM,      // New goal saved
+    NUM_BUZZER_MELODIES
+} buzzer_melody_t;
+
+typedef enum {
+    BUZZER_VOLUME_LOW = 0,
+    BUZZER_VOLUME_MEDIUM,
+    BUZZER_VOLUME_HIGH,
+    NUM_BUZZER_VOLUMES
+} buzzer_volume_t;
+
+// Configures TIM16's prescaler and register buffering; call once at start-up
+void buzzer_init(void);
+
+// Call from main loop; starts the goal melody when the goal is first reached
 void buzzer_execute(void);
 
+// Plays a melody in the background (TIM16 interrupt), replacing any in progress
+void buzzer_play(buzzer_melody_t melody);
+
+// Returns true while a melody is playing
+bool buzzer_is_playing(void);
+
+// Sets the duty cycle used for subsequent notes and saves it in the flash log settings
+void buzzer_set_volume(buzzer_volume_t level);
+
+// Returns the current volume
+buzzer_volume_t buzzer_get_volume(void);
+
+// Applies the volume saved in the flash log; call after flash_log_init()
+void buzzer_restore_volume(void);
+
 // Manual control (optional external use)
 void buzzer_start(void);
 void buzzer_stop(void);
@@ -0,0 +1,51 @@
+/*
+ * cadence.h
+ *
+ * Streaming cadence (steps per minute) estimate from a bank of fixed-point
+ * Goertzel filters spanning 0.8–3.5 Hz, fed with the vertical dynamic
+ * acceleration of each sample before the averaging window (whose null near
+ * 3 Hz would flatten fast cadences) and read out once per window.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef CADENCE_H_
+#define CADENCE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CADENCE_MIN_CHZ       80    // Lowest bin (0.80 Hz = 48 steps/min)
+#define CADENCE_MAX_CHZ      350    // Highest bin (3.50 Hz = 210 steps/min)
+#define CADENCE_STEP_CHZ      10    // Bin spacing (0.10 Hz)
+#define CADENCE_BINS         (((CADENCE_MAX_CHZ - CADENCE_MIN_CHZ) / CADENCE_STEP_CHZ) + 1)
+#define CADENCE_WINDOW_MS   4000    // Readout window (0.25 Hz resolution)
+
+// Optional: use the cadence to reject threshold detections that arrive far too early
+#ifndef CADENCE_GATE_STEPS
+#define CADENCE_GATE_STEPS     0
+#endif
+
+// Per-sample cost counters (SysTick cycles spent in cadence_push)
+typedef struct {
+    uint32_t samples;
+    uint32_t cycles;
+} CadenceStats;
+
+// Sets the input sample rate (centi-Hz) and recomputes the bin coefficients; restarts the window
+void cadence_configure(uint32_t sample_rate_chz);
+
+// Discards the current window and clears the estimate (e.g. when sampling pauses)
+void cadence_reset(void);
+
+// Feeds one vertical dynamic acceleration sample (raw units)
+void cadence_push(int16_t vertical);
+
+// Returns the latest cadence in steps per minute (0 if no clear rhythm in the last window)
+uint16_t cadence_get_spm(void);
+
+// Returns the per-sample cost counters
+CadenceStats cadence_get_stats(void);
+
+#endif /* CADENCE_H_ */
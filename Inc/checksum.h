@@ -0,0 +1,19 @@
+/*
+ * checksum.h
+ *
+ * CRC helper shared by modules that persist or retain state across resets.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef CHECKSUM_H_
+#define CHECKSUM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Computes CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over a buffer
+uint16_t crc16_ccitt(const void *data, size_t length);
+
+#endif /* CHECKSUM_H_ */
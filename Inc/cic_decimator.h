@@ -0,0 +1,37 @@
+/*
+ * cic_decimator.h
+ *
+ * Integer cascaded integrator-comb (CIC) decimator for one axis.
+ * Each input costs CIC_ORDER additions; the combs and gain correction run once
+ * per output. State is in wrap-around 32-bit arithmetic, which is exact as long
+ * as 16 + CIC_ORDER * log2(ratio) <= 32 (ratio <= CIC_MAX_RATIO).
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef CIC_DECIMATOR_H_
+#define CIC_DECIMATOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CIC_ORDER       3
+#define CIC_MAX_RATIO  32
+
+typedef struct {
+    uint32_t integrator[CIC_ORDER];
+    uint32_t comb_delay[CIC_ORDER];
+    uint32_t gain_reciprocal;     // 2^32 / ratio^CIC_ORDER (rounded)
+    uint8_t ratio;
+    uint8_t phase;                // Inputs since the last output
+    uint8_t warmup;               // Outputs still to discard while the pipeline fills
+} CicDecimator;
+
+// Resets the decimator for a decimation ratio (clamped to 1..CIC_MAX_RATIO)
+void cic_init(CicDecimator *cic, uint8_t ratio);
+
+// Pushes one input sample; returns true and writes *out on every ratio-th input
+bool cic_push(CicDecimator *cic, int16_t in, int16_t *out);
+
+#endif /* CIC_DECIMATOR_H_ */
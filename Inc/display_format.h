@@ -0,0 +1,37 @@
+/*
+ * display_format.h
+ *
+ * Text of the main screen's lines from plain values: step count, distance,
+ * goal progress and cadence. HAL-free, so the host bench times the same code
+ * the display task draws with; display_task.c feeds it the live state.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef DISPLAY_FORMAT_H_
+#define DISPLAY_FORMAT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// value * 100 / goal, truncated (0 for a zero goal, UINT32_MAX if it would not fit)
+uint32_t format_percent(uint32_t value, uint16_t goal);
+
+// "1234 steps", or the share of the goal ("56%") in percentage mode
+void format_steps(char *buf, size_t size, uint32_t steps, uint16_t goal, bool percent);
+
+// "1.234 km"
+void format_distance_km(char *buf, size_t size, uint32_t km, uint16_t metres);
+
+// "1350 yd"
+void format_distance_yards(char *buf, size_t size, uint32_t yards);
+
+// "1234/10000", or the share of the goal ("56%") in percentage mode
+void format_progress(char *buf, size_t size, uint32_t steps, uint16_t goal, bool percent);
+
+// "112 steps/min", or dashes while no cadence is known (spm = 0)
+void format_cadence(char *buf, size_t size, uint16_t spm);
+
+#endif /* DISPLAY_FORMAT_H_ */
@@ -11,6 +11,8 @@
 #ifndef DISPLAY_TASK_H_
 #define DISPLAY_TASK_H_
 
+#include <stddef.h>
+
 // Initializes the OLED display (called once at startup)
 void display_task_init(void);
 
@@ -20,4 +22,11 @@ void display_task_execute(void);
 // Toggles between display unit modes (counts/km/steps-per-goal vs. %/yards/%)
 void display_toggle(void);
 
+// Format the main screen's lines from the live state in the current unit mode
+// (also timed by the bench's format kernel)
+void display_format_steps(char *buf, size_t size);
+void display_format_distance(char *buf, size_t size);
+void display_format_progress(char *buf, size_t size);
+void display_format_cadence(char *buf, size_t size);
+
 #endif /* DISPLAY_TASK_H_ */
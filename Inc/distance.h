@@ -0,0 +1,49 @@
+/*
+ * distance.h
+ *
+ * Integer distance engine: keeps a 32-bit millimetre accumulator fed by the
+ * step counter and converts it to metres, kilometres, yards and miles using
+ * precomputed reciprocal multipliers (no division, no floating point).
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef DISTANCE_H_
+#define DISTANCE_H_
+
+#include <stdint.h>
+
+// Stride length limits (mm per step)
+#define DEFAULT_STRIDE_MM  900
+#define MIN_STRIDE_MM      300
+#define MAX_STRIDE_MM     1500
+
+// Sets stride length (clamped to MIN/MAX) and recomputes distance for the given step count
+void distance_set_stride_mm(uint16_t stride_mm, uint32_t steps);
+
+// Returns current stride length in mm
+uint16_t distance_get_stride_mm(void);
+
+// Adds distance for newly counted steps (saturates at UINT32_MAX mm)
+void distance_add_steps(uint32_t steps);
+
+// Recomputes distance from an absolute step count (used when steps are overridden)
+void distance_set_steps(uint32_t steps);
+
+// Returns distance travelled in millimetres
+uint32_t distance_get_mm(void);
+
+// Returns distance travelled in whole metres
+uint32_t distance_get_metres(void);
+
+// Returns distance travelled in whole yards
+uint32_t distance_get_yards(void);
+
+// Splits distance into whole kilometres and remaining metres (0–999)
+void distance_get_km(uint32_t *km, uint16_t *metres);
+
+// Splits distance into whole miles and thousandths of a mile (0–999)
+void distance_get_miles(uint32_t *miles, uint16_t *thousandths);
+
+#endif /* DISTANCE_H_ */
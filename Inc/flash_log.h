@@ -0,0 +1,77 @@
+/*
+ * flash_log.h
+ *
+ * Append-only, wear-levelled log of device state in internal flash.
+ * Persists step count, goal, runtime settings and the completed 15-minute
+ * blocks of step history across power cycles.
+ *
+ * The log occupies the last FLASH_LOG_PAGES pages of the 128 KB STM32C071 flash;
+ * that range must be excluded from the FLASH region in the linker script.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef FLASH_LOG_H_
+#define FLASH_LOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "step_history.h"
+
+#define FLASH_LOG_PAGES              8
+#define FLASH_LOG_FIRST_PAGE        56      // Pages 56–63 (0x0801C000–0x0801FFFF)
+#define FLASH_LOG_RECORD_SIZE       32
+#define FLASH_LOG_SAVE_INTERVAL_MS  60000   // Minimum spacing of step-only updates
+#define FLASH_LOG_SETTINGS_COUNT    16
+#define FLASH_LOG_PROGRAM_ATTEMPTS   3      // Slots a record may use up before it is given up
+
+// Record types (FlashLogRecord.type); state records from before history was logged read as STATE
+#define FLASH_LOG_TYPE_STATE        0xFFFF
+#define FLASH_LOG_TYPE_HISTORY      0x4842
+
+// Indices into FlashLogRecord.settings
+#define FLASH_LOG_SETTING_STEP_SOURCE     0   // step_source_t
+#define FLASH_LOG_SETTING_PROFILE         1   // profile_id_t
+#define FLASH_LOG_SETTING_DETECTOR        2   // step_detector_t
+#define FLASH_LOG_SETTING_ADAPT_PEAK      3   // Calibrated peak envelope, units of 16 raw (0 = not calibrated)
+#define FLASH_LOG_SETTING_ADAPT_TROUGH    4   // Calibrated trough envelope, units of 16 raw
+#define FLASH_LOG_SETTING_BUZZER_VOLUME   5   // Steps below BUZZER_VOLUME_HIGH (0 = high)
+
+// One fixed-size state record (four flash double-words; CRC written last)
+typedef struct {
+    uint32_t sequence;                            // Monotonic record number
+    uint32_t steps;
+    uint16_t goal;
+    uint16_t stride_mm;
+    uint8_t settings[FLASH_LOG_SETTINGS_COUNT];   // Runtime tunables (0 = default)
+    uint16_t type;                                // FLASH_LOG_TYPE_STATE
+    uint16_t crc;                                 // CRC-16 over all preceding bytes
+} FlashLogRecord;
+
+// A completed block of step history, in the same slot layout
+typedef struct {
+    uint32_t sequence;
+    uint32_t first_minute;                        // History minute of bins[0]
+    uint8_t bins[HISTORY_BLOCK_MINUTES];
+    uint8_t unused[5];
+    uint16_t type;                                // FLASH_LOG_TYPE_HISTORY
+    uint16_t crc;
+} FlashLogHistoryRecord;
+
+// Locates the newest valid state record and restores steps, goal and stride from it, then
+// restores the newest saved history blocks (call after step_history_init())
+void flash_log_init(void);
+
+// Runs one bounded unit of flash work (one erase or one double-word program).
+// A program stalls the CPU for ~85 us; an erase for ~22 ms, so erases only run
+// when 'erase_allowed' (pass true only while samples are slow or not needed)
+void flash_log_execute(bool erase_allowed);
+
+// Returns a stored runtime setting (0 if never saved)
+uint8_t flash_log_get_setting(uint8_t index);
+
+// Updates a runtime setting; it is written with the next record
+void flash_log_set_setting(uint8_t index, uint8_t value);
+
+#endif /* FLASH_LOG_H_ */
@@ -14,14 +14,15 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-#define COOLDOWN_TICKS 2 // Joystick input cooldown to prevent rapid flipping
+#define COOLDOWN_MS 500 // Joystick input cooldown to prevent rapid flipping (independent of task rate)
 
 // Display states (cyclical)
 typedef enum {
     DISPLAY_STEPS = 0,
     DISPLAY_GOAL_PROGRESS,
     DISPLAY_DISTANCE,
-    NUM_DISPLAY_STATES  // Not a real state; used to wrap around
+    NUM_DISPLAY_STATES, // Not a real state; used to wrap around
+    DISPLAY_DIAGNOSTICS = NUM_DISPLAY_STATES  // Hidden: outside the left/right cycle
 } display_state_t;
 
 // Initializes the FSM to a default state
@@ -33,4 +34,10 @@ void fsm_update(uint16_t adc_x, bool test_mode);
 // Returns the current screen state
 display_state_t fsm_get_current_state(void);
 
+// Sets the current screen state (used when resuming after a warm reset)
+void fsm_set_state(display_state_t state);
+
+// Enters the hidden diagnostics screen, or returns from it to the steps screen
+void fsm_toggle_diagnostics(void);
+
 #endif /* FSM_H_ */
@@ -0,0 +1,101 @@
+/*
+ * gait_gen.h
+ *
+ * Synthetic gait generator for load-testing the acquisition and detection
+ * pipeline. While running, the accelerometer module takes its samples from
+ * here instead of the IMU and runs them through a private StepCore, so the
+ * live step count, cadence and activity state never see them. Samples model
+ * a walking wearer: gravity along a chosen "up" axis, a vertical bounce at
+ * the step cadence (with a heel-strike harmonic) and uniform noise on every
+ * axis.
+ *
+ * Samples become due in real time at the injection rate and queue in an
+ * emulated sensor FIFO; any that overflow it before the pipeline drains them
+ * are dropped. The ramp raises the rate step by step until a step drops
+ * samples, which gives the highest rate the pipeline sustains alongside the
+ * rest of the scheduler, and the cost of each pipeline stage.
+ *
+ * The generator itself uses no HAL calls; only its timing comes from the
+ * timebase, so it builds for the host (host/test/test_gait_gen.c).
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef GAIT_GEN_H_
+#define GAIT_GEN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GAIT_RAW_PER_G          16384   // ±2 g full scale: 2^15 LSB per 2 g (0.061 mg/LSB)
+#define GAIT_FIFO_SAMPLES       682     // LSM6DS 4 KB FIFO holding accelerometer words only
+#define GAIT_RAMP_START_HZ      50
+#define GAIT_RAMP_MAX_HZ        20000
+#define GAIT_RAMP_STEP_MS       1000    // Time spent at each rate
+#define GAIT_RAMP_MAX_STEPS     32      // Rate rises by 5/4 per step: 50 Hz reaches the maximum in 27
+
+typedef enum {
+    GAIT_ORIENT_FLAT = 0,   // Face up: gravity on Z
+    GAIT_ORIENT_UPRIGHT,    // Worn vertically: gravity on Y
+    GAIT_ORIENT_TILTED,     // 45° between Y and Z
+    GAIT_ORIENT_SIDE,       // On its side: gravity on X
+    NUM_GAIT_ORIENTATIONS
+} gait_orientation_t;
+
+typedef enum {
+    GAIT_STAGE_GENERATE = 0,
+    GAIT_STAGE_GRAVITY,
+    GAIT_STAGE_FILTER,
+    GAIT_STAGE_ACTIVITY,
+    NUM_GAIT_STAGES
+} gait_stage_t;
+
+typedef struct {
+    uint16_t cadence_spm;           // Steps per minute
+    uint16_t amplitude_mg;          // Peak vertical acceleration of the bounce
+    uint16_t noise_mg;              // Peak noise added to each axis
+    gait_orientation_t orientation;
+} GaitParams;
+
+typedef struct {
+    uint32_t rate_hz;
+    uint32_t samples;                           // Samples the pipeline processed
+    uint32_t dropped;                           // Samples lost to FIFO overflow
+    uint32_t stage_cycles[NUM_GAIT_STAGES];     // Mean cycles per sample in each stage
+} GaitStepResult;
+
+// Brisk walking, worn upright
+GaitParams gait_gen_default_params(void);
+
+// Ramps the injection rate from GAIT_RAMP_START_HZ until samples drop (or GAIT_RAMP_MAX_HZ),
+// then stops by itself
+void gait_gen_start_ramp(const GaitParams *params);
+
+// Stops injecting; the IMU takes over again
+void gait_gen_stop(void);
+
+bool gait_gen_is_running(void);
+
+// Number of samples to process now; overflowed samples are counted as dropped and skipped
+uint16_t gait_gen_due(void);
+
+// Produces the next sample
+void gait_gen_sample(int16_t *ax, int16_t *ay, int16_t *az);
+
+// Adds one processed sample's stage costs
+void gait_gen_account(const uint32_t stage_cycles[NUM_GAIT_STAGES]);
+
+// Copies the next completed ramp step not yet returned; false when there is none
+bool gait_gen_next_result(GaitStepResult *result);
+
+// Returns true once per ramp: after it has finished and all its steps have been returned
+bool gait_gen_take_ramp_end(void);
+
+// Highest ramp rate with no drops (0 if even the first step dropped)
+uint32_t gait_gen_max_rate_hz(void);
+
+// Short stage name for telemetry
+const char* gait_gen_stage_name(gait_stage_t stage);
+
+#endif /* GAIT_GEN_H_ */
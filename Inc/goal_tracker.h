@@ -27,6 +27,9 @@ void shortpress_toggle(void);
 // Gets the current goal value
 uint16_t get_goal(void);
 
+// Sets the goal directly (clamped to MIN/MAX_GOAL_VALUE), e.g. when restoring saved state
+void set_goal(uint16_t new_goal);
+
 // Gets percentage progress toward goal
 uint8_t get_goal_progress_percentage(void);
 
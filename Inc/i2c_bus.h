@@ -0,0 +1,83 @@
+/*
+ * i2c_bus.h
+ *
+ * Shared I2C1 transaction layer. Every transaction gets a time budget derived
+ * from its length and the bus clock, a bounded number of attempts, and bus
+ * recovery (SCL clocking plus a peripheral reset) when the bus hangs. A device
+ * that still fails is backed off for a while: calls return I2C_BUS_SKIPPED at
+ * once, so callers skip a sample instead of stalling the scheduler.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef I2C_BUS_H_
+#define I2C_BUS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Build with I2C_BUS_FAULT_INJECTION=1 to compile in the fault hooks (the simulator does)
+#ifndef I2C_BUS_FAULT_INJECTION
+#define I2C_BUS_FAULT_INJECTION  0
+#endif
+
+#define I2C_BUS_CLOCK_HZ         400000u  // SCL rate configured for hi2c1 (Fast mode); sets the time budgets
+#define I2C_BUS_MAX_ATTEMPTS     2        // First try plus one retry (after recovery if the bus hung)
+#define I2C_BUS_BACKOFF_MS       100      // Calls to a failed device are skipped for this long
+
+#ifndef LSM6DS_I2C_ADDRESS
+#define LSM6DS_I2C_ADDRESS       (0x6A << 1)  // SA0 low; use (0x6B << 1) when SA0 is high
+#endif
+#define SSD1306_I2C_ADDRESS      (0x3C << 1)
+
+typedef enum {
+    I2C_DEVICE_IMU = 0,
+    I2C_DEVICE_DISPLAY,
+    NUM_I2C_DEVICES
+} i2c_device_t;
+
+typedef enum {
+    I2C_BUS_OK = 0,
+    I2C_BUS_ERROR,      // Failed on every attempt; the device is now backed off
+    I2C_BUS_SKIPPED     // Not attempted: the device is backed off after a recent failure
+} i2c_bus_status_t;
+
+typedef enum {
+    I2C_FAULT_NACK = 0, // The attempt fails at once, as if the device did not answer
+    I2C_FAULT_STALL,    // The bus goes busy as the attempt starts: the HAL's 25 ms busy wait, then a timeout error
+    NUM_I2C_FAULTS
+} i2c_fault_t;
+
+typedef struct {
+    uint32_t transactions;  // Calls that reached the bus
+    uint32_t errors;        // Transactions that failed on every attempt
+    uint32_t retries;
+    uint32_t timeouts;      // Attempts that found the bus hung (busy, or timed out), each followed by a recovery
+    uint32_t skipped;       // Calls refused while backed off
+    uint32_t worst_us;      // Longest transaction, retries and recovery included
+} I2cDeviceStats;
+
+// Clears counters and back-off; call after the HAL has initialised hi2c1
+void i2c_bus_init(void);
+
+// Reads 'length' bytes from consecutive registers starting at 'reg'
+i2c_bus_status_t i2c_bus_read(i2c_device_t device, uint8_t reg, uint8_t *data, uint16_t length);
+
+// Writes 'length' bytes to consecutive registers starting at 'reg'
+i2c_bus_status_t i2c_bus_write(i2c_device_t device, uint8_t reg, const uint8_t *data, uint16_t length);
+
+// Checks that a device acknowledges its address
+i2c_bus_status_t i2c_bus_probe(i2c_device_t device);
+
+// Per-device counters, and the number of bus recoveries run
+I2cDeviceStats i2c_bus_get_stats(i2c_device_t device);
+uint32_t i2c_bus_recoveries(void);
+
+// Short device name for telemetry
+const char* i2c_bus_device_name(i2c_device_t device);
+
+// Makes the device's next 'attempts' attempts fail with the given fault (no-op without I2C_BUS_FAULT_INJECTION)
+void i2c_bus_inject_fault(i2c_device_t device, i2c_fault_t fault, uint8_t attempts);
+
+#endif /* I2C_BUS_H_ */
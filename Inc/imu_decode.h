@@ -0,0 +1,25 @@
+/*
+ * imu_decode.h
+ *
+ * Turns the IMU's little-endian output words into signed samples. HAL-free,
+ * so the host bench times the same decode the accelerometer module runs on
+ * every direct read and FIFO burst.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef IMU_DECODE_H_
+#define IMU_DECODE_H_
+
+#include <stdint.h>
+
+#define IMU_SAMPLE_BYTES  6    // X, Y and Z words, low byte first
+
+// Reads one little-endian 16-bit word
+int16_t imu_decode_word(const uint8_t *bytes);
+
+// Reads the X, Y and Z words of one IMU_SAMPLE_BYTES sample
+void imu_decode_sample(const uint8_t *bytes, int16_t *x, int16_t *y, int16_t *z);
+
+#endif /* IMU_DECODE_H_ */
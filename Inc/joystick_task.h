@@ -23,7 +23,8 @@
 // Initializes ADC peripheral for joystick input
 void joystick_init(void);
 
-// Starts DMA sampling and handles click detection (long vs short press)
+// Starts DMA sampling, handles click detection (long vs short press) and runs the screen FSM,
+// unit toggle and goal setting
 void joystick_task_execute(void);
 
 // Returns latest raw ADC readings [Pot, Y, X]
@@ -3,7 +3,8 @@
  *
  * Controls LEDs to visually represent goal progress.
  * One LED turns on for every 25% of goal completion.
- * When below 25%, DS3 uses PWM to show partial completion.
+ * DS3 plays a DMA-driven PWM animation: breathing below 25% (peak brightness
+ * shows partial completion), a fill sweep from 25%, and blinking at 100%.
  *
  * Created on: May 20, 2025
  * Author: eaz11 & gjo77
@@ -15,7 +16,7 @@
 // Initializes LED PWM and state
 void LED_init(void);
 
-// Updates LED state based on current goal progress
+// Updates LED state based on current goal progress; writes the hardware only when it changes
 void LED_execute(void);
 
 #endif /* LED_H_ */
@@ -0,0 +1,62 @@
+/*
+ * monitor.h
+ *
+ * Runtime headroom monitor. Measures scheduler busy time against wall time
+ * over one-second windows (overall and per task), and tracks the stack's
+ * high-water mark by painting the unused RAM between the end of .bss and the
+ * stack pointer at boot, then looking for the lowest word that changed.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef MONITOR_H_
+#define MONITOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MONITOR_WINDOW_MS         1000        // Load is measured over windows of this length
+#define MONITOR_STACK_PAINT       0xC5C5C5C5u // Fill pattern for untouched stack
+#define MONITOR_PAINT_MARGIN_WORDS  16        // Words left unpainted below the stack pointer at boot
+
+// Scheduler tasks, in app.c order (matches TRACE_TASK_*)
+typedef enum {
+    MONITOR_TASK_BUTTON = 0,
+    MONITOR_TASK_DISPLAY,
+    MONITOR_TASK_JOYSTICK,
+    MONITOR_TASK_SERIAL,
+    MONITOR_TASK_STEP,
+    MONITOR_TASK_TEST,
+    MONITOR_TASK_BUZZER,
+    MONITOR_TASK_ACCELEROMETER,
+    MONITOR_TASK_LED,
+    NUM_MONITOR_TASKS
+} monitor_task_t;
+
+typedef struct {
+    uint16_t load_permille;                         // Busy share of the last full window
+    uint16_t peak_load_permille;                    // Highest window load since boot
+    uint16_t task_permille[NUM_MONITOR_TASKS];      // Each task's share of the last window
+    uint32_t stack_size;                            // Bytes between the end of .bss and the top of RAM
+    uint32_t stack_used;                            // High-water mark (bytes below the top of RAM)
+    uint32_t windows;                               // Completed windows (changes once per window)
+} MonitorStats;
+
+// Paints the free stack; call at start-up from a shallow stack, after warm_restart_init()
+void monitor_init(void);
+
+// Marks the start of a task run ('late_us' goes to the trace, saturated to 16 bits) and the end of it
+void monitor_task_begin(monitor_task_t task, uint32_t late_us);
+void monitor_task_end(monitor_task_t task);
+
+// Adds a scheduler pass that started at 'start' if it ran a task, and closes the window when due
+void monitor_pass_end(uint32_t start, bool ran);
+
+// Returns the figures from the last completed window
+MonitorStats monitor_get_stats(void);
+
+// Short task name for the diagnostics screen and telemetry
+const char* monitor_task_name(monitor_task_t task);
+
+#endif /* MONITOR_H_ */
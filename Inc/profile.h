@@ -0,0 +1,79 @@
+/*
+ * profile.h
+ *
+ * Named performance profiles. Each profile sets the sensor ODR and power mode,
+ * the averaging filter length, the step detector threshold and the periods of
+ * the sampling, step and display tasks together.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PROFILE_BANNER_MS   2000   // How long the display shows the new profile name
+
+// Estimated supply currents (µA, datasheet typicals) used for the per-profile estimate
+#define PROFILE_MCU_RUN_UA   3800  // STM32C071 running from flash at 48 MHz
+#define PROFILE_MCU_IDLE_UA  1200  // Sleep mode (WFI) between ticks, peripherals clocked
+
+typedef enum {
+    PROFILE_HIGH_ACCURACY = 0,
+    PROFILE_BALANCED,
+    PROFILE_LOW_POWER,
+    NUM_PROFILES
+} profile_id_t;
+
+// Rates are given in Hz; ODR and task periods are derived from them at compile time,
+// and time-based filter/detector parameters are converted to samples when applied
+typedef struct {
+    const char *name;
+    uint16_t sample_hz;                   // Accelerometer sampling task rate
+    uint16_t step_hz;                     // Step detector task rate
+    uint8_t odr;                          // CTRL1_XL ODR bits while active (derived from sample_hz)
+    bool xl_high_performance;             // False selects the sensor's low-power/normal mode
+    uint16_t imu_current_ua;              // Estimated accelerometer current at this ODR/mode
+    uint16_t step_threshold;              // Dynamic magnitude threshold (raw units)
+    uint16_t accelerometer_period_ticks;
+    uint16_t step_period_ticks;
+    uint16_t display_period_ticks;
+} PerformanceProfile;
+
+// Applies the profile saved in the flash log (call after flash_log_init)
+void profile_init(void);
+
+// Requests a profile switch; it takes effect at the next profile_apply_pending()
+void profile_request(profile_id_t id);
+
+// Requests the next/previous profile (wraps)
+void profile_request_next(void);
+void profile_request_previous(void);
+
+// Applies a pending switch; call between samples. Returns true if the task periods changed.
+bool profile_apply_pending(void);
+
+// Applies a profile immediately (used when restoring state after a reset)
+void profile_restore(profile_id_t id);
+
+// Returns the active profile and its id
+const PerformanceProfile* profile_get(void);
+profile_id_t profile_get_id(void);
+const PerformanceProfile* profile_get_by_id(profile_id_t id);
+
+// Returns true for PROFILE_BANNER_MS after a switch
+bool profile_banner_visible(void);
+
+// Adds a scheduler pass that ran at least one task and started at 'start' (timebase_cycles())
+void profile_account_busy(uint32_t start);
+
+// Returns the measured CPU load (permille) while the given profile was active (0 if never used)
+uint16_t profile_load_permille(profile_id_t id);
+
+// Returns the estimated MCU + accelerometer current for a profile at its measured load
+uint32_t profile_estimated_current_ua(profile_id_t id);
+
+#endif /* PROFILE_H_ */
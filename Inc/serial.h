@@ -2,7 +2,7 @@
  * serial.h
  *
  * Provides UART-based debug output for joystick and acceleration data.
- * Can be toggled on/off at runtime.
+ * Can be toggled on/off at runtime. Also handles single-character UART commands.
  *
  * Created on: Mar 19, 2025
  * Author: eaz11 & gjo77
@@ -17,7 +17,7 @@
 // Toggles serial debug output on/off
 void serial_toggle(void);
 
-// If enabled, sends joystick and acceleration data via UART
+// Handles pending UART commands; if enabled, sends joystick and acceleration data via UART
 void serial_task_execute(void);
 
 #endif /* SERIAL_H_ */
@@ -0,0 +1,53 @@
+/*
+ * soft_timer.h
+ *
+ * Millisecond software timers on a hierarchical timer wheel. Timers are
+ * caller-owned structs; starting, restarting and cancelling are O(1), and
+ * each tick costs one slot lookup plus the timers that expire in it.
+ * Callbacks run from soft_timer_process() in the scheduler loop, never from
+ * an interrupt, so they may call any module.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SOFT_TIMER_H_
+#define SOFT_TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SOFT_TIMER_SLOT_BITS   6
+#define SOFT_TIMER_SLOTS       (1u << SOFT_TIMER_SLOT_BITS)   // Slots per wheel level
+#define SOFT_TIMER_LEVELS      3                              // 1 ms, 64 ms and 4.096 s slots
+#define SOFT_TIMER_MAX_DELAY_MS ((1u << (SOFT_TIMER_SLOT_BITS * SOFT_TIMER_LEVELS)) - 1)  // ~262 s; longer delays are clamped
+
+typedef void (*soft_timer_callback_t)(void);
+
+typedef struct SoftTimer {
+    struct SoftTimer *next;
+    struct SoftTimer **link;        // Points at whatever points at this timer; NULL when stopped
+    uint32_t expires;               // Tick at which the timer fires
+    uint32_t period;                // Re-arm interval for periodic timers (0 = one-shot)
+    soft_timer_callback_t callback; // May be NULL for timers that are only polled with soft_timer_is_active
+} SoftTimer;
+
+// Empties the wheel and starts it at the current tick
+void soft_timer_init(void);
+
+// (Re)starts a timer to fire delay_ms from now, then every period_ms if non-zero
+void soft_timer_start(SoftTimer *timer, uint32_t delay_ms, uint32_t period_ms, soft_timer_callback_t callback);
+
+// Stops a timer; harmless if it is not running
+void soft_timer_cancel(SoftTimer *timer);
+
+// Returns true while a timer is waiting to fire
+bool soft_timer_is_active(const SoftTimer *timer);
+
+// Fires every timer due up to and including 'now' (call from the scheduler loop)
+void soft_timer_process(uint32_t now);
+
+// Writes the earliest tick at which a timer may fire; returns false when none are running
+bool soft_timer_next_expiry(uint32_t *tick);
+
+#endif /* SOFT_TIMER_H_ */
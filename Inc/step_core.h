@@ -0,0 +1,204 @@
+/*
+ * step_core.h
+ *
+ * HAL-free step detection pipeline: per-axis averaging filters, the gravity
+ * tracker with its orientation offsets, the filtered and gravity-removed
+ * magnitudes, and the fixed/adaptive threshold detector. Every piece of state
+ * lives in a caller-owned StepCore, so several instances can run side by side
+ * (firmware, benchmarks, offline replays). Depends only on adaptive_threshold.c
+ * and the C standard headers.
+ *
+ * The firmware drives the stages separately (accelerometer.c filters at the
+ * sampling rate, step_detection.c detects at the step task rate);
+ * step_core_process() runs the whole chain over a batch of samples.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef STEP_CORE_H_
+#define STEP_CORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "adaptive_threshold.h"
+
+// Samples at RATE_HZ spanning MS milliseconds (rounded, never less than one).
+// Constant arguments fold at compile time; runtime arguments cost one division.
+#define STEP_CORE_MS_TO_SAMPLES(MS, RATE_HZ) \
+    ((((uint32_t)(MS) * (RATE_HZ) + 500) / 1000) > 0 ? (((uint32_t)(MS) * (RATE_HZ) + 500) / 1000) : 1)
+
+#define STEP_CORE_MAX_FILTER_LENGTH  20    // Averaging window slots (333 ms at 60 Hz)
+#define STEP_CORE_FILTER_WINDOW_MS  333    // Averaging window in time (first null near 3 Hz)
+#define STEP_CORE_MAX_SAMPLE_HZ      60    // Fastest sampling rate whose window fits the slots
+
+#define STEP_DYNAMIC_THRESHOLD     1080    // Raw units of dynamic acceleration (1 g = 16384); matches the
+                                           // gap between 1 g and the original 305M squared-magnitude bound
+#define STEP_REARM_MS               150    // Magnitude must stay back inside the threshold this long to re-arm
+#define STEP_REFRACTORY_MS          300    // Minimum time between counted steps (caps cadence at 200/min)
+
+// Holds a circular buffer of recent values for averaging
+typedef struct {
+    int16_t buffer[STEP_CORE_MAX_FILTER_LENGTH];
+    uint8_t index;
+    bool seeded;    // False until the first real sample has filled the buffer
+} AveragingFilter;
+
+// Averaging filters for x, y and z sharing one window. The histories are interleaved, so a
+// sample touches one row, and each axis keeps a running sum: an update swaps the leaving
+// value for the new one and divides by a reciprocal multiply instead of re-summing the window
+typedef struct {
+    int16_t history[STEP_CORE_MAX_FILTER_LENGTH][3];
+    int32_t sum[3];
+    uint32_t reciprocal;    // ceil(2^24 / length)
+    uint8_t length;
+    uint8_t index;
+    bool seeded;            // False until the first real sample has filled the window
+} TriAxisFilter;
+
+// Holds filtered acceleration values and their squared magnitude
+typedef struct {
+    int16_t acc_x_filtered;
+    int16_t acc_y_filtered;
+    int16_t acc_z_filtered;
+    uint64_t magnitude_square;
+    uint64_t dynamic_magnitude_square;  // |filtered - gravity estimate|^2 (orientation-independent)
+    int16_t vertical_dynamic;           // Dynamic component along gravity (raw units at 1 g = 16384), filtered
+} FilteredAcceleration;
+
+// One raw accelerometer sample for the batch API
+typedef struct {
+    uint32_t t_ms;
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} StepCoreSample;
+
+// One detected step from the batch API
+typedef struct {
+    uint32_t t_ms;
+    uint16_t sample;    // Index of the sample in the batch
+} StepCoreEvent;
+
+// Complete pipeline state
+typedef struct {
+    // Averaging filters
+    TriAxisFilter filter;
+
+    // Gravity tracker and the orientation offsets it selects
+    int32_t gravity_acc[3];             // Gravity estimate scaled by 2^gravity_shift
+    int16_t gravity_at_eval[3];         // Estimate when offsets were last chosen
+    int16_t offset[3];
+    uint16_t samples_since_eval;
+    uint16_t reeval_samples;
+    uint8_t gravity_shift;
+
+    // Latest output and start-up settling
+    FilteredAcceleration latest;
+    bool ready;
+    uint8_t settle_samples;
+    uint8_t warmup_samples;
+    uint8_t stable_samples;
+
+    // Detector
+    bool adaptive;
+    bool step_detected;
+    bool calibration_done;              // Set when an adaptive calibration run finished; see step_core_take_calibration
+    uint8_t below_count;                // Consecutive evaluations inside the threshold
+    uint8_t rearm_samples;
+    uint16_t threshold;
+    uint64_t threshold_square;
+    uint32_t refractory_ms;
+    uint32_t last_step_ms;
+    int16_t vertical_high;              // Extremes of the filtered vertical_dynamic since the last evaluation
+    int16_t vertical_low;               // (the adaptive detector's input; high < low when there were none)
+    bool vertical_fell_last;            // The low came after the high
+    AdaptiveTracker tracker;
+
+    // Batch API: the detector runs on every detect_every-th sample (the firmware's step/sampling rate ratio)
+    uint8_t detect_every;
+    uint8_t detect_phase;
+} StepCore;
+
+// Adds a new value to an averaging filter of 'length' slots and returns the average.
+// This is the scalar reference that the tri-axis filter matches bit for bit
+int16_t step_core_filter_apply(AveragingFilter *filter, uint8_t length, int16_t new_value);
+
+// Empties a tri-axis filter and sets its window (1 to STEP_CORE_MAX_FILTER_LENGTH slots)
+void step_core_tri_filter_init(TriAxisFilter *filter, uint8_t length);
+
+// Pushes n interleaved x/y/z samples through the filter and writes each average to out (which
+// may be in). The output equals three step_core_filter_apply() filters fed the same axes
+void step_core_tri_filter_batch(TriAxisFilter *filter, const int16_t (*in)[3], int16_t (*out)[3], uint16_t n);
+
+// Computes squared magnitude of a 3D vector
+uint64_t step_core_magnitude_squared(int16_t x, int16_t y, int16_t z);
+
+// Resets every stage; defaults match a 60 Hz sampling rate and a 6 Hz fixed-threshold detector
+void step_core_init(StepCore *core);
+
+// Derives the filter length, settle count and gravity time constant for a sampling rate.
+// A seeded filter is refilled with its current average, so the output carries over unchanged.
+// Returns false, changing nothing, if the window would not fit (above STEP_CORE_MAX_SAMPLE_HZ)
+bool step_core_configure_sampling(StepCore *core, uint16_t sample_hz);
+
+// Rounded log2 of a sample count, for exponential averages whose time constant is n samples
+uint8_t step_core_shift_for_samples(uint32_t n);
+
+// Sets the fixed threshold (raw units) and the re-arm/adaptive time constants for the rate
+// the detector is evaluated at; hysteresis state is kept
+void step_core_configure_detector(StepCore *core, uint16_t detect_hz, uint16_t threshold);
+
+// Selects fixed or adaptive bands; adaptive restarts from a saved calibration (0 = none) or the noise floor
+void step_core_set_adaptive(StepCore *core, bool adaptive, uint16_t calibrated_peak, uint16_t calibrated_trough);
+
+// Overrides the minimum spacing between counted steps
+void step_core_set_refractory(StepCore *core, uint32_t refractory_ms);
+
+// Makes step_core_process() run the detector on every n-th sample only (1 = every sample)
+void step_core_set_detect_decimation(StepCore *core, uint8_t every);
+
+// Forces the hysteresis state (true = inside a detected step)
+void step_core_set_step_detected(StepCore *core, bool detected);
+
+// Unseeds the filters; the next sample reseeds them and the gravity estimate
+void step_core_reset_filters(StepCore *core);
+
+// Returns true once the filters hold real data
+bool step_core_is_seeded(const StepCore *core);
+
+// Returns true once the filtered output has settled after seeding (the detector waits for this)
+bool step_core_is_ready(const StepCore *core);
+
+// Seeds or updates the gravity estimate (and with it the orientation offsets)
+void step_core_track_gravity(StepCore *core, int16_t ax, int16_t ay, int16_t az);
+
+// Squared distance of a raw sample from the gravity estimate (offsets cancel out)
+uint64_t step_core_raw_dynamic_square(const StepCore *core, int16_t ax, int16_t ay, int16_t az);
+
+// Vertical dynamic acceleration of a raw sample: its distance from the gravity estimate, along
+// gravity, before the averaging window (whose null near 3 Hz would hide fast cadences)
+int16_t step_core_raw_vertical(const StepCore *core, int16_t ax, int16_t ay, int16_t az);
+
+// Applies offsets, runs the averaging filters and returns the new output
+FilteredAcceleration step_core_filter(StepCore *core, int16_t ax, int16_t ay, int16_t az);
+
+// Evaluates the detector; returns 1 if a step was counted. Fixed mode compares the dynamic
+// magnitude (squared) with the threshold; adaptive mode classifies the extremes of the vertical
+// component step_core_filter() has held since the previous evaluation against its bands.
+// Callers skip it while stationary, so stationary samples never reach the adaptive envelopes
+uint16_t step_core_detect(StepCore *core, uint64_t dynamic_square, uint32_t now_ms);
+
+// Returns true once per finished adaptive calibration run (its result is in core->tracker)
+bool step_core_take_calibration(StepCore *core);
+
+// Restores filter and gravity state (e.g. after a warm reset) and republishes the output
+void step_core_restore(StepCore *core, const TriAxisFilter *filter, const int32_t gravity[3]);
+
+// Runs gravity tracking and filtering on each of n samples and the detector on every
+// detect_every-th one once the output is ready, as the firmware's step task does; writes one event per counted step to events_out (room for n events)
+// and returns the number written. Configure the detector with detect_hz = sample_hz / detect_every.
+// Filtering goes through step_core_tri_filter_batch() in blocks; the result matches step_core_filter()
+uint16_t step_core_process(StepCore *core, const StepCoreSample *samples, uint16_t n, StepCoreEvent *events_out);
+
+#endif /* STEP_CORE_H_ */
@@ -2,7 +2,9 @@
  * step_detection.h
  *
  * Provides core logic for counting steps based on accelerometer data.
- * Also calculates travelled distance in metres/yards and manages step updates.
+ * Also reports travelled distance in metres/yards (via distance.c) and manages step updates.
+ * Steps can come from the software detector, the IMU's embedded pedometer, or both (hybrid).
+ * The software detector uses either a fixed threshold or bands adapted to the wearer.
  *
  * Created on: May 8, 2025
  * Author: eaz11 & gjo77
@@ -13,6 +15,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "adaptive_threshold.h"
 
 // Step update limits
 #define BUTTON_STEP_INCREMENT    10
@@ -23,6 +26,47 @@
 #define MIN_GOAL_VALUE            500
 #define HOLD_TIME_MS             1000
 
+// Hardware pedometer polling and hybrid comparison
+#define HW_PEDOMETER_POLL_MS      500
+#define HYBRID_WINDOW_MS        10000  // Software and hardware counts are compared per window...
+#define HYBRID_TOLERANCE_STEPS      2  // ...and a mismatch is logged when they differ by more than this
+
+// Where counted steps come from
+typedef enum {
+    STEP_SOURCE_SOFTWARE = 0,   // MCU filters and thresholds the accelerometer samples
+    STEP_SOURCE_HARDWARE,       // IMU embedded pedometer; MCU sampling pipeline idle
+    STEP_SOURCE_HYBRID,         // Software counts, hardware runs alongside for comparison
+    NUM_STEP_SOURCES
+} step_source_t;
+
+// How the software detector places its threshold
+typedef enum {
+    STEP_DETECTOR_FIXED = 0,    // Profile threshold, re-arm back inside it
+    STEP_DETECTOR_ADAPTIVE,     // Upper/lower bands tracked from the wearer's signal
+    NUM_STEP_DETECTORS
+} step_detector_t;
+
+// Per-mode cost of software detector evaluations (SysTick cycles)
+typedef struct {
+    uint32_t evaluations[NUM_STEP_DETECTORS];
+    uint32_t cycles[NUM_STEP_DETECTORS];
+} DetectorStats;
+
+// Software vs hardware totals gathered while in hybrid mode
+typedef struct {
+    uint32_t software_steps;
+    uint32_t hardware_steps;
+    uint32_t windows;           // Comparison windows completed
+    uint32_t mismatches;        // Windows where the counts differed by more than the tolerance
+} HybridStats;
+
+// Detector state carried across a warm reset
+typedef struct {
+    AdaptiveTracker tracker;        // Bands and envelopes; calibrate_start_ms holds the run's age
+    uint32_t last_step_age_ms;      // Time since the last counted step (refractory and pause timing)
+    bool step_detected;
+} DetectorSnapshot;
+
 // Called each loop cycle to process acceleration data and update step count
 void steps_task_execute(void);
 
@@ -33,15 +77,62 @@ void increment_stepcount(void);
 void increment_stepcount_button(void);
 
 // Overrides step count with a specific value (used in goal logic)
-void set_step_count(uint16_t new_count);
+void set_step_count(uint32_t new_count);
 
 // Gets distance in yards (based on step count)
-uint16_t get_distance_yards(void);
+uint32_t get_distance_yards(void);
 
 // Gets distance in metres (based on step count)
-uint16_t get_distance_metres(void);
+uint32_t get_distance_metres(void);
 
 // Returns the current step count
-uint16_t get_steps(void);
+uint32_t get_steps(void);
+
+// Copies the detector state a warm reset would lose (ticks as ages, since the tick restarts)
+void steps_save_detector(DetectorSnapshot *snapshot);
+
+// Restores the detector state after a warm reset (detection starts immediately)
+void steps_restore_detector(const DetectorSnapshot *snapshot);
+
+// Returns the time (ms since boot) of the first sample evaluated since reset (0 if none yet)
+uint32_t steps_get_first_detection_ms(void);
+
+// Sets the dynamic magnitude threshold (raw units) and derives the re-arm debounce
+// count for the step task rate; hysteresis state is kept
+void steps_configure(uint16_t step_hz, uint16_t threshold);
+
+// Selects the step source (invalid values fall back to software) and saves it as a setting. A
+// pedometer source on an IMU whose pedometer cannot be enabled runs as software, unsaved
+void steps_set_source(step_source_t source);
+
+// Returns the active step source
+step_source_t steps_get_source(void);
+
+// Returns a short name for a step source
+const char* steps_source_name(step_source_t source);
+
+// Returns the hybrid-mode comparison totals since hybrid was selected
+HybridStats steps_get_hybrid_stats(void);
+
+// Returns true once per newly logged mismatch window, with that window's counts
+bool steps_take_hybrid_mismatch(uint16_t *software_steps, uint16_t *hardware_steps);
+
+// Selects the software detector mode (invalid values fall back to fixed) and saves it as a setting
+void steps_set_detector(step_detector_t mode);
+
+// Returns the active software detector mode
+step_detector_t steps_get_detector(void);
+
+// Returns a short name for a detector mode
+const char* steps_detector_name(step_detector_t mode);
+
+// Switches to the adaptive detector and starts a calibration run (walk normally until it ends)
+void steps_calibrate_start(void);
+
+// Returns the adaptive tracker's bands and statistics
+AdaptiveStats steps_get_adaptive_stats(void);
+
+// Returns the per-mode detector cost counters
+DetectorStats steps_get_detector_stats(void);
 
 #endif /* STEP_DETECTION_H_ */
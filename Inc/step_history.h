@@ -0,0 +1,79 @@
+/*
+ * step_history.h
+ *
+ * Per-minute step history stored in a fixed-size ring of 8-bit bins.
+ * Bins are grouped into 15-minute blocks that carry a running step total,
+ * peak and active-minute count, so window and hourly queries never walk
+ * more than one block of raw bins.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef STEP_HISTORY_H_
+#define STEP_HISTORY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HISTORY_MINUTES        1920  // 32 hours of one-minute bins (1 byte each)
+#define HISTORY_BLOCK_MINUTES    15  // Minutes per summary block (4 per hour)
+#define HISTORY_BLOCKS         (HISTORY_MINUTES / HISTORY_BLOCK_MINUTES)
+#define HISTORY_MAX_QUERY_MINUTES (HISTORY_MINUTES - HISTORY_BLOCK_MINUTES)
+#define HISTORY_BIN_MAX         255  // Bins saturate at this many steps per minute
+#define ACTIVE_MINUTE_STEPS      60  // Steps in a minute for it to count as active
+#define HISTORY_RECENT_MINUTES  (2 * HISTORY_BLOCK_MINUTES)
+
+// The minutes flash may not hold yet: the current block so far and, while flash has not been
+// handed it, the block before. Kept across a warm reset
+typedef struct {
+    uint32_t first_minute;
+    uint32_t handed_out_minute;
+    uint32_t minute_elapsed_ms;     // Into the current (last) minute
+    uint8_t minutes;
+    uint8_t bins[HISTORY_RECENT_MINUTES];
+} StepHistoryRecent;
+
+// Clears all history and starts minute 0 at the current tick
+void step_history_init(void);
+
+// Adds steps to the current minute's bin (advances the ring first if needed)
+void step_history_record(uint16_t steps);
+
+// Returns minutes elapsed since history started (index of the current bin)
+uint32_t step_history_current_minute(void);
+
+// Returns number of minutes currently held in the ring
+uint16_t step_history_length(void);
+
+// Returns steps in the last n minutes, including the current one
+uint32_t step_history_last_minutes(uint16_t n);
+
+// Returns steps in an hour since history start (0 = first hour); false if no longer retained
+bool step_history_hour_total(uint32_t hour, uint32_t *total);
+
+// Returns peak steps-per-minute over the last n minutes
+uint8_t step_history_peak(uint16_t n);
+
+// Returns number of active minutes in the last n minutes
+uint16_t step_history_active_minutes(uint16_t n);
+
+// Hands out the oldest completed block with steps that has not been handed out yet, for
+// saving; false if there is none
+bool step_history_next_completed_block(uint32_t *first_minute, uint8_t bins[HISTORY_BLOCK_MINUTES]);
+
+// Restores a saved block; call straight after step_history_init() in ascending minute order.
+// Recording carries on in the block after the last one restored (power-off time is not counted)
+void step_history_restore_block(uint32_t first_minute, const uint8_t bins[HISTORY_BLOCK_MINUTES]);
+
+// Copies the recent minutes out for a warm-reset snapshot
+void step_history_save_recent(StepHistoryRecent *recent);
+
+// Restores the recent minutes after the flash blocks, resuming the current minute where it
+// was; minutes flash already restored are kept as they are
+void step_history_restore_recent(const StepHistoryRecent *recent);
+
+// Copies up to max bins starting offset minutes after the oldest retained bin; returns count
+uint16_t step_history_read(uint16_t offset, uint8_t *out, uint16_t max);
+
+#endif /* STEP_HISTORY_H_ */
@@ -0,0 +1,31 @@
+/*
+ * timebase.h
+ *
+ * Monotonic high-resolution time from SysTick. The 24-bit SysTick down-counter
+ * runs at the core clock and reloads every millisecond; the HAL's millisecond
+ * count (uwTick) extends it, and is itself extended to 64 bits here. Both
+ * reads are safe from the main loop and from interrupts of any priority,
+ * including while the SysTick interrupt is pending.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#include <stdint.h>
+
+// Computes the cycle-to-microsecond scale for the current SysTick reload; call once at start-up
+void timebase_init(void);
+
+// Core clock cycles since boot (mod 2^32, ~89 s at 48 MHz); the cheapest read, for measuring short spans
+uint32_t timebase_cycles(void);
+
+// Core clock cycles per millisecond (SysTick reload period)
+uint32_t timebase_cycles_per_ms(void);
+
+// Microseconds since boot; never wraps
+uint64_t timebase_us(void);
+
+#endif /* TIMEBASE_H_ */
@@ -0,0 +1,94 @@
+/*
+ * trace.h
+ *
+ * Event trace ring buffer for on-device timelines. Each record is 8 bytes:
+ * a SysTick cycle stamp, an event id, a phase and a 16-bit argument. The
+ * phase bytes are the Chrome trace format's own ('B', 'E', 'i'), so the
+ * host converter (tools/trace2json.py) passes them straight through.
+ * Recording is main-loop only; nothing is traced from interrupts.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Build with TRACE_ENABLED=0 to compile every hook down to an empty call
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED  1
+#endif
+
+#define TRACE_RECORDS        256   // Ring size (power of two); 2 KB of RAM
+
+#define TRACE_PHASE_BEGIN    'B'
+#define TRACE_PHASE_END      'E'
+#define TRACE_PHASE_INSTANT  'i'
+
+typedef enum {
+    // Scheduler tasks (begin arg: µs since the task became due, saturated)
+    TRACE_TASK_BUTTON = 0,
+    TRACE_TASK_DISPLAY,
+    TRACE_TASK_JOYSTICK,
+    TRACE_TASK_SERIAL,
+    TRACE_TASK_STEP,
+    TRACE_TASK_TEST,
+    TRACE_TASK_BUZZER,
+    TRACE_TASK_ACCELEROMETER,
+    TRACE_TASK_LED,
+
+    // Transfers (arg: bytes)
+    TRACE_I2C_READ,
+    TRACE_I2C_WRITE,
+    TRACE_I2C_PROBE,
+    TRACE_UART_TX,
+    TRACE_DISPLAY_FLUSH,
+
+    // Instants
+    TRACE_STEP,             // arg: step count (low 16 bits)
+    TRACE_PROFILE,          // arg: profile id
+    TRACE_SCREEN,           // arg: display state
+    TRACE_STEP_SOURCE,      // arg: step source
+    TRACE_DETECTOR,         // arg: detector mode
+    TRACE_ACTIVITY,         // arg: activity state
+    NUM_TRACE_EVENTS
+} trace_event_t;
+
+typedef struct {
+    uint32_t stamp;         // timebase_cycles() at the event
+    uint8_t event;          // trace_event_t
+    uint8_t phase;          // TRACE_PHASE_*
+    uint16_t arg;
+} TraceRecord;
+
+// Records the start of a span
+void trace_begin(trace_event_t event, uint16_t arg);
+
+// Records the end of a span
+void trace_end(trace_event_t event, uint16_t arg);
+
+// Records a point event
+void trace_instant(trace_event_t event, uint16_t arg);
+
+// Stops (true) or resumes (false) recording; a dump freezes the ring so it reads back consistently
+void trace_freeze(bool frozen);
+
+// Number of records held (at most TRACE_RECORDS)
+uint16_t trace_count(void);
+
+// Records overwritten since the ring was last cleared
+uint32_t trace_dropped(void);
+
+// Copies the index-th oldest record; returns false past the end
+bool trace_get(uint16_t index, TraceRecord *record);
+
+// Empties the ring
+void trace_clear(void);
+
+// Short name of an event for the dump header
+const char* trace_event_name(uint8_t event);
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,29 @@
+/*
+ * warm_restart.h
+ *
+ * Keeps a checksummed snapshot of the live state in a .noinit RAM section so the
+ * firmware can resume instantly after a watchdog, software or pin reset.
+ * The linker script must provide a NOLOAD ".noinit" output section in RAM,
+ * placed below _end so the stack monitor neither paints nor scans it.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef WARM_RESTART_H_
+#define WARM_RESTART_H_
+
+#include <stdbool.h>
+
+// Checks the reset cause and, on a warm reset with a valid snapshot, restores
+// counters, goal, screen, filters, detector state and the minutes of step history
+// flash does not hold yet. Call after all other inits (flash_log_init() first).
+bool warm_restart_init(void);
+
+// Refreshes the retained snapshot from the live state
+void warm_restart_save(void);
+
+// Returns true if this boot resumed from the retained snapshot
+bool warm_restart_is_warm(void);
+
+#endif /* WARM_RESTART_H_ */
@@ -1,103 +1,444 @@
 /*
  * accelerometer.c
  *
- * Handles raw accelerometer readings, applies orientation-based offsets,
- * performs filtering, and computes squared magnitude.
+ * Handles raw accelerometer readings and feeds them through the step core's
+ * offsets, filters and gravity tracker (step_core.c), which owns all of the
+ * signal processing; this module owns the sensor, its ODR and the gating.
+ * While the activity module reports the wearer as stationary the sensor runs at a
+ * low ODR and slots are decimated to ACTIVITY_STATIONARY_SAMPLE_HZ; those samples
+ * update gravity and are checked for motion but are not filtered.
+ * The IMU's embedded pedometer can be enabled alongside (or instead of) this
+ * pipeline; with processing disabled the MCU does no sampling at all.
+ * With ACCEL_CIC_FRONTEND set, full-rate samples come from the sensor FIFO at
+ * ACCEL_CIC_ODR_HZ and are CIC-decimated to the profile rate before filtering.
+ * All sensor traffic goes through the bounded I2C bus layer (i2c_bus.c); a
+ * read that fails or is skipped drops that sample instead of stalling.
+ * While the gait generator runs, its synthetic samples replace sensor reads.
  *
  * Created on: May 8, 2025
  * Author: eaz11 & gjo77
  */
 
 #include "accelerometer.h"
+#include "step_core.h"
 #include "imu_lsm6ds.h"
+#include "activity.h"
+#include "cic_decimator.h"
+#include "imu_decode.h"
+#include "cadence.h"
+#include "timebase.h"
+#include "i2c_bus.h"
+#include "gait_gen.h"
 
-#define ORIENTATION_THRESHOLD  16000  // Raw axis value above which a dominant orientation is detected
-#define ACCEL_GRAVITY_BASELINE  9310  // Expected gravity magnitude in sensor raw units (used to pre-fill filter)
+_Static_assert(ACCEL_MAX_SAMPLE_RATE_HZ <= STEP_CORE_MAX_SAMPLE_HZ, "A profile's filter window would not fit the step core");
 
-// Module-scoped filters and latest result
-static AveragingFilter x_filter, y_filter, z_filter;
-static FilteredAcceleration latest_filtered_data;
+#define CTRL1_XL_ODR_MASK       0xF0
+#define CTRL1_XL_AT_ODR(ODR)    ((CTRL1_XL_HIGH_PERFORMANCE & ~CTRL1_XL_ODR_MASK) | (ODR))
+#define STATIONARY_ODR          ACCEL_ODR_12HZ5  // Low output data rate used while stationary
+#define PEDOMETER_MIN_ODR       ACCEL_ODR_26HZ   // Lowest ODR the embedded pedometer runs at
 
-// Initializes an averaging filter with zeros
-void filter_init(AveragingFilter *filter) {
-    for (int i = 0; i < BUFFER_SIZE; i++) {
-        filter->buffer[i] = ACCEL_GRAVITY_BASELINE;
-    }
-    filter->index = 0;
-}
+#ifndef CTRL6_C
+#define CTRL6_C                 0x15
+#endif
+#define CTRL6_C_XL_HM_MODE      0x10  // Set = high-performance mode disabled
 
-// Returns average of buffer after inserting new value
-int16_t filter_apply(AveragingFilter *filter, int16_t new_value) {
-    filter->buffer[filter->index] = new_value;
-    filter->index = (filter->index + 1) % BUFFER_SIZE;
+// Embedded pedometer. The enable bit differs between the variants: the LSM6DSL has
+// PEDO_EN in CTRL10_C, the LSM6DS3 in TAP_CFG (its CTRL10_C bit 4 enables the gyro Y axis)
+#ifndef WHO_AM_I
+#define WHO_AM_I                0x0F
+#endif
+#define WHO_AM_I_LSM6DS3        0x69
+#define WHO_AM_I_LSM6DSL        0x6A
+#ifndef CTRL10_C
+#define CTRL10_C                0x19
+#endif
+#define CTRL10_C_FUNC_EN        0x04
+#define CTRL10_C_PEDO_EN        0x10  // LSM6DSL only
+#ifndef TAP_CFG
+#define TAP_CFG                 0x58
+#endif
+#define TAP_CFG_PEDO_EN         0x40  // LSM6DS3 only
+#ifndef STEP_COUNTER_L
+#define STEP_COUNTER_L          0x4B
+#define STEP_COUNTER_H          0x4C
+#endif
 
-    int32_t sum = 0;
-    for (int i = 0; i < BUFFER_SIZE; i++) {
-        sum += filter->buffer[i];
-    }
-    return (int16_t)(sum / BUFFER_SIZE);
+// FIFO (LSM6DS3/LSM6DSL register map), used by the CIC front-end
+#ifndef FIFO_CTRL3
+#define FIFO_CTRL3              0x08
+#define FIFO_CTRL5              0x0A
+#define FIFO_STATUS1            0x3A
+#define FIFO_STATUS2            0x3B
+#define FIFO_STATUS3            0x3C
+#define FIFO_STATUS4            0x3D
+#define FIFO_DATA_OUT_L         0x3E
+#endif
+#define FIFO_CTRL3_XL_NO_DECIMATION  0x01  // Accelerometer in FIFO, gyro not
+#define FIFO_CTRL5_ODR_416HZ    0x30
+#define FIFO_CTRL5_CONTINUOUS   0x06
+#define FIFO_CTRL5_BYPASS       0x00
+#define FIFO_DIFF_HIGH_MASK     0x07  // FIFO_STATUS2[2:0] = unread word count [10:8]
+#define FIFO_PATTERN_HIGH_MASK  0x03  // FIFO_STATUS4[1:0] = pattern [9:8]
+#define FIFO_WORDS_PER_SAMPLE   3
+#define CIC_SAMPLES_PER_READ    8     // Samples per I2C burst (48 bytes)
+#define CIC_MAX_SAMPLES_PER_RUN 64    // Bounds time per task run; the FIFO keeps the rest
+#define PEDOMETER_READ_ATTEMPTS 3     // Re-reads allowed when the counter carries mid-read
+
+// Filters, gravity tracker and step detector (the detector half is driven by step_detection.c)
+static StepCore core;
+static uint64_t sample_time_us = 0;       // Timebase time of the latest filtered sample
+
+// Sampling configuration
+static uint8_t active_odr = ACCEL_ODR_104HZ;
+static bool processing = true;            // False when the MCU pipeline is idle (hardware step source)
+static bool pedometer_on = false;
+
+// CIC front-end state
+static CicDecimator x_cic, y_cic, z_cic;
+static CicStats cic_stats;
+
+static uint16_t pedometer_count = 0;      // Last counter value read successfully
+static uint8_t imu_id = 0;                // WHO_AM_I, 0 until read successfully
+static bool injecting = false;            // Samples came from the gait generator on the last run
+static StepCore ramp_core;                // The gait ramp's own pipeline, so its samples reach no live consumer
+static volatile bool sink_still;          // Keeps the ramp's activity check from being optimised out
+
+// Reads consecutive IMU registers (the address auto-increments); false if the bus failed or skipped it
+static bool imu_read(uint8_t reg, uint8_t *data, uint16_t length) {
+    return i2c_bus_read(I2C_DEVICE_IMU, reg, data, length) == I2C_BUS_OK;
 }
 
-// Computes squared magnitude without sqrt for performance
-uint64_t magnitude_squared(int16_t x, int16_t y, int16_t z) {
-    return (int64_t)x * x + (int64_t)y * y + (int64_t)z * z;
+// Writes one IMU register; a failed write is counted by the bus layer and otherwise dropped
+static void imu_write(uint8_t reg, uint8_t value) {
+    i2c_bus_write(I2C_DEVICE_IMU, reg, &value, 1);
 }
 
-// Reads 16-bit signed acceleration value from register pair
+// Reads 16-bit signed acceleration value from register pair (0 for a byte the bus could not read)
 int16_t get_acceleration_axis(uint8_t low_reg, uint8_t high_reg) {
-    uint8_t low = imu_lsm6ds_read_byte(low_reg);
-    uint8_t high = imu_lsm6ds_read_byte(high_reg);
-    return (int16_t)((high << 8) | low);
+    uint8_t low = 0, high = 0;
+    imu_read(low_reg, &low, 1);
+    imu_read(high_reg, &high, 1);
+    const uint8_t bytes[2] = { low, high };
+    return imu_decode_word(bytes);
+}
+
+// Sets or clears bits of an IMU register; never writes back a register that was not read
+static void update_bits(uint8_t reg, uint8_t mask, bool set) {
+    uint8_t value;
+
+    if (!imu_read(reg, &value, 1)) return;
+    value = set ? (uint8_t)(value | mask) : (uint8_t)(value & ~mask);
+    imu_write(reg, value);
+}
+
+// True while samples should come from the FIFO through the decimators
+static bool cic_active(void) {
+    return ACCEL_CIC_FRONTEND && processing && !activity_is_stationary();
+}
+
+// Restarts the decimators (their first outputs are discarded while they refill)
+static void cic_reset(void) {
+    cic_init(&x_cic, cic_stats.ratio);
+    cic_init(&y_cic, cic_stats.ratio);
+    cic_init(&z_cic, cic_stats.ratio);
+}
+
+// Writes the ODR matching the current mode: profile rate only while the MCU pipeline is active and moving
+static void apply_odr(void) {
+    uint8_t odr = active_odr;
+    if (!processing || activity_is_stationary()) {
+        odr = pedometer_on ? PEDOMETER_MIN_ODR : STATIONARY_ODR;
+    }
+
+    if (ACCEL_CIC_FRONTEND) {
+        // Bypass empties the FIFO; continuous mode then refills it from the new ODR
+        imu_write(FIFO_CTRL5, FIFO_CTRL5_BYPASS);
+        if (cic_active()) {
+            odr = ACCEL_ODR_416HZ;
+            imu_write(FIFO_CTRL3, FIFO_CTRL3_XL_NO_DECIMATION);
+            imu_write(FIFO_CTRL5, FIFO_CTRL5_ODR_416HZ | FIFO_CTRL5_CONTINUOUS);
+            cic_reset();
+        }
+    }
+    imu_write(CTRL1_XL, CTRL1_XL_AT_ODR(odr));
 }
 
 // Hardware and filters init
 void accelerometer_init(void) {
-    imu_lsm6ds_write_byte(CTRL1_XL, CTRL1_XL_HIGH_PERFORMANCE);
-    filter_init(&x_filter);
-    filter_init(&y_filter);
-    filter_init(&z_filter);
+    processing = true;
+    pedometer_on = false;
+    imu_write(CTRL1_XL, CTRL1_XL_HIGH_PERFORMANCE);
+    step_core_init(&core);
+}
+
+// Runs the core's filters on a sample; the cadence estimator takes the sample from before the
+// averaging window, which would otherwise flatten cadences near its 3 Hz null
+static void filter_sample(int16_t ax, int16_t ay, int16_t az) {
+    cadence_push(step_core_raw_vertical(&core, ax, ay, az));
+    step_core_filter(&core, ax, ay, az);
+}
+
+// Switches to the stationary configuration; the cadence window would have a gap, so drop it
+static void enter_stationary(void) {
+    cadence_reset();
+    apply_odr();
+}
+
+// Drains up to CIC_MAX_SAMPLES_PER_RUN samples from the FIFO through the decimators;
+// each decimated sample goes through the normal gravity/filter path
+static void cic_execute(void) {
+    uint8_t burst[CIC_SAMPLES_PER_READ * IMU_SAMPLE_BYTES];
+
+    uint8_t status[4];
+
+    if (!imu_read(FIFO_STATUS1, status, sizeof(status))) return;
+    uint16_t words = status[0] | ((status[1] & FIFO_DIFF_HIGH_MASK) << 8);
+    uint16_t pattern = status[2] | ((status[3] & FIFO_PATTERN_HIGH_MASK) << 8);
+
+    // Realign to an X word if an overrun left the read pointer mid-sample
+    while (pattern != 0 && words > 0) {
+        if (!imu_read(FIFO_DATA_OUT_L, burst, 2)) return;
+        words--;
+        if (++pattern == FIFO_WORDS_PER_SAMPLE) pattern = 0;
+    }
+
+    uint16_t samples = words / FIFO_WORDS_PER_SAMPLE;
+    if (samples > CIC_MAX_SAMPLES_PER_RUN) samples = CIC_MAX_SAMPLES_PER_RUN;
+
+    while (samples > 0) {
+        uint16_t count = (samples < CIC_SAMPLES_PER_READ) ? samples : CIC_SAMPLES_PER_READ;
+
+        // FIFO_DATA_OUT rolls back from _H to _L, so one burst returns consecutive words
+        uint16_t bytes = count * IMU_SAMPLE_BYTES;
+        if (!imu_read(FIFO_DATA_OUT_L, burst, bytes)) return;
+        samples -= count;
+        uint64_t burst_us = timebase_us();
+
+        for (uint16_t i = 0; i < count; i++) {
+            const uint8_t *sample = &burst[i * IMU_SAMPLE_BYTES];
+            int16_t ix, iy, iz, ox, oy, oz;
+
+            uint32_t start = timebase_cycles();
+            imu_decode_sample(sample, &ix, &iy, &iz);
+            bool output = cic_push(&x_cic, ix, &ox);
+            cic_push(&y_cic, iy, &oy);
+            cic_push(&z_cic, iz, &oz);
+            cic_stats.cycles += timebase_cycles() - start;
+            cic_stats.inputs++;
+
+            if (!output) continue;
+            cic_stats.outputs++;
+
+            // The burst's last sample was converted just before the read; earlier ones one ODR period apart
+            sample_time_us = burst_us - (uint64_t)(count - 1 - i) * (1000000 / ACCEL_CIC_ODR_HZ);
+            step_core_track_gravity(&core, ox, oy, oz);
+            filter_sample(ox, oy, oz);
+            if (activity_update(core.latest.dynamic_magnitude_square)) {
+                enter_stationary();  // FIFO off, direct low-rate reads from here on
+                return;
+            }
+        }
+    }
+}
+
+// Runs every due synthetic sample through the moving-sample stages on the ramp's own core,
+// timing each. The live core, cadence, activity state and step count never see them
+static void inject_execute(void) {
+    uint16_t count = gait_gen_due();
+    uint32_t stage_cycles[NUM_GAIT_STAGES];
+    int16_t ax, ay, az;
+
+    while (count-- > 0) {
+        uint32_t t0 = timebase_cycles();
+        gait_gen_sample(&ax, &ay, &az);
+        uint32_t t1 = timebase_cycles();
+        step_core_track_gravity(&ramp_core, ax, ay, az);
+        uint32_t t2 = timebase_cycles();
+        FilteredAcceleration output = step_core_filter(&ramp_core, ax, ay, az);
+        uint32_t t3 = timebase_cycles();
+        sink_still = activity_sample_is_still(output.dynamic_magnitude_square);
+        uint32_t t4 = timebase_cycles();
+
+        stage_cycles[GAIT_STAGE_GENERATE] = t1 - t0;
+        stage_cycles[GAIT_STAGE_GRAVITY] = t2 - t1;
+        stage_cycles[GAIT_STAGE_FILTER] = t3 - t2;
+        stage_cycles[GAIT_STAGE_ACTIVITY] = t4 - t3;
+        gait_gen_account(stage_cycles);
+    }
 }
 
 // Main accelerometer logic: read, adjust, filter, compute magnitude
 FilteredAcceleration accelerometer_execute(void) {
-    int16_t ax = get_acceleration_axis(OUTX_L_XL, OUTX_H_XL);
-    int16_t ay = get_acceleration_axis(OUTY_L_XL, OUTY_H_XL);
-    int16_t az = get_acceleration_axis(OUTZ_L_XL, OUTZ_H_XL);
+    if (gait_gen_is_running()) {
+        if (!injecting) {
+            // Same configuration as the live core, empty filters and gravity (reseeded by the first sample)
+            injecting = true;
+            ramp_core = core;
+            step_core_reset_filters(&ramp_core);
+        }
+        inject_execute();
+        return core.latest;
+    }
+    if (injecting) {
+        // The live filters missed the ramp's duration of real samples: reseed from the next read
+        injecting = false;
+        step_core_reset_filters(&core);
+    }
 
-    int16_t x_offset = 0, y_offset = 0, z_offset = 0;
+    if (!processing || !activity_sample_due()) {
+        return core.latest;
+    }
+
+    if (cic_active()) {
+        cic_execute();
+        return core.latest;
+    }
 
-    if (ax > ORIENTATION_THRESHOLD) {          // Portrait right
-        x_offset = 100; y_offset = -70; z_offset = -500;
-    } else if (ax < -ORIENTATION_THRESHOLD) {  // Portrait left
-        x_offset = 100; z_offset = 300;
-    } else if (ay > ORIENTATION_THRESHOLD) {   // Landscape top-up
-        x_offset = 500; y_offset = -200; z_offset = 600;
-    } else if (ay < -ORIENTATION_THRESHOLD) {  // Landscape top-down
-        x_offset = -65; z_offset = -225;
-    } else if (az > ORIENTATION_THRESHOLD) {   // Face-up (flat)
-        x_offset = 150; y_offset = -110;
-    } else {                                   // Face-down (flat)
-        x_offset = 0; y_offset = 0; z_offset = 0;
+    // One burst for all three axes; if the bus fails, skip this sample rather than wait
+    uint8_t raw[IMU_SAMPLE_BYTES];
+    if (!imu_read(OUTX_L_XL, raw, sizeof(raw))) {
+        return core.latest;
     }
+    int16_t ax, ay, az;
+    imu_decode_sample(raw, &ax, &ay, &az);
+    uint64_t read_us = timebase_us();
+
+    // Output registers read zero until the first conversion completes; don't seed from that
+    if (!step_core_is_seeded(&core) && ax == 0 && ay == 0 && az == 0) {
+        return core.latest;
+    }
+
+    step_core_track_gravity(&core, ax, ay, az);
 
-    ax += x_offset;
-    ay += y_offset;
-    az += z_offset;
+    // Stationary: leave the filters alone unless this sample shows motion
+    bool stationary = activity_is_stationary();
+    if (stationary) {
+        if (!activity_update(step_core_raw_dynamic_square(&core, ax, ay, az))) {
+            return core.latest;
+        }
+        apply_odr();
+        if (cic_active()) {
+            return core.latest;  // Full-rate samples now come from the FIFO
+        }
+    }
 
-    int16_t fx = filter_apply(&x_filter, ax);
-    int16_t fy = filter_apply(&y_filter, ay);
-    int16_t fz = filter_apply(&z_filter, az);
+    sample_time_us = read_us;
+    filter_sample(ax, ay, az);
 
-    latest_filtered_data = (FilteredAcceleration){
-        .acc_x_filtered = fx,
-        .acc_y_filtered = fy,
-        .acc_z_filtered = fz,
-        .magnitude_square = magnitude_squared(fx, fy, fz)
-    };
+    if (!stationary && activity_update(core.latest.dynamic_magnitude_square)) {
+        enter_stationary();
+    }
 
-    return latest_filtered_data;
+    return core.latest;
 }
 
 FilteredAcceleration accelerometer_get_latest(void) {
-    return latest_filtered_data;
+    return core.latest;
+}
+
+uint64_t accelerometer_get_sample_time_us(void) {
+    return sample_time_us;
+}
+
+bool accelerometer_is_ready(void) {
+    return step_core_is_ready(&core);
+}
+
+uint8_t accelerometer_get_warmup_samples(void) {
+    return core.ready ? core.warmup_samples : 0;
+}
+
+StepCore* accelerometer_get_core(void) {
+    return &core;
+}
+
+void accelerometer_set_profile(uint8_t odr, bool high_performance, uint16_t sample_hz) {
+    step_core_configure_sampling(&core, sample_hz);
+
+    // Decimation ratio that brings the FIFO rate closest to the sampling rate
+    uint32_t ratio = (ACCEL_CIC_ODR_HZ + sample_hz / 2) / sample_hz;
+    cic_stats.ratio = (ratio > CIC_MAX_RATIO) ? CIC_MAX_RATIO : (ratio == 0) ? 1 : (uint8_t)ratio;
+
+    uint8_t ctrl6;
+    if (imu_read(CTRL6_C, &ctrl6, 1)) {  // Never write back a register that was not read
+        if (high_performance) {
+            ctrl6 &= (uint8_t)~CTRL6_C_XL_HM_MODE;
+        } else {
+            ctrl6 |= CTRL6_C_XL_HM_MODE;
+        }
+        imu_write(CTRL6_C, ctrl6);
+    }
+
+    active_odr = odr;
+    apply_odr();
+}
+
+void accelerometer_set_processing(bool enable) {
+    if (enable && !processing) {
+        // Buffers are stale after an idle spell: reseed filters and gravity from the next sample
+        step_core_reset_filters(&core);
+    }
+    processing = enable;
+    apply_odr();
+}
+
+bool accelerometer_is_processing(void) {
+    return processing;
+}
+
+bool accelerometer_pedometer_enable(bool enable) {
+    if (imu_id == 0 && !imu_read(WHO_AM_I, &imu_id, 1)) {
+        imu_id = 0;
+    }
+
+    if (imu_id == WHO_AM_I_LSM6DS3) {
+        update_bits(TAP_CFG, TAP_CFG_PEDO_EN, enable);
+        update_bits(CTRL10_C, CTRL10_C_FUNC_EN, enable);
+    } else if (imu_id == WHO_AM_I_LSM6DSL) {
+        update_bits(CTRL10_C, CTRL10_C_FUNC_EN | CTRL10_C_PEDO_EN, enable);
+    } else {
+        // Unreadable or unknown ID: the PEDO_EN position differs between parts (on the LSM6DS3
+        // it enables the gyro Y axis), so nothing is written
+        return false;
+    }
+    pedometer_on = enable;
+    apply_odr();
+    return true;
+}
+
+uint8_t accelerometer_get_imu_id(void) {
+    return imu_id;
+}
+
+CicStats accelerometer_get_cic_stats(void) {
+    return cic_stats;
+}
+
+// The counter can carry between the two byte reads, so re-read until the high byte is stable.
+// If the bus fails (or the counter never settles) the last good count is returned, so no steps are invented.
+uint16_t accelerometer_pedometer_read(void) {
+    uint8_t high, low, check;
+
+    for (uint8_t attempt = 0; attempt < PEDOMETER_READ_ATTEMPTS; attempt++) {
+        if (!imu_read(STEP_COUNTER_H, &high, 1) || !imu_read(STEP_COUNTER_L, &low, 1) ||
+            !imu_read(STEP_COUNTER_H, &check, 1)) {
+            break;
+        }
+        if (check == high) {
+            pedometer_count = (uint16_t)((high << 8) | low);
+            break;
+        }
+    }
+    return pedometer_count;
+}
+
+void accelerometer_save_state(AccelerometerState *state) {
+    state->filter = core.filter;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        state->gravity[axis] = core.gravity_acc[axis];
+    }
+}
+
+void accelerometer_restore_state(const AccelerometerState *state) {
+    step_core_restore(&core, &state->filter, state->gravity);
 }
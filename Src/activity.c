@@ -0,0 +1,127 @@
+/*
+ * activity.c
+ *
+ * Two-state activity detector (active / stationary) with time accounting.
+ * Entering stationary needs ACTIVITY_STILL_TIME_MS of continuously small dynamic
+ * magnitude; leaving it needs a single sample above the (higher) wake threshold,
+ * so the full rate is restored on the first impact of the next step.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "activity.h"
+#include "trace.h"
+#include "stm32c0xx_hal.h"
+
+#define STILL_THRESHOLD_SQ  ((uint64_t)ACTIVITY_STILL_THRESHOLD * ACTIVITY_STILL_THRESHOLD)
+#define WAKE_THRESHOLD_SQ   ((uint64_t)ACTIVITY_WAKE_THRESHOLD * ACTIVITY_WAKE_THRESHOLD)
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static activity_state_t state = ACTIVITY_ACTIVE;
+static uint32_t still_since_ms = 0;       // Start of the current run of still samples
+static bool still_run = false;
+static uint32_t state_entered_ms = 0;
+static uint32_t time_in_state_ms[NUM_ACTIVITY_STATES];
+static uint8_t slot_counter = 0;
+static uint8_t stationary_divider = 5;    // Accelerometer slots per stationary sample
+static uint32_t skipped_samples = 0;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+static void enter_state(activity_state_t new_state, uint32_t now) {
+    time_in_state_ms[state] += now - state_entered_ms;
+    state_entered_ms = now;
+    state = new_state;
+    still_run = false;
+    slot_counter = 0;
+    trace_instant(TRACE_ACTIVITY, new_state);
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void activity_init(void) {
+    state = ACTIVITY_ACTIVE;
+    still_run = false;
+    state_entered_ms = HAL_GetTick();
+    for (uint8_t i = 0; i < NUM_ACTIVITY_STATES; i++) {
+        time_in_state_ms[i] = 0;
+    }
+    slot_counter = 0;
+    skipped_samples = 0;
+}
+
+void activity_set_sample_rate(uint16_t sample_hz) {
+    uint16_t divider = sample_hz / ACTIVITY_STATIONARY_SAMPLE_HZ;
+    stationary_divider = (divider > 0) ? (uint8_t)divider : 1;
+    slot_counter = 0;
+}
+
+bool activity_update(uint64_t dynamic_square) {
+    uint32_t now = HAL_GetTick();
+
+    if (state == ACTIVITY_STATIONARY) {
+        if (dynamic_square > WAKE_THRESHOLD_SQ) {
+            enter_state(ACTIVITY_ACTIVE, now);
+            return true;
+        }
+        return false;
+    }
+
+    if (!activity_sample_is_still(dynamic_square)) {
+        still_run = false;
+        return false;
+    }
+    if (!still_run) {
+        still_run = true;
+        still_since_ms = now;
+    } else if (now - still_since_ms >= ACTIVITY_STILL_TIME_MS) {
+        enter_state(ACTIVITY_STATIONARY, now);
+        return true;
+    }
+    return false;
+}
+
+bool activity_sample_is_still(uint64_t dynamic_square) {
+    return dynamic_square < STILL_THRESHOLD_SQ;
+}
+
+activity_state_t activity_get_state(void) {
+    return state;
+}
+
+bool activity_is_stationary(void) {
+    return state == ACTIVITY_STATIONARY;
+}
+
+bool activity_sample_due(void) {
+    if (state == ACTIVITY_ACTIVE) return true;
+
+    if (++slot_counter >= stationary_divider) {
+        slot_counter = 0;
+        return true;
+    }
+    skipped_samples++;
+    return false;
+}
+
+uint32_t activity_get_time_ms(activity_state_t query) {
+    if (query >= NUM_ACTIVITY_STATES) return 0;
+
+    uint32_t total = time_in_state_ms[query];
+    if (query == state) {
+        total += HAL_GetTick() - state_entered_ms;
+    }
+    return total;
+}
+
+uint32_t activity_get_skipped_samples(void) {
+    return skipped_samples;
+}
@@ -0,0 +1,103 @@
+/*
+ * adaptive_threshold.c
+ *
+ * Envelope band tracker for the step detector. Each envelope is held in Q8
+ * and moves as x += (extreme - x) >> shift, with a small shift when the
+ * extreme is beyond it (attack) and the release shift otherwise, so an
+ * evaluation costs a handful of adds and shifts and no division. The caller
+ * freezes the envelopes during pauses, and runs no detection at all while
+ * stationary, so the bands do not sag towards the floor between walks.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "adaptive_threshold.h"
+#include "step_core.h"
+
+#define STAT_FRACTION_BITS   8
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Moves an envelope towards an extreme (clipped at zero): quickly up, slowly down
+static void follow(int32_t *envelope_q8, int16_t extreme, uint8_t release_shift) {
+    int32_t sample_q8 = (extreme > 0) ? (int32_t)extreme << STAT_FRACTION_BITS : 0;
+    int32_t error = sample_q8 - *envelope_q8;
+    *envelope_q8 += error >> ((error > 0) ? ADAPT_ATTACK_SHIFT : release_shift);
+}
+
+// Half an envelope, kept between the noise floor and the cap
+static uint16_t band(int32_t envelope_q8) {
+    int32_t level = ((envelope_q8 >> STAT_FRACTION_BITS) * ADAPT_BAND_GAIN_Q4) >> 4;
+    if (level < ADAPT_MIN_BAND) level = ADAPT_MIN_BAND;
+    if (level > ADAPT_MAX_BAND) level = ADAPT_MAX_BAND;
+    return (uint16_t)level;
+}
+
+// Recomputes the bands from the envelopes
+static void update_bands(AdaptiveTracker *tracker) {
+    tracker->upper = band(tracker->peak_q8);
+    tracker->lower = band(tracker->trough_q8);
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void adaptive_configure(AdaptiveTracker *tracker, uint16_t step_hz) {
+    tracker->track_shift = step_core_shift_for_samples(STEP_CORE_MS_TO_SAMPLES(ADAPT_TIME_CONSTANT_MS, step_hz));
+    tracker->calibrate_shift = step_core_shift_for_samples(STEP_CORE_MS_TO_SAMPLES(ADAPT_CALIBRATE_TIME_CONSTANT_MS, step_hz));
+}
+
+void adaptive_reset(AdaptiveTracker *tracker, uint16_t calibrated_peak, uint16_t calibrated_trough) {
+    tracker->calibrated = (calibrated_peak > 0 && calibrated_trough > 0);
+    tracker->peak_q8 = (int32_t)calibrated_peak << STAT_FRACTION_BITS;
+    tracker->trough_q8 = (int32_t)calibrated_trough << STAT_FRACTION_BITS;
+    tracker->calibrating = false;
+    tracker->updates = 0;
+    tracker->frozen = 0;
+    update_bands(tracker);
+}
+
+bool adaptive_update(AdaptiveTracker *tracker, int16_t high, int16_t low, bool frozen, uint32_t now_ms) {
+    bool finished = false;
+
+    if (frozen) {
+        tracker->frozen++;
+    } else {
+        uint8_t shift = tracker->calibrating ? tracker->calibrate_shift : tracker->track_shift;
+        follow(&tracker->peak_q8, high, shift);
+        follow(&tracker->trough_q8, (int16_t)((low > -INT16_MAX) ? -low : INT16_MAX), shift);
+        tracker->updates++;
+        if (tracker->calibrating) tracker->calibrate_samples++;
+        update_bands(tracker);
+    }
+
+    if (tracker->calibrating && now_ms - tracker->calibrate_start_ms >= ADAPT_CALIBRATE_MS) {
+        tracker->calibrating = false;
+        finished = (tracker->calibrate_samples >= ADAPT_CALIBRATE_MIN_SAMPLES);
+        if (finished) tracker->calibrated = true;
+    }
+    return finished;
+}
+
+void adaptive_calibrate_start(AdaptiveTracker *tracker, uint32_t now_ms) {
+    tracker->calibrating = true;
+    tracker->calibrate_start_ms = now_ms;
+    tracker->calibrate_samples = 0;
+}
+
+AdaptiveStats adaptive_get_stats(const AdaptiveTracker *tracker) {
+    return (AdaptiveStats){
+        .peak = (uint16_t)((uint32_t)tracker->peak_q8 >> STAT_FRACTION_BITS),
+        .trough = (uint16_t)((uint32_t)tracker->trough_q8 >> STAT_FRACTION_BITS),
+        .upper = tracker->upper,
+        .lower = tracker->lower,
+        .updates = tracker->updates,
+        .frozen = tracker->frozen,
+        .calibrating = tracker->calibrating,
+        .calibrated = tracker->calibrated
+    };
+}
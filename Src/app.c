@@ -3,6 +3,7 @@
  *
  * Main application scheduler for step counter firmware.
  * Handles task initialization and periodic execution.
+ * Accelerometer, step and display periods come from the active performance profile.
  *
  * Created on: Mar 13, 2025
  * Author: eaz11 & gjo77
@@ -23,6 +24,15 @@
 #include "accelerometer.h"
 #include "tim.h"
 #include "fsm.h"
+#include "step_history.h"
+#include "flash_log.h"
+#include "warm_restart.h"
+#include "activity.h"
+#include "profile.h"
+#include "timebase.h"
+#include "monitor.h"
+#include "soft_timer.h"
+#include "i2c_bus.h"
 
 // Stores next execution time for each task
 static uint32_t taskButtonNextRun = 0;
@@ -35,8 +45,37 @@ static uint32_t taskBuzzerNextRun = 0;
 static uint32_t taskAccelerometerNextRun = 0;
 static uint32_t taskLEDNextRun = 0;
 
-void app_main(void)
+// Profile-controlled task periods (ticks)
+static uint32_t taskDisplayPeriod = TASK_DISPLAY_PERIOD_TICKS;
+static uint32_t taskStepPeriod = TASK_STEP_PERIOD_TICKS;
+static uint32_t taskAccelerometerPeriod = TASK_ACCELEROMETER_PERIOD_TICKS;
+
+// Loads the active profile's task periods and restarts those tasks' schedules from 'now'
+static void load_profile_periods(uint32_t now)
+{
+    const PerformanceProfile *profile = profile_get();
+
+    taskDisplayPeriod       = profile->display_period_ticks;
+    taskStepPeriod          = profile->step_period_ticks;
+    taskAccelerometerPeriod = profile->accelerometer_period_ticks;
+
+    taskDisplayNextRun       = now + taskDisplayPeriod;
+    taskStepNextRun          = now + taskStepPeriod;
+    taskAccelerometerNextRun = now + taskAccelerometerPeriod;
+}
+
+// Microseconds since a task became due (the tick after its next-run time began)
+static uint32_t late_us(uint32_t next_run)
+{
+    return (uint32_t)timebase_us() - (next_run + 1) * (1000000 / TICK_FREQUENCY_HZ);
+}
+
+void app_init(void)
 {
+    timebase_init();
+    soft_timer_init();  // Before the modules, which may start timers
+    i2c_bus_init();
+
     // Set next run times relative to current tick
     uint32_t now = HAL_GetTick();
     taskButtonNextRun        = now + TASK_BUTTON_PERIOD_TICKS;
@@ -55,49 +94,144 @@ void app_main(void)
     rgb_colour_all_on();
     joystick_init();
     LED_init();
+    buzzer_init();
     accelerometer_init();
+    activity_init();
     fsm_init();
+    step_history_init();
+    flash_log_init();  // Restores steps and goal saved before power-off
+    profile_init();
+    steps_set_source((step_source_t)flash_log_get_setting(FLASH_LOG_SETTING_STEP_SOURCE));
+    steps_set_detector((step_detector_t)flash_log_get_setting(FLASH_LOG_SETTING_DETECTOR));
+    buzzer_restore_volume();
+    warm_restart_init();  // Newer RAM snapshot wins after a warm reset
+    monitor_init();  // Paints the stack only once the snapshot in .noinit has been read
+    load_profile_periods(HAL_GetTick());
+}
+
+bool app_step(void)
+{
+    buttons_update(); // Must be called frequently to detect button events
+    uint32_t ticks = HAL_GetTick();
+    uint32_t pass_start = timebase_cycles();
+    bool ran = false;
+
+    soft_timer_process(ticks);  // Timeouts and one-shots fire before the tasks see this tick
+
+    if (ticks > taskButtonNextRun) {
+        ran = true;
+        monitor_task_begin(MONITOR_TASK_BUTTON, late_us(taskButtonNextRun));
+        button_task_execute();
+        taskButtonNextRun += TASK_BUTTON_PERIOD_TICKS;
+        monitor_task_end(MONITOR_TASK_BUTTON);
+    }
+    if (ticks > taskDisplayNextRun) {
+        ran = true;
+        monitor_task_begin(MONITOR_TASK_DISPLAY, late_us(taskDisplayNextRun));
+        display_task_execute();
+        taskDisplayNextRun += taskDisplayPeriod;
+        monitor_task_end(MONITOR_TASK_DISPLAY);
+    }
+    if (ticks > taskJoystickNextRun) {
+        ran = true;
+        monitor_task_begin(MONITOR_TASK_JOYSTICK, late_us(taskJoystickNextRun));
+        joystick_task_execute();
+        taskJoystickNextRun += TASK_JOYSTICK_PERIOD_TICKS;
+        monitor_task_end(MONITOR_TASK_JOYSTICK);
+    }
+    if (ticks > taskSerialNextRun) {
+        ran = true;
+        monitor_task_begin(MONITOR_TASK_SERIAL, late_us(taskSerialNextRun));
+        serial_task_execute();
+        taskSerialNextRun += TASK_SERIAL_PERIOD_TICKS;
+        monitor_task_end(MONITOR_TASK_SERIAL);
+    }
+    if (ticks > taskStepNextRun) {
+        ran = true;
+        monitor_task_begin(MONITOR_TASK_STEP, late_us(taskStepNextRun));
+        steps_task_execute();
+        warm_restart_save();
+        taskStepNextRun += taskStepPeriod;
+        monitor_task_end(MONITOR_TASK_STEP);
+    }
+    if (ticks > taskTestNextRun) {
+        ran = true;
+        monitor_task_begin(MONITOR_TASK_TEST, late_us(taskTestNextRun));
+        test_mode_execute();
+        taskTestNextRun += TASK_TEST_PERIOD_TICKS;
+        monitor_task_end(MONITOR_TASK_TEST);
+    }
+    if (ticks > taskBuzzerNextRun) {
+        ran = true;
+        monitor_task_begin(MONITOR_TASK_BUZZER, late_us(taskBuzzerNextRun));
+        buzzer_execute();
+        taskBuzzerNextRun += TASK_BUZZER_PERIOD_TICKS;
+        monitor_task_end(MONITOR_TASK_BUZZER);
+    }
+    if (ticks > taskAccelerometerNextRun) {
+        ran = true;
+        monitor_task_begin(MONITOR_TASK_ACCELEROMETER, late_us(taskAccelerometerNextRun));
+        accelerometer_execute();
+        // Straight after a sample; page erases wait for stationary (12.5 Hz) or idle sampling
+        flash_log_execute(activity_is_stationary() || !accelerometer_is_processing());
+        taskAccelerometerNextRun += taskAccelerometerPeriod;
+        if (profile_apply_pending()) {  // Between samples, so no sample sees a mixed configuration
+            load_profile_periods(ticks);
+        }
+        monitor_task_end(MONITOR_TASK_ACCELEROMETER);
+    }
+    if (ticks > taskLEDNextRun) {
+        ran = true;
+        monitor_task_begin(MONITOR_TASK_LED, late_us(taskLEDNextRun));
+        LED_execute();
+        taskLEDNextRun += TASK_LED_PERIOD_TICKS;
+        monitor_task_end(MONITOR_TASK_LED);
+    }
+
+    if (ran) {
+        profile_account_busy(pass_start);
+    }
+    monitor_pass_end(pass_start, ran);
+    return ran;
+}
+
+uint32_t app_next_deadline(void)
+{
+    const uint32_t next_runs[] = {
+        taskButtonNextRun, taskDisplayNextRun, taskJoystickNextRun,
+        taskSerialNextRun, taskStepNextRun, taskTestNextRun,
+        taskBuzzerNextRun, taskAccelerometerNextRun, taskLEDNextRun
+    };
+    uint32_t earliest = next_runs[0];
+    uint32_t timer_tick;
+
+    for (uint8_t i = 1; i < sizeof(next_runs) / sizeof(next_runs[0]); i++) {
+        if (next_runs[i] < earliest) earliest = next_runs[i];
+    }
+    earliest += 1;  // Tasks run once the tick has passed their next run time
+
+    if (soft_timer_next_expiry(&timer_tick) && timer_tick < earliest) {
+        earliest = timer_tick;
+    }
+    return earliest;
+}
+
+void app_main(void)
+{
+    app_init();
 
     while (1)
     {
-        buttons_update(); // Must be called frequently to detect button events
-        uint32_t ticks = HAL_GetTick();
+        uint32_t seen = HAL_GetTick();
 
-        if (ticks > taskButtonNextRun) {
-            button_task_execute();
-            taskButtonNextRun += TASK_BUTTON_PERIOD_TICKS;
-        }
-        if (ticks > taskDisplayNextRun) {
-            display_task_execute();
-            taskDisplayNextRun += TASK_DISPLAY_PERIOD_TICKS;
-        }
-        if (ticks > taskJoystickNextRun) {
-            joystick_task_execute();
-            taskJoystickNextRun += TASK_JOYSTICK_PERIOD_TICKS;
-        }
-        if (ticks > taskSerialNextRun) {
-            serial_task_execute();
-            taskSerialNextRun += TASK_SERIAL_PERIOD_TICKS;
-        }
-        if (ticks > taskStepNextRun) {
-            steps_task_execute();
-            taskStepNextRun += TASK_STEP_PERIOD_TICKS;
-        }
-        if (ticks > taskTestNextRun) {
-            test_mode_execute();
-            taskTestNextRun += TASK_TEST_PERIOD_TICKS;
-        }
-        if (ticks > taskBuzzerNextRun) {
-            buzzer_execute();
-            taskBuzzerNextRun += TASK_BUZZER_PERIOD_TICKS;
-        }
-        if (ticks > taskAccelerometerNextRun) {
-            accelerometer_execute();
-            taskAccelerometerNextRun += TASK_ACCELEROMETER_PERIOD_TICKS;
-        }
-        if (ticks > taskLEDNextRun) {
-            LED_execute();
-            taskLEDNextRun += TASK_LED_PERIOD_TICKS;
+        if (!app_step()) {
+            // Nothing was due: sleep until the next interrupt (at the latest, the next SysTick).
+            // Interrupts are masked so one arriving after the check still ends the WFI.
+            __disable_irq();
+            if (HAL_GetTick() == seen) {
+                __WFI();
+            }
+            __enable_irq();
         }
     }
 }
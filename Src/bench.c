@@ -0,0 +1,266 @@
+/*
+ * bench.c
+ *
+ * Microbenchmark kernels. Inputs are a deterministic walking-like signal
+ * (gravity on Z plus a 2 Hz swing and pseudo-random noise), so runs on
+ * different builds see the same data and their numbers can be compared
+ * directly. A sink variable consumes every result so the compiler cannot
+ * drop the work being timed.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "bench.h"
+#include "step_core.h"
+#include "accelerometer.h"
+#include "joystick_math.h"
+#include "imu_lsm6ds.h"
+#include "timebase.h"
+#include "display_task.h"
+
+#define ONE_G              16384
+#define SWING_AMPLITUDE     3000   // Peak dynamic swing of the synthetic signal (raw units)
+#define NOISE_MASK           255   // Noise amplitude (raw units, before centring)
+#define BENCH_RATE_HZ         60   // Sampling rate the private step core is configured for
+#define BENCH_DETECT_HZ        6
+#define CHECK_SAMPLES        128   // Per window length: the walking inputs, then full-range noise
+
+_Static_assert(BENCH_SAMPLES % BENCH_INPUT_SAMPLES == 0, "the batch kernel runs whole passes over the inputs");
+_Static_assert(CHECK_SAMPLES >= BENCH_INPUT_SAMPLES, "the filter check starts with the walking inputs");
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static StepCore core;
+static AveragingFilter scalar_filter;
+static TriAxisFilter batch_filter;
+static int16_t input[BENCH_INPUT_SAMPLES][3];
+static int16_t check_input[CHECK_SAMPLES][3];
+static int16_t batch_output[CHECK_SAMPLES][3];
+static uint32_t check_outputs = 0;
+static uint32_t check_mismatches = 0;
+static uint32_t check_seed = 1u;
+static uint8_t check_length = STEP_CORE_MAX_FILTER_LENGTH + 1;   // Next window length to check
+static uint64_t dynamic_input[BENCH_INPUT_SAMPLES];
+static int16_t vertical_input[BENCH_INPUT_SAMPLES];
+static uint8_t next_kernel = NUM_BENCH_KERNELS;
+static uint32_t timer_overhead = 0;
+static volatile uint32_t sink;
+
+static const char* const kernel_names[NUM_BENCH_KERNELS] = {
+    "filter_apply", "filter_batch", "magnitude", "axis_read", "pipeline",
+    "detect_fixed", "detect_adaptive", "joystick", "format"
+};
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Triangle wave standing in for the step swing: one period per BENCH_INPUT_SAMPLES/2 samples
+static int32_t swing(uint16_t i) {
+    int32_t phase = i % (BENCH_INPUT_SAMPLES / 2);
+    int32_t quarter = BENCH_INPUT_SAMPLES / 8;
+    int32_t ramp = (phase < 2 * quarter) ? phase - quarter : 3 * quarter - phase;
+    return ramp * SWING_AMPLITUDE / quarter;
+}
+
+// Fills the input tables; the dynamic magnitudes and vertical components come from a clean
+// pass through the pipeline
+static void generate_inputs(void) {
+    uint32_t seed = 0x2545F491u;
+
+    for (uint16_t i = 0; i < BENCH_INPUT_SAMPLES; i++) {
+        int16_t noise[3];
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            seed = seed * 1664525u + 1013904223u;  // Numerical Recipes LCG
+            noise[axis] = (int16_t)((seed >> 24) & NOISE_MASK) - (NOISE_MASK / 2);
+        }
+        input[i][0] = noise[0] + (int16_t)(swing(i) / 4);
+        input[i][1] = noise[1];
+        input[i][2] = noise[2] + (int16_t)(ONE_G + swing(i));
+    }
+
+    step_core_init(&core);
+    step_core_configure_sampling(&core, BENCH_RATE_HZ);
+    for (uint16_t i = 0; i < BENCH_INPUT_SAMPLES; i++) {
+        step_core_track_gravity(&core, input[i][0], input[i][1], input[i][2]);
+        FilteredAcceleration output = step_core_filter(&core, input[i][0], input[i][1], input[i][2]);
+        dynamic_input[i] = output.dynamic_magnitude_square;
+        vertical_input[i] = output.vertical_dynamic;
+    }
+}
+
+// Feeds the tri-axis filter and three scalar filters the same samples at one window
+// length and counts the outputs that differ. The second half of the run is full-range
+// noise, which drives the running sums to their extremes, and the batches grow in size
+// so every split of the stream is covered. One length per call keeps each serial task
+// run short; the whole check is about 0.6M cycles
+static void check_tri_filter(uint8_t length) {
+    for (uint16_t i = 0; i < CHECK_SAMPLES; i++) {
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            check_seed = check_seed * 1664525u + 1013904223u;
+            check_input[i][axis] = (i < BENCH_INPUT_SAMPLES) ? input[i][axis] : (int16_t)(check_seed >> 16);
+        }
+    }
+
+    step_core_tri_filter_init(&batch_filter, length);
+    for (uint16_t done = 0, batch = 1; done < CHECK_SAMPLES; done += batch, batch++) {
+        if (batch > CHECK_SAMPLES - done) batch = CHECK_SAMPLES - done;
+        step_core_tri_filter_batch(&batch_filter, &check_input[done], &batch_output[done], batch);
+    }
+
+    AveragingFilter reference[3] = { 0 };
+    for (uint16_t i = 0; i < CHECK_SAMPLES; i++) {
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            check_outputs++;
+            if (step_core_filter_apply(&reference[axis], length, check_input[i][axis]) != batch_output[i][axis]) {
+                check_mismatches++;
+            }
+        }
+    }
+}
+
+// Runs one kernel over its sample count and returns the elapsed cycles
+static uint32_t run_kernel(bench_kernel_t kernel, uint32_t *samples) {
+    char buf[24];
+    uint32_t acc = 0;
+    uint32_t start = 0;
+    uint32_t n = BENCH_SAMPLES;
+
+    switch (kernel) {
+        case BENCH_FILTER_APPLY:
+            scalar_filter = (AveragingFilter){ 0 };
+            step_core_filter_apply(&scalar_filter, core.filter.length, input[0][0]);  // Seeds outside the timing
+            start = timebase_cycles();
+            for (uint32_t i = 0; i < n; i++) {
+                acc += (uint16_t)step_core_filter_apply(&scalar_filter, core.filter.length,
+                                                        input[i % BENCH_INPUT_SAMPLES][0]);
+            }
+            break;
+
+        case BENCH_FILTER_BATCH:
+            step_core_tri_filter_init(&batch_filter, core.filter.length);
+            step_core_tri_filter_batch(&batch_filter, input, batch_output, 1);
+            start = timebase_cycles();
+            for (uint32_t i = 0; i < n; i += BENCH_INPUT_SAMPLES) {
+                step_core_tri_filter_batch(&batch_filter, input, batch_output, BENCH_INPUT_SAMPLES);
+                acc += (uint16_t)batch_output[BENCH_INPUT_SAMPLES - 1][0];
+            }
+            break;
+
+        case BENCH_MAGNITUDE:
+            start = timebase_cycles();
+            for (uint32_t i = 0; i < n; i++) {
+                const int16_t *v = input[i % BENCH_INPUT_SAMPLES];
+                acc += (uint32_t)step_core_magnitude_squared(v[0], v[1], v[2]);
+            }
+            break;
+
+        case BENCH_AXIS_READ:
+            n = BENCH_BUS_SAMPLES;
+            start = timebase_cycles();
+            for (uint32_t i = 0; i < n; i++) {
+                acc += (uint16_t)get_acceleration_axis(OUTX_L_XL, OUTX_H_XL);
+            }
+            break;
+
+        case BENCH_PIPELINE:
+            start = timebase_cycles();
+            for (uint32_t i = 0; i < n; i++) {
+                const int16_t *v = input[i % BENCH_INPUT_SAMPLES];
+                step_core_track_gravity(&core, v[0], v[1], v[2]);
+                acc += (uint32_t)step_core_filter(&core, v[0], v[1], v[2]).dynamic_magnitude_square;
+            }
+            break;
+
+        case BENCH_DETECT_FIXED:
+        case BENCH_DETECT_ADAPTIVE:
+            step_core_configure_detector(&core, BENCH_DETECT_HZ, STEP_DYNAMIC_THRESHOLD);
+            step_core_set_adaptive(&core, kernel == BENCH_DETECT_ADAPTIVE, 0, 0);
+            start = timebase_cycles();
+            for (uint32_t i = 0; i < n; i++) {
+                // 167 ms apart, as the step task would see them, each with the extremes the filter held
+                core.vertical_high = vertical_input[i % BENCH_INPUT_SAMPLES];
+                core.vertical_low = vertical_input[i % BENCH_INPUT_SAMPLES];
+                acc += step_core_detect(&core, dynamic_input[i % BENCH_INPUT_SAMPLES], i * 167);
+            }
+            break;
+
+        case BENCH_JOYSTICK:
+            start = timebase_cycles();
+            for (uint32_t i = 0; i < n; i++) {
+                uint16_t adc = (uint16_t)((i * 16) & 0x0FFF);  // Sweeps the 12-bit range
+                acc += calculate_x_percentage(adc) + calculate_y_percentage(adc) +
+                       calculate_potentiometer_percentage(adc);
+            }
+            break;
+
+        case BENCH_FORMAT:
+            // The display task's own formatters, on the live count, goal and distance
+            n = BENCH_FORMAT_SAMPLES;
+            start = timebase_cycles();
+            for (uint32_t i = 0; i < n; i++) {
+                display_format_steps(buf, sizeof(buf));
+                acc += (uint8_t)buf[0];
+                display_format_distance(buf, sizeof(buf));
+                acc += (uint8_t)buf[0];
+                display_format_progress(buf, sizeof(buf));
+                acc += (uint8_t)buf[0];
+                display_format_cadence(buf, sizeof(buf));
+                acc += (uint8_t)buf[0];
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    uint32_t elapsed = timebase_cycles() - start;
+    sink = acc;
+    *samples = n;
+    return (elapsed > timer_overhead) ? elapsed - timer_overhead : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void bench_start(void) {
+    generate_inputs();
+    check_outputs = 0;
+    check_mismatches = 0;
+    check_seed = 1u;
+    check_length = 1;
+
+    // Cost of the stamp pair itself, subtracted from every result
+    uint32_t start = timebase_cycles();
+    timer_overhead = timebase_cycles() - start;
+
+    next_kernel = 0;
+}
+
+bool bench_is_running(void) {
+    return check_length <= STEP_CORE_MAX_FILTER_LENGTH || next_kernel < NUM_BENCH_KERNELS;
+}
+
+bool bench_run_next(BenchResult *result) {
+    if (!bench_is_running()) return false;
+
+    // The filter check goes first, one window length per call, so the last call is a kernel
+    if (check_length <= STEP_CORE_MAX_FILTER_LENGTH) {
+        check_tri_filter(check_length++);
+        return false;
+    }
+
+    bench_kernel_t kernel = (bench_kernel_t)next_kernel++;
+    result->name = kernel_names[kernel];
+    result->cycles = run_kernel(kernel, &result->samples);
+    return true;
+}
+
+uint32_t bench_filter_check(uint32_t *mismatches) {
+    *mismatches = check_mismatches;
+    return check_outputs;
+}
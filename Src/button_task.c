@@ -4,6 +4,7 @@
  * Handles all button input and associated actions:
  * - UP button increments step count (unless setting goal)
  * - DOWN button toggles serial on single press, test mode on double press
+ * - RIGHT/LEFT buttons select the next/previous performance profile
  *
  * Created on: Mar 12, 2025
  * Author: eaz11 & gjo77
@@ -18,6 +19,7 @@
 #include "goal_tracker.h"
 #include "test_mode.h"
 #include "step_detection.h"
+#include "profile.h"
 
 static DoublePressTracker downTracker = {0};
 
@@ -31,19 +33,17 @@ static void handle_left_button(void);
 // Returns true if button was double-pressed within threshold time
 static bool check_double_press(DoublePressTracker *tracker)
 {
-    uint32_t currentTime = HAL_GetTick();
-
-    if (currentTime - tracker->lastPressTime < DOUBLE_PRESS_THRESHOLD_MS) {
+    if (soft_timer_is_active(&tracker->window)) {
         tracker->pressCount++;
-        tracker->lastPressTime = currentTime;
-
-        if (tracker->pressCount == 2) {
-            tracker->pressCount = 0;
-            return true;
-        }
     } else {
         tracker->pressCount = 1;
-        tracker->lastPressTime = currentTime;
+    }
+    soft_timer_start(&tracker->window, DOUBLE_PRESS_THRESHOLD_MS, 0, NULL);
+
+    if (tracker->pressCount == 2) {
+        tracker->pressCount = 0;
+        soft_timer_cancel(&tracker->window);
+        return true;
     }
 
     return false;
@@ -68,19 +68,19 @@ static void handle_down_button(void)
     }
 }
 
-// Placeholder for RIGHT button
+// Handles RIGHT button logic (next performance profile)
 static void handle_right_button(void)
 {
     if (buttons_checkButton(RIGHT) == PUSHED) {
-        // Future functionality
+        profile_request_next();
     }
 }
 
-// Placeholder for LEFT button
+// Handles LEFT button logic (previous performance profile)
 static void handle_left_button(void)
 {
     if (buttons_checkButton(LEFT) == PUSHED) {
-        // Future functionality
+        profile_request_previous();
     }
 }
 
@@ -1,8 +1,11 @@
 /*
  * buzzer.c
  *
- * Plays a celebratory tune when the step goal is reached.
- * Uses non-blocking state machine with timer-driven melody playback.
+ * Plays a celebratory tune when the step goal is reached, and a short chirp
+ * when a new goal is saved. Melodies are tables of TIM16 period values built
+ * at compile time. TIM16's update interrupt counts each note's cycles and
+ * loads the next note into the preload registers, so notes change on an exact
+ * period boundary and playback costs the main loop nothing.
  *
  * Created on: Apr 4, 2025
  * Author: eaz11 & gjo77
@@ -13,9 +16,14 @@
 #include "goal_tracker.h"
 #include "test_mode.h"
 #include "step_detection.h"
+#include "flash_log.h"
 #include <stdint.h>
 #include <stdbool.h>
 
+// -----------------------------------------------------------------------------
+// Constants
+// -----------------------------------------------------------------------------
+
 // Notes (frequencies in Hz)
 #define NOTE_C3  131
 #define NOTE_D3  147
@@ -32,70 +40,144 @@
 #define NOTE_A4  440
 #define NOTE_B4  494
 #define NOTE_C5  523
-#define REST     0
 
-// Melody and note durations
-static const uint16_t melody[] = {
-    NOTE_E4, NOTE_E4, REST, NOTE_E4, REST, NOTE_C4, NOTE_E4, REST,
-    NOTE_G4, REST, REST, NOTE_G3
+#define BUZZER_TICK_HZ   1000000u   // TIM16 counter rate after the prescaler
+#define BUZZER_REST_HZ   1000u      // Period the timer keeps counting at (silently) during a rest
+
+_Static_assert(BUZZER_TICK_HZ / NOTE_C3 <= 65536u, "lowest note must fit TIM16's 16-bit period");
+
+typedef struct {
+    uint16_t period;    // ARR value: counter ticks per cycle - 1
+    uint16_t cycles;    // Cycles (update events) the note lasts; at least 1
+    bool silent;
+} BuzzerNote;
+
+// A note lasting MS milliseconds, and a rest of the same length
+#define TONE(HZ, MS)  { .period = (BUZZER_TICK_HZ / (HZ)) - 1, .cycles = ((HZ) * (MS)) / 1000, .silent = false }
+#define REST(MS)      { .period = (BUZZER_TICK_HZ / BUZZER_REST_HZ) - 1, .cycles = (BUZZER_REST_HZ * (MS)) / 1000, .silent = true }
+
+static const BuzzerNote goal_melody[] = {
+    TONE(NOTE_E4, 150), TONE(NOTE_E4, 150), REST(100), TONE(NOTE_E4, 150), REST(100),
+    TONE(NOTE_C4, 150), TONE(NOTE_E4, 150), REST(100), TONE(NOTE_G4, 300), REST(300),
+    TONE(NOTE_G3, 200)
+};
+
+static const BuzzerNote confirm_melody[] = {
+    TONE(NOTE_G4, 60), TONE(NOTE_C5, 90)
+};
+
+static const struct {
+    const BuzzerNote *notes;
+    uint8_t length;
+} melodies[NUM_BUZZER_MELODIES] = {
+    [BUZZER_MELODY_GOAL]    = { goal_melody,    sizeof(goal_melody) / sizeof(goal_melody[0]) },
+    [BUZZER_MELODY_CONFIRM] = { confirm_melody, sizeof(confirm_melody) / sizeof(confirm_melody[0]) },
 };
 
-static const uint16_t durations[] = {
-    150, 150, 100, 150, 100, 150, 150, 100, 300, 200, 100, 200
+// Duty cycle as a right shift of the period: 50%, 12.5% and 3%
+static const uint8_t volume_shift[NUM_BUZZER_VOLUMES] = {
+    [BUZZER_VOLUME_LOW]    = 5,
+    [BUZZER_VOLUME_MEDIUM] = 3,
+    [BUZZER_VOLUME_HIGH]   = 1,
 };
 
-static const uint8_t melody_length = sizeof(melody) / sizeof(melody[0]);
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
 
-// Melody state
 static bool tune_played = false;
-static bool melody_active = false;
-static uint32_t next_note_time = 0;
-static uint8_t current_note_index = 0;
-
-// Sets buzzer frequency using TIM16 PWM
-static void set_buzzer_freq(uint16_t freq) {
-    uint32_t timer_clk = HAL_RCC_GetPCLK1Freq();
-    uint32_t period = (timer_clk / freq) - 1;
-
-    __HAL_TIM_SET_AUTORELOAD(&htim16, period);
-    __HAL_TIM_SET_COMPARE(&htim16, TIM_CHANNEL_1, period / 2);
-    __HAL_TIM_SET_PRESCALER(&htim16, 0);
-    HAL_TIM_GenerateEvent(&htim16, TIM_EVENTSOURCE_UPDATE);
+static buzzer_volume_t volume = BUZZER_VOLUME_HIGH;
+
+// Shared with the update interrupt
+static const BuzzerNote *volatile playing = NULL;  // Note currently sounding; NULL when idle
+static const BuzzerNote *melody_end = NULL;
+static volatile uint16_t cycles_left = 0;          // Update events until 'playing' ends
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Writes a note (or silence past the end) to the preload registers; it takes over at the next update
+static void preload(const BuzzerNote *note) {
+    if (note == melody_end) {
+        __HAL_TIM_SET_COMPARE(&htim16, TIM_CHANNEL_1, 0);
+        return;
+    }
+
+    __HAL_TIM_SET_AUTORELOAD(&htim16, note->period);
+    __HAL_TIM_SET_COMPARE(&htim16, TIM_CHANNEL_1, note->silent ? 0 : (uint32_t)(note->period + 1) >> volume_shift[volume]);
+}
+
+// Stops the timer and the sequence
+static void halt(void) {
+    __HAL_TIM_DISABLE_IT(&htim16, TIM_IT_UPDATE);
+    HAL_TIM_PWM_Stop(&htim16, TIM_CHANNEL_1);
+    playing = NULL;
 }
 
-// Non-blocking state machine to play melody
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+// Sets TIM16 to count at BUZZER_TICK_HZ with buffered period and compare registers
+void buzzer_init(void) {
+    __HAL_TIM_SET_PRESCALER(&htim16, HAL_RCC_GetPCLK1Freq() / BUZZER_TICK_HZ - 1);
+    htim16.Instance->CR1 |= TIM_CR1_ARPE;
+}
+
+// Starts the melody once per goal reached; the timer interrupt plays it
 void buzzer_execute(void) {
-    uint16_t steps = get_steps();
+    uint32_t steps = get_steps();
     uint16_t goal = get_goal();
 
     if (steps >= goal && !tune_played && !check_set_goal_state()) {
         tune_played = true;
-        melody_active = true;
-        current_note_index = 0;
-        next_note_time = HAL_GetTick(); // Start immediately
+        buzzer_play(BUZZER_MELODY_GOAL);
     } else if (steps < goal) {
         tune_played = false; // Reset if goal is no longer reached
     }
+}
 
-    if (melody_active && HAL_GetTick() >= next_note_time) {
-        if (current_note_index < melody_length) {
-            uint16_t note = melody[current_note_index];
-            uint16_t duration = durations[current_note_index];
-
-            if (note == REST) {
-                buzzer_stop();
-            } else {
-                set_buzzer_freq(note);
-                buzzer_start();
-            }
-
-            next_note_time = HAL_GetTick() + duration;
-            current_note_index++;
-        } else {
-            buzzer_stop();
-            melody_active = false;
-        }
-    }
+// Plays a melody from its first note, replacing any melody in progress
+void buzzer_play(buzzer_melody_t melody) {
+    if (melody >= NUM_BUZZER_MELODIES) return;
+
+    halt();
+    melody_end = melodies[melody].notes + melodies[melody].length;
+
+    // Load the first note straight into the active registers
+    preload(melodies[melody].notes);
+    HAL_TIM_GenerateEvent(&htim16, TIM_EVENTSOURCE_UPDATE);
+    __HAL_TIM_CLEAR_FLAG(&htim16, TIM_FLAG_UPDATE);
+
+    cycles_left = melodies[melody].notes->cycles;
+    playing = melodies[melody].notes;
+    if (cycles_left == 1) preload(playing + 1);
+
+    __HAL_TIM_ENABLE_IT(&htim16, TIM_IT_UPDATE);
+    HAL_TIM_PWM_Start(&htim16, TIM_CHANNEL_1);
+}
+
+bool buzzer_is_playing(void) {
+    return playing != NULL;
+}
+
+// Takes effect from the next note
+void buzzer_set_volume(buzzer_volume_t level) {
+    if ((unsigned)level >= NUM_BUZZER_VOLUMES) return;
+
+    volume = level;
+    flash_log_set_setting(FLASH_LOG_SETTING_BUZZER_VOLUME, (uint8_t)(BUZZER_VOLUME_HIGH - level));
+}
+
+buzzer_volume_t buzzer_get_volume(void) {
+    return volume;
+}
+
+// Stored as steps below high, so a log without the setting (0) keeps the old full volume
+void buzzer_restore_volume(void) {
+    uint8_t below_high = flash_log_get_setting(FLASH_LOG_SETTING_BUZZER_VOLUME);
+    volume = (below_high <= BUZZER_VOLUME_HIGH) ? (buzzer_volume_t)(BUZZER_VOLUME_HIGH - below_high) : BUZZER_VOLUME_HIGH;
 }
 
 // Starts buzzer using current timer settings
@@ -104,7 +186,26 @@ void buzzer_start(void) {
     HAL_TIM_PWM_Start(&htim16, TIM_CHANNEL_1);
 }
 
-// Stops buzzer output
+// Stops buzzer output and any melody in progress
 void buzzer_stop(void) {
-    HAL_TIM_PWM_Stop(&htim16, TIM_CHANNEL_1);
+    halt();
+}
+
+// TIM16 update: one cycle of the sounding note has ended. The next note is
+// preloaded one cycle ahead, so the registers switch at exactly the right edge.
+// (No other module handles timer update interrupts; add a dispatch here if one does.)
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+    if (htim->Instance != TIM16 || playing == NULL) return;
+
+    if (--cycles_left == 0) {
+        playing++;
+        if (playing == melody_end) {
+            halt();
+            return;
+        }
+        cycles_left = playing->cycles;
+    }
+    if (cycles_left == 1) {
+        preload(playing + 1);
+    }
 }
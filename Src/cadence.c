@@ -0,0 +1,154 @@
+/*
+ * cadence.c
+ *
+ * Goertzel filter bank for cadence. Each bin keeps two int32 state words and
+ * a Q14 coefficient 2cos(2*pi*f/fs); the per-sample update is split so it only
+ * needs 32-bit multiplies on the Cortex-M0+. Bin power is evaluated once per
+ * window; the strongest bin is refined by parabolic interpolation and accepted
+ * only if it clearly stands out from the rest of the bank.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "cadence.h"
+#include "timebase.h"
+
+#define COEFF_SHIFT          14
+#define COEFF_MASK           ((1 << COEFF_SHIFT) - 1)
+#define INPUT_SHIFT           4      // Inputs in units of 16 raw (~1 mg) keep the states well inside int32
+#define INPUT_LIMIT        1023
+#define MIN_PEAK_TO_MEAN      4      // Peak bin power must be at least this multiple of the bank mean
+#define MIN_PEAK_POWER   100000      // Rejects windows with no real movement
+#define Q30_ONE          (1LL << 30)
+#define TWO_PI_Q30       6746518852LL  // 2*pi * 2^30
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static int32_t coeff[CADENCE_BINS];        // Q14 2cos(theta)
+static int32_t s1[CADENCE_BINS];
+static int32_t s2[CADENCE_BINS];
+static uint16_t window_samples = 0;
+static uint16_t sample_index = 0;
+static uint16_t cadence_spm = 0;
+static CadenceStats stats;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// 2cos(theta) in Q14 for 0 <= theta <= ~1 rad (Taylor series to theta^8 in Q30; configuration time only)
+static int32_t two_cos_q14(int64_t theta_q30) {
+    int64_t theta2 = (theta_q30 * theta_q30) >> 30;
+    int64_t term = Q30_ONE;
+    int64_t sum = Q30_ONE;
+
+    for (int32_t k = 1; k <= 4; k++) {
+        term = -((term * theta2) >> 30) / ((2 * k - 1) * (2 * k));
+        sum += term;
+    }
+    return (int32_t)((2 * sum + (1LL << (30 - COEFF_SHIFT - 1))) >> (30 - COEFF_SHIFT));
+}
+
+// Goertzel power for one bin, scaled down to keep the bank comparison in 64 bits
+static int64_t bin_power(uint8_t bin) {
+    int64_t a = s1[bin], b = s2[bin];
+    int64_t power = a * a + b * b - ((coeff[bin] * a) >> COEFF_SHIFT) * b;
+    return power >> 8;
+}
+
+// Picks the dominant bin of the finished window and converts it to steps per minute
+static void evaluate_window(void) {
+    int64_t power[CADENCE_BINS];
+    int64_t total = 0;
+    uint8_t peak = 0;
+
+    for (uint8_t bin = 0; bin < CADENCE_BINS; bin++) {
+        power[bin] = bin_power(bin);
+        total += power[bin];
+        if (power[bin] > power[peak]) peak = bin;
+    }
+
+    if (power[peak] < MIN_PEAK_POWER || power[peak] * CADENCE_BINS < total * MIN_PEAK_TO_MEAN) {
+        cadence_spm = 0;
+        return;
+    }
+
+    // Parabolic interpolation between neighbouring bins (in hundredths of a bin)
+    int32_t offset = 0;
+    if (peak > 0 && peak < CADENCE_BINS - 1) {
+        int64_t left = power[peak - 1], centre = power[peak], right = power[peak + 1];
+        int64_t denominator = 2 * (2 * centre - left - right);
+        if (denominator > 0) {
+            offset = (int32_t)(((right - left) * 100) / denominator);
+        }
+    }
+
+    int32_t frequency_chz = CADENCE_MIN_CHZ + peak * CADENCE_STEP_CHZ + (offset * CADENCE_STEP_CHZ) / 100;
+    cadence_spm = (uint16_t)((frequency_chz * 60 + 50) / 100);
+}
+
+static void clear_bank(void) {
+    for (uint8_t bin = 0; bin < CADENCE_BINS; bin++) {
+        s1[bin] = 0;
+        s2[bin] = 0;
+    }
+    sample_index = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void cadence_configure(uint32_t sample_rate_chz) {
+    if (sample_rate_chz == 0) return;
+
+    for (uint8_t bin = 0; bin < CADENCE_BINS; bin++) {
+        int64_t frequency_chz = CADENCE_MIN_CHZ + bin * CADENCE_STEP_CHZ;
+        coeff[bin] = two_cos_q14((TWO_PI_Q30 * frequency_chz) / sample_rate_chz);
+    }
+    window_samples = (uint16_t)(((uint64_t)CADENCE_WINDOW_MS * sample_rate_chz + 50000) / 100000);
+    cadence_reset();
+}
+
+void cadence_reset(void) {
+    clear_bank();
+    cadence_spm = 0;
+}
+
+void cadence_push(int16_t vertical) {
+    uint32_t start = timebase_cycles();
+
+    int32_t x = vertical >> INPUT_SHIFT;
+    if (x > INPUT_LIMIT) x = INPUT_LIMIT;
+    if (x < -INPUT_LIMIT) x = -INPUT_LIMIT;
+
+    for (uint8_t bin = 0; bin < CADENCE_BINS; bin++) {
+        // coeff * s1 >> 14, split into high and low parts so both products fit in 32 bits
+        int32_t high = s1[bin] >> COEFF_SHIFT;
+        int32_t low = s1[bin] & COEFF_MASK;
+        int32_t feedback = coeff[bin] * high + ((coeff[bin] * low) >> COEFF_SHIFT);
+
+        int32_t s0 = x + feedback - s2[bin];
+        s2[bin] = s1[bin];
+        s1[bin] = s0;
+    }
+
+    if (++sample_index >= window_samples) {
+        evaluate_window();
+        clear_bank();
+    }
+
+    stats.cycles += timebase_cycles() - start;
+    stats.samples++;
+}
+
+uint16_t cadence_get_spm(void) {
+    return cadence_spm;
+}
+
+CadenceStats cadence_get_stats(void) {
+    return stats;
+}
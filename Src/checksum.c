@@ -0,0 +1,27 @@
+/*
+ * checksum.c
+ *
+ * Bitwise CRC-16/CCITT-FALSE. Records are short (tens of bytes), so a
+ * table-free implementation keeps flash usage down without a noticeable cost.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "checksum.h"
+
+#define CRC16_POLY  0x1021
+#define CRC16_INIT  0xFFFF
+
+uint16_t crc16_ccitt(const void *data, size_t length) {
+    const uint8_t *bytes = (const uint8_t*)data;
+    uint16_t crc = CRC16_INIT;
+
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)bytes[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ CRC16_POLY) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,67 @@
+/*
+ * cic_decimator.c
+ *
+ * Order-3 CIC decimator. Integrators run at the input rate, combs at the output
+ * rate. The DC gain ratio^3 is removed with one 32x32->64 multiply per output,
+ * so no division is needed on the Cortex-M0+. The first CIC_ORDER outputs after
+ * a reset come from a partly filled pipeline and are discarded.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "cic_decimator.h"
+
+void cic_init(CicDecimator *cic, uint8_t ratio) {
+    if (ratio == 0) ratio = 1;
+    if (ratio > CIC_MAX_RATIO) ratio = CIC_MAX_RATIO;
+
+    for (uint8_t stage = 0; stage < CIC_ORDER; stage++) {
+        cic->integrator[stage] = 0;
+        cic->comb_delay[stage] = 0;
+    }
+
+    uint32_t gain = 1;
+    for (uint8_t stage = 0; stage < CIC_ORDER; stage++) {
+        gain *= ratio;
+    }
+    // Configuration time only; gain 1 (ratio 1) saturates to the largest reciprocal
+    uint64_t reciprocal = ((1ULL << 32) + gain / 2) / gain;
+    cic->gain_reciprocal = (reciprocal > UINT32_MAX) ? UINT32_MAX : (uint32_t)reciprocal;
+
+    cic->ratio = ratio;
+    cic->phase = 0;
+    cic->warmup = CIC_ORDER;
+}
+
+bool cic_push(CicDecimator *cic, int16_t in, int16_t *out) {
+    // Integrators: additions only, wrapping modulo 2^32
+    uint32_t acc = (uint32_t)(int32_t)in;
+    for (uint8_t stage = 0; stage < CIC_ORDER; stage++) {
+        cic->integrator[stage] += acc;
+        acc = cic->integrator[stage];
+    }
+
+    if (++cic->phase < cic->ratio) return false;
+    cic->phase = 0;
+
+    // Combs at the output rate
+    for (uint8_t stage = 0; stage < CIC_ORDER; stage++) {
+        uint32_t delayed = cic->comb_delay[stage];
+        cic->comb_delay[stage] = acc;
+        acc -= delayed;
+    }
+
+    if (cic->warmup > 0) {
+        cic->warmup--;
+        return false;
+    }
+
+    if (cic->ratio == 1) {
+        *out = (int16_t)(int32_t)acc;
+    } else {
+        int64_t scaled = (int64_t)(int32_t)acc * cic->gain_reciprocal + (1LL << 31);
+        *out = (int16_t)(scaled >> 32);
+    }
+    return true;
+}
@@ -0,0 +1,78 @@
+/*
+ * display_format.c
+ *
+ * Main screen line formatting. The goal percentage avoids a 64-bit division:
+ * whole goals and the remainder's hundredths each come from a cached 32-bit
+ * reciprocal of the goal, corrected by at most two subtractions.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "display_format.h"
+#include <stdio.h>
+
+// floor((2^32 - 1) / goal), refreshed only when the goal changes
+static uint16_t percent_goal = 0;
+static uint32_t percent_reciprocal = 0;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// floor(n / percent_goal): the reciprocal estimate is never high and at most two low
+static uint32_t divide_by_goal(uint32_t n) {
+    uint32_t q = (uint32_t)(((uint64_t)n * percent_reciprocal) >> 32);
+    uint32_t r = n - q * percent_goal;
+    while (r >= percent_goal) {
+        q++;
+        r -= percent_goal;
+    }
+    return q;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+uint32_t format_percent(uint32_t value, uint16_t goal) {
+    if (goal == 0) return 0;
+    if (goal != percent_goal) {
+        percent_goal = goal;
+        percent_reciprocal = UINT32_MAX / goal;
+    }
+
+    uint32_t whole = divide_by_goal(value);
+    if (whole > UINT32_MAX / 100) return UINT32_MAX;
+    uint32_t remainder = value - whole * goal;
+    return whole * 100 + divide_by_goal(remainder * 100);
+}
+
+void format_steps(char *buf, size_t size, uint32_t steps, uint16_t goal, bool percent) {
+    if (percent)
+        snprintf(buf, size, "%lu%%", (unsigned long)format_percent(steps, goal));
+    else
+        snprintf(buf, size, "%lu steps", (unsigned long)steps);
+}
+
+void format_distance_km(char *buf, size_t size, uint32_t km, uint16_t metres) {
+    snprintf(buf, size, "%lu.%03u km", (unsigned long)km, metres);
+}
+
+void format_distance_yards(char *buf, size_t size, uint32_t yards) {
+    snprintf(buf, size, "%lu yd", (unsigned long)yards);
+}
+
+void format_progress(char *buf, size_t size, uint32_t steps, uint16_t goal, bool percent) {
+    if (percent)
+        snprintf(buf, size, "%lu%%", (unsigned long)format_percent(steps, goal));
+    else
+        snprintf(buf, size, "%lu/%u", (unsigned long)steps, goal);
+}
+
+void format_cadence(char *buf, size_t size, uint16_t spm) {
+    if (spm > 0)
+        snprintf(buf, size, "%u steps/min", spm);
+    else
+        snprintf(buf, size, "-- steps/min");
+}
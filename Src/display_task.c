@@ -3,12 +3,17 @@
  *
  * Manages OLED content rendering based on UI state.
  * Handles test mode, goal setting, and main display states.
+ * While the wearer is stationary the screen is only redrawn when its content changes.
+ * The new profile name is shown along the bottom line for a moment after a switch.
+ * The hidden diagnostics screen shows CPU load, stack high-water mark and per-task load.
+ * A flush is skipped (and retried next run) when the display does not answer a bounded probe.
  *
  * Created on: Mar 12, 2025
  * Author: eaz11 & gjo77
  */
 
 #include "display_task.h"
+#include "display_format.h"
 #include "ssd1306.h"
 #include "ssd1306_fonts.h"
 #include "joystick_task.h"
@@ -17,20 +22,42 @@
 #include "goal_tracker.h"
 #include "test_mode.h"
 #include "step_detection.h"
+#include "distance.h"
+#include "activity.h"
+#include "profile.h"
+#include "cadence.h"
+#include "trace.h"
+#include "monitor.h"
+#include "i2c_bus.h"
 #include <string.h>
 
 // --- Local Prototypes ---
 static void display_draw_test_mode(void);
 static void display_draw_set_goal(void);
 static void display_draw_main_screen(void);
-static uint8_t calculate_percent(uint16_t value, uint16_t goal);
-static void format_steps(char *buf, size_t size);
-static void format_distance(char *buf, size_t size);
-static void format_progress(char *buf, size_t size);
+static void display_draw_diagnostics(void);
+static bool display_content_changed(void);
 
 // Display mode toggle flag (true = percentage/km, false = raw/yd)
 static bool display_mode;
 
+// Inputs the current frame was drawn from
+typedef struct {
+    uint32_t steps;
+    uint16_t goal;
+    uint8_t screen;
+    bool mode;
+    bool test_mode;
+    bool set_goal;
+    uint8_t profile;
+    bool profile_banner;
+    uint16_t cadence;
+    uint32_t monitor_windows;   // Only tracked on the diagnostics screen, so it redraws once per window
+} DisplayContent;
+
+static DisplayContent drawn_content;
+static bool flush_missed = false;   // The last frame never reached the panel
+
 // --- Public Functions ---
 
 void display_task_init(void) {
@@ -39,31 +66,69 @@ void display_task_init(void) {
 }
 
 void display_task_execute(void) {
+    bool changed = display_content_changed() || flush_missed;
+    if (activity_is_stationary() && !changed) return;
+
     ssd1306_Fill(Black);
 
     if (check_test_mode())
         display_draw_test_mode();
     else if (check_set_goal_state())
         display_draw_set_goal();
+    else if (fsm_get_current_state() == DISPLAY_DIAGNOSTICS)
+        display_draw_diagnostics();
     else
         display_draw_main_screen();
 
+    if (drawn_content.profile_banner) {
+        ssd1306_SetCursor(0, 56);
+        ssd1306_WriteString((char*)profile_get()->name, Font_6x8, White);
+    }
+
+    // The driver's own transfers have no time budget, so only start one on a bus that answers
+    flush_missed = (i2c_bus_probe(I2C_DEVICE_DISPLAY) != I2C_BUS_OK);
+    if (flush_missed) return;
+
+    trace_begin(TRACE_DISPLAY_FLUSH, 0);
     ssd1306_UpdateScreen();
+    trace_end(TRACE_DISPLAY_FLUSH, 0);
 }
 
 void display_toggle(void) {
     display_mode = !display_mode;
 }
 
+// --- Private Helpers ---
+
+// Captures the values the screen depends on; returns true if any differ from the last frame
+static bool display_content_changed(void) {
+    DisplayContent now;
+    memset(&now, 0, sizeof(now));  // Padding must compare equal
+    now.steps = get_steps();
+    now.goal = get_goal();
+    now.screen = (uint8_t)fsm_get_current_state();
+    now.mode = display_mode;
+    now.test_mode = check_test_mode();
+    now.set_goal = check_set_goal_state();
+    now.profile = (uint8_t)profile_get_id();
+    now.profile_banner = profile_banner_visible();
+    now.cadence = cadence_get_spm();
+    if (now.screen == DISPLAY_DIAGNOSTICS) now.monitor_windows = monitor_get_stats().windows;
+
+    if (memcmp(&now, &drawn_content, sizeof(now)) == 0) return false;
+    drawn_content = now;
+    return true;
+}
+
 // --- Private Drawing Functions ---
 
 static void display_draw_test_mode(void) {
-    char buf[20];
+    char buf[24];   // "Steps RN: " and a 10-digit count
 
     ssd1306_SetCursor(0, 0);
     ssd1306_WriteString("=== TEST MODE ===", Font_7x10, White);
 
-    snprintf(buf, sizeof(buf), "Steps RN: %u", get_steps());
+    snprintf(buf, sizeof(buf), "Steps RN: %lu", (unsigned long)get_steps());
     ssd1306_SetCursor(0, 12);
     ssd1306_WriteString(buf, Font_7x10, White);
 
@@ -81,7 +146,7 @@ static void display_draw_set_goal(void) {
     ssd1306_SetCursor(0, 0);
     ssd1306_WriteString("Set Step Goal:", Font_7x10, White);
 
-    snprintf(buf, sizeof(buf), "%u/%u", get_steps(), get_goal());
+    snprintf(buf, sizeof(buf), "%lu/%u", (unsigned long)get_steps(), get_goal());
     ssd1306_SetCursor(0, 12);
     ssd1306_WriteString(buf, Font_11x18, White);
 }
@@ -94,19 +159,22 @@ static void display_draw_main_screen(void) {
         case DISPLAY_STEPS:
             ssd1306_SetCursor(0, 0);
             ssd1306_WriteString("Steps:", Font_7x10, White);
-            format_steps(buf, sizeof(buf));
+            display_format_cadence(buf, sizeof(buf));
+            ssd1306_SetCursor(0, 36);
+            ssd1306_WriteString(buf, Font_7x10, White);
+            display_format_steps(buf, sizeof(buf));
             break;
 
         case DISPLAY_DISTANCE:
             ssd1306_SetCursor(0, 0);
             ssd1306_WriteString("Distance:", Font_7x10, White);
-            format_distance(buf, sizeof(buf));
+            display_format_distance(buf, sizeof(buf));
             break;
 
         case DISPLAY_GOAL_PROGRESS:
             ssd1306_SetCursor(0, 0);
             ssd1306_WriteString("Goal Progress:", Font_7x10, White);
-            format_progress(buf, sizeof(buf));
+            display_format_progress(buf, sizeof(buf));
 
             if (!display_mode) {
                 ssd1306_SetCursor(0, 36);
@@ -124,31 +192,58 @@ static void display_draw_main_screen(void) {
     ssd1306_WriteString(buf, Font_11x18, White);
 }
 
-// --- Private Formatting Functions ---
+// CPU load (this window and peak), stack high-water mark, then two tasks per line
+static void display_draw_diagnostics(void) {
+    char buf[32];   // Room for the widest line at full 32-bit values; the screen shows 21 characters
+    MonitorStats stats = monitor_get_stats();
 
-static uint8_t calculate_percent(uint16_t value, uint16_t goal) {
-    return (goal == 0) ? 0 : (value * 100) / goal;
+    ssd1306_SetCursor(0, 0);
+    ssd1306_WriteString("== DIAGNOSTICS ==", Font_6x8, White);
+
+    snprintf(buf, sizeof(buf), "CPU %u.%u%% pk %u.%u%%",
+        stats.load_permille / 10, stats.load_permille % 10,
+        stats.peak_load_permille / 10, stats.peak_load_permille % 10);
+    ssd1306_SetCursor(0, 8);
+    ssd1306_WriteString(buf, Font_6x8, White);
+
+    snprintf(buf, sizeof(buf), "Stack %lu/%lu B", (unsigned long)stats.stack_used, (unsigned long)stats.stack_size);
+    ssd1306_SetCursor(0, 16);
+    ssd1306_WriteString(buf, Font_6x8, White);
+
+    for (uint8_t task = 0; task < NUM_MONITOR_TASKS; task += 2) {
+        uint16_t left = stats.task_permille[task];
+        int len = snprintf(buf, sizeof(buf), "%-4s%3u.%u%%", monitor_task_name((monitor_task_t)task), left / 10, left % 10);
+        if (task + 1 < NUM_MONITOR_TASKS) {
+            uint16_t right = stats.task_permille[task + 1];
+            snprintf(buf + len, sizeof(buf) - len, " %-4s%3u.%u%%",
+                monitor_task_name((monitor_task_t)(task + 1)), right / 10, right % 10);
+        }
+        ssd1306_SetCursor(0, 24 + (task / 2) * 8);
+        ssd1306_WriteString(buf, Font_6x8, White);
+    }
 }
 
-static void format_steps(char *buf, size_t size) {
-    if (display_mode)
-        snprintf(buf, size, "%u%%", calculate_percent(get_steps(), get_goal()));
-    else
-        snprintf(buf, size, "%u steps", get_steps());
+// --- Formatting Functions ---
+
+void display_format_steps(char *buf, size_t size) {
+    format_steps(buf, size, get_steps(), get_goal(), display_mode);
 }
 
-static void format_distance(char *buf, size_t size) {
+void display_format_distance(char *buf, size_t size) {
     if (display_mode)
-        snprintf(buf, size, "%u yd", get_distance_yards());
+        format_distance_yards(buf, size, get_distance_yards());
     else {
-        uint16_t metres = get_distance_metres();
-        snprintf(buf, size, "%u.%03u km", metres / 1000, metres % 1000);
+        uint32_t km;
+        uint16_t metres;
+        distance_get_km(&km, &metres);
+        format_distance_km(buf, size, km, metres);
     }
 }
 
-static void format_progress(char *buf, size_t size) {
-    if (display_mode)
-        snprintf(buf, size, "%u%%", calculate_percent(get_steps(), get_goal()));
-    else
-        snprintf(buf, size, "%u/%u", get_steps(), get_goal());
+void display_format_progress(char *buf, size_t size) {
+    format_progress(buf, size, get_steps(), get_goal(), display_mode);
+}
+
+void display_format_cadence(char *buf, size_t size) {
+    format_cadence(buf, size, cadence_get_spm());
 }
@@ -0,0 +1,113 @@
+/*
+ * distance.c
+ *
+ * Fixed-point distance conversions for the step counter.
+ * The Cortex-M0+ has no hardware divider, so every conversion is a 32x32->64
+ * multiply by a precomputed reciprocal followed by a shift. Each constant was
+ * checked exhaustively against integer division over its full input range.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "distance.h"
+
+// -----------------------------------------------------------------------------
+// Reciprocal constants: floor(n / d) == (n * M) >> S over the stated range
+// -----------------------------------------------------------------------------
+
+#define RECIP_DIV_1000_M         0x10624DD3u  // d = 1000,   n < 2^32
+#define RECIP_DIV_1000_S         38
+#define RECIP_DIV_1143_M         0x39563AAFu  // d = 1143,   n < 2^30 (n/4572 == (n>>2)/1143)
+#define RECIP_DIV_1143_S         40
+#define RECIP_DIV_4572_SMALL_M   0x72ADu      // d = 4572,   n <= 22860
+#define RECIP_DIV_4572_SMALL_S   27
+#define RECIP_DIV_201168_M       0x536626CFu  // d = 201168, n < 2^32
+#define RECIP_DIV_201168_S       48
+#define RECIP_DIV_201168_SMALL_M 0x536627u    // d = 201168, n <= 25146000
+#define RECIP_DIV_201168_SMALL_S 40
+
+// 1 yd = 914.4 mm = 4572/5 mm; 1 mile/1000 = 1609.344 mm = 201168/125 mm
+#define MM_PER_5_YARDS         4572u
+#define MM_PER_125_MILLIMILES  201168u
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static uint16_t stride_mm = DEFAULT_STRIDE_MM;
+static uint32_t distance_mm = 0;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+static inline uint32_t mul_shift(uint32_t n, uint32_t m, uint8_t s) {
+    return (uint32_t)(((uint64_t)n * m) >> s);
+}
+
+static inline uint32_t div_1000(uint32_t n) {
+    return mul_shift(n, RECIP_DIV_1000_M, RECIP_DIV_1000_S);
+}
+
+// Multiplies steps by stride, saturating at the accumulator limit
+static uint32_t steps_to_mm(uint32_t steps) {
+    uint64_t mm = (uint64_t)steps * stride_mm;
+    return (mm > UINT32_MAX) ? UINT32_MAX : (uint32_t)mm;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void distance_set_stride_mm(uint16_t new_stride_mm, uint32_t steps) {
+    if (new_stride_mm < MIN_STRIDE_MM) new_stride_mm = MIN_STRIDE_MM;
+    if (new_stride_mm > MAX_STRIDE_MM) new_stride_mm = MAX_STRIDE_MM;
+    stride_mm = new_stride_mm;
+    distance_set_steps(steps);
+}
+
+uint16_t distance_get_stride_mm(void) {
+    return stride_mm;
+}
+
+void distance_add_steps(uint32_t steps) {
+    uint32_t added = steps_to_mm(steps);
+    distance_mm = (added > UINT32_MAX - distance_mm) ? UINT32_MAX : distance_mm + added;
+}
+
+void distance_set_steps(uint32_t steps) {
+    distance_mm = steps_to_mm(steps);
+}
+
+uint32_t distance_get_mm(void) {
+    return distance_mm;
+}
+
+uint32_t distance_get_metres(void) {
+    return div_1000(distance_mm);
+}
+
+// floor(mm * 5 / 4572), split so every product fits in 64 bits
+uint32_t distance_get_yards(void) {
+    uint32_t q = mul_shift(distance_mm >> 2, RECIP_DIV_1143_M, RECIP_DIV_1143_S);
+    uint32_t r = distance_mm - q * MM_PER_5_YARDS;
+    return q * 5 + mul_shift(r * 5, RECIP_DIV_4572_SMALL_M, RECIP_DIV_4572_SMALL_S);
+}
+
+void distance_get_km(uint32_t *km, uint16_t *metres) {
+    uint32_t total_metres = div_1000(distance_mm);
+    uint32_t whole_km = div_1000(total_metres);
+    *km = whole_km;
+    *metres = (uint16_t)(total_metres - whole_km * 1000);
+}
+
+// floor(mm * 125 / 201168) thousandths of a mile, split into whole miles
+void distance_get_miles(uint32_t *miles, uint16_t *thousandths) {
+    uint32_t q = mul_shift(distance_mm, RECIP_DIV_201168_M, RECIP_DIV_201168_S);
+    uint32_t r = distance_mm - q * MM_PER_125_MILLIMILES;
+    uint32_t millimiles = q * 125 + mul_shift(r * 125, RECIP_DIV_201168_SMALL_M, RECIP_DIV_201168_SMALL_S);
+    uint32_t whole = div_1000(millimiles);
+    *miles = whole;
+    *thousandths = (uint16_t)(millimiles - whole * 1000);
+}
@@ -0,0 +1,433 @@
+/*
+ * flash_log.c
+ *
+ * Log-structured persistence in internal flash.
+ * - Records are appended sequentially through a ring of pages, so every page
+ *   is erased equally often (one erase per FLASH_LOG_PAGES * 64 records).
+ * - The page after the write page is erased ahead of time, so appends never wait.
+ *   Erases (~22 ms, longer than a 60 Hz sample period) only run when the caller
+ *   allows them; if the write page fills first, saving waits for the next chance.
+ * - Each record is programmed one double-word per call with the CRC last;
+ *   a record torn by power loss fails its CRC and is skipped at boot. A
+ *   double-word that fails to program starts the record again in the next
+ *   free slot, up to FLASH_LOG_PROGRAM_ATTEMPTS slots.
+ * - State records and history records (one completed 15-minute block of
+ *   step history each) share the ring; state is written first when both are due.
+ *   Before the spare page is erased, the history blocks in it that the ring of
+ *   minutes still holds are copied to the write page, so a day of state saves
+ *   never pushes them out.
+ * - Boot picks the page with the newest valid head record, binary-searches it
+ *   for the first blank slot and walks back over torn and history records to
+ *   the newest state record. One pass over every slot then finds the history
+ *   blocks to restore, indexed by their place in the ring of minutes.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "flash_log.h"
+#include "checksum.h"
+#include "step_detection.h"
+#include "goal_tracker.h"
+#include "distance.h"
+#include "stm32c0xx_hal.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define RECORDS_PER_PAGE   (FLASH_PAGE_SIZE / FLASH_LOG_RECORD_SIZE)
+#define DOUBLEWORDS_PER_RECORD (FLASH_LOG_RECORD_SIZE / sizeof(uint64_t))
+#define ERASED_WORD        0xFFFFFFFFu
+#define NO_PAGE            0xFF
+#define NO_SLOT            0xFFFF
+
+_Static_assert(sizeof(FlashLogRecord) == FLASH_LOG_RECORD_SIZE, "FlashLogRecord must be 32 bytes");
+_Static_assert(sizeof(FlashLogHistoryRecord) == FLASH_LOG_RECORD_SIZE &&
+               offsetof(FlashLogHistoryRecord, type) == offsetof(FlashLogRecord, type) &&
+               offsetof(FlashLogHistoryRecord, crc) == offsetof(FlashLogRecord, crc),
+               "History records must share the state record's slot layout");
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static uint8_t write_page = 0;
+static uint8_t write_slot = 0;
+static bool write_page_blank = false;   // Slots from write_slot onwards are erased
+static bool spare_page_blank = false;   // Page after write_page is erased
+static uint32_t next_sequence = 0;
+
+static FlashLogRecord pending;          // Record being programmed (either type)
+static uint8_t pending_doubleword = 0;
+static uint8_t pending_attempts = 0;    // Slots the pending record has been started in
+static bool programming = false;
+
+static uint32_t newest_history_minute = 0;  // First minute of the newest block logged
+static bool history_logged = false;
+static uint8_t carry_slot = RECORDS_PER_PAGE;   // Next spare-page slot to check for blocks to keep
+static FlashLogHistoryRecord deferred;  // History record given up on, tried again when nothing else is due
+static bool history_deferred = false;
+
+static FlashLogRecord saved;            // Contents of the newest record in flash
+static uint8_t settings[FLASH_LOG_SETTINGS_COUNT];
+static uint32_t last_save_ms = 0;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+static uint8_t next_page(uint8_t page) {
+    return (page + 1 == FLASH_LOG_PAGES) ? 0 : page + 1;
+}
+
+static uint8_t previous_page(uint8_t page) {
+    return (page == 0) ? FLASH_LOG_PAGES - 1 : page - 1;
+}
+
+// Moves back one slot through the ring from the write page; false past the oldest slot
+static bool step_back(uint8_t *page, uint8_t *slot) {
+    if (*slot > 0) {
+        (*slot)--;
+        return true;
+    }
+    uint8_t older = previous_page(*page);
+    if (older == write_page) return false;
+    *page = older;
+    *slot = RECORDS_PER_PAGE - 1;
+    return true;
+}
+
+static uintptr_t page_address(uint8_t page) {
+    return FLASH_BASE + (uintptr_t)(FLASH_LOG_FIRST_PAGE + page) * FLASH_PAGE_SIZE;
+}
+
+static const FlashLogRecord *record_at(uint8_t page, uint8_t slot) {
+    return (const FlashLogRecord*)(page_address(page) + (uintptr_t)slot * FLASH_LOG_RECORD_SIZE);
+}
+
+static bool record_valid(const FlashLogRecord *record) {
+    return record->sequence != ERASED_WORD &&
+           record->crc == crc16_ccitt(record, offsetof(FlashLogRecord, crc));
+}
+
+static bool record_blank(const FlashLogRecord *record) {
+    const uint32_t *words = (const uint32_t*)record;
+    for (uint8_t i = 0; i < FLASH_LOG_RECORD_SIZE / sizeof(uint32_t); i++) {
+        if (words[i] != ERASED_WORD) return false;
+    }
+    return true;
+}
+
+static bool page_blank(uint8_t page) {
+    const uint32_t *words = (const uint32_t*)page_address(page);
+    for (uint16_t i = 0; i < FLASH_PAGE_SIZE / sizeof(uint32_t); i++) {
+        if (words[i] != ERASED_WORD) return false;
+    }
+    return true;
+}
+
+// Slots are written in order, so "blank" is monotonic within a page: binary search for the first one
+static uint8_t first_blank_slot(uint8_t page) {
+    uint8_t lo = 0, hi = RECORDS_PER_PAGE;
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if (record_blank(record_at(page, mid))) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+static void erase_page(uint8_t page) {
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase = FLASH_TYPEERASE_PAGES,
+        .Page = FLASH_LOG_FIRST_PAGE + page,
+        .NbPages = 1
+    };
+    uint32_t page_error;
+
+    HAL_FLASH_Unlock();
+    HAL_FLASHEx_Erase(&erase, &page_error);
+    HAL_FLASH_Lock();
+}
+
+// Moves writing onto the next page (already erased ahead of time)
+static void open_next_page(void) {
+    write_page = next_page(write_page);
+    write_slot = 0;
+    write_page_blank = true;
+    spare_page_blank = page_blank(next_page(write_page));
+    carry_slot = 0;
+}
+
+// True while a block is inside the ring of minutes behind the newest block logged
+static bool history_retained(uint32_t first_minute) {
+    return history_logged && newest_history_minute - first_minute < HISTORY_MAX_QUERY_MINUTES;
+}
+
+static const FlashLogHistoryRecord *history_at(uint8_t page, uint8_t slot) {
+    const FlashLogRecord *record = record_at(page, slot);
+    if (!record_valid(record) || record->type != FLASH_LOG_TYPE_HISTORY) return NULL;
+    return (const FlashLogHistoryRecord*)record;
+}
+
+// Captures the live device state into the pending record
+static void build_record(FlashLogRecord *record) {
+    memset(record, 0xFF, sizeof(*record));
+    record->sequence = next_sequence;
+    record->steps = get_steps();
+    record->goal = get_goal();
+    record->stride_mm = distance_get_stride_mm();
+    memcpy(record->settings, settings, sizeof(settings));
+    record->type = FLASH_LOG_TYPE_STATE;
+    record->crc = crc16_ccitt(record, offsetof(FlashLogRecord, crc));
+}
+
+// Puts a completed history block into the pending record
+static void build_history_record(FlashLogRecord *record, uint32_t first_minute,
+                                 const uint8_t bins[HISTORY_BLOCK_MINUTES]) {
+    FlashLogHistoryRecord history;
+    memset(&history, 0xFF, sizeof(history));
+    history.sequence = next_sequence;
+    history.first_minute = first_minute;
+    memcpy(history.bins, bins, sizeof(history.bins));
+    history.type = FLASH_LOG_TYPE_HISTORY;
+    history.crc = crc16_ccitt(&history, offsetof(FlashLogHistoryRecord, crc));
+    memcpy(record, &history, sizeof(*record));
+}
+
+// Restores the newest history blocks the ring of minutes can hold, oldest first. Copies made
+// before an erase put blocks out of order, so each is placed by its block index in the ring
+static void restore_history(void) {
+    uint16_t where[HISTORY_BLOCKS];     // Slot (page * RECORDS_PER_PAGE + slot) holding each block
+    memset(where, 0xFF, sizeof(where));
+
+    for (uint8_t page = 0; page < FLASH_LOG_PAGES; page++) {
+        for (uint8_t slot = 0; slot < RECORDS_PER_PAGE; slot++) {
+            const FlashLogHistoryRecord *record = history_at(page, slot);
+            if (record == NULL) continue;
+
+            uint16_t *held = &where[(record->first_minute / HISTORY_BLOCK_MINUTES) % HISTORY_BLOCKS];
+            if (*held == NO_SLOT || record->first_minute >
+                ((const FlashLogHistoryRecord*)record_at(*held / RECORDS_PER_PAGE, *held % RECORDS_PER_PAGE))->first_minute) {
+                *held = (uint16_t)(page * RECORDS_PER_PAGE + slot);
+            }
+            if (!history_logged || record->first_minute > newest_history_minute) {
+                newest_history_minute = record->first_minute;
+                history_logged = true;
+            }
+        }
+    }
+    if (!history_logged) return;
+
+    // Oldest first: start at the block after the newest and go once round the ring
+    uint16_t newest_index = (newest_history_minute / HISTORY_BLOCK_MINUTES) % HISTORY_BLOCKS;
+    for (uint16_t i = 1; i <= HISTORY_BLOCKS; i++) {
+        uint16_t held = where[(newest_index + i) % HISTORY_BLOCKS];
+        if (held == NO_SLOT) continue;
+        const FlashLogHistoryRecord *record =
+            (const FlashLogHistoryRecord*)record_at(held / RECORDS_PER_PAGE, held % RECORDS_PER_PAGE);
+        if (history_retained(record->first_minute)) {
+            step_history_restore_block(record->first_minute, record->bins);
+        }
+    }
+}
+
+// Finds the next block in the spare page that must outlive its erase; false once all are copied
+static bool next_carry(uint32_t *first_minute, uint8_t bins[HISTORY_BLOCK_MINUTES]) {
+    while (carry_slot < RECORDS_PER_PAGE) {
+        const FlashLogHistoryRecord *record = history_at(next_page(write_page), carry_slot++);
+        if (record != NULL && history_retained(record->first_minute)) {
+            *first_minute = record->first_minute;
+            memcpy(bins, record->bins, HISTORY_BLOCK_MINUTES);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool save_due(uint32_t now) {
+    if (check_set_goal_state()) return false;  // Goal is in flux until confirmed
+
+    if (get_goal() != saved.goal || distance_get_stride_mm() != saved.stride_mm ||
+        memcmp(settings, saved.settings, sizeof(settings)) != 0) {
+        return true;
+    }
+    return get_steps() != saved.steps && now - last_save_ms >= FLASH_LOG_SAVE_INTERVAL_MS;
+}
+
+// Programs the next double-word of the pending record
+static void program_step(void) {
+    uint32_t address = (uint32_t)((uintptr_t)record_at(write_page, write_slot) + pending_doubleword * sizeof(uint64_t));
+    uint64_t data;
+    memcpy(&data, (const uint8_t*)&pending + pending_doubleword * sizeof(uint64_t), sizeof(data));
+
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address, data);
+    HAL_FLASH_Lock();
+
+    if (status == HAL_OK && ++pending_doubleword < DOUBLEWORDS_PER_RECORD) return;
+
+    if (status != HAL_OK) {
+        // The torn slot fails its CRC at boot; start again in the next free slot (the same
+        // one if the failure left it blank, so blank slots stay at the end of the page)
+        if (!record_blank(record_at(write_page, write_slot))) write_slot++;
+        pending_doubleword = 0;
+        if (++pending_attempts < FLASH_LOG_PROGRAM_ATTEMPTS) {
+            if (write_slot < RECORDS_PER_PAGE) return;
+            if (spare_page_blank) {
+                open_next_page();
+                return;
+            }
+        }
+        // Given up: a state record is built again when next due, a history block is kept to
+        // try again; the sequence is not reused
+        if (pending.type == FLASH_LOG_TYPE_HISTORY) {
+            memcpy(&deferred, &pending, sizeof(deferred));
+            history_deferred = true;
+        }
+        programming = false;
+        next_sequence++;
+        return;
+    }
+
+    programming = false;
+    write_slot++;
+    next_sequence++;
+    if (pending.type == FLASH_LOG_TYPE_STATE) {
+        saved = pending;
+        last_save_ms = HAL_GetTick();
+    } else {
+        uint32_t first_minute = ((const FlashLogHistoryRecord*)&pending)->first_minute;
+        if (!history_logged || first_minute > newest_history_minute) newest_history_minute = first_minute;
+        history_logged = true;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void flash_log_init(void) {
+    uint8_t newest_page = NO_PAGE;
+    uint32_t newest_sequence = 0;
+
+    memset(&saved, 0, sizeof(saved));
+    history_logged = false;
+    history_deferred = false;
+    carry_slot = 0;
+    saved.goal = get_goal();
+    saved.stride_mm = distance_get_stride_mm();
+    last_save_ms = HAL_GetTick();
+
+    for (uint8_t page = 0; page < FLASH_LOG_PAGES; page++) {
+        const FlashLogRecord *head = record_at(page, 0);
+        if (record_valid(head) && (newest_page == NO_PAGE || head->sequence > newest_sequence)) {
+            newest_page = page;
+            newest_sequence = head->sequence;
+        }
+    }
+
+    if (newest_page == NO_PAGE) {
+        // Empty (or unreadable) log: start from page 0
+        write_page = 0;
+        write_slot = 0;
+        write_page_blank = page_blank(0);
+        spare_page_blank = page_blank(next_page(0));
+        return;
+    }
+
+    // Newest state record: walk back from the first blank slot over torn and history records
+    write_page = newest_page;
+    write_slot = first_blank_slot(newest_page);
+    write_page_blank = true;
+    spare_page_blank = page_blank(next_page(newest_page));
+
+    uint8_t page = write_page, slot = write_slot;
+    bool restored = false;
+    next_sequence = newest_sequence + 1;
+    while (step_back(&page, &slot)) {
+        const FlashLogRecord *record = record_at(page, slot);
+        if (!record_valid(record)) continue;
+        if (record->sequence >= next_sequence) next_sequence = record->sequence + 1;
+        if (record->type == FLASH_LOG_TYPE_STATE) {
+            saved = *record;
+            restored = true;
+            break;
+        }
+    }
+
+    restore_history();
+    if (!restored) return;
+
+    memcpy(settings, saved.settings, sizeof(settings));
+    set_goal(saved.goal);
+    distance_set_stride_mm(saved.stride_mm, saved.steps);
+    set_step_count(saved.steps);
+}
+
+void flash_log_execute(bool erase_allowed) {
+    if (programming) {
+        program_step();
+        return;
+    }
+
+    // Erases are the long operations: at most one per call, never mid-record
+    if (erase_allowed && !write_page_blank) {
+        erase_page(write_page);
+        write_page_blank = true;
+        return;
+    }
+    if (erase_allowed && !spare_page_blank && carry_slot == RECORDS_PER_PAGE) {
+        erase_page(next_page(write_page));
+        spare_page_blank = true;
+        return;
+    }
+
+    // Nothing can be written until the page it goes to has been erased
+    if (!write_page_blank) return;
+    if (write_slot == RECORDS_PER_PAGE && !spare_page_blank) {
+        carry_slot = RECORDS_PER_PAGE;      // Out of room: blocks not yet copied go with the erase
+        return;
+    }
+
+    // State first, then a block given up on, then blocks the spare page erase would lose; a
+    // newly completed history block is only taken when it can be written now
+    uint32_t first_minute = deferred.first_minute;
+    uint8_t bins[HISTORY_BLOCK_MINUTES];
+    bool state_due = save_due(HAL_GetTick());
+    bool retry = !state_due && history_deferred;
+    if (retry) {
+        memcpy(bins, deferred.bins, sizeof(bins));
+        history_deferred = false;
+    } else if (!state_due && !next_carry(&first_minute, bins) &&
+               !step_history_next_completed_block(&first_minute, bins)) {
+        return;
+    }
+
+    if (write_slot == RECORDS_PER_PAGE) {
+        open_next_page();
+    }
+    if (state_due) {
+        build_record(&pending);
+    } else {
+        build_history_record(&pending, first_minute, bins);
+    }
+    pending_doubleword = 0;
+    pending_attempts = 0;
+    programming = true;
+    program_step();
+}
+
+uint8_t flash_log_get_setting(uint8_t index) {
+    return (index < FLASH_LOG_SETTINGS_COUNT) ? settings[index] : 0;
+}
+
+void flash_log_set_setting(uint8_t index, uint8_t value) {
+    if (index < FLASH_LOG_SETTINGS_COUNT) {
+        settings[index] = value;
+    }
+}
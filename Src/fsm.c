@@ -12,23 +12,25 @@
 #include "joystick_math.h"
 #include "joystick_task.h"
 #include "goal_tracker.h"
+#include "trace.h"
+#include "soft_timer.h"
 #include <string.h> // For strcmp
 
 // Current state of the display screen
 static display_state_t current_display_state;
 
+// Runs for COOLDOWN_MS after each flip
+static SoftTimer cooldown;
+
 void fsm_init(void) {
     current_display_state = DISPLAY_STEPS;
 }
 
 void fsm_update(uint16_t adc_x, bool test_mode) {
-    static uint8_t cooldown_timer = 0;
-
     if (test_mode || check_set_goal_state())
         return;
 
-    if (cooldown_timer > 0) {
-        cooldown_timer--;
+    if (soft_timer_is_active(&cooldown)) {
         return;
     }
 
@@ -36,16 +38,23 @@ void fsm_update(uint16_t adc_x, bool test_mode) {
     const char* direction = get_x_direction(adc_x);
 
     if (x_percent >= 75) {
-        if (strcmp(direction, "Right") == 0) {
+        if (current_display_state == DISPLAY_DIAGNOSTICS) {
+            // Either direction leaves the hidden screen
+            current_display_state = DISPLAY_STEPS;
+            soft_timer_start(&cooldown, COOLDOWN_MS, 0, NULL);
+            trace_instant(TRACE_SCREEN, current_display_state);
+        } else if (strcmp(direction, "Right") == 0) {
             current_display_state = (current_display_state + 1) % NUM_DISPLAY_STATES;
-            cooldown_timer = COOLDOWN_TICKS;
+            soft_timer_start(&cooldown, COOLDOWN_MS, 0, NULL);
+            trace_instant(TRACE_SCREEN, current_display_state);
         } else if (strcmp(direction, "Left") == 0) {
             if (current_display_state == 0) {
                 current_display_state = NUM_DISPLAY_STATES - 1;
             } else {
                 current_display_state--;
             }
-            cooldown_timer = COOLDOWN_TICKS;
+            soft_timer_start(&cooldown, COOLDOWN_MS, 0, NULL);
+            trace_instant(TRACE_SCREEN, current_display_state);
         }
     }
 }
@@ -53,3 +62,15 @@ void fsm_update(uint16_t adc_x, bool test_mode) {
 display_state_t fsm_get_current_state(void) {
     return current_display_state;
 }
+
+void fsm_set_state(display_state_t state) {
+    if (state < NUM_DISPLAY_STATES) {
+        current_display_state = state;
+        trace_instant(TRACE_SCREEN, state);
+    }
+}
+
+void fsm_toggle_diagnostics(void) {
+    current_display_state = (current_display_state == DISPLAY_DIAGNOSTICS) ? DISPLAY_STEPS : DISPLAY_DIAGNOSTICS;
+    trace_instant(TRACE_SCREEN, current_display_state);
+}
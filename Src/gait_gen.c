@@ -0,0 +1,239 @@
+/*
+ * gait_gen.c
+ *
+ * Synthetic gait samples and the injection-rate ramp. The bounce is a sine at
+ * the step frequency plus a second harmonic at a third of its amplitude, which
+ * gives each step a sharper heel-strike peak. It is generated with a 32-bit
+ * phase accumulator and a quarter-wave table, and noise comes from a
+ * xorshift generator scaled by a multiply, so a sample costs no division.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "gait_gen.h"
+#include "timebase.h"
+
+#define GAIT_MAX_AMPLITUDE_MG   2000    // Keeps the bounce product inside 32 bits
+#define GAIT_UNIT_Q14           16384
+
+// -----------------------------------------------------------------------------
+// Constants
+// -----------------------------------------------------------------------------
+
+// sin(0..π/2) in Q15, 64 steps plus the end point
+static const int16_t quarter_sine[65] = {
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,  6393,
+     7179,  7962,  8739,  9512, 10278, 11039, 11793, 12539, 13279,
+    14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519,
+    20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+    25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898,
+    29268, 29621, 29956, 30273, 30571, 30852, 31113, 31356, 31580,
+    31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728,
+    32757, 32767,
+};
+
+// Unit "up" vector in sensor axes (Q14) for each orientation
+static const int16_t up_vector[NUM_GAIT_ORIENTATIONS][3] = {
+    [GAIT_ORIENT_FLAT]    = { 0, 0, GAIT_UNIT_Q14 },
+    [GAIT_ORIENT_UPRIGHT] = { 0, GAIT_UNIT_Q14, 0 },
+    [GAIT_ORIENT_TILTED]  = { 0, 11585, 11585 },
+    [GAIT_ORIENT_SIDE]    = { GAIT_UNIT_Q14, 0, 0 },
+};
+
+static const char* const stage_names[NUM_GAIT_STAGES] = {
+    "generate", "gravity", "filter", "activity"
+};
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static GaitParams params;
+static bool running = false;
+
+// Signal
+static uint32_t phase = 0;
+static uint32_t phase_step = 0;         // Phase advance per sample at the current rate
+static int32_t amplitude_raw = 0;
+static int32_t noise_half = 0;          // Noise spans ±noise_half
+static uint32_t noise_span = 1;
+static uint32_t noise_state = 0x2545F491u;
+
+// Current rate step
+static uint32_t rate_hz = 0;
+static uint64_t step_start_us = 0;
+static uint32_t generated = 0;          // Samples made due (processed or dropped) since the step began
+static GaitStepResult current;
+static uint64_t stage_sums[NUM_GAIT_STAGES];
+
+// Ramp results
+static GaitStepResult results[GAIT_RAMP_MAX_STEPS];
+static uint8_t result_count = 0;
+static uint8_t results_returned = 0;
+static bool ramp_end_pending = false;
+static uint32_t max_rate_hz = 0;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// sin(2π · phase / 2^32) in Q15
+static int32_t sine_q15(uint32_t angle) {
+    uint8_t index = (angle >> 24) & 63;
+
+    switch (angle >> 30) {
+    case 0:  return quarter_sine[index];
+    case 1:  return quarter_sine[64 - index];
+    case 2:  return -quarter_sine[index];
+    default: return -quarter_sine[64 - index];
+    }
+}
+
+// Uniform noise in ±noise_half
+static int32_t noise(void) {
+    noise_state ^= noise_state << 13;
+    noise_state ^= noise_state >> 17;
+    noise_state ^= noise_state << 5;
+    return (int32_t)(((noise_state >> 16) * noise_span) >> 16) - noise_half;
+}
+
+static int16_t clamp16(int32_t value) {
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return (int16_t)value;
+}
+
+// Starts a rate step: resets the due-sample clock and the step's accounting
+static void set_rate(uint32_t hz) {
+    rate_hz = hz;
+    phase_step = (uint32_t)(((uint64_t)params.cadence_spm << 32) / (60u * hz));
+    step_start_us = timebase_us();
+    generated = 0;
+    current = (GaitStepResult){ .rate_hz = hz };
+    for (uint8_t stage = 0; stage < NUM_GAIT_STAGES; stage++) {
+        stage_sums[stage] = 0;
+    }
+}
+
+// Records the finished ramp step and moves to the next rate, or ends the ramp
+static void finish_step(void) {
+    for (uint8_t stage = 0; stage < NUM_GAIT_STAGES; stage++) {
+        current.stage_cycles[stage] = current.samples ? (uint32_t)(stage_sums[stage] / current.samples) : 0;
+    }
+    results[result_count++] = current;
+    if (current.dropped == 0) max_rate_hz = current.rate_hz;
+
+    uint32_t next = rate_hz + rate_hz / 4;
+    if (current.dropped > 0 || next > GAIT_RAMP_MAX_HZ || result_count == GAIT_RAMP_MAX_STEPS) {
+        gait_gen_stop();
+    } else {
+        set_rate(next);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+GaitParams gait_gen_default_params(void) {
+    GaitParams defaults = {
+        .cadence_spm = 110,
+        .amplitude_mg = 300,
+        .noise_mg = 20,
+        .orientation = GAIT_ORIENT_UPRIGHT,
+    };
+    return defaults;
+}
+
+void gait_gen_start_ramp(const GaitParams *p) {
+    params = *p;
+    if (params.orientation >= NUM_GAIT_ORIENTATIONS) params.orientation = GAIT_ORIENT_FLAT;
+    if (params.amplitude_mg > GAIT_MAX_AMPLITUDE_MG) params.amplitude_mg = GAIT_MAX_AMPLITUDE_MG;
+
+    amplitude_raw = (int32_t)params.amplitude_mg * GAIT_RAW_PER_G / 1000;
+    noise_half = (int32_t)params.noise_mg * GAIT_RAW_PER_G / 1000;
+    noise_span = 2 * (uint32_t)noise_half + 1;
+    phase = 0;
+
+    result_count = 0;
+    results_returned = 0;
+    ramp_end_pending = false;
+    max_rate_hz = 0;
+
+    running = true;
+    set_rate(GAIT_RAMP_START_HZ);
+}
+
+void gait_gen_stop(void) {
+    if (!running) return;
+    running = false;
+    ramp_end_pending = true;
+}
+
+bool gait_gen_is_running(void) {
+    return running;
+}
+
+uint16_t gait_gen_due(void) {
+    if (!running) return 0;
+
+    uint64_t now = timebase_us();
+    if (now - step_start_us >= (uint64_t)GAIT_RAMP_STEP_MS * 1000) {
+        finish_step();
+        if (!running) return 0;
+        now = timebase_us();
+    }
+
+    uint32_t expected = (uint32_t)(((now - step_start_us) * rate_hz) / 1000000);
+    uint32_t due = expected - generated;
+    generated = expected;
+
+    // The emulated FIFO keeps the newest samples; older ones are lost
+    if (due > GAIT_FIFO_SAMPLES) {
+        uint32_t lost = due - GAIT_FIFO_SAMPLES;
+        current.dropped += lost;
+        phase += lost * phase_step;
+        due = GAIT_FIFO_SAMPLES;
+    }
+    return (uint16_t)due;
+}
+
+void gait_gen_sample(int16_t *ax, int16_t *ay, int16_t *az) {
+    const int16_t *up = up_vector[params.orientation];
+
+    int32_t bounce = (amplitude_raw * (sine_q15(phase) + sine_q15(phase * 2) / 3)) >> 15;
+    int32_t vertical = GAIT_RAW_PER_G + bounce;
+    phase += phase_step;
+
+    *ax = clamp16(((vertical * up[0]) >> 14) + noise());
+    *ay = clamp16(((vertical * up[1]) >> 14) + noise());
+    *az = clamp16(((vertical * up[2]) >> 14) + noise());
+}
+
+void gait_gen_account(const uint32_t stage_cycles[NUM_GAIT_STAGES]) {
+    current.samples++;
+    for (uint8_t stage = 0; stage < NUM_GAIT_STAGES; stage++) {
+        stage_sums[stage] += stage_cycles[stage];
+    }
+}
+
+bool gait_gen_next_result(GaitStepResult *result) {
+    if (results_returned >= result_count) return false;
+    *result = results[results_returned++];
+    return true;
+}
+
+bool gait_gen_take_ramp_end(void) {
+    if (!ramp_end_pending || results_returned < result_count) return false;
+    ramp_end_pending = false;
+    return true;
+}
+
+uint32_t gait_gen_max_rate_hz(void) {
+    return max_rate_hz;
+}
+
+const char* gait_gen_stage_name(gait_stage_t stage) {
+    return (stage < NUM_GAIT_STAGES) ? stage_names[stage] : "?";
+}
@@ -33,6 +33,14 @@ static uint16_t prev_goal = 1000;
 static bool longpress = false;
 static bool shortpress = false;
 
+// -----------------------------------------------------------------------------
+// Internal Prototypes
+// -----------------------------------------------------------------------------
+
+static void steps_enter_goal_setting(void);
+static void steps_exit_goal_setting(void);
+static void set_goal_mode_toggle(void);
+
 // -----------------------------------------------------------------------------
 // Public Functions
 // -----------------------------------------------------------------------------
@@ -52,6 +60,7 @@ void goal_set_mode(void)
         if (longpress) {
             steps_exit_goal_setting();
             longpress_toggle();
+            buzzer_play(BUZZER_MELODY_CONFIRM);
         } else if (shortpress) {
             goal = prev_goal;
             steps_exit_goal_setting();
@@ -88,6 +97,14 @@ uint16_t get_goal(void) {
     return goal;
 }
 
+// Restores a goal (e.g. from flash), clamped to the valid range
+void set_goal(uint16_t new_goal) {
+    if (new_goal < MIN_GOAL_VALUE) new_goal = MIN_GOAL_VALUE;
+    if (new_goal > MAX_GOAL_VALUE) new_goal = MAX_GOAL_VALUE;
+    goal = new_goal;
+    prev_goal = new_goal;
+}
+
 // Returns goal progress as a percentage (0–100)
 uint8_t get_goal_progress_percentage(void) {
     if (goal == 0) return 0;
@@ -0,0 +1,290 @@
+/*
+ * i2c_bus.c
+ *
+ * Bounded-latency I2C transactions on hi2c1. A call costs at most
+ * I2C_BUS_MAX_ATTEMPTS time budgets, each followed by a bus recovery if the
+ * bus hung; while a device is backed off it costs nothing. Recovery follows the usual procedure for a
+ * slave holding SDA low: release the pins from the peripheral, clock SCL until
+ * SDA is released (at most nine clocks), send a STOP, then reset and
+ * re-initialise the peripheral.
+ *
+ * The HAL's memory transfers first wait I2C_TIMEOUT_BUSY (25 ms) for a busy bus,
+ * whatever timeout they are given, and then fail with HAL_ERROR and
+ * HAL_I2C_ERROR_TIMEOUT. Each attempt therefore checks the BUSY flag itself and
+ * goes straight to recovery, and a HAL_ERROR carrying the timeout code counts
+ * as a hang like HAL_TIMEOUT and HAL_BUSY do.
+ *
+ * Every transaction that reaches the bus, retries included, is one span in the
+ * trace ring; calls skipped during a back-off are only counted.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "i2c_bus.h"
+#include "i2c.h"
+#include "main.h"
+#include "soft_timer.h"
+#include "timebase.h"
+#include "trace.h"
+#include "stm32c0xx_hal.h"
+
+// Recovery drives the pins CubeMX assigned to I2C1 (main.h user labels I2C1_SCL/I2C1_SDA),
+// falling back to the board's PB8/PB9
+#if defined(I2C1_SCL_Pin) && defined(I2C1_SDA_Pin)
+#define I2C_BUS_SCL_PORT       I2C1_SCL_GPIO_Port
+#define I2C_BUS_SCL_PIN        I2C1_SCL_Pin
+#define I2C_BUS_SDA_PORT       I2C1_SDA_GPIO_Port
+#define I2C_BUS_SDA_PIN        I2C1_SDA_Pin
+#else
+#define I2C_BUS_SCL_PORT       GPIOB
+#define I2C_BUS_SCL_PIN        GPIO_PIN_8
+#define I2C_BUS_SDA_PORT       GPIOB
+#define I2C_BUS_SDA_PIN        GPIO_PIN_9
+#endif
+
+#ifndef I2C_TIMEOUT_BUSY
+#define I2C_TIMEOUT_BUSY       25u      // The HAL's busy-bus wait (private to stm32c0xx_hal_i2c.c)
+#endif
+#define I2C_BUS_HALF_CLOCK_US  5        // Recovery clocks run at 100 kHz
+#define I2C_BUS_RECOVERY_CLOCKS  9
+
+#define I2C_BUS_BITS_PER_MS    (I2C_BUS_CLOCK_HZ / 1000)
+#define I2C_BUS_OVERHEAD_BYTES 3        // Address, register, repeated-start address
+
+// -----------------------------------------------------------------------------
+// Constants
+// -----------------------------------------------------------------------------
+
+static const struct {
+    const char *name;
+    uint16_t address;
+} devices[NUM_I2C_DEVICES] = {
+    [I2C_DEVICE_IMU]     = { "imu",     LSM6DS_I2C_ADDRESS },
+    [I2C_DEVICE_DISPLAY] = { "display", SSD1306_I2C_ADDRESS },
+};
+
+typedef enum {
+    BUS_READ = 0,
+    BUS_WRITE,
+    BUS_PROBE
+} bus_op_t;
+
+// Trace span recorded for each operation (arg: bytes)
+static const trace_event_t op_trace[] = {
+    [BUS_READ]  = TRACE_I2C_READ,
+    [BUS_WRITE] = TRACE_I2C_WRITE,
+    [BUS_PROBE] = TRACE_I2C_PROBE,
+};
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static I2cDeviceStats stats[NUM_I2C_DEVICES];
+static SoftTimer backoff[NUM_I2C_DEVICES];   // Runs while a device's calls are being skipped
+static uint32_t recoveries = 0;
+
+#if I2C_BUS_FAULT_INJECTION
+static i2c_fault_t injected_fault[NUM_I2C_DEVICES];
+static uint8_t injected_attempts[NUM_I2C_DEVICES];
+#endif
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Time allowed for one attempt: the transfer at the bus clock (9 bits per byte),
+// plus 1 ms because HAL timeouts are whole ticks
+static uint32_t budget_ms(uint16_t length) {
+    uint32_t bits = (uint32_t)(length + I2C_BUS_OVERHEAD_BYTES) * 9;
+    return 1 + (bits + I2C_BUS_BITS_PER_MS - 1) / I2C_BUS_BITS_PER_MS;
+}
+
+static void wait_us(uint32_t us) {
+    uint64_t end = timebase_us() + us;
+    while (timebase_us() < end) {
+    }
+}
+
+// Frees a bus held by a slave stuck mid-byte, then resets the peripheral
+static void recover_bus(void) {
+    GPIO_InitTypeDef gpio = {0};
+
+    recoveries++;
+    HAL_I2C_DeInit(&hi2c1);
+
+    // Drive both lines as open-drain GPIO, released (high)
+    HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+    HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_SET);
+    gpio.Mode = GPIO_MODE_OUTPUT_OD;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_LOW;
+    gpio.Pin = I2C_BUS_SCL_PIN;
+    HAL_GPIO_Init(I2C_BUS_SCL_PORT, &gpio);
+    gpio.Pin = I2C_BUS_SDA_PIN;
+    HAL_GPIO_Init(I2C_BUS_SDA_PORT, &gpio);
+
+    // Clock out the byte the slave is sending until it lets go of SDA
+    for (uint8_t i = 0; i < I2C_BUS_RECOVERY_CLOCKS &&
+                        HAL_GPIO_ReadPin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN) == GPIO_PIN_RESET; i++) {
+        HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_RESET);
+        wait_us(I2C_BUS_HALF_CLOCK_US);
+        HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+        wait_us(I2C_BUS_HALF_CLOCK_US);
+    }
+
+    // STOP: SDA rises while SCL is high
+    HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_RESET);
+    HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_RESET);
+    wait_us(I2C_BUS_HALF_CLOCK_US);
+    HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+    wait_us(I2C_BUS_HALF_CLOCK_US);
+    HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_SET);
+    wait_us(I2C_BUS_HALF_CLOCK_US);
+
+    __HAL_RCC_I2C1_FORCE_RESET();
+    __HAL_RCC_I2C1_RELEASE_RESET();
+    HAL_I2C_Init(&hi2c1);  // The MSP init hands the pins back to the peripheral
+}
+
+// True if a failed attempt means a line is held; a plain NACK needs no recovery
+static bool bus_hung(HAL_StatusTypeDef status) {
+    return status == HAL_TIMEOUT || status == HAL_BUSY ||
+           (status == HAL_ERROR && (HAL_I2C_GetError(&hi2c1) & HAL_I2C_ERROR_TIMEOUT) != 0);
+}
+
+#if I2C_BUS_FAULT_INJECTION
+// Fails the attempt the way the injected fault would, if one is pending. A stall is a
+// bus that goes busy as the attempt starts: the HAL's busy wait, then its timeout error
+static bool take_injected_fault(i2c_device_t device, HAL_StatusTypeDef *status) {
+    if (injected_attempts[device] == 0) return false;
+    injected_attempts[device]--;
+
+    if (injected_fault[device] == I2C_FAULT_STALL) {
+        uint32_t start = HAL_GetTick();
+        while (HAL_GetTick() - start <= I2C_TIMEOUT_BUSY) {
+        }
+        hi2c1.ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+    } else {
+        hi2c1.ErrorCode = HAL_I2C_ERROR_AF;
+    }
+    *status = HAL_ERROR;
+    return true;
+}
+#endif
+
+static HAL_StatusTypeDef attempt(i2c_device_t device, bus_op_t op, uint8_t reg, uint8_t *data, uint16_t length, uint32_t timeout_ms) {
+    HAL_StatusTypeDef status;
+
+#if I2C_BUS_FAULT_INJECTION
+    if (take_injected_fault(device, &status)) return status;
+#endif
+
+    // A held bus would cost the HAL's 25 ms busy wait before it reported anything
+    if (__HAL_I2C_GET_FLAG(&hi2c1, I2C_FLAG_BUSY)) return HAL_BUSY;
+
+    switch (op) {
+    case BUS_READ:
+        status = HAL_I2C_Mem_Read(&hi2c1, devices[device].address, reg, I2C_MEMADD_SIZE_8BIT, data, length, timeout_ms);
+        break;
+    case BUS_WRITE:
+        status = HAL_I2C_Mem_Write(&hi2c1, devices[device].address, reg, I2C_MEMADD_SIZE_8BIT, data, length, timeout_ms);
+        break;
+    default:
+        status = HAL_I2C_IsDeviceReady(&hi2c1, devices[device].address, 1, timeout_ms);
+        break;
+    }
+    return status;
+}
+
+// Runs one transaction with retries, recovery and back-off, and accounts for it
+static i2c_bus_status_t transact(i2c_device_t device, bus_op_t op, uint8_t reg, uint8_t *data, uint16_t length) {
+    if (device >= NUM_I2C_DEVICES) return I2C_BUS_ERROR;
+
+    I2cDeviceStats *device_stats = &stats[device];
+    if (soft_timer_is_active(&backoff[device])) {
+        device_stats->skipped++;
+        return I2C_BUS_SKIPPED;
+    }
+
+    uint32_t timeout_ms = budget_ms(length);
+    uint64_t start_us = timebase_us();
+    HAL_StatusTypeDef status = HAL_ERROR;
+
+    device_stats->transactions++;
+    trace_begin(op_trace[op], length);
+    for (uint8_t i = 0; i < I2C_BUS_MAX_ATTEMPTS; i++) {
+        if (i > 0) device_stats->retries++;
+
+        status = attempt(device, op, reg, data, length, timeout_ms);
+        if (status == HAL_OK) break;
+
+        if (bus_hung(status)) {
+            device_stats->timeouts++;
+            recover_bus();
+        }
+    }
+
+    trace_end(op_trace[op], length);
+    uint32_t elapsed_us = (uint32_t)(timebase_us() - start_us);
+    if (elapsed_us > device_stats->worst_us) device_stats->worst_us = elapsed_us;
+
+    if (status != HAL_OK) {
+        device_stats->errors++;
+        soft_timer_start(&backoff[device], I2C_BUS_BACKOFF_MS, 0, NULL);
+        return I2C_BUS_ERROR;
+    }
+    return I2C_BUS_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void i2c_bus_init(void) {
+    for (uint8_t device = 0; device < NUM_I2C_DEVICES; device++) {
+        stats[device] = (I2cDeviceStats){0};
+        soft_timer_cancel(&backoff[device]);
+#if I2C_BUS_FAULT_INJECTION
+        injected_attempts[device] = 0;
+#endif
+    }
+    recoveries = 0;
+}
+
+i2c_bus_status_t i2c_bus_read(i2c_device_t device, uint8_t reg, uint8_t *data, uint16_t length) {
+    return transact(device, BUS_READ, reg, data, length);
+}
+
+i2c_bus_status_t i2c_bus_write(i2c_device_t device, uint8_t reg, const uint8_t *data, uint16_t length) {
+    return transact(device, BUS_WRITE, reg, (uint8_t*)data, length);  // The HAL takes a non-const buffer but only reads it
+}
+
+i2c_bus_status_t i2c_bus_probe(i2c_device_t device) {
+    return transact(device, BUS_PROBE, 0, NULL, 0);
+}
+
+I2cDeviceStats i2c_bus_get_stats(i2c_device_t device) {
+    return (device < NUM_I2C_DEVICES) ? stats[device] : (I2cDeviceStats){0};
+}
+
+uint32_t i2c_bus_recoveries(void) {
+    return recoveries;
+}
+
+const char* i2c_bus_device_name(i2c_device_t device) {
+    return (device < NUM_I2C_DEVICES) ? devices[device].name : "?";
+}
+
+void i2c_bus_inject_fault(i2c_device_t device, i2c_fault_t fault, uint8_t attempts) {
+#if I2C_BUS_FAULT_INJECTION
+    if (device >= NUM_I2C_DEVICES || fault >= NUM_I2C_FAULTS) return;
+    injected_fault[device] = fault;
+    injected_attempts[device] = attempts;
+#else
+    (void)device;
+    (void)fault;
+    (void)attempts;
+#endif
+}
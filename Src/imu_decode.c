@@ -0,0 +1,20 @@
+/*
+ * imu_decode.c
+ *
+ * Little-endian word decoding for the IMU's output and FIFO registers.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "imu_decode.h"
+
+int16_t imu_decode_word(const uint8_t *bytes) {
+    return (int16_t)((bytes[1] << 8) | bytes[0]);
+}
+
+void imu_decode_sample(const uint8_t *bytes, int16_t *x, int16_t *y, int16_t *z) {
+    *x = imu_decode_word(&bytes[0]);
+    *y = imu_decode_word(&bytes[2]);
+    *z = imu_decode_word(&bytes[4]);
+}
@@ -3,7 +3,10 @@
  *
  * Handles joystick ADC readings and button press detection.
  * Detects click duration for entering/exiting goal-setting mode.
+ * A long press on the steps screen opens (and on it, closes) the hidden diagnostics screen.
  * Detects upward motion to toggle between unit display modes.
+ * Also runs the screen FSM and goal setting from the same readings, so the step
+ * task only counts steps.
  *
  * Created on: Mar 13, 2025
  * Author: eaz11 & gjo77
@@ -16,6 +19,7 @@
 #include "step_detection.h"
 #include "fsm.h"
 #include "display_task.h"
+#include "soft_timer.h"
 
 #include <string.h>
 
@@ -23,6 +27,11 @@
 
 static uint16_t raw_adc[3];  // Format: [Potentiometer, Y, X]
 
+static SoftTimer hold_timer;            // Runs while the click is held, up to HOLD_TIME_MS
+static bool click_in_progress = false;
+static bool longpress_detected = false;
+static display_state_t hold_screen;     // Screen the press started on
+
 // Returns the current raw ADC values (from DMA): [Pot, Y, X]
 uint16_t* joystick_get_values(void) {
     return raw_adc;
@@ -33,33 +42,70 @@ void joystick_init(void) {
     HAL_ADC_Init(&hadc1);
 }
 
-// Starts ADC sampling and processes joystick button click for goal setting mode
-void joystick_task_execute(void) {
-    static uint32_t press_start_time = 0;
-    static bool click_in_progress = false;
-    static bool longpress_detected = false;
+// Fires HOLD_TIME_MS into a press. The timer can expire between task runs, so the
+// pin and screen are checked again here rather than trusting the last poll
+static void on_hold_timeout(void) {
+    if (HAL_GPIO_ReadPin(JOYSTICK_CLICK_GPIO_Port, JOYSTICK_CLICK_Pin) != GPIO_PIN_SET) {
+        click_in_progress = false;  // Released since the last poll: neither a long nor a short press
+        return;
+    }
+    longpress_detected = true;  // Still held: either way nothing more happens until release
+    if (fsm_get_current_state() != hold_screen) return;
 
+    if (hold_screen == DISPLAY_GOAL_PROGRESS) {
+        longpress_toggle();
+    } else {
+        fsm_toggle_diagnostics();
+    }
+}
+
+// Screen cycling, unit toggle and goal setting from the latest readings (none in test mode)
+static void update_ui(void) {
+    if (check_test_mode()) return;
+
+    if (!check_set_goal_state()) {
+        fsm_update(raw_adc[ADC_IDX_X], false);
+        check_for_display_toggle();
+        goal_set_mode();
+    }
+
+    // Goal-setting mode logic (joystick + potentiometer)
+    if (check_set_goal_state()) {
+        potentiometer_update_stepcount(raw_adc[ADC_IDX_POT]);
+        goal_set_mode();
+    }
+}
+
+// Starts ADC sampling, processes joystick button click for goal setting mode and updates the UI
+void joystick_task_execute(void) {
     HAL_ADC_Start_DMA(&hadc1, (uint32_t*)raw_adc, 3);
 
-    if (!check_test_mode() && fsm_get_current_state() == DISPLAY_GOAL_PROGRESS) {
+    display_state_t screen = fsm_get_current_state();
+    bool goal_screen = (screen == DISPLAY_GOAL_PROGRESS);
+
+    if (!check_test_mode() && (goal_screen || screen == DISPLAY_STEPS || screen == DISPLAY_DIAGNOSTICS)) {
         if (HAL_GPIO_ReadPin(JOYSTICK_CLICK_GPIO_Port, JOYSTICK_CLICK_Pin) == GPIO_PIN_SET) {
             if (!click_in_progress) {
-                press_start_time = HAL_GetTick();
                 click_in_progress = true;
                 longpress_detected = false;
-            } else if (!longpress_detected && (HAL_GetTick() - press_start_time >= HOLD_TIME_MS)) {
-                longpress_toggle();
-                longpress_detected = true;
+                hold_screen = screen;
+                soft_timer_start(&hold_timer, HOLD_TIME_MS, 0, on_hold_timeout);
             }
         } else {
-            if (click_in_progress && !longpress_detected) {
+            if (click_in_progress && !longpress_detected && goal_screen) {
                 shortpress_toggle();
             }
-            press_start_time = 0;
+            soft_timer_cancel(&hold_timer);
             click_in_progress = false;
             longpress_detected = false;
         }
+    } else {
+        // Leaving the click screens (or entering test mode) abandons a press in progress
+        soft_timer_cancel(&hold_timer);
+        click_in_progress = false;
     }
+
+    update_ui();
 }
 
 // Detects "Up" joystick movement and toggles display units if movement is significant
@@ -3,7 +3,13 @@
  *
  * Visual indicator for goal progress using three RGB LEDs and one PWM-controlled LED.
  * - Each 25% progress activates another full-brightness LED
- * - Below 25%, a fourth LED (DS3) shows partial progress via PWM brightness
+ * - Below 25%, a fourth LED (DS3) breathes, peaking brighter as progress grows
+ * - From 25%, DS3 repeats a fill sweep; at 100% it blinks
+ *
+ * DS3's animations run in hardware: TIM2 CH3's DMA request writes the next
+ * compare value from a circular waveform buffer every PWM cycle. The buffer
+ * is rendered (with gamma correction) only when the LED state changes, and
+ * the RGB GPIOs are written only when their pattern changes.
  *
  * Created on: May 20, 2025
  * Author: eaz11 & gjo77
@@ -12,41 +18,149 @@
 #include "led.h"
 #include "rgb.h"
 #include "goal_tracker.h"
-#include "pwm.h"
 #include "tim.h"
 
-void LED_init(void) {
-    pwm_setDutyCycle(&htim2, TIM_CHANNEL_3, 0); // DS3 initially off
-    HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_3);
-}
+// -----------------------------------------------------------------------------
+// Constants
+// -----------------------------------------------------------------------------
 
-void LED_execute(void)
-{
-    uint8_t progress = get_goal_progress_percentage(); // 0–100%
-    uint8_t duty_cycle_level = 0;
+#define LED_PWM_HZ        256u   // DS3 PWM rate, which is also the waveform frame rate
+#define LED_PWM_PERIOD    1875u  // Counts per PWM cycle (ARR + 1); 48 MHz / 100 / 1875 = 256 Hz
+#define LED_WAVE_FRAMES   256u   // Frames per animation cycle (1 s)
+#define LED_LEVEL_MAX     255u   // Full scale of perceived brightness
+
+#define RGB_MASK_RIGHT    (1u << 0)
+#define RGB_MASK_DOWN     (1u << 1)
+#define RGB_MASK_LEFT     (1u << 2)
+
+_Static_assert(LED_PWM_PERIOD * LED_LEVEL_MAX * LED_LEVEL_MAX <= UINT32_MAX, "gamma product must fit 32 bits");
+
+typedef enum {
+    LED_PATTERN_OFF = 0,
+    LED_PATTERN_BREATHE,    // Triangle up to the peak and back down
+    LED_PATTERN_FILL,       // Ramp to the peak over 3/4 of the cycle, then hold
+    LED_PATTERN_BLINK       // 2 Hz on/off at the peak
+} led_pattern_t;
+
+typedef struct {
+    led_pattern_t pattern;
+    uint8_t peak;           // Perceived brightness, 0–LED_LEVEL_MAX
+    uint8_t rgb_mask;       // RGB_MASK_* of the LEDs that are on
+} LedState;
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
 
-    // Turn off all RGB LEDs initially
-    rgb_led_off(RGB_RIGHT);
-    rgb_led_off(RGB_DOWN);
-    rgb_led_off(RGB_LEFT);
+static uint16_t wave[LED_WAVE_FRAMES];  // Compare values streamed to TIM2 CH3 by DMA
+static LedState shown;
+static bool shown_valid = false;        // False until the LEDs have been written once
 
-    // LED logic:
-    // DS3: Gradual brightness for 0–24%
-    // RGB_RIGHT: ≥50%
-    // RGB_DOWN:  ≥75%
-    // RGB_LEFT: 100%
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Maps perceived brightness to a compare value (square law, gamma 2)
+static uint16_t gamma_correct(uint8_t level) {
+    return (uint16_t)(((uint32_t)level * level * LED_PWM_PERIOD) / (LED_LEVEL_MAX * LED_LEVEL_MAX));
+}
+
+// The LED state that shows a given goal progress
+static LedState state_for_progress(uint8_t progress) {
+    LedState state = { LED_PATTERN_OFF, 0, 0 };
 
     if (progress == 0) {
-        duty_cycle_level = 0;
-    } else if (progress < 25) {
-        duty_cycle_level = (progress * 100) / 25; // Scale 0–24% to 0–100 brightness
+        return state;
+    }
+
+    if (progress < 25) {
+        state.pattern = LED_PATTERN_BREATHE;
+        state.peak = (uint8_t)((progress * LED_LEVEL_MAX) / 25);
     } else {
-        duty_cycle_level = 100;
+        state.pattern = (progress == 100) ? LED_PATTERN_BLINK : LED_PATTERN_FILL;
+        state.peak = LED_LEVEL_MAX;
 
-        if (progress >= 50) rgb_led_on(RGB_RIGHT);
-        if (progress >= 75) rgb_led_on(RGB_DOWN);
-        if (progress == 100) rgb_led_on(RGB_LEFT);
+        if (progress >= 50) state.rgb_mask |= RGB_MASK_RIGHT;
+        if (progress >= 75) state.rgb_mask |= RGB_MASK_DOWN;
+        if (progress == 100) state.rgb_mask |= RGB_MASK_LEFT;
     }
+    return state;
+}
+
+// Fills the waveform buffer with one cycle of a pattern
+static void render(led_pattern_t pattern, uint8_t peak) {
+    for (uint16_t i = 0; i < LED_WAVE_FRAMES; i++) {
+        uint8_t level;
+
+        switch (pattern) {
+        case LED_PATTERN_BREATHE:
+            level = (uint8_t)((i < LED_WAVE_FRAMES / 2) ? i * 2 : (LED_WAVE_FRAMES - 1 - i) * 2);
+            break;
+        case LED_PATTERN_FILL:
+            level = (i < LED_WAVE_FRAMES * 3 / 4) ? (uint8_t)((i * LED_LEVEL_MAX) / (LED_WAVE_FRAMES * 3 / 4)) : LED_LEVEL_MAX;
+            break;
+        case LED_PATTERN_BLINK:
+            level = (i & (LED_WAVE_FRAMES / 4)) ? 0 : LED_LEVEL_MAX;
+            break;
+        default:
+            level = 0;
+            break;
+        }
+        wave[i] = gamma_correct((uint8_t)((level * peak) / LED_LEVEL_MAX));
+    }
+}
 
-    pwm_setDutyCycle(&htim2, TIM_CHANNEL_3, duty_cycle_level); // DS3
+static void set_rgb(rgb_led_t led, bool on) {
+    if (on) {
+        rgb_led_on(led);
+    } else {
+        rgb_led_off(led);
+    }
+}
+
+// Writes only what differs from what is already shown
+static void show(LedState next) {
+    uint8_t rgb_changed = shown_valid ? (uint8_t)(next.rgb_mask ^ shown.rgb_mask) : 0xFF;
+
+    if (rgb_changed & RGB_MASK_RIGHT) set_rgb(RGB_RIGHT, next.rgb_mask & RGB_MASK_RIGHT);
+    if (rgb_changed & RGB_MASK_DOWN)  set_rgb(RGB_DOWN, next.rgb_mask & RGB_MASK_DOWN);
+    if (rgb_changed & RGB_MASK_LEFT)  set_rgb(RGB_LEFT, next.rgb_mask & RGB_MASK_LEFT);
+
+    if (!shown_valid || next.pattern != shown.pattern || next.peak != shown.peak) {
+        // The DMA must not read the buffer while it is rewritten
+        HAL_TIM_PWM_Stop_DMA(&htim2, TIM_CHANNEL_3);
+
+        if (next.pattern == LED_PATTERN_OFF) {
+            __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_3, 0);
+            HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_3);
+        } else {
+            render(next.pattern, next.peak);
+            HAL_TIM_PWM_Start_DMA(&htim2, TIM_CHANNEL_3, (const uint32_t*)wave, LED_WAVE_FRAMES);
+        }
+    }
+
+    shown = next;
+    shown_valid = true;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+// Sets TIM2 to LED_PWM_HZ with LED_PWM_PERIOD steps; DS3 starts off
+void LED_init(void) {
+    __HAL_TIM_SET_PRESCALER(&htim2, HAL_RCC_GetPCLK1Freq() / (LED_PWM_HZ * LED_PWM_PERIOD) - 1);
+    __HAL_TIM_SET_AUTORELOAD(&htim2, LED_PWM_PERIOD - 1);
+    __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_3, 0);
+    HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_3);
+}
+
+void LED_execute(void)
+{
+    LedState next = state_for_progress(get_goal_progress_percentage());
+
+    if (shown_valid && next.pattern == shown.pattern && next.peak == shown.peak && next.rgb_mask == shown.rgb_mask) {
+        return;  // Nothing crossed a threshold; the animation keeps running on its own
+    }
+    show(next);
 }
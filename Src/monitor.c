@@ -0,0 +1,135 @@
+/*
+ * monitor.c
+ *
+ * Runtime headroom monitor. Task and pass times are SysTick cycle differences.
+ * The stack scan runs once per window and only walks the painted words below
+ * the previous high-water mark, since the mark can only move down.
+ *
+ * The heap would also grow up from the end of .bss, but the firmware never
+ * allocates, so every changed word below the stack pointer is stack usage.
+ *
+ * The paint and the scan cover everything from _end to the stack pointer, so
+ * the linker script must place the NOLOAD .noinit section (warm_restart.c's
+ * snapshot) below _end, after .bss and ahead of ._user_heap_stack. Placed in
+ * the free RAM above _end, the snapshot would be painted over and every save
+ * would read as stack usage. app_init() also runs monitor_init() only after
+ * warm_restart_init(), so the snapshot is read before any paint is written.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "monitor.h"
+#include "timebase.h"
+#include "trace.h"
+#include "stm32c0xx_hal.h"
+
+_Static_assert(TRACE_TASK_LED - TRACE_TASK_BUTTON + 1 == NUM_MONITOR_TASKS,
+               "monitor and trace task lists must match");
+
+// Linker script symbols: end of .bss (start of the free RAM) and the initial stack pointer
+extern uint32_t _end;
+extern uint32_t _estack;
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static uint32_t window_start_ms = 0;
+static uint32_t window_busy = 0;                        // Pass cycles in the current window
+static uint32_t window_task[NUM_MONITOR_TASKS];         // Task cycles in the current window
+static uint32_t task_start[NUM_MONITOR_TASKS];
+static uint32_t *stack_mark = &_estack;                 // Lowest word found changed so far
+static MonitorStats stats;
+
+static const char* const task_names[NUM_MONITOR_TASKS] = {
+    "btn", "disp", "joy", "ser", "step", "test", "buzz", "acc", "led"
+};
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Moves the high-water mark down to the lowest changed word and returns the bytes used
+static uint32_t stack_scan(void) {
+    uint32_t *word = &_end;
+    while (word < stack_mark && *word == MONITOR_STACK_PAINT) {
+        word++;
+    }
+    stack_mark = word;
+    return (uint32_t)((uint8_t*)&_estack - (uint8_t*)stack_mark);
+}
+
+// Cycles in 'cycles' as a share (permille) of 'window_cycles'
+static uint16_t permille_of(uint32_t cycles, uint64_t window_cycles) {
+    uint64_t permille = (uint64_t)cycles * 1000 / window_cycles;
+    return (permille > 1000) ? 1000 : (uint16_t)permille;
+}
+
+// Publishes the window's figures and starts the next window
+static void close_window(uint32_t now) {
+    uint64_t window_cycles = (uint64_t)(now - window_start_ms) * timebase_cycles_per_ms();
+
+    stats.load_permille = permille_of(window_busy, window_cycles);
+    if (stats.load_permille > stats.peak_load_permille) {
+        stats.peak_load_permille = stats.load_permille;
+    }
+    for (uint8_t task = 0; task < NUM_MONITOR_TASKS; task++) {
+        stats.task_permille[task] = permille_of(window_task[task], window_cycles);
+        window_task[task] = 0;
+    }
+    stats.stack_used = stack_scan();
+    stats.windows++;
+
+    window_busy = 0;
+    window_start_ms = now;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void monitor_init(void) {
+    uint32_t *word = &_end;
+    uint32_t *limit = (uint32_t*)(uintptr_t)__get_MSP() - MONITOR_PAINT_MARGIN_WORDS;
+
+    while (word < limit) {
+        *word++ = MONITOR_STACK_PAINT;
+    }
+    stack_mark = limit;
+
+    stats = (MonitorStats){0};
+    stats.stack_size = (uint32_t)((uint8_t*)&_estack - (uint8_t*)&_end);
+    stats.stack_used = stack_scan();
+    window_busy = 0;
+    window_start_ms = HAL_GetTick();
+}
+
+void monitor_task_begin(monitor_task_t task, uint32_t late_us) {
+    trace_begin((trace_event_t)(TRACE_TASK_BUTTON + task), (late_us > UINT16_MAX) ? UINT16_MAX : (uint16_t)late_us);
+    task_start[task] = timebase_cycles();
+}
+
+void monitor_task_end(monitor_task_t task) {
+    window_task[task] += timebase_cycles() - task_start[task];
+    trace_end((trace_event_t)(TRACE_TASK_BUTTON + task), 0);
+}
+
+void monitor_pass_end(uint32_t start, bool ran) {
+    if (ran) {
+        window_busy += timebase_cycles() - start;
+    }
+
+    uint32_t now = HAL_GetTick();
+    if (now - window_start_ms >= MONITOR_WINDOW_MS) {
+        close_window(now);
+    }
+}
+
+MonitorStats monitor_get_stats(void) {
+    return stats;
+}
+
+const char* monitor_task_name(monitor_task_t task) {
+    return (task < NUM_MONITOR_TASKS) ? task_names[task] : "?";
+}
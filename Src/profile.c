@@ -0,0 +1,175 @@
+/*
+ * profile.c
+ *
+ * Performance profile table and switching. Switches requested from the UI are
+ * deferred until the scheduler calls profile_apply_pending() straight after a
+ * sample, so the filters and detector never see a half-applied configuration.
+ * CPU load is measured per profile from SysTick cycle stamps taken by the scheduler.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "profile.h"
+#include "app.h"
+#include "accelerometer.h"
+#include "step_detection.h"
+#include "activity.h"
+#include "cadence.h"
+#include "flash_log.h"
+#include "timebase.h"
+#include "trace.h"
+#include "soft_timer.h"
+#include "stm32c0xx_hal.h"
+
+#define NO_PENDING_PROFILE  NUM_PROFILES
+
+// -----------------------------------------------------------------------------
+// Constants
+// -----------------------------------------------------------------------------
+
+// Builds a table entry from rates in Hz; everything rate-dependent is derived here
+#define PROFILE_ENTRY(NAME, SAMPLE_HZ, HIGH_PERFORMANCE, IMU_UA, THRESHOLD, STEP_HZ, DISPLAY_HZ) { \
+    .name = (NAME),                                                  \
+    .sample_hz = (SAMPLE_HZ),                                        \
+    .step_hz = (STEP_HZ),                                            \
+    .odr = ACCEL_ODR_FOR_HZ(SAMPLE_HZ),                              \
+    .xl_high_performance = (HIGH_PERFORMANCE),                       \
+    .imu_current_ua = (IMU_UA),                                      \
+    .step_threshold = (THRESHOLD),                                   \
+    .accelerometer_period_ticks = HZ_TO_TICKS(SAMPLE_HZ),            \
+    .step_period_ticks = HZ_TO_TICKS(STEP_HZ),                       \
+    .display_period_ticks = HZ_TO_TICKS(DISPLAY_HZ),                 \
+}
+
+// Filter windows all span STEP_CORE_FILTER_WINDOW_MS; fewer samples per window attenuate
+// impacts less, so the lower-rate profiles use slightly higher thresholds.
+static const PerformanceProfile profiles[NUM_PROFILES] = {
+    // Arguments: name, sample Hz, high-performance XL mode, IMU µA, threshold, step Hz, display Hz
+    [PROFILE_HIGH_ACCURACY] = PROFILE_ENTRY("High accuracy", 60, true,   150, 1080, 6, 4),
+    [PROFILE_BALANCED]      = PROFILE_ENTRY("Balanced",      50, false,   45, 1120, 5, 4),
+    [PROFILE_LOW_POWER]     = PROFILE_ENTRY("Low power",     25, false,   25, 1160, 4, 2),
+};
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static profile_id_t active = PROFILE_HIGH_ACCURACY;
+static profile_id_t pending = NO_PENDING_PROFILE;
+static SoftTimer banner;     // Runs for PROFILE_BANNER_MS after a switch
+
+// Load accounting for each profile
+static uint64_t busy_cycles[NUM_PROFILES];
+static uint32_t active_ms[NUM_PROFILES];
+static uint32_t active_since_ms = 0;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Pushes the profile's settings into the sampling and detection modules
+static void apply(profile_id_t id) {
+    const PerformanceProfile *profile = &profiles[id];
+    uint32_t now = HAL_GetTick();
+
+    active_ms[active] += now - active_since_ms;
+    active_since_ms = now;
+
+    accelerometer_set_profile(profile->odr, profile->xl_high_performance, profile->sample_hz);
+    activity_set_sample_rate(profile->sample_hz);
+
+    // Cadence bins need the true filtered-sample rate: the tick-rounded task rate or the CIC output rate
+    uint32_t rate_chz = ACCEL_CIC_FRONTEND ?
+        (ACCEL_CIC_ODR_HZ * 100u) / accelerometer_get_cic_stats().ratio :
+        (TICK_FREQUENCY_HZ * 100u) / profile->accelerometer_period_ticks;
+    cadence_configure(rate_chz);
+    steps_configure(profile->step_hz, profile->step_threshold);
+
+    active = id;
+    flash_log_set_setting(FLASH_LOG_SETTING_PROFILE, (uint8_t)id);
+    trace_instant(TRACE_PROFILE, id);
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void profile_init(void) {
+    active_since_ms = HAL_GetTick();
+    profile_restore((profile_id_t)flash_log_get_setting(FLASH_LOG_SETTING_PROFILE));
+}
+
+void profile_request(profile_id_t id) {
+    if (id < NUM_PROFILES) {
+        pending = id;
+    }
+}
+
+void profile_request_next(void) {
+    profile_id_t current = (pending != NO_PENDING_PROFILE) ? pending : active;
+    profile_request((profile_id_t)((current + 1) % NUM_PROFILES));
+}
+
+void profile_request_previous(void) {
+    profile_id_t current = (pending != NO_PENDING_PROFILE) ? pending : active;
+    profile_request((profile_id_t)((current + NUM_PROFILES - 1) % NUM_PROFILES));
+}
+
+bool profile_apply_pending(void) {
+    if (pending == NO_PENDING_PROFILE) return false;
+
+    profile_id_t id = pending;
+    pending = NO_PENDING_PROFILE;
+    if (id == active) return false;
+
+    apply(id);
+    soft_timer_start(&banner, PROFILE_BANNER_MS, 0, NULL);
+    return true;
+}
+
+void profile_restore(profile_id_t id) {
+    if (id >= NUM_PROFILES) id = PROFILE_HIGH_ACCURACY;
+    pending = NO_PENDING_PROFILE;
+    apply(id);
+}
+
+const PerformanceProfile* profile_get(void) {
+    return &profiles[active];
+}
+
+profile_id_t profile_get_id(void) {
+    return active;
+}
+
+const PerformanceProfile* profile_get_by_id(profile_id_t id) {
+    return (id < NUM_PROFILES) ? &profiles[id] : &profiles[PROFILE_HIGH_ACCURACY];
+}
+
+bool profile_banner_visible(void) {
+    return soft_timer_is_active(&banner);
+}
+
+void profile_account_busy(uint32_t start) {
+    busy_cycles[active] += timebase_cycles() - start;
+}
+
+uint16_t profile_load_permille(profile_id_t id) {
+    if (id >= NUM_PROFILES) return 0;
+
+    uint64_t elapsed_ms = active_ms[id];
+    if (id == active) elapsed_ms += HAL_GetTick() - active_since_ms;
+    if (elapsed_ms == 0) return 0;
+
+    uint64_t elapsed_cycles = elapsed_ms * timebase_cycles_per_ms();
+    uint64_t permille = busy_cycles[id] * 1000 / elapsed_cycles;
+    return (permille > 1000) ? 1000 : (uint16_t)permille;
+}
+
+uint32_t profile_estimated_current_ua(profile_id_t id) {
+    const PerformanceProfile *profile = profile_get_by_id(id);
+    uint32_t load = profile_load_permille(id);
+
+    uint32_t mcu_ua = (PROFILE_MCU_RUN_UA * load + PROFILE_MCU_IDLE_UA * (1000 - load)) / 1000;
+    return mcu_ua + profile->imu_current_ua;
+}
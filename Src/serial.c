@@ -2,7 +2,26 @@
  * serial.c
  *
  * UART debug output for step counter project.
- * Streams raw ADC and acceleration data when serial output is toggled on.
+ * Streams raw ADC and acceleration data when serial output is toggled on,
+ * and answers single-character commands received on USART2:
+ * - 'H' streams the per-minute step history as hex lines
+ * - 'B' reports the boot path (cold/warm) and time to first valid detection
+ * - 'A' reports time spent active/stationary and accelerometer slots skipped
+ * - 'S' cycles the step source (software -> hardware -> hybrid)
+ * - 'P' reports software vs hardware pedometer totals gathered in hybrid mode
+ * - 'L' reports measured CPU load and estimated current for each performance profile
+ * - 'C' reports CIC front-end sample counts and decimator cycles per input sample
+ * - 'R' reports the Goertzel cadence estimate and its cycles per sample
+ * - 'D' toggles the software detector (fixed <-> adaptive) and reports its bands and cost
+ * - 'K' starts a 10 s adaptive calibration run (walk normally) and reports
+ * - 'M' runs the kernel microbenchmarks, one result line per task run
+ * - 'T' dumps the event trace ring as hex lines (tools/trace2json.py converts it)
+ * - 'U' reports CPU load, stack high-water mark and per-task load from the monitor
+ * - 'I' reports per-device I2C transaction, error, retry and timeout counts and the worst transaction time
+ * - 'J' injects a stalled-bus fault into the IMU's next transaction (all of its attempts)
+ * - 'G' starts (or stops) the synthetic gait ramp; one line per rate step, then the maximum sustainable rate
+ * - 'V' cycles the buzzer volume (low -> medium -> high), chirps at the new level and saves it
+ * Hybrid-mode mismatch windows are logged as they happen.
  *
  * Created on: Mar 19, 2025
  * Author: eaz11 & gjo77
@@ -12,17 +31,496 @@
 #include "usart.h"
 #include "joystick_task.h"
 #include "accelerometer.h"
+#include "step_history.h"
+#include "step_detection.h"
+#include "warm_restart.h"
+#include "activity.h"
+#include "profile.h"
+#include "timebase.h"
+#include "cadence.h"
+#include "bench.h"
+#include "trace.h"
+#include "monitor.h"
+#include "i2c_bus.h"
+#include "gait_gen.h"
+#include "buzzer.h"
 #include <stdio.h>
 
+#define HISTORY_DUMP_BINS_PER_LINE   48  // 96 hex chars per line fits uart_buffer
+#define HISTORY_DUMP_LINES_PER_CALL   2  // Bounds time spent blocking on UART per task run
+#define TRACE_DUMP_RECORDS_PER_LINE   6  // 96 hex chars per line, like the history dump
+#define TRACE_DUMP_LINES_PER_CALL     4
+
 static bool serial_on = false;  // Serial toggle state
 
+// History dump progress (absolute minute indices)
+static bool history_dump_active = false;
+static uint32_t history_dump_next = 0;
+static uint32_t history_dump_last = 0;
+
+// Trace dump progress (index into the frozen ring)
+static bool trace_dump_active = false;
+static uint16_t trace_dump_next = 0;
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+// Sends a formatted buffer over USART2
+static void serial_send(const char *buf, int len) {
+    if (len <= 0) return;
+    trace_begin(TRACE_UART_TX, (uint16_t)len);
+    HAL_UART_Transmit(&huart2, (const uint8_t*)buf, (uint16_t)len, HAL_MAX_DELAY);
+    trace_end(TRACE_UART_TX, (uint16_t)len);
+}
+
+// Starts a history dump covering every retained minute up to now
+static void history_dump_start(void) {
+    char uart_buffer[64];
+    uint32_t current = step_history_current_minute();
+    uint16_t length = step_history_length();
+
+    history_dump_next = current + 1 - length;
+    history_dump_last = current;
+    history_dump_active = true;
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">HIST:BEGIN,%lu,%u\r\n",
+        (unsigned long)history_dump_next, length);
+    serial_send(uart_buffer, len);
+}
+
+// Streams a few lines of the history dump per call
+static void history_dump_execute(void) {
+    char uart_buffer[128];
+    uint8_t bins[HISTORY_DUMP_BINS_PER_LINE];
+
+    for (uint8_t line = 0; line < HISTORY_DUMP_LINES_PER_CALL; line++) {
+        if (history_dump_next > history_dump_last) {
+            serial_send(">HIST:END\r\n", 11);
+            history_dump_active = false;
+            return;
+        }
+
+        // Skip minutes that were overwritten while the dump was in progress
+        uint32_t oldest = step_history_current_minute() + 1 - step_history_length();
+        if (history_dump_next < oldest) history_dump_next = oldest;
+
+        uint32_t wanted = history_dump_last - history_dump_next + 1;
+        uint16_t max = (wanted < HISTORY_DUMP_BINS_PER_LINE) ? (uint16_t)wanted : HISTORY_DUMP_BINS_PER_LINE;
+        uint16_t count = step_history_read((uint16_t)(history_dump_next - oldest), bins, max);
+
+        int len = snprintf(uart_buffer, sizeof(uart_buffer), ">HIST:%lu:", (unsigned long)history_dump_next);
+        for (uint16_t i = 0; i < count; i++) {
+            uart_buffer[len++] = hex_digits[bins[i] >> 4];
+            uart_buffer[len++] = hex_digits[bins[i] & 0x0F];
+        }
+        uart_buffer[len++] = '\r';
+        uart_buffer[len++] = '\n';
+        serial_send(uart_buffer, len);
+
+        history_dump_next += (count > 0) ? count : wanted;
+    }
+}
+
+// Reports which boot path ran and how long it took to reach the first detection
+static void boot_report(void) {
+    char uart_buffer[64];
+    uint32_t first_detection = steps_get_first_detection_ms();
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">BOOT:%s,FIRST_DETECTION_MS:%lu,WARMUP_SAMPLES:%u\r\n",
+        warm_restart_is_warm() ? "warm" : "cold", (unsigned long)first_detection,
+        accelerometer_get_warmup_samples());
+    serial_send(uart_buffer, len);
+}
+
+// Reports the motion-gating state and how long has been spent in each state
+static void activity_report(void) {
+    char uart_buffer[96];
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">ACTIVITY:%s,ACTIVE_MS:%lu,STATIONARY_MS:%lu,SKIPPED:%lu\r\n",
+        activity_is_stationary() ? "stationary" : "active",
+        (unsigned long)activity_get_time_ms(ACTIVITY_ACTIVE),
+        (unsigned long)activity_get_time_ms(ACTIVITY_STATIONARY),
+        (unsigned long)activity_get_skipped_samples());
+    serial_send(uart_buffer, len);
+}
+
+// Reports the active step source
+static void step_source_report(void) {
+    char uart_buffer[48];
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">STEP_SOURCE:%s\r\n",
+        steps_source_name(steps_get_source()));
+    serial_send(uart_buffer, len);
+}
+
+// Reports the buzzer volume
+static void volume_report(void) {
+    static const char* const names[NUM_BUZZER_VOLUMES] = { "low", "medium", "high" };
+    char uart_buffer[32];
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">VOLUME:%s\r\n", names[buzzer_get_volume()]);
+    serial_send(uart_buffer, len);
+}
+
+// Reports the hybrid-mode comparison between the software and hardware counts
+static void pedometer_report(void) {
+    char uart_buffer[112];
+    HybridStats stats = steps_get_hybrid_stats();
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">PEDO:%s,IMU:0x%02X,SW:%lu,HW:%lu,WINDOWS:%lu,MISMATCHES:%lu\r\n",
+        steps_source_name(steps_get_source()), accelerometer_get_imu_id(), (unsigned long)stats.software_steps,
+        (unsigned long)stats.hardware_steps, (unsigned long)stats.windows, (unsigned long)stats.mismatches);
+    serial_send(uart_buffer, len);
+}
+
+// Logs a hybrid comparison window whose counts disagreed
+static void pedometer_mismatch_log(void) {
+    char uart_buffer[48];
+    uint16_t software_steps, hardware_steps;
+
+    if (!steps_take_hybrid_mismatch(&software_steps, &hardware_steps)) return;
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">PEDO_MISMATCH:SW:%u,HW:%u\r\n",
+        software_steps, hardware_steps);
+    serial_send(uart_buffer, len);
+}
+
+// Reports measured load and estimated current for every profile
+static void profile_report(void) {
+    char uart_buffer[96];
+
+    for (uint8_t id = 0; id < NUM_PROFILES; id++) {
+        int len = snprintf(uart_buffer, sizeof(uart_buffer), ">PROFILE:%s%s,LOAD_PERMILLE:%u,EST_UA:%lu\r\n",
+            profile_get_by_id((profile_id_t)id)->name, (id == profile_get_id()) ? "*" : "",
+            profile_load_permille((profile_id_t)id),
+            (unsigned long)profile_estimated_current_ua((profile_id_t)id));
+        serial_send(uart_buffer, len);
+    }
+}
+
+// Reports the CIC front-end's decimation ratio and cost per high-rate input sample
+static void cic_report(void) {
+    char uart_buffer[96];
+    CicStats stats = accelerometer_get_cic_stats();
+    int len;
+
+    if (!ACCEL_CIC_FRONTEND) {
+        len = snprintf(uart_buffer, sizeof(uart_buffer), ">CIC:OFF\r\n");
+    } else {
+        uint32_t cycles_x100 = (stats.inputs > 0) ? (uint32_t)((uint64_t)stats.cycles * 100 / stats.inputs) : 0;
+        len = snprintf(uart_buffer, sizeof(uart_buffer), ">CIC:RATIO:%u,IN:%lu,OUT:%lu,CYCLES_PER_INPUT:%lu.%02lu\r\n",
+            stats.ratio, (unsigned long)stats.inputs, (unsigned long)stats.outputs,
+            (unsigned long)(cycles_x100 / 100), (unsigned long)(cycles_x100 % 100));
+    }
+    serial_send(uart_buffer, len);
+}
+
+// Reports the cadence estimate and the bank's measured cost per filtered sample
+static void cadence_report(void) {
+    char uart_buffer[80];
+    CadenceStats stats = cadence_get_stats();
+    uint32_t cycles_x100 = (stats.samples > 0) ? (uint32_t)((uint64_t)stats.cycles * 100 / stats.samples) : 0;
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">CADENCE:SPM:%u,SAMPLES:%lu,CYCLES_PER_SAMPLE:%lu.%02lu\r\n",
+        cadence_get_spm(), (unsigned long)stats.samples,
+        (unsigned long)(cycles_x100 / 100), (unsigned long)(cycles_x100 % 100));
+    serial_send(uart_buffer, len);
+}
+
+// Reports the detector mode, the adaptive bands and the mean cost per evaluation of each mode
+static void detector_report(void) {
+    char uart_buffer[160];
+    AdaptiveStats adaptive = steps_get_adaptive_stats();
+    DetectorStats stats = steps_get_detector_stats();
+    uint32_t cycles_x100[NUM_STEP_DETECTORS];
+
+    for (uint8_t mode = 0; mode < NUM_STEP_DETECTORS; mode++) {
+        cycles_x100[mode] = (stats.evaluations[mode] > 0) ?
+            (uint32_t)((uint64_t)stats.cycles[mode] * 100 / stats.evaluations[mode]) : 0;
+    }
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer),
+        ">DETECTOR:%s,UPPER:%u,LOWER:%u,PEAK:%u,TROUGH:%u,CAL:%s,FROZEN:%lu,FIXED_CYCLES:%lu.%02lu,ADAPTIVE_CYCLES:%lu.%02lu\r\n",
+        steps_detector_name(steps_get_detector()), adaptive.upper, adaptive.lower, adaptive.peak, adaptive.trough,
+        adaptive.calibrating ? "running" : (adaptive.calibrated ? "saved" : "none"), (unsigned long)adaptive.frozen,
+        (unsigned long)(cycles_x100[STEP_DETECTOR_FIXED] / 100), (unsigned long)(cycles_x100[STEP_DETECTOR_FIXED] % 100),
+        (unsigned long)(cycles_x100[STEP_DETECTOR_ADAPTIVE] / 100), (unsigned long)(cycles_x100[STEP_DETECTOR_ADAPTIVE] % 100));
+    serial_send(uart_buffer, len);
+}
+
+// Reports the last monitor window: overall and peak load, stack use, then each task's load (permille)
+static void monitor_report(void) {
+    char uart_buffer[128];
+    MonitorStats stats = monitor_get_stats();
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer),
+        ">MONITOR:LOAD_PERMILLE:%u,PEAK_PERMILLE:%u,STACK_USED:%lu,STACK_SIZE:%lu\r\n",
+        stats.load_permille, stats.peak_load_permille,
+        (unsigned long)stats.stack_used, (unsigned long)stats.stack_size);
+    serial_send(uart_buffer, len);
+
+    len = snprintf(uart_buffer, sizeof(uart_buffer), ">MONITOR_TASKS:");
+    for (uint8_t task = 0; task < NUM_MONITOR_TASKS; task++) {
+        len += snprintf(uart_buffer + len, sizeof(uart_buffer) - len, (task == 0) ? "%s:%u" : ",%s:%u",
+            monitor_task_name((monitor_task_t)task), stats.task_permille[task]);
+    }
+    len += snprintf(uart_buffer + len, sizeof(uart_buffer) - len, "\r\n");
+    serial_send(uart_buffer, len);
+}
+
+// Reports each I2C device's counters and worst transaction time, then the bus recovery count
+static void i2c_report(void) {
+    char uart_buffer[128];
+    int len;
+
+    for (uint8_t device = 0; device < NUM_I2C_DEVICES; device++) {
+        I2cDeviceStats stats = i2c_bus_get_stats((i2c_device_t)device);
+        len = snprintf(uart_buffer, sizeof(uart_buffer),
+            ">I2C:%s,TX:%lu,ERR:%lu,RETRY:%lu,TIMEOUT:%lu,SKIP:%lu,WORST_US:%lu\r\n",
+            i2c_bus_device_name((i2c_device_t)device), (unsigned long)stats.transactions,
+            (unsigned long)stats.errors, (unsigned long)stats.retries, (unsigned long)stats.timeouts,
+            (unsigned long)stats.skipped, (unsigned long)stats.worst_us);
+        serial_send(uart_buffer, len);
+    }
+
+    len = snprintf(uart_buffer, sizeof(uart_buffer), ">I2C:RECOVERIES:%lu\r\n", (unsigned long)i2c_bus_recoveries());
+    serial_send(uart_buffer, len);
+}
+
+// Makes every attempt of the IMU's next transaction stall, which exercises recovery and back-off
+static void i2c_inject_stall(void) {
+    char uart_buffer[48];
+
+    i2c_bus_inject_fault(I2C_DEVICE_IMU, I2C_FAULT_STALL, I2C_BUS_MAX_ATTEMPTS);
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">I2C:INJECT,%s,STALL,%u,ENABLED:%u\r\n",
+        i2c_bus_device_name(I2C_DEVICE_IMU), I2C_BUS_MAX_ATTEMPTS, I2C_BUS_FAULT_INJECTION);
+    serial_send(uart_buffer, len);
+}
+
+// Appends 'digits' hex digits of value to buf and returns the new length
+static int append_hex(char *buf, int len, uint32_t value, uint8_t digits) {
+    while (digits > 0) {
+        digits--;
+        buf[len++] = hex_digits[(value >> (digits * 4)) & 0x0F];
+    }
+    return len;
+}
+
+// Freezes the trace ring and sends the dump header and the event name table
+static void trace_dump_start(void) {
+    char uart_buffer[64];
+
+    trace_freeze(true);
+    trace_dump_next = 0;
+    trace_dump_active = true;
+
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">TRACE:BEGIN,%u,CLOCK_KHZ:%lu,DROPPED:%lu\r\n",
+        trace_count(), (unsigned long)timebase_cycles_per_ms(), (unsigned long)trace_dropped());
+    serial_send(uart_buffer, len);
+
+    serial_send(">TRACE:EVENTS:", 14);
+    for (uint8_t event = 0; event < NUM_TRACE_EVENTS; event++) {
+        len = snprintf(uart_buffer, sizeof(uart_buffer), (event == 0) ? "%s" : ",%s", trace_event_name(event));
+        serial_send(uart_buffer, len);
+    }
+    serial_send("\r\n", 2);
+}
+
+// Streams a few lines of the trace dump per call; each record is stamp(8) event(2) phase(2) arg(4) in hex.
+// Recording resumes with an empty ring once the dump completes
+static void trace_dump_execute(void) {
+    char uart_buffer[128];
+    TraceRecord record;
+
+    for (uint8_t line = 0; line < TRACE_DUMP_LINES_PER_CALL; line++) {
+        if (trace_dump_next >= trace_count()) {
+            serial_send(">TRACE:END\r\n", 12);
+            trace_dump_active = false;
+            trace_clear();
+            trace_freeze(false);
+            return;
+        }
+
+        int len = snprintf(uart_buffer, sizeof(uart_buffer), ">TRACE:%u:", trace_dump_next);
+        for (uint8_t i = 0; i < TRACE_DUMP_RECORDS_PER_LINE && trace_get(trace_dump_next, &record); i++) {
+            len = append_hex(uart_buffer, len, record.stamp, 8);
+            len = append_hex(uart_buffer, len, record.event, 2);
+            len = append_hex(uart_buffer, len, record.phase, 2);
+            len = append_hex(uart_buffer, len, record.arg, 4);
+            trace_dump_next++;
+        }
+        uart_buffer[len++] = '\r';
+        uart_buffer[len++] = '\n';
+        serial_send(uart_buffer, len);
+    }
+}
+
+// Reports the next microbenchmark result (cycles from SysTick, ns at the current core clock)
+static void bench_report_next(void) {
+    char uart_buffer[96];
+    BenchResult result;
+
+    if (!bench_run_next(&result)) return;
+
+    uint32_t cycles_x100 = (result.samples > 0) ? (uint32_t)((uint64_t)result.cycles * 100 / result.samples) : 0;
+    uint32_t ns = (uint32_t)((uint64_t)cycles_x100 * 10000 / timebase_cycles_per_ms());
+    int len = snprintf(uart_buffer, sizeof(uart_buffer), ">BENCH:%s,N:%lu,CYCLES_PER_SAMPLE:%lu.%02lu,NS_PER_SAMPLE:%lu\r\n",
+        result.name, (unsigned long)result.samples,
+        (unsigned long)(cycles_x100 / 100), (unsigned long)(cycles_x100 % 100), (unsigned long)ns);
+    serial_send(uart_buffer, len);
+
+    if (!bench_is_running()) {
+        uint32_t mismatches;
+        uint32_t checked = bench_filter_check(&mismatches);
+        len = snprintf(uart_buffer, sizeof(uart_buffer), ">BENCH:END,CLOCK_KHZ:%lu,FILTER_CHECKED:%lu,FILTER_MISMATCHES:%lu\r\n",
+            (unsigned long)timebase_cycles_per_ms(), (unsigned long)checked, (unsigned long)mismatches);
+        serial_send(uart_buffer, len);
+    }
+}
+
+// Reports finished gait ramp steps (rate, processed and dropped samples, mean cycles per stage), then the result
+static void gait_report_next(void) {
+    char uart_buffer[128];
+    GaitStepResult result;
+    int len;
+
+    while (gait_gen_next_result(&result)) {
+        len = snprintf(uart_buffer, sizeof(uart_buffer), ">GAIT:HZ:%lu,SAMPLES:%lu,DROPPED:%lu",
+            (unsigned long)result.rate_hz, (unsigned long)result.samples, (unsigned long)result.dropped);
+        for (uint8_t stage = 0; stage < NUM_GAIT_STAGES; stage++) {
+            len += snprintf(uart_buffer + len, sizeof(uart_buffer) - len, ",%s:%lu",
+                gait_gen_stage_name((gait_stage_t)stage), (unsigned long)result.stage_cycles[stage]);
+        }
+        len += snprintf(uart_buffer + len, sizeof(uart_buffer) - len, "\r\n");
+        serial_send(uart_buffer, len);
+    }
+
+    if (gait_gen_take_ramp_end()) {
+        len = snprintf(uart_buffer, sizeof(uart_buffer), ">GAIT:END,MAX_HZ:%lu,CLOCK_KHZ:%lu\r\n",
+            (unsigned long)gait_gen_max_rate_hz(), (unsigned long)timebase_cycles_per_ms());
+        serial_send(uart_buffer, len);
+    }
+}
+
+// Polls USART2 for a single command byte without blocking
+static void serial_poll_command(void) {
+    uint8_t command;
+
+    // An overrun stops reception until ORE is cleared, and a zero-timeout receive returns
+    // before the HAL would clear it, so a single overrun would leave every command dead
+    if (__HAL_UART_GET_FLAG(&huart2, UART_FLAG_ORE)) {
+        __HAL_UART_CLEAR_OREFLAG(&huart2);
+    }
+    if (HAL_UART_Receive(&huart2, &command, 1, 0) != HAL_OK) return;
+
+    switch (command) {
+        case 'H':
+            history_dump_start();
+            break;
+
+        case 'B':
+            boot_report();
+            break;
+
+        case 'A':
+            activity_report();
+            break;
+
+        case 'S':
+            steps_set_source((step_source_t)((steps_get_source() + 1) % NUM_STEP_SOURCES));
+            step_source_report();
+            break;
+
+        case 'P':
+            pedometer_report();
+            break;
+
+        case 'L':
+            profile_report();
+            break;
+
+        case 'C':
+            cic_report();
+            break;
+
+        case 'R':
+            cadence_report();
+            break;
+
+        case 'D':
+            steps_set_detector((step_detector_t)((steps_get_detector() + 1) % NUM_STEP_DETECTORS));
+            detector_report();
+            break;
+
+        case 'K':
+            steps_calibrate_start();
+            detector_report();
+            break;
+
+        case 'M':
+            bench_start();
+            break;
+
+        case 'T':
+            if (!trace_dump_active) trace_dump_start();
+            break;
+
+        case 'U':
+            monitor_report();
+            break;
+
+        case 'I':
+            i2c_report();
+            break;
+
+        case 'J':
+            i2c_inject_stall();
+            break;
+
+        case 'G':
+            if (gait_gen_is_running()) {
+                gait_gen_stop();
+            } else {
+                GaitParams params = gait_gen_default_params();
+                gait_gen_start_ramp(&params);
+            }
+            break;
+
+        case 'V':
+            buzzer_set_volume((buzzer_volume_t)((buzzer_get_volume() + 1) % NUM_BUZZER_VOLUMES));
+            buzzer_play(BUZZER_MELODY_CONFIRM);
+            volume_report();
+            break;
+
+        default:
+            break;
+    }
+}
+
 // Enables/disables UART data output
 void serial_toggle(void) {
     serial_on = !serial_on;
 }
 
-// Outputs joystick and filtered acceleration data to UART
+// Handles commands and, if enabled, outputs joystick and filtered acceleration data to UART
 void serial_task_execute(void) {
+    serial_poll_command();
+
+    if (history_dump_active) {
+        history_dump_execute();
+    }
+
+    if (trace_dump_active) {
+        trace_dump_execute();
+    }
+
+    if (bench_is_running()) {
+        bench_report_next();
+    }
+
+    gait_report_next();
+
+    pedometer_mismatch_log();
+
     if (!serial_on) return;
 
     char uart_buffer[128];
@@ -32,10 +530,11 @@ void serial_task_execute(void) {
 
     // Format data for UART transmission
     int len = snprintf(uart_buffer, sizeof(uart_buffer),
-        ">ACC_X:%d,ACC_Y:%d,ACC_Z:%d,MAG:%llu\r\n",
+        ">ACC_X:%d,ACC_Y:%d,ACC_Z:%d,MAG:%llu,DYN:%llu,T_US:%llu\r\n",
         data.acc_x_filtered, data.acc_y_filtered, data.acc_z_filtered,
-        data.magnitude_square);
+        (unsigned long long)data.magnitude_square, (unsigned long long)data.dynamic_magnitude_square,
+        (unsigned long long)accelerometer_get_sample_time_us());
 
     // Send over USART2
-    HAL_UART_Transmit(&huart2, (uint8_t*)uart_buffer, len, HAL_MAX_DELAY);
+    serial_send(uart_buffer, len);
 }
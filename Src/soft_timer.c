@@ -0,0 +1,163 @@
+/*
+ * soft_timer.c
+ *
+ * Hierarchical timer wheel. Level 0 has one slot per millisecond for the next
+ * 64 ms, level 1 one slot per 64 ms for the next 4 s, and level 2 one slot per
+ * 4.096 s. A timer further out sits in a coarse slot until the wheel reaches
+ * it. That slot is then cascaded: its timers are re-inserted one level finer,
+ * so every timer fires on its exact tick. Slots are doubly linked through
+ * 'link', so a timer can be removed without searching.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "soft_timer.h"
+#include "stm32c0xx_hal.h"
+
+#define SLOT_MASK    (SOFT_TIMER_SLOTS - 1)
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static SoftTimer *wheel[SOFT_TIMER_LEVELS][SOFT_TIMER_SLOTS];
+static uint32_t wheel_tick = 0;     // Every timer due at or before this tick has fired
+static uint16_t active_count = 0;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Links a timer into the slot matching its distance from the wheel's current tick
+static void insert(SoftTimer *timer) {
+    uint32_t delta = timer->expires - wheel_tick;
+    uint8_t level = 0;
+
+    while (level < SOFT_TIMER_LEVELS - 1 && delta >= (1u << (SOFT_TIMER_SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+
+    SoftTimer **head = &wheel[level][(timer->expires >> (SOFT_TIMER_SLOT_BITS * level)) & SLOT_MASK];
+    timer->next = *head;
+    if (*head != NULL) (*head)->link = &timer->next;
+    timer->link = head;
+    *head = timer;
+}
+
+static void detach(SoftTimer *timer) {
+    *timer->link = timer->next;
+    if (timer->next != NULL) timer->next->link = timer->link;
+    timer->next = NULL;
+    timer->link = NULL;
+}
+
+// Re-inserts every timer of a coarse slot; each lands one or more levels finer
+static void cascade(uint8_t level, uint8_t slot) {
+    SoftTimer *timer = wheel[level][slot];
+    wheel[level][slot] = NULL;
+
+    while (timer != NULL) {
+        SoftTimer *next = timer->next;
+        insert(timer);
+        timer = next;
+    }
+}
+
+// Advances the wheel by one tick and fires what is due on it
+static void advance(void) {
+    wheel_tick++;
+
+    if ((wheel_tick & SLOT_MASK) == 0) {
+        // Coarsest first: level 2 timers may land in the level 1 slot cascaded next
+        if (((wheel_tick >> SOFT_TIMER_SLOT_BITS) & SLOT_MASK) == 0) {
+            cascade(2, (wheel_tick >> (2 * SOFT_TIMER_SLOT_BITS)) & SLOT_MASK);
+        }
+        cascade(1, (wheel_tick >> SOFT_TIMER_SLOT_BITS) & SLOT_MASK);
+    }
+
+    // Callbacks may start or cancel timers; none can land back in this slot, as the earliest is the next tick
+    SoftTimer **slot = &wheel[0][wheel_tick & SLOT_MASK];
+    while (*slot != NULL) {
+        SoftTimer *timer = *slot;
+        detach(timer);
+
+        if (timer->period > 0) {
+            timer->expires += timer->period;
+            insert(timer);
+        } else {
+            active_count--;
+        }
+        if (timer->callback != NULL) timer->callback();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void soft_timer_init(void) {
+    for (uint8_t level = 0; level < SOFT_TIMER_LEVELS; level++) {
+        for (uint8_t slot = 0; slot < SOFT_TIMER_SLOTS; slot++) {
+            wheel[level][slot] = NULL;
+        }
+    }
+    wheel_tick = HAL_GetTick();
+    active_count = 0;
+}
+
+void soft_timer_start(SoftTimer *timer, uint32_t delay_ms, uint32_t period_ms, soft_timer_callback_t callback) {
+    if (timer->link != NULL) {
+        detach(timer);
+    } else {
+        active_count++;
+    }
+
+    if (delay_ms > SOFT_TIMER_MAX_DELAY_MS) delay_ms = SOFT_TIMER_MAX_DELAY_MS;
+    if (period_ms > SOFT_TIMER_MAX_DELAY_MS) period_ms = SOFT_TIMER_MAX_DELAY_MS;
+
+    // Measured from the current tick, which the wheel may not have processed yet
+    uint32_t expires = HAL_GetTick() + delay_ms;
+    if ((int32_t)(expires - wheel_tick) <= 0) expires = wheel_tick + 1;
+
+    timer->expires = expires;
+    timer->period = period_ms;
+    timer->callback = callback;
+    insert(timer);
+}
+
+void soft_timer_cancel(SoftTimer *timer) {
+    if (timer->link == NULL) return;
+    detach(timer);
+    active_count--;
+}
+
+bool soft_timer_is_active(const SoftTimer *timer) {
+    return timer->link != NULL;
+}
+
+void soft_timer_process(uint32_t now) {
+    while ((int32_t)(now - wheel_tick) > 0) {
+        advance();
+    }
+}
+
+bool soft_timer_next_expiry(uint32_t *tick) {
+    if (active_count == 0) return false;
+
+    // Exact within the next 64 ticks
+    for (uint32_t ahead = 1; ahead <= SOFT_TIMER_SLOTS; ahead++) {
+        uint32_t candidate = wheel_tick + ahead;
+        if ((candidate & SLOT_MASK) == 0) {
+            break;  // Beyond here, coarse slots cascade first
+        }
+        if (wheel[0][candidate & SLOT_MASK] != NULL) {
+            *tick = candidate;
+            return true;
+        }
+    }
+
+    // Otherwise nothing fires before the next cascade, which may bring timers down to level 0
+    *tick = (wheel_tick | SLOT_MASK) + 1;
+    return true;
+}
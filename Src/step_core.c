@@ -0,0 +1,590 @@
+/*
+ * step_core.c
+ *
+ * Signal processing behind step detection, free of HAL and module state.
+ * Raw samples get orientation offsets and a moving average per axis; a slow
+ * low-pass gravity estimate picks the offsets (re-evaluated on a timer or a
+ * large move, not per sample) and is subtracted from the filtered vector to
+ * give an orientation-independent dynamic magnitude. The detector counts once
+ * per excursion above the upper level and re-arms once back inside the lower
+ * one: a fixed threshold on the magnitude, or adaptive bands on the extremes
+ * of its signed vertical component.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "step_core.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define ORIENTATION_THRESHOLD  16000  // Raw axis value above which a dominant orientation is detected
+#define SETTLE_MS                 50  // Output must stay stable this long before it is trusted
+#define SETTLE_SHIFT               4  // Stable = magnitude moved less than 1/16 since last sample
+
+#define GRAVITY_TIME_CONSTANT_MS 1000  // Gravity low-pass time constant (alpha = 1/2^shift, rounded)
+#define GRAVITY_REEVAL_MS        1000  // Re-check orientation calibration at least once a second...
+#define GRAVITY_MOVE_THRESHOLD   2000  // ...or sooner once any gravity axis has moved this far
+
+_Static_assert(STEP_CORE_MS_TO_SAMPLES(STEP_CORE_FILTER_WINDOW_MS, STEP_CORE_MAX_SAMPLE_HZ) <= STEP_CORE_MAX_FILTER_LENGTH,
+               "The filter window at the fastest rate must fit the buffer");
+#define GRAVITY_ONE_G_SHIFT        14  // 1 g = 2^14 raw units (+/-2 g full scale)
+
+#define RECIPROCAL_SHIFT          24  // sum * ceil(2^24 / length) >> 24 is exact for any window of int16 values
+#define RECIPROCAL_SPLIT          12  // The product is formed in two halves that each fit 32 bits
+
+#define DEFAULT_SAMPLE_HZ         60
+#define DEFAULT_DETECT_HZ          6
+#define PROCESS_BLOCK             32  // Samples step_core_process() hands the filter per batch call
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Returns average of the values currently in the buffer
+static int16_t filter_average(const AveragingFilter *filter, uint8_t length) {
+    int32_t sum = 0;
+    for (int i = 0; i < length; i++) {
+        sum += filter->buffer[i];
+    }
+    return (int16_t)(sum / length);
+}
+
+// Sets a tri-axis filter's window and the reciprocal that stands in for its divide
+static void tri_set_length(TriAxisFilter *filter, uint8_t length) {
+    filter->length = length;
+    filter->reciprocal = ((1u << RECIPROCAL_SHIFT) + length - 1) / length;
+}
+
+// Returns sum / length truncated toward zero, as C division would. |sum| stays below 2^20, so
+// |sum| * (reciprocal >> 12) and the low half's share both fit 32 bits: two MULS, no 64-bit helper
+static int16_t tri_divide(const TriAxisFilter *filter, int32_t sum) {
+    uint32_t magnitude = (sum < 0) ? (uint32_t)-sum : (uint32_t)sum;
+    uint32_t high = magnitude * (filter->reciprocal >> RECIPROCAL_SPLIT);
+    uint32_t low = (magnitude * (filter->reciprocal & ((1u << RECIPROCAL_SPLIT) - 1))) >> RECIPROCAL_SPLIT;
+    int32_t quotient = (int32_t)((high + low) >> (RECIPROCAL_SHIFT - RECIPROCAL_SPLIT));
+    return (int16_t)((sum < 0) ? -quotient : quotient);
+}
+
+// Fills the whole window with one sample
+static void tri_seed(TriAxisFilter *filter, const int16_t sample[3]) {
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        for (uint8_t i = 0; i < filter->length; i++) {
+            filter->history[i][axis] = sample[axis];
+        }
+        filter->sum[axis] = (int32_t)sample[axis] * filter->length;
+    }
+    filter->index = 0;
+    filter->seeded = true;
+}
+
+// Refills a seeded filter's window at a new length with its current averages
+static void tri_resize(TriAxisFilter *filter, uint8_t new_length) {
+    int16_t average[3];
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        average[axis] = tri_divide(filter, filter->sum[axis]);
+    }
+    tri_set_length(filter, new_length);
+    tri_seed(filter, average);
+}
+
+// Runs one sample through the filter; the value leaving the window is swapped for the new one in each sum
+static void tri_push(TriAxisFilter *filter, const int16_t sample[3], int16_t out[3]) {
+    if (!filter->seeded) {
+        tri_seed(filter, sample);
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            out[axis] = sample[axis];
+        }
+        return;
+    }
+
+    int16_t *row = filter->history[filter->index];
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        int16_t value = sample[axis];
+        filter->sum[axis] += value - row[axis];
+        row[axis] = value;
+        out[axis] = tri_divide(filter, filter->sum[axis]);
+    }
+    if (++filter->index >= filter->length) filter->index = 0;
+}
+
+#if defined(__SSE2__)
+// Host builds keep the three sums in one SSE register and divide in float: |sum| < 2^24 converts
+// exactly, a whole quotient comes out exact, and any other lies at least 1/length from a whole
+// number, far beyond float rounding, so truncation gives the same result as tri_divide()
+static void tri_batch_sse2(TriAxisFilter *filter, const int16_t (*in)[3], int16_t (*out)[3], uint16_t n) {
+    __m128i sum = _mm_setr_epi32(filter->sum[0], filter->sum[1], filter->sum[2], 0);
+    const __m128 length = _mm_set1_ps((float)filter->length);
+    int32_t lanes[4];
+    uint8_t index = filter->index;
+
+    for (uint16_t i = 0; i < n; i++) {
+        int16_t *row = filter->history[index];
+        __m128i value = _mm_setr_epi32(in[i][0], in[i][1], in[i][2], 0);
+        sum = _mm_add_epi32(sum, _mm_sub_epi32(value, _mm_setr_epi32(row[0], row[1], row[2], 0)));
+        row[0] = in[i][0];
+        row[1] = in[i][1];
+        row[2] = in[i][2];
+
+        _mm_storeu_si128((__m128i *)lanes, _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(sum), length)));
+        out[i][0] = (int16_t)lanes[0];
+        out[i][1] = (int16_t)lanes[1];
+        out[i][2] = (int16_t)lanes[2];
+        if (++index >= filter->length) index = 0;
+    }
+
+    _mm_storeu_si128((__m128i *)lanes, sum);
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        filter->sum[axis] = lanes[axis];
+    }
+    filter->index = index;
+}
+#endif
+
+static int16_t gravity_axis(const StepCore *core, uint8_t axis) {
+    return (int16_t)(core->gravity_acc[axis] >> core->gravity_shift);
+}
+
+static int16_t abs_diff(int16_t a, int16_t b) {
+    return (a > b) ? a - b : b - a;
+}
+
+// Chooses orientation calibration offsets from the smoothed gravity vector
+static void select_orientation_offsets(StepCore *core) {
+    int16_t gx = gravity_axis(core, 0), gy = gravity_axis(core, 1), gz = gravity_axis(core, 2);
+    int16_t *offset = core->offset;
+
+    if (gx > ORIENTATION_THRESHOLD) {          // Portrait right
+        offset[0] = 100; offset[1] = -70; offset[2] = -500;
+    } else if (gx < -ORIENTATION_THRESHOLD) {  // Portrait left
+        offset[0] = 100; offset[1] = 0; offset[2] = 300;
+    } else if (gy > ORIENTATION_THRESHOLD) {   // Landscape top-up
+        offset[0] = 500; offset[1] = -200; offset[2] = 600;
+    } else if (gy < -ORIENTATION_THRESHOLD) {  // Landscape top-down
+        offset[0] = -65; offset[1] = 0; offset[2] = -225;
+    } else if (gz > ORIENTATION_THRESHOLD) {   // Face-up (flat)
+        offset[0] = 150; offset[1] = -110; offset[2] = 0;
+    } else {                                   // Face-down (flat)
+        offset[0] = 0; offset[1] = 0; offset[2] = 0;
+    }
+
+    core->gravity_at_eval[0] = gx;
+    core->gravity_at_eval[1] = gy;
+    core->gravity_at_eval[2] = gz;
+    core->samples_since_eval = 0;
+}
+
+// Seeds the gravity estimate from a single sample (scaled by multiplying: left-shifting a
+// negative value is undefined)
+static void gravity_seed(StepCore *core, int16_t ax, int16_t ay, int16_t az) {
+    int32_t scale = (int32_t)1 << core->gravity_shift;
+    core->gravity_acc[0] = ax * scale;
+    core->gravity_acc[1] = ay * scale;
+    core->gravity_acc[2] = az * scale;
+    select_orientation_offsets(core);
+}
+
+// One incremental low-pass step; offsets are only re-chosen on a timer or a large move
+static void gravity_update(StepCore *core, int16_t ax, int16_t ay, int16_t az) {
+    core->gravity_acc[0] += ax - gravity_axis(core, 0);
+    core->gravity_acc[1] += ay - gravity_axis(core, 1);
+    core->gravity_acc[2] += az - gravity_axis(core, 2);
+
+    if (++core->samples_since_eval >= core->reeval_samples ||
+        abs_diff(gravity_axis(core, 0), core->gravity_at_eval[0]) > GRAVITY_MOVE_THRESHOLD ||
+        abs_diff(gravity_axis(core, 1), core->gravity_at_eval[1]) > GRAVITY_MOVE_THRESHOLD ||
+        abs_diff(gravity_axis(core, 2), core->gravity_at_eval[2]) > GRAVITY_MOVE_THRESHOLD) {
+        select_orientation_offsets(core);
+    }
+}
+
+// Component of a dynamic vector along the gravity estimate, in raw units (saturated to 16 bits)
+static int16_t along_gravity(const StepCore *core, int32_t dx, int32_t dy, int32_t dz) {
+    int64_t dot = (int64_t)dx * gravity_axis(core, 0) + (int64_t)dy * gravity_axis(core, 1) +
+                  (int64_t)dz * gravity_axis(core, 2);
+    int64_t vertical = dot >> GRAVITY_ONE_G_SHIFT;
+    if (vertical > INT16_MAX) vertical = INT16_MAX;
+    if (vertical < INT16_MIN) vertical = INT16_MIN;
+    return (int16_t)vertical;
+}
+
+// Publishes a filtered vector along with its total and gravity-removed magnitudes
+static void publish_filtered(StepCore *core, int16_t fx, int16_t fy, int16_t fz) {
+    int16_t gx = gravity_axis(core, 0), gy = gravity_axis(core, 1), gz = gravity_axis(core, 2);
+    int32_t dx = fx - (gx + core->offset[0]);
+    int32_t dy = fy - (gy + core->offset[1]);
+    int32_t dz = fz - (gz + core->offset[2]);
+
+    core->latest = (FilteredAcceleration){
+        .acc_x_filtered = fx,
+        .acc_y_filtered = fy,
+        .acc_z_filtered = fz,
+        .magnitude_square = step_core_magnitude_squared(fx, fy, fz),
+        .dynamic_magnitude_square = (uint64_t)((int64_t)dx * dx + (int64_t)dy * dy + (int64_t)dz * dz),
+        .vertical_dynamic = along_gravity(core, dx, dy, dz)
+    };
+}
+
+// Tracks whether the filtered magnitude has settled since start-up
+static void update_ready(StepCore *core, uint64_t previous, uint64_t current) {
+    if (core->ready) return;
+
+    uint64_t delta = (current > previous) ? current - previous : previous - current;
+    core->stable_samples = (delta < (previous >> SETTLE_SHIFT)) ? core->stable_samples + 1 : 0;
+    core->warmup_samples++;
+
+    // Ready regardless once the window holds only real data
+    if (core->stable_samples >= core->settle_samples || core->warmup_samples >= core->filter.length) {
+        core->ready = true;
+    }
+}
+
+// Empties the window of vertical extremes the next evaluation classifies
+static void clear_vertical_extremes(StepCore *core) {
+    core->vertical_high = INT16_MIN;
+    core->vertical_low = INT16_MAX;
+}
+
+// Publishes one filter output, tracks settling and the adaptive detector's extremes
+static void accept_filtered(StepCore *core, const int16_t filtered[3]) {
+    uint64_t previous_magnitude = core->latest.magnitude_square;
+
+    publish_filtered(core, filtered[0], filtered[1], filtered[2]);
+    update_ready(core, previous_magnitude, core->latest.magnitude_square);
+
+    // Extremes for the adaptive detector; settling output is left out
+    int16_t vertical = core->latest.vertical_dynamic;
+    if (!core->ready) {
+        clear_vertical_extremes(core);
+    } else {
+        if (vertical > core->vertical_high) {
+            core->vertical_high = vertical;
+            core->vertical_fell_last = false;
+        }
+        if (vertical < core->vertical_low) {
+            core->vertical_low = vertical;
+            core->vertical_fell_last = true;
+        }
+    }
+}
+
+// Feeds the adaptive tracker the extremes since the last evaluation and classifies them
+// against its bands. Holding the extremes between the step task's runs keeps every
+// bounce in view however the runs fall against it, and the signed vertical component
+// gives one peak per step where the magnitude would give two
+static void adaptive_classify(StepCore *core, uint32_t now_ms, bool *above, bool *inside, bool *fell_last) {
+    int16_t high = core->vertical_high, low = core->vertical_low;
+    *fell_last = core->vertical_fell_last;
+    clear_vertical_extremes(core);
+
+    // Envelopes hold still through pauses (quiet, no recent step) and when no sample arrived
+    bool quiet = high < ADAPT_QUIET_LEVEL && low > -ADAPT_QUIET_LEVEL;
+    bool paused = high < low || (quiet && now_ms - core->last_step_ms >= ADAPT_PAUSE_MS);
+    if (adaptive_update(&core->tracker, high, low, paused, now_ms)) {
+        core->calibration_done = true;
+    }
+
+    *above = high > (int32_t)core->tracker.upper;
+    *inside = low < -(int32_t)core->tracker.lower;
+}
+
+// Batch API: runs the detector if sample i falls on its decimation phase and appends any step
+static uint16_t detect_sample(StepCore *core, const StepCoreSample *samples, uint16_t i,
+                              StepCoreEvent *events_out, uint16_t events) {
+    if (++core->detect_phase < core->detect_every) return events;
+    core->detect_phase = 0;
+    if (!core->ready) return events;
+
+    if (step_core_detect(core, core->latest.dynamic_magnitude_square, samples[i].t_ms)) {
+        events_out[events].t_ms = samples[i].t_ms;
+        events_out[events].sample = i;
+        events++;
+    }
+    return events;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+// Returns average of buffer after inserting new value
+int16_t step_core_filter_apply(AveragingFilter *filter, uint8_t length, int16_t new_value) {
+    if (!filter->seeded) {
+        for (int i = 0; i < length; i++) {
+            filter->buffer[i] = new_value;
+        }
+        filter->index = 0;
+        filter->seeded = true;
+        return new_value;
+    }
+
+    filter->buffer[filter->index] = new_value;
+    if (++filter->index >= length) filter->index = 0;
+    return filter_average(filter, length);
+}
+
+void step_core_tri_filter_init(TriAxisFilter *filter, uint8_t length) {
+    memset(filter, 0, sizeof(*filter));
+    tri_set_length(filter, length);
+}
+
+void step_core_tri_filter_batch(TriAxisFilter *filter, const int16_t (*in)[3], int16_t (*out)[3], uint16_t n) {
+    uint16_t i = 0;
+
+    // The first sample of an unseeded filter fills the window
+    if (n > 0 && !filter->seeded) {
+        tri_push(filter, in[0], out[0]);
+        i = 1;
+    }
+
+#if defined(__SSE2__)
+    tri_batch_sse2(filter, in + i, out + i, n - i);
+#else
+    for (; i < n; i++) {
+        tri_push(filter, in[i], out[i]);
+    }
+#endif
+}
+
+// Computes squared magnitude without sqrt for performance
+uint64_t step_core_magnitude_squared(int16_t x, int16_t y, int16_t z) {
+    return (int64_t)x * x + (int64_t)y * y + (int64_t)z * z;
+}
+
+void step_core_init(StepCore *core) {
+    memset(core, 0, sizeof(*core));
+    step_core_tri_filter_init(&core->filter, STEP_CORE_MAX_FILTER_LENGTH);
+    step_core_configure_sampling(core, DEFAULT_SAMPLE_HZ);
+    step_core_configure_detector(core, DEFAULT_DETECT_HZ, STEP_DYNAMIC_THRESHOLD);
+    core->refractory_ms = STEP_REFRACTORY_MS;
+    core->detect_every = 1;
+    clear_vertical_extremes(core);
+    adaptive_reset(&core->tracker, 0, 0);
+}
+
+bool step_core_configure_sampling(StepCore *core, uint16_t sample_hz) {
+    // A shorter window would move the filter's null and change detection, so the rate is refused
+    uint32_t length = STEP_CORE_MS_TO_SAMPLES(STEP_CORE_FILTER_WINDOW_MS, sample_hz);
+    if (sample_hz == 0 || length > STEP_CORE_MAX_FILTER_LENGTH) return false;
+
+    // Gravity estimate is rescaled in place to the new shift (a multiply, as the axes can be negative)
+    uint8_t new_shift = step_core_shift_for_samples(STEP_CORE_MS_TO_SAMPLES(GRAVITY_TIME_CONSTANT_MS, sample_hz));
+    int32_t scale = (int32_t)1 << new_shift;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        core->gravity_acc[axis] = gravity_axis(core, axis) * scale;
+    }
+    core->gravity_shift = new_shift;
+    core->reeval_samples = STEP_CORE_MS_TO_SAMPLES(GRAVITY_REEVAL_MS, sample_hz);
+    core->settle_samples = STEP_CORE_MS_TO_SAMPLES(SETTLE_MS, sample_hz);
+
+    if (length != core->filter.length) {
+        if (core->filter.seeded) {
+            tri_resize(&core->filter, (uint8_t)length);
+        } else {
+            tri_set_length(&core->filter, (uint8_t)length);
+        }
+    }
+    return true;
+}
+
+// Smallest shift whose 2^shift is at least 2/3 of n (i.e. log2(n) rounded on a linear midpoint)
+uint8_t step_core_shift_for_samples(uint32_t n) {
+    uint8_t shift = 0;
+    while (((3u << shift) >> 1) < n) {
+        shift++;
+    }
+    return shift;
+}
+
+void step_core_configure_detector(StepCore *core, uint16_t detect_hz, uint16_t threshold) {
+    core->threshold = threshold;
+    core->threshold_square = (uint64_t)threshold * threshold;
+    core->rearm_samples = (uint8_t)STEP_CORE_MS_TO_SAMPLES(STEP_REARM_MS, detect_hz);
+    core->below_count = 0;
+    adaptive_configure(&core->tracker, detect_hz);
+}
+
+void step_core_set_adaptive(StepCore *core, bool adaptive, uint16_t calibrated_peak, uint16_t calibrated_trough) {
+    if (adaptive) {
+        adaptive_reset(&core->tracker, calibrated_peak, calibrated_trough);
+    }
+    core->adaptive = adaptive;
+    core->step_detected = false;
+    core->below_count = 0;
+}
+
+void step_core_set_refractory(StepCore *core, uint32_t refractory_ms) {
+    core->refractory_ms = refractory_ms;
+}
+
+void step_core_set_detect_decimation(StepCore *core, uint8_t every) {
+    core->detect_every = (every > 0) ? every : 1;
+    core->detect_phase = 0;
+}
+
+void step_core_set_step_detected(StepCore *core, bool detected) {
+    core->step_detected = detected;
+}
+
+void step_core_reset_filters(StepCore *core) {
+    step_core_tri_filter_init(&core->filter, core->filter.length);
+}
+
+bool step_core_is_seeded(const StepCore *core) {
+    return core->filter.seeded;
+}
+
+bool step_core_is_ready(const StepCore *core) {
+    return core->ready;
+}
+
+void step_core_track_gravity(StepCore *core, int16_t ax, int16_t ay, int16_t az) {
+    if (core->filter.seeded) {
+        gravity_update(core, ax, ay, az);
+    } else {
+        gravity_seed(core, ax, ay, az);
+    }
+}
+
+uint64_t step_core_raw_dynamic_square(const StepCore *core, int16_t ax, int16_t ay, int16_t az) {
+    int32_t dx = ax - gravity_axis(core, 0);
+    int32_t dy = ay - gravity_axis(core, 1);
+    int32_t dz = az - gravity_axis(core, 2);
+    return (uint64_t)((int64_t)dx * dx + (int64_t)dy * dy + (int64_t)dz * dz);
+}
+
+int16_t step_core_raw_vertical(const StepCore *core, int16_t ax, int16_t ay, int16_t az) {
+    return along_gravity(core, ax - gravity_axis(core, 0), ay - gravity_axis(core, 1), az - gravity_axis(core, 2));
+}
+
+FilteredAcceleration step_core_filter(StepCore *core, int16_t ax, int16_t ay, int16_t az) {
+    const int16_t sample[3] = {
+        (int16_t)(ax + core->offset[0]), (int16_t)(ay + core->offset[1]), (int16_t)(az + core->offset[2])
+    };
+    int16_t filtered[3];
+
+    tri_push(&core->filter, sample, filtered);
+    accept_filtered(core, filtered);
+    return core->latest;
+}
+
+uint16_t step_core_detect(StepCore *core, uint64_t dynamic_square, uint32_t now_ms) {
+    bool above, inside, fell_last = false;
+    uint16_t counted = 0;
+
+    if (core->adaptive) {
+        adaptive_classify(core, now_ms, &above, &inside, &fell_last);
+    } else {
+        above = dynamic_square > core->threshold_square;
+        inside = !above;
+    }
+
+    // A whole swing between two adaptive evaluations: a fall through the lower band before
+    // the rise re-arms first, a fall after it re-arms for the next step
+    if (above && inside && !fell_last) core->step_detected = false;
+
+    // Count once per excursion beyond the upper level, re-arm once back inside the lower one
+    if (above) {
+        core->below_count = 0;
+        if (!core->step_detected) {
+            core->step_detected = true;  // An excursion inside the refractory period is consumed uncounted
+            if (now_ms - core->last_step_ms >= core->refractory_ms) {
+                core->last_step_ms = now_ms;
+                counted = 1;
+            }
+        }
+        if (inside && fell_last) core->step_detected = false;
+    } else if (!inside) {
+        core->below_count = 0;  // Between the adaptive bands: neither counts nor re-arms
+    } else if (core->step_detected && ++core->below_count >= core->rearm_samples) {
+        core->step_detected = false; // Reset step window
+        core->below_count = 0;
+    }
+    return counted;
+}
+
+bool step_core_take_calibration(StepCore *core) {
+    if (!core->calibration_done) return false;
+    core->calibration_done = false;
+    return true;
+}
+
+void step_core_restore(StepCore *core, const TriAxisFilter *filter, const int32_t gravity[3]) {
+    uint8_t length = core->filter.length;
+    uint8_t saved_length = filter->length;
+    if (saved_length == 0 || saved_length > STEP_CORE_MAX_FILTER_LENGTH) saved_length = length;
+
+    // Sums and reciprocal are rebuilt from the history rather than trusted, then the
+    // window is brought to the current rate's length
+    core->filter = *filter;
+    tri_set_length(&core->filter, saved_length);
+    if (core->filter.index >= saved_length) core->filter.index = 0;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        core->filter.sum[axis] = 0;
+        for (uint8_t i = 0; i < saved_length; i++) {
+            core->filter.sum[axis] += core->filter.history[i][axis];
+        }
+        core->gravity_acc[axis] = gravity[axis];
+    }
+    if (saved_length != length) {
+        if (core->filter.seeded) {
+            tri_resize(&core->filter, length);
+        } else {
+            tri_set_length(&core->filter, length);
+        }
+    }
+    select_orientation_offsets(core);
+
+    publish_filtered(core, tri_divide(&core->filter, core->filter.sum[0]),
+                     tri_divide(&core->filter, core->filter.sum[1]),
+                     tri_divide(&core->filter, core->filter.sum[2]));
+    core->ready = true;  // Restored filters already hold settled data
+    core->warmup_samples = 0;
+}
+
+uint16_t step_core_process(StepCore *core, const StepCoreSample *samples, uint16_t n, StepCoreEvent *events_out) {
+    int16_t block[PROCESS_BLOCK][3];
+    int32_t gravity[PROCESS_BLOCK][3];
+    int16_t offset[PROCESS_BLOCK][3];
+    uint16_t events = 0;
+    uint16_t i = 0;
+
+    // An unseeded core seeds gravity and the filter from one sample first, as step_core_filter() would
+    if (n > 0 && !core->filter.seeded) {
+        step_core_track_gravity(core, samples[0].x, samples[0].y, samples[0].z);
+        step_core_filter(core, samples[0].x, samples[0].y, samples[0].z);
+        events = detect_sample(core, samples, 0, events_out, events);
+        i = 1;
+    }
+
+    while (i < n) {
+        uint16_t count = (n - i < PROCESS_BLOCK) ? n - i : PROCESS_BLOCK;
+
+        // The tracker runs ahead over the block; each sample keeps the gravity and offsets it saw
+        for (uint16_t j = 0; j < count; j++) {
+            const StepCoreSample *sample = &samples[i + j];
+            step_core_track_gravity(core, sample->x, sample->y, sample->z);
+            block[j][0] = (int16_t)(sample->x + core->offset[0]);
+            block[j][1] = (int16_t)(sample->y + core->offset[1]);
+            block[j][2] = (int16_t)(sample->z + core->offset[2]);
+            memcpy(gravity[j], core->gravity_acc, sizeof(gravity[j]));
+            memcpy(offset[j], core->offset, sizeof(offset[j]));
+        }
+
+        step_core_tri_filter_batch(&core->filter, block, block, count);
+
+        // Publishing replays each sample's tracker state and leaves the last one in place
+        for (uint16_t j = 0; j < count; j++) {
+            memcpy(core->gravity_acc, gravity[j], sizeof(gravity[j]));
+            memcpy(core->offset, offset[j], sizeof(offset[j]));
+            accept_filtered(core, block[j]);
+            events = detect_sample(core, samples, i + j, events_out, events);
+        }
+        i += count;
+    }
+    return events;
+}
@@ -2,19 +2,35 @@
  * step_detection.c
  *
  * Core logic for tracking user steps based on accelerometer magnitude.
- * Uses thresholds to detect discrete step events, with support for test mode and button-based input.
+ * Uses a threshold on the gravity-removed (dynamic) magnitude to detect discrete step events,
+ * with support for test mode and button-based input.
+ * The detector itself is the step core's (step_core.c); this module runs it at the step
+ * task rate, counts its steps and persists its mode and adaptive calibration.
+ * The adaptive detector mode counts above an upper band and re-arms below a lower band,
+ * both tracked from the wearer's own signal (adaptive_threshold.c).
+ * In hardware mode the IMU's embedded pedometer counter is polled instead and its
+ * increments go through the same goal/test-mode/history path; in hybrid mode the
+ * software count is authoritative and the two are compared per window.
  *
  * Created on: May 8, 2025
  * Author: eaz11 & gjo77
  */
 
 #include "step_detection.h"
+#include "app.h"
 #include "goal_tracker.h"
 #include "test_mode.h"
-#include "joystick_task.h"
-#include "joystick_math.h"
 #include "accelerometer.h"
-#include "fsm.h"
+#include "distance.h"
+#include "step_history.h"
+#include "activity.h"
+#include "flash_log.h"
+#include "cadence.h"
+#include "step_core.h"
+#include "adaptive_threshold.h"
+#include "timebase.h"
+#include "trace.h"
+#include "stm32c0xx_hal.h"
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -23,16 +39,35 @@
 // Constants
 // -----------------------------------------------------------------------------
 
-#define STEP_LENGTH_CM          90  // Distance per step in cm
-#define LOWER_THRESHOLD        225000000  // Squared magnitude (raw sensor units): lower hysteresis bound
-#define UPPER_THRESHOLD        305000000  // Squared magnitude (raw sensor units): upper hysteresis bound
+#define CADENCE_GATE_FRACTION_MS   36000  // With the cadence gate: 60% of the step interval (60000 ms * 0.6)
+#define ADAPT_SETTING_SHIFT            4  // Calibration is saved in units of 16 raw to fit a setting byte
 
 // -----------------------------------------------------------------------------
 // State
 // -----------------------------------------------------------------------------
 
-static bool step_detected = false;
-static uint16_t step_count = 0;
+static uint32_t step_count = 0;
+
+static bool detector_ready = false;      // False until the accelerometer output has settled
+static uint32_t first_detection_ms = 0;  // Tick of the first evaluated sample (0 = none yet)
+
+static step_source_t step_source = STEP_SOURCE_SOFTWARE;
+static uint16_t hw_last_counter = 0;     // Embedded counter value at the last poll
+static uint32_t hw_last_poll_ms = 0;
+
+static HybridStats hybrid_stats;
+static uint16_t window_software = 0;
+static uint16_t window_hardware = 0;
+static uint32_t window_start_ms = 0;
+static bool mismatch_pending = false;
+static uint16_t mismatch_software = 0;
+static uint16_t mismatch_hardware = 0;
+
+static step_detector_t detector = STEP_DETECTOR_FIXED;
+static DetectorStats detector_stats;
+
+static const char* const source_names[NUM_STEP_SOURCES] = { "software", "hardware", "hybrid" };
+static const char* const detector_names[NUM_STEP_DETECTORS] = { "fixed", "adaptive" };
 
 // -----------------------------------------------------------------------------
 // Internal Utility Functions
@@ -43,14 +78,112 @@ static void increment_stepcount_common(uint16_t increment_value) {
     if (check_test_mode()) {
         uint16_t goal = get_goal();
         if (step_count < goal) {
+            uint32_t previous = step_count;
             step_count += increment_value;
             if (step_count > goal) {
                 step_count = goal;
             }
+            distance_add_steps(step_count - previous);
+            step_history_record(step_count - previous);
         }
     } else {
         step_count += increment_value;
+        distance_add_steps(increment_value);
+        step_history_record(increment_value);
+    }
+    trace_instant(TRACE_STEP, (uint16_t)step_count);
+}
+
+// Time of the latest filtered sample in ms since boot (the tick's time base); the detector
+// times steps by their samples rather than by when the task got round to them
+static uint32_t sample_ms(void) {
+    return (uint32_t)(accelerometer_get_sample_time_us() / 1000);
+}
+
+// Returns steps counted by the embedded pedometer since the last poll (0 between polls). It
+// keeps the tick: with the hardware source the MCU takes no samples
+static uint16_t hardware_poll(void) {
+    uint32_t now = HAL_GetTick();
+    if (now - hw_last_poll_ms < HW_PEDOMETER_POLL_MS) return 0;
+    hw_last_poll_ms = now;
+
+    uint16_t counter = accelerometer_pedometer_read();
+    uint16_t delta = counter - hw_last_counter;  // Wraps correctly at 65536
+    hw_last_counter = counter;
+    return delta;
+}
+
+// Accumulates both counts and closes a comparison window when it is due
+static void hybrid_update(uint16_t software_steps, uint16_t hardware_steps) {
+    uint32_t now = HAL_GetTick();
+
+    window_software += software_steps;
+    window_hardware += hardware_steps;
+    hybrid_stats.software_steps += software_steps;
+    hybrid_stats.hardware_steps += hardware_steps;
+
+    if (now - window_start_ms < HYBRID_WINDOW_MS) return;
+    window_start_ms = now;
+    hybrid_stats.windows++;
+
+    uint16_t difference = (window_software > window_hardware) ?
+        window_software - window_hardware : window_hardware - window_software;
+    if (difference > HYBRID_TOLERANCE_STEPS) {
+        hybrid_stats.mismatches++;
+        mismatch_software = window_software;
+        mismatch_hardware = window_hardware;
+        mismatch_pending = true;
+    }
+    window_software = 0;
+    window_hardware = 0;
+}
+
+// Minimum spacing before another step may be counted
+static uint32_t refractory_ms(void) {
+    if (CADENCE_GATE_STEPS) {
+        uint16_t spm = cadence_get_spm();
+        if (spm > 0) {
+            uint32_t gate = CADENCE_GATE_FRACTION_MS / spm;  // Once per step-task run, not per sample
+            if (gate > STEP_REFRACTORY_MS) return gate;
+        }
     }
+    return STEP_REFRACTORY_MS;
+}
+
+// Packs a calibrated statistic into a setting byte (never 0, which means "not calibrated")
+static uint8_t calibration_to_setting(uint16_t value) {
+    uint16_t packed = (uint16_t)((value + (1u << (ADAPT_SETTING_SHIFT - 1))) >> ADAPT_SETTING_SHIFT);
+    if (packed == 0) return 1;
+    return (packed > UINT8_MAX) ? UINT8_MAX : (uint8_t)packed;
+}
+
+// Saves a finished calibration run so adaptive mode starts from it after a reboot
+static void save_calibration(const StepCore *core) {
+    AdaptiveStats stats = adaptive_get_stats(&core->tracker);
+    flash_log_set_setting(FLASH_LOG_SETTING_ADAPT_PEAK, calibration_to_setting(stats.peak));
+    flash_log_set_setting(FLASH_LOG_SETTING_ADAPT_TROUGH, calibration_to_setting(stats.trough));
+}
+
+// Runs the core's detector on the latest filtered sample; returns 1 if a step was counted
+static uint16_t software_detect(uint32_t now) {
+    StepCore *core = accelerometer_get_core();
+
+    if (CADENCE_GATE_STEPS) step_core_set_refractory(core, refractory_ms());
+
+    uint16_t steps = step_core_detect(core, core->latest.dynamic_magnitude_square, now);
+    if (step_core_take_calibration(core)) save_calibration(core);
+    if (steps > 0) increment_stepcount();
+    return steps;
+}
+
+// Runs the software detector and charges its cost to the active mode
+static uint16_t software_detect_timed(uint32_t now) {
+    uint32_t start = timebase_cycles();
+    uint16_t steps = software_detect(now);
+
+    detector_stats.cycles[detector] += timebase_cycles() - start;
+    detector_stats.evaluations[detector]++;
+    return steps;
 }
 
 // -----------------------------------------------------------------------------
@@ -65,61 +198,152 @@ void increment_stepcount(void) {
     increment_stepcount_common(1);
 }
 
-void set_step_count(uint16_t new_count) {
+void set_step_count(uint32_t new_count) {
     step_count = new_count;
+    distance_set_steps(new_count);
 }
 
-uint16_t get_distance_yards(void) {
-    return (step_count * STEP_LENGTH_CM) / 91.44;
+uint32_t get_distance_yards(void) {
+    return distance_get_yards();
 }
 
-uint16_t get_distance_metres(void) {
-    return (step_count * STEP_LENGTH_CM) / 100;
+uint32_t get_distance_metres(void) {
+    return distance_get_metres();
 }
 
-uint16_t get_steps(void) {
+uint32_t get_steps(void) {
     return step_count;
 }
 
-// Main step processing loop, runs periodically
+void steps_save_detector(DetectorSnapshot *snapshot) {
+    const StepCore *core = accelerometer_get_core();
+    uint32_t now = HAL_GetTick();
+
+    snapshot->tracker = core->tracker;
+    snapshot->tracker.calibrate_start_ms = now - core->tracker.calibrate_start_ms;
+    snapshot->last_step_age_ms = now - core->last_step_ms;
+    snapshot->step_detected = core->step_detected;
+}
+
+void steps_restore_detector(const DetectorSnapshot *snapshot) {
+    StepCore *core = accelerometer_get_core();
+    uint32_t now = HAL_GetTick();
+
+    // Ages wrap back to the same spacing from the restarted tick
+    core->tracker = snapshot->tracker;
+    core->tracker.calibrate_start_ms = now - snapshot->tracker.calibrate_start_ms;
+    core->last_step_ms = now - snapshot->last_step_age_ms;
+    step_core_set_step_detected(core, snapshot->step_detected);
+    detector_ready = true;  // Filters were restored too, so there is nothing to wait for
+}
+
+uint32_t steps_get_first_detection_ms(void) {
+    return first_detection_ms;
+}
+
+void steps_configure(uint16_t step_hz, uint16_t threshold) {
+    step_core_configure_detector(accelerometer_get_core(), step_hz, threshold);
+}
+
+void steps_set_source(step_source_t source) {
+    if (source >= NUM_STEP_SOURCES) source = STEP_SOURCE_SOFTWARE;
+
+    // Without a known IMU there is no pedometer to use; the saved choice is kept for the next boot
+    bool pedometer_known = accelerometer_pedometer_enable(source != STEP_SOURCE_SOFTWARE);
+    bool fall_back = !pedometer_known && source != STEP_SOURCE_SOFTWARE;
+    if (fall_back) source = STEP_SOURCE_SOFTWARE;
+    accelerometer_set_processing(source != STEP_SOURCE_HARDWARE);
+
+    // Only steps taken from now on count; the embedded counter keeps running across MCU resets
+    uint32_t now = HAL_GetTick();
+    hw_last_counter = (source != STEP_SOURCE_SOFTWARE) ? accelerometer_pedometer_read() : 0;
+    hw_last_poll_ms = now;
+    hybrid_stats = (HybridStats){0};
+    window_software = 0;
+    window_hardware = 0;
+    window_start_ms = now;
+    mismatch_pending = false;
+    step_core_set_step_detected(accelerometer_get_core(), false);
+
+    step_source = source;
+    if (!fall_back) flash_log_set_setting(FLASH_LOG_SETTING_STEP_SOURCE, (uint8_t)source);
+    trace_instant(TRACE_STEP_SOURCE, source);
+}
+
+step_source_t steps_get_source(void) {
+    return step_source;
+}
+
+const char* steps_source_name(step_source_t source) {
+    return (source < NUM_STEP_SOURCES) ? source_names[source] : "unknown";
+}
+
+HybridStats steps_get_hybrid_stats(void) {
+    return hybrid_stats;
+}
+
+bool steps_take_hybrid_mismatch(uint16_t *software_steps, uint16_t *hardware_steps) {
+    if (!mismatch_pending) return false;
+    *software_steps = mismatch_software;
+    *hardware_steps = mismatch_hardware;
+    mismatch_pending = false;
+    return true;
+}
+
+void steps_set_detector(step_detector_t mode) {
+    if (mode >= NUM_STEP_DETECTORS) mode = STEP_DETECTOR_FIXED;
+
+    step_core_set_adaptive(accelerometer_get_core(), mode == STEP_DETECTOR_ADAPTIVE,
+        (uint16_t)flash_log_get_setting(FLASH_LOG_SETTING_ADAPT_PEAK) << ADAPT_SETTING_SHIFT,
+        (uint16_t)flash_log_get_setting(FLASH_LOG_SETTING_ADAPT_TROUGH) << ADAPT_SETTING_SHIFT);
+
+    detector = mode;
+    flash_log_set_setting(FLASH_LOG_SETTING_DETECTOR, (uint8_t)mode);
+    trace_instant(TRACE_DETECTOR, mode);
+}
+
+step_detector_t steps_get_detector(void) {
+    return detector;
+}
+
+const char* steps_detector_name(step_detector_t mode) {
+    return (mode < NUM_STEP_DETECTORS) ? detector_names[mode] : "unknown";
+}
+
+void steps_calibrate_start(void) {
+    if (detector != STEP_DETECTOR_ADAPTIVE) steps_set_detector(STEP_DETECTOR_ADAPTIVE);
+    adaptive_calibrate_start(&accelerometer_get_core()->tracker, sample_ms());
+}
+
+AdaptiveStats steps_get_adaptive_stats(void) {
+    return adaptive_get_stats(&accelerometer_get_core()->tracker);
+}
+
+DetectorStats steps_get_detector_stats(void) {
+    return detector_stats;
+}
+
+// Main step processing loop, runs periodically. Only counts steps: the screens, unit toggle
+// and goal setting run in the joystick task
 void steps_task_execute(void) {
-    static bool initialized = false;
-    static uint32_t skip_start = 0;
-    if (!initialized) {
-        if (skip_start == 0) skip_start = HAL_GetTick();
-        if (HAL_GetTick() - skip_start < 500) return; // skip first 500ms
-        initialized = true;
+    if (!detector_ready) {
+        if (step_source != STEP_SOURCE_HARDWARE && !accelerometer_is_ready()) return;
+        detector_ready = true;
     }
 
+    // Poll even when steps aren't being counted so the baseline stays current
+    uint16_t hardware_steps = (step_source != STEP_SOURCE_SOFTWARE) ? hardware_poll() : 0;
 
-    uint16_t* adc_values = joystick_get_values();
-    uint16_t adc_x = adc_values[ADC_IDX_X];
-    uint16_t potent = adc_values[ADC_IDX_POT];
-    bool test_mode = check_test_mode();
-
-    if (!test_mode && !check_set_goal_state()) {
-        // Update display and goal states
-        fsm_update(adc_x, test_mode);
-        check_for_display_toggle();
-        goal_set_mode();
-
-        // Get filtered magnitude from accelerometer
-        FilteredAcceleration data = accelerometer_get_latest();
-        uint64_t magnitude_square = data.magnitude_square;
-
-        // Step detection logic using hysteresis-style thresholds
-        if ((magnitude_square > UPPER_THRESHOLD && !step_detected) ||
-            (magnitude_square < LOWER_THRESHOLD && !step_detected)) {
-            increment_stepcount();
-            step_detected = true;
-        } else if (magnitude_square >= LOWER_THRESHOLD && magnitude_square <= UPPER_THRESHOLD) {
-            step_detected = false; // Reset step window
-        }
-    }
+    if (check_test_mode() || check_set_goal_state()) return;
 
-    // Goal-setting mode logic (joystick + potentiometer)
-    if (check_set_goal_state() && !test_mode) {
-        potentiometer_update_stepcount(potent);
-        goal_set_mode();
+    uint32_t now = sample_ms();
+    if (first_detection_ms == 0) first_detection_ms = now;
+
+    if (step_source == STEP_SOURCE_HARDWARE) {
+        if (hardware_steps > 0) increment_stepcount_common(hardware_steps);
+    } else {
+        // Filtered output is frozen while stationary, so there is nothing to detect
+        uint16_t software_steps = activity_is_stationary() ? 0 : software_detect_timed(now);
+        if (step_source == STEP_SOURCE_HYBRID) hybrid_update(software_steps, hardware_steps);
     }
 }
@@ -0,0 +1,367 @@
+/*
+ * step_history.c
+ *
+ * Bins detected steps per minute into a 32-hour ring of saturating 8-bit counts.
+ * Each 15-minute block keeps the cumulative step total and active-minute count
+ * at its start, so window totals and active minutes are a difference of two
+ * prefix counts (at most one partial block summed), and hourly totals are O(1)
+ * because hours always start on a block boundary. Block peaks sit in the leaves
+ * of a max tree over the ring of blocks, so a window's peak is the partial
+ * block at its start plus one O(log blocks) range query.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "step_history.h"
+#include "stm32c0xx_hal.h"
+
+#include <string.h>
+
+#define MS_PER_MINUTE  60000
+#define MINUTES_PER_HOUR  60
+
+_Static_assert((HISTORY_BLOCKS & (HISTORY_BLOCKS - 1)) == 0, "The peak tree needs a power-of-two block count");
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static uint8_t bins[HISTORY_MINUTES];
+static uint32_t block_base[HISTORY_BLOCKS];   // Cumulative total before the block's first minute
+static uint32_t block_active_base[HISTORY_BLOCKS];  // Cumulative active minutes before it
+static uint8_t peak_tree[2 * HISTORY_BLOCKS]; // Node i holds max(2i, 2i+1); block b's peak is leaf HISTORY_BLOCKS + b
+
+static uint32_t total = 0;            // Steps recorded across all minutes so far
+static uint32_t active_total = 0;     // Active minutes across all minutes so far
+static uint32_t head_minute = 0;      // Absolute minute index of the current bin
+static uint16_t head_slot = 0;
+static uint16_t head_block = 0;
+static uint8_t head_block_pos = 0;    // Position of head_slot within its block
+static uint32_t minute_start_ms = 0;
+static uint32_t handed_out_minute = 0;    // First minute of the oldest block not yet handed out for saving
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Sets a block's peak leaf and refreshes the maxima above it
+static void set_block_peak(uint16_t block, uint8_t peak) {
+    uint16_t node = HISTORY_BLOCKS + block;
+    peak_tree[node] = peak;
+    for (node >>= 1; node > 0; node >>= 1) {
+        uint8_t left = peak_tree[2 * node], right = peak_tree[2 * node + 1];
+        peak_tree[node] = (left > right) ? left : right;
+    }
+}
+
+// Largest block peak over blocks first..last (no wrap), bottom-up over the tree
+static uint8_t peak_of_blocks(uint16_t first, uint16_t last) {
+    uint8_t peak = 0;
+    uint16_t lo = first + HISTORY_BLOCKS, hi = last + HISTORY_BLOCKS + 1;
+
+    while (lo < hi) {
+        if (lo & 1) {
+            if (peak_tree[lo] > peak) peak = peak_tree[lo];
+            lo++;
+        }
+        if (hi & 1) {
+            hi--;
+            if (peak_tree[hi] > peak) peak = peak_tree[hi];
+        }
+        lo >>= 1;
+        hi >>= 1;
+    }
+    return peak;
+}
+
+// Moves the head on by one minute, opening a fresh block summary on block boundaries
+static void advance_minute(void) {
+    head_minute++;
+    if (++head_slot == HISTORY_MINUTES) head_slot = 0;
+
+    if (++head_block_pos == HISTORY_BLOCK_MINUTES) {
+        head_block_pos = 0;
+        if (++head_block == HISTORY_BLOCKS) head_block = 0;
+        block_base[head_block] = total;
+        block_active_base[head_block] = active_total;
+        set_block_peak(head_block, 0);
+    }
+    bins[head_slot] = 0;
+}
+
+// Moves the head to an absolute minute; a jump past the whole ring restarts it empty
+static void move_to_minute(uint32_t minute) {
+    if (minute - head_minute < HISTORY_MINUTES) {
+        while (head_minute != minute) advance_minute();
+        return;
+    }
+
+    head_minute = minute;
+    head_slot = (uint16_t)(minute % HISTORY_MINUTES);
+    head_block = head_slot / HISTORY_BLOCK_MINUTES;
+    head_block_pos = head_slot % HISTORY_BLOCK_MINUTES;
+    memset(bins, 0, sizeof(bins));
+    memset(peak_tree, 0, sizeof(peak_tree));
+    for (uint16_t block = 0; block < HISTORY_BLOCKS; block++) {
+        block_base[block] = total;
+        block_active_base[block] = active_total;
+    }
+}
+
+// Fills the empty head bin with a restored count
+static void put_bin(uint8_t bin) {
+    if (bin >= ACTIVE_MINUTE_STEPS) active_total++;
+    bins[head_slot] = bin;
+    total += bin;
+    if (bin > peak_tree[HISTORY_BLOCKS + head_block]) set_block_peak(head_block, bin);
+}
+
+// Catches the ring up with the system tick (normally zero or one iteration)
+static void sync_to_tick(void) {
+    uint32_t now = HAL_GetTick();
+    while (now - minute_start_ms >= MS_PER_MINUTE) {
+        minute_start_ms += MS_PER_MINUTE;
+        advance_minute();
+    }
+}
+
+static uint16_t retained_minutes(void) {
+    return (head_minute + 1 < HISTORY_MINUTES) ? (uint16_t)(head_minute + 1) : HISTORY_MINUTES;
+}
+
+// Limits a query window to what is both retained and covered by valid block summaries
+static uint16_t clamp_window(uint16_t n) {
+    uint16_t available = retained_minutes();
+    if (available > HISTORY_MAX_QUERY_MINUTES) available = HISTORY_MAX_QUERY_MINUTES;
+    return (n > available) ? available : n;
+}
+
+// Ring slot of the minute 'back' minutes before the head
+static uint16_t slot_back(uint16_t back) {
+    return (head_slot >= back) ? head_slot - back : head_slot + HISTORY_MINUTES - back;
+}
+
+// Total steps recorded before the minute 'back' minutes behind the head
+static uint32_t total_before(uint16_t back) {
+    uint16_t slot = slot_back(back);
+    uint16_t block_start = (slot / HISTORY_BLOCK_MINUTES) * HISTORY_BLOCK_MINUTES;
+    uint32_t sum = block_base[slot / HISTORY_BLOCK_MINUTES];
+
+    for (uint16_t s = block_start; s < slot; s++) {
+        sum += bins[s];
+    }
+    return sum;
+}
+
+// Active minutes recorded before the minute 'back' minutes behind the head
+static uint32_t active_before(uint16_t back) {
+    uint16_t slot = slot_back(back);
+    uint16_t block_start = (slot / HISTORY_BLOCK_MINUTES) * HISTORY_BLOCK_MINUTES;
+    uint32_t count = block_active_base[slot / HISTORY_BLOCK_MINUTES];
+
+    for (uint16_t s = block_start; s < slot; s++) {
+        if (bins[s] >= ACTIVE_MINUTE_STEPS) count++;
+    }
+    return count;
+}
+
+// Peak of the last n minutes: raw bins up to the end of the first block, then the tree
+static uint8_t window_peak(uint16_t n) {
+    n = clamp_window(n);
+    if (n == 0) return 0;
+
+    uint16_t slot = slot_back(n - 1);
+    uint16_t block = slot / HISTORY_BLOCK_MINUTES;
+    uint16_t block_end = (block + 1) * HISTORY_BLOCK_MINUTES;
+    uint8_t peak = 0;
+
+    if (block == head_block) {
+        block_end = head_slot + 1;          // The window lies inside the current block
+    } else if (slot == block * HISTORY_BLOCK_MINUTES) {
+        block_end = slot;                   // Whole first block: its leaf covers it
+        peak = peak_tree[HISTORY_BLOCKS + block];
+    }
+    for (uint16_t s = slot; s < block_end; s++) {
+        if (bins[s] > peak) peak = bins[s];
+    }
+    if (block == head_block) return peak;
+
+    // Whole blocks after the first, up to and including the current one
+    uint16_t first = (block + 1 == HISTORY_BLOCKS) ? 0 : block + 1;
+    uint8_t rest = (first <= head_block) ? peak_of_blocks(first, head_block)
+                                         : peak_of_blocks(first, HISTORY_BLOCKS - 1);
+    if (first > head_block) {
+        uint8_t wrapped = peak_of_blocks(0, head_block);
+        if (wrapped > rest) rest = wrapped;
+    }
+    return (rest > peak) ? rest : peak;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void step_history_init(void) {
+    memset(bins, 0, sizeof(bins));
+    memset(block_base, 0, sizeof(block_base));
+    memset(block_active_base, 0, sizeof(block_active_base));
+    memset(peak_tree, 0, sizeof(peak_tree));
+    total = 0;
+    active_total = 0;
+    head_minute = 0;
+    head_slot = 0;
+    head_block = 0;
+    head_block_pos = 0;
+    minute_start_ms = HAL_GetTick();
+    handed_out_minute = 0;
+}
+
+void step_history_record(uint16_t steps) {
+    sync_to_tick();
+
+    uint8_t bin = bins[head_slot];
+    uint8_t room = HISTORY_BIN_MAX - bin;
+    uint8_t added = (steps > room) ? room : (uint8_t)steps;
+    if (added == 0) return;
+
+    if (bin < ACTIVE_MINUTE_STEPS && bin + added >= ACTIVE_MINUTE_STEPS) {
+        active_total++;
+    }
+    bin += added;
+    bins[head_slot] = bin;
+    total += added;
+
+    if (bin > peak_tree[HISTORY_BLOCKS + head_block]) set_block_peak(head_block, bin);
+}
+
+bool step_history_next_completed_block(uint32_t *first_minute, uint8_t block_bins[HISTORY_BLOCK_MINUTES]) {
+    sync_to_tick();
+
+    uint32_t head_block_start = head_minute - head_block_pos;
+    if (head_block_start - handed_out_minute > HISTORY_MAX_QUERY_MINUTES) {
+        handed_out_minute = head_block_start - HISTORY_MAX_QUERY_MINUTES;   // Older blocks are overwritten
+    }
+
+    // Empty blocks are skipped: a block's steps are the difference of its base and the next one's
+    for (; handed_out_minute < head_block_start; handed_out_minute += HISTORY_BLOCK_MINUTES) {
+        uint16_t block = (uint16_t)((handed_out_minute % HISTORY_MINUTES) / HISTORY_BLOCK_MINUTES);
+        uint16_t next = (block + 1 == HISTORY_BLOCKS) ? 0 : block + 1;
+        if (block_base[next] == block_base[block]) continue;
+
+        *first_minute = handed_out_minute;
+        memcpy(block_bins, &bins[block * HISTORY_BLOCK_MINUTES], HISTORY_BLOCK_MINUTES);
+        handed_out_minute += HISTORY_BLOCK_MINUTES;
+        return true;
+    }
+    return false;
+}
+
+void step_history_restore_block(uint32_t first_minute, const uint8_t block_bins[HISTORY_BLOCK_MINUTES]) {
+    if (first_minute % HISTORY_BLOCK_MINUTES != 0) return;
+    if (head_minute > 0 && first_minute < head_minute) return;     // Out of order
+
+    move_to_minute(first_minute);
+    for (uint8_t i = 0; i < HISTORY_BLOCK_MINUTES; i++) {
+        put_bin(block_bins[i]);
+        advance_minute();
+    }
+
+    // Recording carries on in the block after it, from now
+    minute_start_ms = HAL_GetTick();
+    handed_out_minute = head_minute;
+}
+
+void step_history_save_recent(StepHistoryRecent *recent) {
+    sync_to_tick();
+
+    // The block before the current one too, while flash has not been handed it yet
+    uint32_t first = head_minute - head_block_pos;
+    if (handed_out_minute < first && first >= HISTORY_BLOCK_MINUTES) first -= HISTORY_BLOCK_MINUTES;
+
+    recent->first_minute = first;
+    recent->handed_out_minute = handed_out_minute;
+    recent->minute_elapsed_ms = HAL_GetTick() - minute_start_ms;
+    recent->minutes = (uint8_t)(head_minute - first + 1);
+    for (uint8_t i = 0; i < recent->minutes; i++) {
+        recent->bins[i] = bins[slot_back((uint16_t)(recent->minutes - 1 - i))];
+    }
+}
+
+void step_history_restore_recent(const StepHistoryRecent *recent) {
+    if (recent->minutes == 0 || recent->minutes > HISTORY_RECENT_MINUTES) return;
+
+    uint32_t last = recent->first_minute + recent->minutes - 1;
+    if (last < head_minute) return;     // Flash already holds newer minutes
+
+    for (uint8_t i = 0; i < recent->minutes; i++) {
+        uint32_t minute = recent->first_minute + i;
+        if (minute < head_minute) continue;     // Restored from flash already
+        move_to_minute(minute);
+        put_bin(recent->bins[i]);
+    }
+
+    // The current minute carries on where it was; blocks flash never got are handed out again
+    minute_start_ms = HAL_GetTick() - recent->minute_elapsed_ms;
+    if (recent->handed_out_minute > handed_out_minute) handed_out_minute = recent->handed_out_minute;
+}
+
+uint32_t step_history_current_minute(void) {
+    sync_to_tick();
+    return head_minute;
+}
+
+uint16_t step_history_length(void) {
+    sync_to_tick();
+    return retained_minutes();
+}
+
+uint32_t step_history_last_minutes(uint16_t n) {
+    sync_to_tick();
+    n = clamp_window(n);
+    if (n == 0) return 0;
+    return total - total_before(n - 1);
+}
+
+bool step_history_hour_total(uint32_t hour, uint32_t *hour_total) {
+    sync_to_tick();
+
+    uint32_t start = hour * MINUTES_PER_HOUR;
+    if (start > head_minute || head_minute - start >= clamp_window(HISTORY_MAX_QUERY_MINUTES)) {
+        return false;
+    }
+
+    uint32_t end = start + MINUTES_PER_HOUR;  // First minute after the hour
+    uint32_t total_at_end = (end > head_minute) ? total : total_before((uint16_t)(head_minute - end));
+    *hour_total = total_at_end - total_before((uint16_t)(head_minute - start));
+    return true;
+}
+
+uint8_t step_history_peak(uint16_t n) {
+    sync_to_tick();
+    return window_peak(n);
+}
+
+uint16_t step_history_active_minutes(uint16_t n) {
+    sync_to_tick();
+    n = clamp_window(n);
+    if (n == 0) return 0;
+    return (uint16_t)(active_total - active_before(n - 1));
+}
+
+uint16_t step_history_read(uint16_t offset, uint8_t *out, uint16_t max) {
+    sync_to_tick();
+
+    uint16_t length = retained_minutes();
+    if (offset >= length) return 0;
+
+    uint16_t count = length - offset;
+    if (count > max) count = max;
+
+    uint16_t slot = slot_back(length - 1 - offset);
+    for (uint16_t i = 0; i < count; i++) {
+        out[i] = bins[slot];
+        if (++slot == HISTORY_MINUTES) slot = 0;
+    }
+    return count;
+}
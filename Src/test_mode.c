@@ -34,7 +34,7 @@ void test_mode_update_stepcount(uint16_t adc_y) {
     const char* direction = get_y_direction(adc_y);
 
     uint16_t goal = get_goal();
-    uint16_t current = get_steps();
+    uint32_t current = get_steps();
 
     if (percent >= 30) {
         // Scale step change to joystick force and goal size
@@ -42,10 +42,10 @@ void test_mode_update_stepcount(uint16_t adc_y) {
         uint16_t step_delta = (percent * max_step_change) / 100;
 
         if (strcmp(direction, "Up") == 0) {
-            uint16_t new_count = (current + step_delta > goal) ? goal : current + step_delta;
+            uint32_t new_count = (current + step_delta > goal) ? goal : current + step_delta;
             set_step_count(new_count);
         } else if (strcmp(direction, "Down") == 0) {
-            uint16_t new_count = (step_delta > current) ? 0 : current - step_delta;
+            uint32_t new_count = (step_delta > current) ? 0 : current - step_delta;
             set_step_count(new_count);
         }
     }
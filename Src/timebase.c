@@ -0,0 +1,97 @@
+/*
+ * timebase.c
+ *
+ * SysTick-based timebase. A read samples uwTick and SysTick->VAL until uwTick
+ * is stable across the pair. Inside an interrupt that blocks SysTick, the
+ * counter can reload without uwTick moving; the pending flag in SCB->ICSR
+ * shows this, and the missing millisecond is added back.
+ *
+ * The position within the millisecond is scaled to microseconds with a Q16
+ * reciprocal, since the M0+ has no divider.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "timebase.h"
+#include "stm32c0xx_hal.h"
+#include <stdbool.h>
+
+#define US_PER_MS        1000u
+#define SCALE_BITS         16
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static uint32_t us_per_cycle_q16 = 0;     // 1000 / (LOAD + 1) in Q16
+static uint32_t tick_high = 0;            // Upper 32 bits of the millisecond count
+static uint32_t last_tick = 0;            // Last millisecond count seen, to spot uwTick wrapping
+                                          // (timebase_us() must run at least every 24 days; the scheduler does)
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// Reads the millisecond count and the cycles elapsed within it as one consistent pair
+static uint32_t read_tick(uint32_t *cycles_in_ms) {
+    uint32_t reload = SysTick->LOAD + 1;
+    uint32_t tick, count;
+    bool pending;
+
+    do {
+        tick = uwTick;
+        pending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+        count = SysTick->VAL;
+        if (!pending && (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0) {
+            // Reloaded between the two reads; re-read so the count is after the reload
+            pending = true;
+            count = SysTick->VAL;
+        }
+    } while (tick != uwTick);
+
+    if (pending) tick++;  // uwTick has not caught up with the reload yet
+    *cycles_in_ms = reload - 1 - count;
+    return tick;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void timebase_init(void) {
+    uint32_t reload = SysTick->LOAD + 1;
+    us_per_cycle_q16 = ((US_PER_MS << SCALE_BITS) + reload / 2) / reload;
+    tick_high = 0;
+    last_tick = uwTick;
+}
+
+uint32_t timebase_cycles(void) {
+    uint32_t cycles_in_ms;
+    uint32_t tick = read_tick(&cycles_in_ms);
+    return tick * (SysTick->LOAD + 1) + cycles_in_ms;
+}
+
+uint32_t timebase_cycles_per_ms(void) {
+    return SysTick->LOAD + 1;
+}
+
+uint64_t timebase_us(void) {
+    uint32_t cycles_in_ms;
+    uint32_t tick = read_tick(&cycles_in_ms);
+
+    // The high word is shared with interrupt-context readers, so extend with interrupts masked
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if ((int32_t)(tick - last_tick) >= 0) {
+        if (tick < last_tick) tick_high++;  // uwTick wrapped
+        last_tick = tick;
+    }
+    // An interrupt may have stored a newer tick since ours was read; if that one already wrapped, ours is from before
+    uint32_t high = (tick > last_tick) ? tick_high - 1 : tick_high;
+    __set_PRIMASK(primask);
+
+    uint64_t ms = ((uint64_t)high << 32) | tick;
+
+    return ms * US_PER_MS + ((cycles_in_ms * us_per_cycle_q16) >> SCALE_BITS);
+}
@@ -0,0 +1,89 @@
+/*
+ * trace.c
+ *
+ * Event trace ring buffer. Recording a record costs one cycle stamp and four
+ * stores; when full, the oldest record is overwritten, so the ring always
+ * holds the most recent TRACE_RECORDS events.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "trace.h"
+#include "timebase.h"
+
+_Static_assert(sizeof(TraceRecord) == 8, "trace records must stay 8 bytes");
+_Static_assert((TRACE_RECORDS & (TRACE_RECORDS - 1)) == 0, "TRACE_RECORDS must be a power of two");
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static TraceRecord ring[TRACE_RECORDS];
+static uint32_t written = 0;     // Total records written since the last clear
+static bool frozen = false;
+
+static const char* const event_names[NUM_TRACE_EVENTS] = {
+    "button", "display", "joystick", "serial", "step_task", "test", "buzzer", "accelerometer", "led",
+    "i2c_read", "i2c_write", "i2c_probe", "uart_tx", "display_flush",
+    "step", "profile", "screen", "step_source", "detector", "activity"
+};
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+static void record(trace_event_t event, uint8_t phase, uint16_t arg) {
+    if (!TRACE_ENABLED || frozen) return;
+
+    TraceRecord *slot = &ring[written & (TRACE_RECORDS - 1)];
+    slot->stamp = timebase_cycles();
+    slot->event = (uint8_t)event;
+    slot->phase = phase;
+    slot->arg = arg;
+    written++;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void trace_begin(trace_event_t event, uint16_t arg) {
+    record(event, TRACE_PHASE_BEGIN, arg);
+}
+
+void trace_end(trace_event_t event, uint16_t arg) {
+    record(event, TRACE_PHASE_END, arg);
+}
+
+void trace_instant(trace_event_t event, uint16_t arg) {
+    record(event, TRACE_PHASE_INSTANT, arg);
+}
+
+void trace_freeze(bool freeze) {
+    frozen = freeze;
+}
+
+uint16_t trace_count(void) {
+    return (written < TRACE_RECORDS) ? (uint16_t)written : TRACE_RECORDS;
+}
+
+uint32_t trace_dropped(void) {
+    return (written > TRACE_RECORDS) ? written - TRACE_RECORDS : 0;
+}
+
+bool trace_get(uint16_t index, TraceRecord *out) {
+    if (index >= trace_count()) return false;
+
+    uint32_t oldest = written - trace_count();
+    *out = ring[(oldest + index) & (TRACE_RECORDS - 1)];
+    return true;
+}
+
+void trace_clear(void) {
+    written = 0;
+}
+
+const char* trace_event_name(uint8_t event) {
+    return (event < NUM_TRACE_EVENTS) ? event_names[event] : "unknown";
+}
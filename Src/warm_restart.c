@@ -0,0 +1,96 @@
+/*
+ * warm_restart.c
+ *
+ * Retained-RAM resume path. The snapshot lives in .noinit, which the C runtime
+ * neither zeroes nor initialises, so it survives any reset that keeps power.
+ * After a power-on reset its contents are random and fail the magic/CRC check.
+ * Tick-based times are kept as ages, because the tick restarts from zero.
+ * A transient screen (goal setting, diagnostics) resumes on the steps screen.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "warm_restart.h"
+#include "checksum.h"
+#include "accelerometer.h"
+#include "step_detection.h"
+#include "goal_tracker.h"
+#include "distance.h"
+#include "step_history.h"
+#include "fsm.h"
+#include "profile.h"
+#include "stm32c0xx_hal.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RETAINED_MAGIC  0x57524D33u  // "WRM3" (detector and recent history added)
+
+// Snapshot of everything needed to resume without a skip window or count loss
+typedef struct {
+    uint32_t magic;
+    uint32_t steps;
+    uint16_t goal;
+    uint16_t stride_mm;
+    uint8_t screen;
+    uint8_t profile;              // Filter contents are only valid for this profile's length
+    uint16_t reserved;
+    AccelerometerState accel;
+    DetectorSnapshot detector;
+    StepHistoryRecent history;    // Minutes flash may not hold yet
+    uint16_t crc;                 // CRC-16 over all preceding bytes
+} RetainedState;
+
+static RetainedState retained __attribute__((section(".noinit")));
+static bool warm_boot = false;
+
+// The screen to resume on: the current one unless it only makes sense mid-interaction
+static display_state_t home_screen(void) {
+    display_state_t screen = fsm_get_current_state();
+    if (check_set_goal_state() || screen >= NUM_DISPLAY_STATES) return DISPLAY_STEPS;
+    return screen;
+}
+
+static uint16_t retained_crc(void) {
+    return crc16_ccitt(&retained, offsetof(RetainedState, crc));
+}
+
+bool warm_restart_init(void) {
+    bool power_on = __HAL_RCC_GET_FLAG(RCC_FLAG_PWRRST) != 0;
+    __HAL_RCC_CLEAR_RESET_FLAGS();
+
+    warm_boot = !power_on && retained.magic == RETAINED_MAGIC && retained.crc == retained_crc();
+
+    if (warm_boot) {
+        set_goal(retained.goal);
+        distance_set_stride_mm(retained.stride_mm, retained.steps);
+        set_step_count(retained.steps);
+        step_history_restore_recent(&retained.history);
+        fsm_set_state((display_state_t)retained.screen);
+        profile_restore((profile_id_t)retained.profile);
+        accelerometer_restore_state(&retained.accel);
+        steps_restore_detector(&retained.detector);
+    }
+
+    retained.magic = 0;  // Invalid until the first save of this run
+    return warm_boot;
+}
+
+void warm_restart_save(void) {
+    retained.magic = RETAINED_MAGIC;
+    retained.steps = get_steps();
+    retained.goal = get_goal();
+    retained.stride_mm = distance_get_stride_mm();
+    retained.screen = (uint8_t)home_screen();
+    retained.profile = (uint8_t)profile_get_id();
+    retained.reserved = 0;
+    accelerometer_save_state(&retained.accel);
+    steps_save_detector(&retained.detector);
+    step_history_save_recent(&retained.history);
+    retained.crc = retained_crc();
+}
+
+bool warm_restart_is_warm(void) {
+    return warm_boot;
+}
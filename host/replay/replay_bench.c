@@ -0,0 +1,442 @@
+/*
+ * replay_bench.c
+ *
+ * Host counterpart of the on-target bench (bench.c): the HAL-free kernels of
+ * libstep_core.a, the CIC decimator, the cadence bank, the IMU word decode, the
+ * joystick math and the main screen formatters run over a whole trace, and each is
+ * reported in nanoseconds and retired instructions per sample. Instructions
+ * come from the Linux perf counter (perf_event_open, user space only); where
+ * the kernel refuses it (perf_event_paranoid, containers, VMs without a PMU)
+ * the column shows "-". Instruction counts do not depend on the clock or on
+ * what else the machine is doing, so they are the column to diff between
+ * builds; the nanoseconds (fastest pass) show what the host actually spends.
+ *
+ * The synthetic walk's results can be checked against a saved baseline: a
+ * kernel fails if it retires more than REGRESSION_INSTR_PERCENT more
+ * instructions per sample than the baseline, or, where either run has no
+ * instruction count, takes more than REGRESSION_NS_PERCENT more nanoseconds
+ * (a loose bound, since the time depends on the machine).
+ *
+ * Usage: replay_bench [trace.csv ...]   (60 Hz; no arguments: synthetic walk)
+ *        replay_bench --baseline FILE   (synthetic walk, exits 1 on a regression)
+ *        replay_bench --save FILE       (synthetic walk, writes its results as the baseline)
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#define _GNU_SOURCE   // syscall() and clock_gettime under -std=c11
+
+#include "walk.h"
+#include "step_core.h"
+#include "cic_decimator.h"
+#include "cadence.h"
+#include "joystick_math.h"
+#include "display_format.h"
+#include "imu_decode.h"
+#include "timebase.h"
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SAMPLE_HZ       60
+#define DETECT_EVERY    10      // Step task at 6 Hz, as in the firmware's default profile
+#define MAX_SAMPLES     (SAMPLE_HZ * 300)
+#define BATCH_SAMPLES   64      // BENCH_INPUT_SAMPLES: the on-target batch size
+#define MIN_SAMPLES     1000000 // Each kernel repeats over the trace until it has run this many
+#define CIC_RATIO       7       // The default profile's 416 Hz -> 59.4 Hz
+#define FORMAT_GOAL     10000   // Goal the format kernel's percentages are taken of
+
+#define REGRESSION_INSTR_PERCENT   5
+#define REGRESSION_NS_PERCENT    100
+
+typedef enum {
+    KERNEL_FILTER_APPLY = 0,
+    KERNEL_FILTER_BATCH,
+    KERNEL_MAGNITUDE,
+    KERNEL_PIPELINE,
+    KERNEL_DETECT_FIXED,
+    KERNEL_DETECT_ADAPTIVE,
+    KERNEL_PROCESS,
+    KERNEL_CIC,
+    KERNEL_CADENCE,
+    KERNEL_AXIS_DECODE,
+    KERNEL_JOYSTICK,
+    KERNEL_FORMAT,
+    NUM_KERNELS
+} kernel_t;
+
+typedef struct {
+    double ns;              // Per sample
+    double instructions;    // Per sample; negative without a perf counter
+} KernelResult;
+
+// Names follow the on-target kernels where there is one
+static const char *const kernel_names[NUM_KERNELS] = {
+    "FILTER_APPLY", "FILTER_BATCH", "MAGNITUDE", "PIPELINE", "DETECT_FIXED", "DETECT_ADAPTIVE",
+    "PROCESS", "CIC", "CADENCE", "AXIS_DECODE", "JOYSTICK", "FORMAT",
+};
+
+static StepCoreSample samples[MAX_SAMPLES];
+static StepCoreEvent events[MAX_SAMPLES];
+static int16_t interleaved[MAX_SAMPLES][3];
+static int16_t batch_output[MAX_SAMPLES][3];
+static uint64_t dynamic[MAX_SAMPLES];
+static int16_t highs[MAX_SAMPLES];      // Vertical extremes held up to each sample since the last evaluation
+static int16_t lows[MAX_SAMPLES];
+static int16_t vertical[MAX_SAMPLES];
+static uint8_t encoded[MAX_SAMPLES][IMU_SAMPLE_BYTES];  // Each sample as the IMU's output registers hold it
+static KernelResult results[NUM_KERNELS];
+static int perf_fd = -1;
+static volatile uint64_t sink;
+
+// The cadence bank's own cost counters read the cycle counter; the bench times it from outside
+uint32_t timebase_cycles(void) {
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Opens a user-space instruction counter on this thread; -1 when perf is not available
+static int perf_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void perf_start(void) {
+    if (perf_fd < 0) return;
+    ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+// Instructions since perf_start(); UINT64_MAX without a counter
+static uint64_t perf_stop(void) {
+    uint64_t count;
+    if (perf_fd < 0) return UINT64_MAX;
+    ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+    return (read(perf_fd, &count, sizeof(count)) == sizeof(count)) ? count : UINT64_MAX;
+}
+
+static void core_setup(StepCore *core, bool adaptive) {
+    step_core_init(core);
+    step_core_configure_sampling(core, SAMPLE_HZ);
+    step_core_configure_detector(core, SAMPLE_HZ / DETECT_EVERY, STEP_DYNAMIC_THRESHOLD);
+    step_core_set_adaptive(core, adaptive, 0, 0);
+    step_core_set_detect_decimation(core, DETECT_EVERY);
+}
+
+// One pass of a kernel over the trace; returns the samples it covered
+static uint32_t run_pass(kernel_t kernel, StepCore *core, uint32_t n) {
+    uint64_t acc = 0;
+
+    switch (kernel) {
+        case KERNEL_FILTER_APPLY: {
+            AveragingFilter filter = { 0 };
+            for (uint32_t i = 0; i < n; i++) {
+                acc += (uint16_t)step_core_filter_apply(&filter, core->filter.length, samples[i].x);
+            }
+            break;
+        }
+
+        case KERNEL_FILTER_BATCH:
+            for (uint32_t i = 0; i < n; i += BATCH_SAMPLES) {
+                uint16_t batch = (n - i < BATCH_SAMPLES) ? (uint16_t)(n - i) : BATCH_SAMPLES;
+                step_core_tri_filter_batch(&core->filter, &interleaved[i], &batch_output[i], batch);
+            }
+            acc += (uint16_t)batch_output[n - 1][0];
+            break;
+
+        case KERNEL_MAGNITUDE:
+            for (uint32_t i = 0; i < n; i++) {
+                acc += step_core_magnitude_squared(samples[i].x, samples[i].y, samples[i].z);
+            }
+            break;
+
+        case KERNEL_PIPELINE:
+            for (uint32_t i = 0; i < n; i++) {
+                step_core_track_gravity(core, samples[i].x, samples[i].y, samples[i].z);
+                acc += step_core_filter(core, samples[i].x, samples[i].y, samples[i].z).dynamic_magnitude_square;
+            }
+            break;
+
+        case KERNEL_DETECT_FIXED:
+        case KERNEL_DETECT_ADAPTIVE:
+            // One evaluation per step-task run, on the magnitudes and extremes the pipeline produced
+            for (uint32_t i = DETECT_EVERY - 1; i < n; i += DETECT_EVERY) {
+                core->vertical_high = highs[i];
+                core->vertical_low = lows[i];
+                acc += step_core_detect(core, dynamic[i], samples[i].t_ms);
+            }
+            n /= DETECT_EVERY;
+            break;
+
+        case KERNEL_PROCESS:
+            for (uint32_t i = 0; i < n; i += UINT16_MAX) {
+                uint16_t chunk = (n - i > UINT16_MAX) ? UINT16_MAX : (uint16_t)(n - i);
+                acc += step_core_process(core, samples + i, chunk, events);
+            }
+            break;
+
+        case KERNEL_CIC: {
+            CicDecimator cic[3];
+            for (uint8_t axis = 0; axis < 3; axis++) cic_init(&cic[axis], CIC_RATIO);
+            for (uint32_t i = 0; i < n; i++) {
+                int16_t ox, oy, oz;
+                bool output = cic_push(&cic[0], samples[i].x, &ox);
+                cic_push(&cic[1], samples[i].y, &oy);
+                cic_push(&cic[2], samples[i].z, &oz);
+                if (output) acc += (uint16_t)(ox ^ oy ^ oz);
+            }
+            break;
+        }
+
+        case KERNEL_CADENCE:
+            // One Goertzel update per sample, with the readout at each window's end
+            for (uint32_t i = 0; i < n; i++) {
+                cadence_push(vertical[i]);
+            }
+            acc += cadence_get_spm();
+            break;
+
+        case KERNEL_AXIS_DECODE:
+            // The decode half of the on-target AXIS_READ; the host has no bus to time
+            for (uint32_t i = 0; i < n; i++) {
+                int16_t x, y, z;
+                imu_decode_sample(encoded[i], &x, &y, &z);
+                acc += (uint16_t)(x ^ y ^ z);
+            }
+            break;
+
+        case KERNEL_JOYSTICK:
+            for (uint32_t i = 0; i < n; i++) {
+                uint16_t adc = (uint16_t)((i * 16) & 0x0FFF);  // Sweeps the 12-bit range, as on target
+                acc += calculate_x_percentage(adc) + calculate_y_percentage(adc) +
+                       calculate_potentiometer_percentage(adc);
+            }
+            break;
+
+        case KERNEL_FORMAT: {
+            // The main screen's four lines, alternating between the two unit modes
+            char buf[20];
+            for (uint32_t i = 0; i < n; i++) {
+                bool percent = (i & 1) != 0;
+                format_steps(buf, sizeof(buf), i, FORMAT_GOAL, percent);
+                acc += (uint8_t)buf[0];
+                if (percent) {
+                    format_distance_yards(buf, sizeof(buf), i);
+                } else {
+                    format_distance_km(buf, sizeof(buf), i / 1000, (uint16_t)(i % 1000));
+                }
+                acc += (uint8_t)buf[0];
+                format_progress(buf, sizeof(buf), i, FORMAT_GOAL, percent);
+                acc += (uint8_t)buf[0];
+                format_cadence(buf, sizeof(buf), (uint16_t)(i % 200));
+                acc += (uint8_t)buf[0];
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    sink = acc;
+    return n;
+}
+
+// Times a kernel over repeated passes, each on a freshly set-up core outside the timing. The time
+// reported is the fastest pass's, which interruptions and frequency changes inflate the least;
+// instructions are averaged over every pass
+static void run_kernel(kernel_t kernel, uint32_t n) {
+    uint64_t instructions = 0, covered = 0;
+    double fastest_ns = -1.0;
+    bool counted = true;
+
+    while (covered < MIN_SAMPLES) {
+        StepCore core;
+        core_setup(&core, kernel == KERNEL_DETECT_ADAPTIVE);
+        if (kernel == KERNEL_FILTER_BATCH) {
+            step_core_tri_filter_batch(&core.filter, interleaved, batch_output, 1);  // Seeds the window
+        }
+        if (kernel == KERNEL_CADENCE) cadence_configure(SAMPLE_HZ * 100u);
+
+        perf_start();
+        uint64_t start = now_ns();
+        uint32_t pass = run_pass(kernel, &core, n);
+        double pass_ns = (double)(now_ns() - start) / pass;
+        uint64_t count = perf_stop();
+
+        covered += pass;
+        if (fastest_ns < 0 || pass_ns < fastest_ns) fastest_ns = pass_ns;
+
+        if (count == UINT64_MAX) counted = false;
+        instructions += count;
+    }
+
+    results[kernel].ns = fastest_ns;
+    results[kernel].instructions = counted ? (double)instructions / covered : -1.0;
+
+    printf("  %-16s %10lu %10.2f", kernel_names[kernel], (unsigned long)covered, results[kernel].ns);
+    if (counted) {
+        printf(" %12.1f\n", results[kernel].instructions);
+    } else {
+        printf(" %12s\n", "-");
+    }
+}
+
+static void report(const char *name, uint32_t n) {
+    StepCore core;
+
+    // Layouts, magnitudes and vertical components the kernels take as input, prepared outside the timing
+    core_setup(&core, false);
+    for (uint32_t i = 0; i < n; i++) {
+        interleaved[i][0] = samples[i].x;
+        interleaved[i][1] = samples[i].y;
+        interleaved[i][2] = samples[i].z;
+        encoded[i][0] = (uint8_t)samples[i].x;
+        encoded[i][1] = (uint8_t)((uint16_t)samples[i].x >> 8);
+        encoded[i][2] = (uint8_t)samples[i].y;
+        encoded[i][3] = (uint8_t)((uint16_t)samples[i].y >> 8);
+        encoded[i][4] = (uint8_t)samples[i].z;
+        encoded[i][5] = (uint8_t)((uint16_t)samples[i].z >> 8);
+        step_core_track_gravity(&core, samples[i].x, samples[i].y, samples[i].z);
+        vertical[i] = step_core_raw_vertical(&core, samples[i].x, samples[i].y, samples[i].z);
+        dynamic[i] = step_core_filter(&core, samples[i].x, samples[i].y, samples[i].z).dynamic_magnitude_square;
+        highs[i] = core.vertical_high;
+        lows[i] = core.vertical_low;
+        if ((i + 1) % DETECT_EVERY == 0) {
+            core.vertical_high = INT16_MIN;
+            core.vertical_low = INT16_MAX;
+        }
+    }
+
+    printf("%s (%lu samples)\n", name, (unsigned long)n);
+    printf("  %-16s %10s %10s %12s\n", "kernel", "samples", "ns/sample", "instr/sample");
+    for (uint8_t k = 0; k < NUM_KERNELS; k++) run_kernel((kernel_t)k, n);
+}
+
+// Writes the results as a baseline: one "kernel ns/sample instr/sample" line per kernel ("-" without a count)
+static bool save_baseline(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "# replay_bench baseline (synthetic walk): kernel ns/sample instr/sample\n");
+    for (uint8_t k = 0; k < NUM_KERNELS; k++) {
+        fprintf(file, "%s %.2f", kernel_names[k], results[k].ns);
+        if (results[k].instructions >= 0) {
+            fprintf(file, " %.1f\n", results[k].instructions);
+        } else {
+            fprintf(file, " -\n");
+        }
+    }
+    return fclose(file) == 0;
+}
+
+// Compares the results with a baseline file; returns the number of kernels that regressed, -1 if unreadable
+static int check_baseline(const char *path) {
+    FILE *file = fopen(path, "r");
+    char line[128], name[32], instr_text[32];
+    double base_ns;
+    int regressions = 0;
+
+    if (file == NULL) return -1;
+    printf("baseline %s: instructions within %d%%, else time within %d%%\n", path, REGRESSION_INSTR_PERCENT,
+           REGRESSION_NS_PERCENT);
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (line[0] == '#' || sscanf(line, "%31s %lf %31s", name, &base_ns, instr_text) != 3) continue;
+
+        uint8_t k = 0;
+        while (k < NUM_KERNELS && strcmp(kernel_names[k], name) != 0) k++;
+        if (k == NUM_KERNELS) {
+            printf("  %-16s not measured any more\n", name);
+            continue;
+        }
+
+        double base_instr = (strcmp(instr_text, "-") == 0) ? -1.0 : atof(instr_text);
+        bool by_instructions = base_instr >= 0 && results[k].instructions >= 0;
+        double base = by_instructions ? base_instr : base_ns;
+        double now = by_instructions ? results[k].instructions : results[k].ns;
+        int percent = by_instructions ? REGRESSION_INSTR_PERCENT : REGRESSION_NS_PERCENT;
+        bool regressed = now > base * (100 + percent) / 100.0;
+
+        printf("  %-16s %10.2f -> %10.2f %s%s\n", name, base, now, by_instructions ? "instr" : "ns",
+               regressed ? "  REGRESSED" : "");
+        if (regressed) regressions++;
+    }
+    fclose(file);
+    return regressions;
+}
+
+// -----------------------------------------------------------------------------
+// Main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+    perf_fd = perf_open();
+    if (perf_fd < 0) printf("perf instruction counter unavailable (%s); instructions not reported\n", strerror(errno));
+
+    bool baseline = argc == 3 && strcmp(argv[1], "--baseline") == 0;
+    bool save = argc == 3 && strcmp(argv[1], "--save") == 0;
+
+    if (argc < 2 || baseline || save) {
+        const WalkSegment walk[] = {
+            { .duration_ms = 10000, .cadence_spm = 0, .amplitude = 0, .noise = 200 },
+            { .duration_ms = 110000, .cadence_spm = 120, .amplitude = 4000, .noise = 200 },
+        };
+        uint32_t n = walk_generate(samples, MAX_SAMPLES, SAMPLE_HZ, 0, walk, 2, 5, NULL);
+        report("synthetic walk", n);
+
+        if (save && !save_baseline(argv[2])) {
+            fprintf(stderr, "%s: cannot write\n", argv[2]);
+            return 1;
+        }
+        if (baseline) {
+            int regressions = check_baseline(argv[2]);
+            if (regressions < 0) {
+                fprintf(stderr, "%s: cannot open\n", argv[2]);
+                return 1;
+            }
+            if (regressions > 0) {
+                printf("FAIL: %d kernels regressed\n", regressions);
+                return 1;
+            }
+        }
+        return 0;
+    }
+    for (int i = 1; i < argc; i++) {
+        int32_t n = walk_load_csv(argv[i], samples, MAX_SAMPLES);
+        if (n < 0) {
+            fprintf(stderr, "%s: cannot open\n", argv[i]);
+            return 1;
+        }
+        if (n < DETECT_EVERY) {
+            fprintf(stderr, "%s: too short to time\n", argv[i]);
+            return 1;
+        }
+        report(argv[i], (uint32_t)n);
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * replay_cic.c
+ *
+ * Offline replay of the CIC front-end (cic_decimator.c): a 416 Hz trace, as
+ * the sensor FIFO delivers it with ACCEL_CIC_FRONTEND set, goes through one
+ * decimator per axis at each ratio the profiles use. For every ratio it
+ * reports the host cost per input sample of all three axes (ns, and TSC ticks
+ * on x86) and the largest difference from a direct order-3 boxcar
+ * convolution of the same input, which the decimator must match to within
+ * rounding.
+ *
+ * Usage: replay_cic [trace.csv ...]   (a 416 Hz trace; no arguments: synthetic walk)
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#define _POSIX_C_SOURCE 199309L   // clock_gettime under -std=c11
+
+#include "walk.h"
+#include "cic_decimator.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define INPUT_HZ      416     // ACCEL_CIC_ODR_HZ
+#define MAX_SAMPLES   (INPUT_HZ * 120)
+#define REPEATS       50      // Passes over the trace for the timing
+#define MAX_TAPS      (CIC_ORDER * (CIC_MAX_RATIO - 1) + 1)
+
+static StepCoreSample samples[MAX_SAMPLES];
+static int16_t axis_in[3][MAX_SAMPLES];
+
+// Ratios the profiles select (7 -> 59.4 Hz, 8 -> 52 Hz, 17 -> 24.5 Hz)
+static const uint8_t ratios[] = { 7, 8, 17 };
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t ticks(void) {
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Impulse response of CIC_ORDER cascaded boxcars of 'ratio' taps
+static uint16_t boxcar_taps(uint8_t ratio, int64_t *taps) {
+    uint16_t length = 1;
+    taps[0] = 1;
+    for (uint8_t stage = 0; stage < CIC_ORDER; stage++) {
+        int64_t next[MAX_TAPS] = {0};
+        for (uint16_t i = 0; i < length; i++) {
+            for (uint8_t k = 0; k < ratio; k++) next[i + k] += taps[i];
+        }
+        length += ratio - 1;
+        for (uint16_t i = 0; i < length; i++) taps[i] = next[i];
+    }
+    return length;
+}
+
+// Largest difference (LSB) between the decimator and the direct convolution, over all axes
+static uint32_t max_error(uint8_t ratio, uint32_t n) {
+    int64_t taps[MAX_TAPS];
+    uint16_t length = boxcar_taps(ratio, taps);
+    double gain = pow(ratio, CIC_ORDER);
+    uint32_t worst = 0;
+
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        CicDecimator cic;
+        cic_init(&cic, ratio);
+        for (uint32_t i = 0; i < n; i++) {
+            int16_t out;
+            if (!cic_push(&cic, axis_in[axis][i], &out)) continue;
+
+            int64_t sum = 0;
+            for (uint16_t k = 0; k < length && k <= i; k++) sum += taps[k] * axis_in[axis][i - k];
+            uint32_t error = (uint32_t)labs(out - lround(sum / gain));
+            if (error > worst) worst = error;
+        }
+    }
+    return worst;
+}
+
+static void report(const char *name, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        axis_in[0][i] = samples[i].x;
+        axis_in[1][i] = samples[i].y;
+        axis_in[2][i] = samples[i].z;
+    }
+
+    for (uint8_t r = 0; r < sizeof(ratios) / sizeof(ratios[0]); r++) {
+        CicDecimator cic[3];
+        volatile int16_t sink = 0;
+        uint32_t outputs = 0;
+
+        uint64_t t0 = now_ns(), c0 = ticks();
+        for (uint32_t pass = 0; pass < REPEATS; pass++) {
+            for (uint8_t axis = 0; axis < 3; axis++) cic_init(&cic[axis], ratios[r]);
+            for (uint32_t i = 0; i < n; i++) {
+                int16_t ox, oy, oz;
+                bool output = cic_push(&cic[0], axis_in[0][i], &ox);
+                cic_push(&cic[1], axis_in[1][i], &oy);
+                cic_push(&cic[2], axis_in[2][i], &oz);
+                if (output) {
+                    sink = (int16_t)(ox ^ oy ^ oz);
+                    outputs++;
+                }
+            }
+        }
+        uint64_t elapsed_ns = now_ns() - t0, elapsed_ticks = ticks() - c0;
+        (void)sink;
+
+        double inputs = (double)n * REPEATS;
+        printf("%-24s %5u %8.1f Hz %10.2f %10.2f %10lu %8u\n", name, ratios[r], (double)INPUT_HZ / ratios[r],
+               elapsed_ns / inputs, elapsed_ticks / inputs, (unsigned long)(outputs / REPEATS),
+               max_error(ratios[r], n));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+    printf("%-24s %5s %11s %10s %10s %10s %8s\n", "trace", "ratio", "output", "ns/input", "tsc/input",
+           "outputs", "max err");
+
+    if (argc < 2) {
+        const WalkSegment walk[] = {
+            { .duration_ms = 5000, .cadence_spm = 0, .amplitude = 0, .noise = 200 },
+            { .duration_ms = 55000, .cadence_spm = 120, .amplitude = 4000, .noise = 200 },
+        };
+        uint32_t n = walk_generate(samples, MAX_SAMPLES, INPUT_HZ, 0, walk, 2, 7, NULL);
+        report("synthetic walk", n);
+        return 0;
+    }
+    for (int i = 1; i < argc; i++) {
+        int32_t n = walk_load_csv(argv[i], samples, MAX_SAMPLES);
+        if (n < 0) {
+            fprintf(stderr, "%s: cannot open\n", argv[i]);
+            return 1;
+        }
+        report(argv[i], (uint32_t)n);
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * replay_detectors.c
+ *
+ * Offline comparison of the fixed and adaptive step detectors. Each trace is
+ * run through libstep_core.a once per mode with the firmware's default rates
+ * (60 Hz sampling, detector at 6 Hz). The report gives the steps counted
+ * against the steps in the trace and the host time per detector evaluation.
+ * The synthetic set covers gentle, normal and heavy walkers at slow, normal
+ * and brisk cadences, each after a still spell, plus walks broken by pauses
+ * (the adaptive envelopes freeze through them). The adaptive count must be
+ * within ADAPTIVE_TOLERANCE of the truth on every synthetic trace, or the
+ * replay fails; the fixed detector's misses are reported but not checked.
+ *
+ * Usage: replay_detectors [trace.csv ...]   (60 Hz; no arguments: synthetic set)
+ * Recorded traces carry no step truth, so only the counts are printed.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#define _POSIX_C_SOURCE 199309L   // clock_gettime under -std=c11
+
+#include "walk.h"
+#include "step_core.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SAMPLE_HZ     60
+#define DETECT_EVERY  10    // Step task at 6 Hz, as in the firmware's default profile
+#define MAX_SAMPLES   (SAMPLE_HZ * 300)
+#define NO_TRUTH      UINT32_MAX
+#define ADAPTIVE_TOLERANCE(TRUTH)  ((TRUTH) / 50 + 2)  // 2% and two steps for the start and end of a walk
+
+typedef struct {
+    uint32_t counted;
+    double ns_per_eval;
+} DetectorResult;
+
+static StepCoreSample samples[MAX_SAMPLES];
+static StepCoreEvent events[MAX_SAMPLES];
+static uint32_t failures = 0;
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Runs a fresh core over the trace in one mode
+static DetectorResult run(uint32_t n, bool adaptive) {
+    DetectorResult result = { 0, 0.0 };
+    StepCore core;
+
+    step_core_init(&core);
+    step_core_configure_sampling(&core, SAMPLE_HZ);
+    step_core_configure_detector(&core, SAMPLE_HZ / DETECT_EVERY, STEP_DYNAMIC_THRESHOLD);
+    step_core_set_adaptive(&core, adaptive, 0, 0);
+    step_core_set_detect_decimation(&core, DETECT_EVERY);
+
+    for (uint32_t i = 0; i < n; i += UINT16_MAX) {
+        uint16_t chunk = (n - i > UINT16_MAX) ? UINT16_MAX : (uint16_t)(n - i);
+        result.counted += step_core_process(&core, samples + i, chunk, events);
+    }
+
+    // Detector alone, on the dynamic magnitudes and vertical extremes a second core produced
+    // (the filters are the same for both modes, so only the detector's cost differs)
+    static uint64_t dynamic[MAX_SAMPLES / DETECT_EVERY];
+    static int16_t highs[MAX_SAMPLES / DETECT_EVERY], lows[MAX_SAMPLES / DETECT_EVERY];
+    uint32_t evaluations = 0;
+    StepCore filter_core;
+    step_core_init(&filter_core);
+    step_core_configure_sampling(&filter_core, SAMPLE_HZ);
+    for (uint32_t i = 0; i < n; i++) {
+        step_core_track_gravity(&filter_core, samples[i].x, samples[i].y, samples[i].z);
+        FilteredAcceleration output = step_core_filter(&filter_core, samples[i].x, samples[i].y, samples[i].z);
+        if ((i + 1) % DETECT_EVERY == 0) {
+            dynamic[evaluations] = output.dynamic_magnitude_square;
+            highs[evaluations] = filter_core.vertical_high;
+            lows[evaluations++] = filter_core.vertical_low;
+            filter_core.vertical_high = INT16_MIN;
+            filter_core.vertical_low = INT16_MAX;
+        }
+    }
+
+    volatile uint32_t sink = 0;
+    step_core_set_adaptive(&core, adaptive, 0, 0);
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < evaluations; i++) {
+        core.vertical_high = highs[i];      // What step_core_filter() would have held
+        core.vertical_low = lows[i];
+        sink += step_core_detect(&core, dynamic[i], samples[(i + 1) * DETECT_EVERY - 1].t_ms);
+    }
+    (void)sink;
+    if (evaluations > 0) result.ns_per_eval = (double)(now_ns() - start) / evaluations;
+    return result;
+}
+
+static void report(const char *name, uint32_t n, uint32_t truth) {
+    printf("%-30s", name);
+    if (truth == NO_TRUTH) {
+        printf(" %6s", "-");
+    } else {
+        printf(" %6lu", (unsigned long)truth);
+    }
+
+    for (int adaptive = 0; adaptive <= 1; adaptive++) {
+        DetectorResult result = run(n, adaptive);
+        printf(" %8lu", (unsigned long)result.counted);
+        if (truth == NO_TRUTH || truth == 0) {
+            printf(" %7s", "-");
+        } else {
+            printf(" %6.1f%%", 100.0 * ((double)result.counted - truth) / truth);
+        }
+        printf(" %7.1f", result.ns_per_eval);
+        if (adaptive && truth != NO_TRUTH) {
+            uint32_t error = (result.counted > truth) ? result.counted - truth : truth - result.counted;
+            if (error > ADAPTIVE_TOLERANCE(truth)) {
+                printf("  FAIL: off by %lu, tolerance %lu", (unsigned long)error,
+                       (unsigned long)ADAPTIVE_TOLERANCE(truth));
+                failures++;
+            }
+        }
+    }
+    printf("\n");
+}
+
+static void replay_synthetic(void) {
+    static const uint16_t amplitudes[] = { 1500, 4000, 8000 };      // Gentle, normal, heavy
+    static const char *const amplitude_names[] = { "gentle", "normal", "heavy" };
+    static const uint16_t cadences[] = { 90, 120, 150 };
+    char name[48];
+    uint32_t seed = 1;
+
+    for (uint8_t a = 0; a < 3; a++) {
+        for (uint8_t c = 0; c < 3; c++) {
+            const WalkSegment walk[] = {
+                { 5000, 0, 0, 150 },
+                { 90000, cadences[c], amplitudes[a], 150 },
+            };
+            uint32_t truth;
+            uint32_t n = walk_generate(samples, MAX_SAMPLES, SAMPLE_HZ, 0, walk, 2, seed++, &truth);
+            snprintf(name, sizeof(name), "%s %u spm", amplitude_names[a], cadences[c]);
+            report(name, n, truth);
+        }
+    }
+
+    // Walks broken by pauses, and a still trace with enough noise to sit near the fixed threshold
+    const WalkSegment stop_start[] = {
+        { 5000, 0, 0, 150 }, { 30000, 110, 3000, 150 }, { 20000, 0, 0, 150 },
+        { 30000, 110, 3000, 150 }, { 20000, 0, 0, 150 }, { 30000, 110, 3000, 150 },
+    };
+    const WalkSegment noisy_still = { 120000, 0, 0, 500 };
+    uint32_t truth;
+    uint32_t n = walk_generate(samples, MAX_SAMPLES, SAMPLE_HZ, 0, stop_start, 6, seed++, &truth);
+    report("stop-start 110 spm", n, truth);
+    n = walk_generate(samples, MAX_SAMPLES, SAMPLE_HZ, 0, &noisy_still, 1, seed++, &truth);
+    report("still, noise 500", n, truth);
+}
+
+// -----------------------------------------------------------------------------
+// Main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+    printf("%-30s %6s %8s %7s %7s %8s %7s %7s\n", "trace", "steps", "fixed", "error", "ns/eval",
+           "adaptive", "error", "ns/eval");
+
+    if (argc < 2) {
+        replay_synthetic();
+        return (failures > 0) ? 1 : 0;
+    }
+    for (int i = 1; i < argc; i++) {
+        int32_t n = walk_load_csv(argv[i], samples, MAX_SAMPLES);
+        if (n < 0) {
+            fprintf(stderr, "%s: cannot open\n", argv[i]);
+            return 1;
+        }
+        report(argv[i], (uint32_t)n, NO_TRUTH);
+    }
+    return 0;
+}
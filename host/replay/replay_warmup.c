@@ -0,0 +1,156 @@
+/*
+ * replay_warmup.c
+ *
+ * Offline replay of the start-up window: how long after the first sample the
+ * detector is allowed to run, when it counts its first step, and whether the
+ * start-up transient produces false steps. Each trace is run twice through
+ * libstep_core.a:
+ * - seeded: the current start-up, filters seeded from the first real sample
+ *   and detection gated on step_core_is_ready()
+ * - legacy: the old start-up, every filter slot prefilled with the 9310
+ *   gravity baseline and detection skipped for the first 500 ms
+ *
+ * Usage: replay_warmup [trace.csv ...]   (no arguments: synthetic traces)
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "walk.h"
+#include "step_core.h"
+
+#include <stdio.h>
+
+#define SAMPLE_HZ          60
+#define DETECT_EVERY       10      // Step task at 6 Hz, as in the firmware's default profile
+#define MAX_SAMPLES        (SAMPLE_HZ * 600)
+#define LEGACY_BASELINE    9310    // Old filter prefill on every axis (raw units)
+#define LEGACY_SKIP_MS      500    // Old fixed start-up skip
+#define FALSE_STEP_MS      2000    // Steps this early in a still trace are start-up artefacts
+
+typedef struct {
+    uint32_t enabled_ms;    // First detector evaluation, from the first sample (UINT32_MAX = never)
+    uint32_t first_step_ms; // First counted step, from the first sample (UINT32_MAX = none)
+    uint32_t early_steps;   // Steps counted within FALSE_STEP_MS
+    uint32_t steps;
+} WarmupResult;
+
+static StepCoreSample samples[MAX_SAMPLES];
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+static void core_setup(StepCore *core) {
+    step_core_init(core);
+    step_core_configure_sampling(core, SAMPLE_HZ);
+    step_core_configure_detector(core, SAMPLE_HZ / DETECT_EVERY, STEP_DYNAMIC_THRESHOLD);
+}
+
+// Runs the pipeline the way the firmware's tasks do; 'legacy' selects the old start-up
+static WarmupResult run(const StepCoreSample *trace, uint32_t n, bool legacy) {
+    WarmupResult result = { UINT32_MAX, UINT32_MAX, 0, 0 };
+    StepCore core;
+    uint8_t phase = 0;
+
+    core_setup(&core);
+    if (n == 0) return result;
+
+    uint32_t t0 = trace[0].t_ms;
+    if (legacy) {
+        // Gravity still starts from the first sample; only the filter window holds the baseline
+        const int16_t baseline[1][3] = { { LEGACY_BASELINE, LEGACY_BASELINE, LEGACY_BASELINE } };
+        int16_t out[1][3];
+        step_core_track_gravity(&core, trace[0].x, trace[0].y, trace[0].z);
+        step_core_tri_filter_batch(&core.filter, baseline, out, 1);
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        const StepCoreSample *sample = &trace[i];
+        uint32_t elapsed = sample->t_ms - t0;
+
+        step_core_track_gravity(&core, sample->x, sample->y, sample->z);
+        FilteredAcceleration output = step_core_filter(&core, sample->x, sample->y, sample->z);
+
+        if (++phase < DETECT_EVERY) continue;
+        phase = 0;
+
+        bool enabled = legacy ? elapsed >= LEGACY_SKIP_MS : step_core_is_ready(&core);
+        if (!enabled) continue;
+        if (result.enabled_ms == UINT32_MAX) result.enabled_ms = elapsed;
+
+        if (step_core_detect(&core, output.dynamic_magnitude_square, sample->t_ms)) {
+            if (result.first_step_ms == UINT32_MAX) result.first_step_ms = elapsed;
+            if (elapsed < FALSE_STEP_MS) result.early_steps++;
+            result.steps++;
+        }
+    }
+    return result;
+}
+
+static void print_ms(uint32_t ms) {
+    if (ms == UINT32_MAX) {
+        printf(" %10s", "-");
+    } else {
+        printf(" %7lu ms", (unsigned long)ms);
+    }
+}
+
+static void report(const char *name, const StepCoreSample *trace, uint32_t n) {
+    for (int legacy = 1; legacy >= 0; legacy--) {
+        WarmupResult result = run(trace, n, legacy);
+        printf("%-22s %-7s", name, legacy ? "legacy" : "seeded");
+        print_ms(result.enabled_ms);
+        print_ms(result.first_step_ms);
+        printf(" %12lu %6lu\n", (unsigned long)result.early_steps, (unsigned long)result.steps);
+    }
+}
+
+// Synthetic starts: standing still, walking from the first sample, and walking after a short pause
+static void replay_synthetic(void) {
+    const struct {
+        const char *name;
+        WalkSegment segments[2];
+        uint8_t count;
+    } cases[] = {
+        { "still",          { { 10000, 0, 0, 200 } }, 1 },
+        { "walk from boot", { { 10000, 120, 4000, 150 } }, 1 },
+        { "still 0.3s, walk", { { 300, 0, 0, 150 }, { 10000, 120, 4000, 150 } }, 2 },
+        { "tilted still",   { { 10000, 0, 0, 200 } }, 1 },
+    };
+
+    for (uint8_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        uint32_t n = walk_generate(samples, MAX_SAMPLES, SAMPLE_HZ, 0, cases[c].segments, cases[c].count,
+                                   c + 1, NULL);
+        if (c == 3) {
+            // Gravity split between y and z, as with the device held at 45 degrees
+            for (uint32_t i = 0; i < n; i++) {
+                samples[i].y = (int16_t)(samples[i].y + 11585);
+                samples[i].z = (int16_t)(samples[i].z - 4799);
+            }
+        }
+        report(cases[c].name, samples, n);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+    printf("%-22s %-7s %10s %10s %12s %6s\n", "trace", "start", "detecting", "1st step", "steps < 2 s", "steps");
+
+    if (argc < 2) {
+        replay_synthetic();
+        return 0;
+    }
+    for (int i = 1; i < argc; i++) {
+        int32_t n = walk_load_csv(argv[i], samples, MAX_SAMPLES);
+        if (n < 0) {
+            fprintf(stderr, "%s: cannot open\n", argv[i]);
+            return 1;
+        }
+        report(argv[i], samples, (uint32_t)n);
+    }
+    return 0;
+}
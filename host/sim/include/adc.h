@@ -0,0 +1,17 @@
+/*
+ * adc.h (simulator)
+ *
+ * Peripheral handle normally defined by the STM32CubeMX-generated adc.c.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_ADC_H_
+#define SIM_ADC_H_
+
+#include "main.h"
+
+extern ADC_HandleTypeDef hadc1;
+
+#endif /* SIM_ADC_H_ */
@@ -0,0 +1,33 @@
+/*
+ * buttons.h (simulator)
+ *
+ * Board button driver API; the simulator presses buttons from its script.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_BUTTONS_H_
+#define SIM_BUTTONS_H_
+
+#include "main.h"
+
+typedef enum {
+    UP = 0,
+    DOWN,
+    LEFT,
+    RIGHT,
+    NUM_BUTTONS
+} button_t;
+
+typedef enum {
+    RELEASED = 0,
+    PUSHED,
+    NO_CHANGE
+} butState_t;
+
+void buttons_init(void);
+void buttons_update(void);
+butState_t buttons_checkButton(button_t button);
+
+#endif /* SIM_BUTTONS_H_ */
@@ -0,0 +1,17 @@
+/*
+ * i2c.h (simulator)
+ *
+ * Peripheral handle normally defined by the STM32CubeMX-generated i2c.c.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_I2C_H_
+#define SIM_I2C_H_
+
+#include "main.h"
+
+extern I2C_HandleTypeDef hi2c1;
+
+#endif /* SIM_I2C_H_ */
@@ -0,0 +1,26 @@
+/*
+ * imu_lsm6ds.h (simulator)
+ *
+ * LSM6DS register names used by the firmware. The simulator's IMU model sits
+ * behind the I2C HAL at LSM6DS_I2C_ADDRESS.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_IMU_LSM6DS_H_
+#define SIM_IMU_LSM6DS_H_
+
+#include "main.h"
+
+#define WHO_AM_I                   0x0F
+#define CTRL1_XL                   0x10
+#define CTRL1_XL_HIGH_PERFORMANCE  0x40  // 104 Hz, +/-2 g
+#define OUTX_L_XL                  0x28
+#define OUTX_H_XL                  0x29
+#define OUTY_L_XL                  0x2A
+#define OUTY_H_XL                  0x2B
+#define OUTZ_L_XL                  0x2C
+#define OUTZ_H_XL                  0x2D
+
+#endif /* SIM_IMU_LSM6DS_H_ */
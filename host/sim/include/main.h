@@ -0,0 +1,22 @@
+/*
+ * main.h (simulator)
+ *
+ * Pin labels as generated by STM32CubeMX for the board.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_MAIN_H_
+#define SIM_MAIN_H_
+
+#include "stm32c0xx_hal.h"
+
+#define JOYSTICK_CLICK_Pin        GPIO_PIN_1
+#define JOYSTICK_CLICK_GPIO_Port  GPIOA
+#define I2C1_SCL_Pin              GPIO_PIN_8
+#define I2C1_SCL_GPIO_Port        GPIOB
+#define I2C1_SDA_Pin              GPIO_PIN_9
+#define I2C1_SDA_GPIO_Port        GPIOB
+
+#endif /* SIM_MAIN_H_ */
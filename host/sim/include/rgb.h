@@ -0,0 +1,26 @@
+/*
+ * rgb.h (simulator)
+ *
+ * Board RGB LED driver API; the simulator records every change on its LED timeline.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_RGB_H_
+#define SIM_RGB_H_
+
+#include "main.h"
+
+typedef enum {
+    RGB_RIGHT = 0,
+    RGB_DOWN,
+    RGB_LEFT,
+    NUM_RGB_LEDS
+} rgb_led_t;
+
+void rgb_colour_all_on(void);
+void rgb_led_on(rgb_led_t led);
+void rgb_led_off(rgb_led_t led);
+
+#endif /* SIM_RGB_H_ */
@@ -0,0 +1,33 @@
+/*
+ * ssd1306.h (simulator)
+ *
+ * SSD1306 library API. The simulator keeps the text drawn since the last fill
+ * as the frame, charges each flush its I2C transfer time, and snapshots every
+ * flushed frame that differs from the previous one.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_SSD1306_H_
+#define SIM_SSD1306_H_
+
+#include "main.h"
+#include "ssd1306_fonts.h"
+#include <stdio.h>
+
+#define SSD1306_WIDTH   128
+#define SSD1306_HEIGHT   64
+
+typedef enum {
+    Black = 0,
+    White = 1
+} SSD1306_COLOR;
+
+void ssd1306_Init(void);
+void ssd1306_Fill(SSD1306_COLOR color);
+void ssd1306_UpdateScreen(void);
+void ssd1306_SetCursor(uint8_t x, uint8_t y);
+char ssd1306_WriteString(char *str, SSD1306_FontDef font, SSD1306_COLOR color);
+
+#endif /* SIM_SSD1306_H_ */
@@ -0,0 +1,24 @@
+/*
+ * ssd1306_fonts.h (simulator)
+ *
+ * Font descriptors of the SSD1306 library; only the cell sizes are modelled.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_SSD1306_FONTS_H_
+#define SIM_SSD1306_FONTS_H_
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t FontWidth;
+    uint8_t FontHeight;
+} SSD1306_FontDef;
+
+extern const SSD1306_FontDef Font_6x8;
+extern const SSD1306_FontDef Font_7x10;
+extern const SSD1306_FontDef Font_11x18;
+
+#endif /* SIM_SSD1306_FONTS_H_ */
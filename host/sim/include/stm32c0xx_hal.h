@@ -0,0 +1,270 @@
+/*
+ * stm32c0xx_hal.h (simulator)
+ *
+ * The slice of the STM32C0 HAL and CMSIS that the firmware uses, backed by the
+ * simulator's virtual clock and peripheral models. Register macros keep their
+ * real semantics (they read and write the fake register blocks), so code such
+ * as the buzzer's preload sequencing behaves as on the board.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_STM32C0XX_HAL_H_
+#define SIM_STM32C0XX_HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef enum {
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY  0xFFFFFFFFu
+
+// -----------------------------------------------------------------------------
+// Core: SysTick, SCB, PRIMASK, sleep
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    volatile uint32_t CTRL, LOAD, VAL, CALIB;
+} SysTick_Type;
+
+typedef struct {
+    volatile uint32_t CPUID, ICSR, VTOR, AIRCR, SCR, CCR;
+} SCB_Type;
+
+extern SysTick_Type sim_systick;
+extern SCB_Type sim_scb;
+#define SysTick  (&sim_systick)
+#define SCB      (&sim_scb)
+
+#define SysTick_CTRL_COUNTFLAG_Msk  (1UL << 16)
+#define SCB_ICSR_PENDSTSET_Msk      (1UL << 26)
+#define SCB_SCR_SLEEPONEXIT_Msk     (1UL << 1)
+#define SCB_SCR_SLEEPDEEP_Msk       (1UL << 2)
+
+extern volatile uint32_t uwTick;
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay_ms);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __WFI(void);
+uint32_t __get_MSP(void);
+void NVIC_SystemReset(void);
+
+// The linker symbols bounding free RAM; the simulator places them around the firmware's stack
+#define _end     sim_stack_bottom
+#define _estack  sim_stack_top
+
+// -----------------------------------------------------------------------------
+// RCC
+// -----------------------------------------------------------------------------
+
+#define RCC_FLAG_PWRRST   1
+#define RCC_FLAG_SFTRST   2
+#define RCC_FLAG_IWDGRST  3
+#define RCC_FLAG_PINRST   4
+
+int sim_rcc_get_flag(int flag);
+void sim_rcc_clear_flags(void);
+#define __HAL_RCC_GET_FLAG(FLAG)        sim_rcc_get_flag(FLAG)
+#define __HAL_RCC_CLEAR_RESET_FLAGS()   sim_rcc_clear_flags()
+#define __HAL_RCC_I2C1_FORCE_RESET()    do { } while (0)
+#define __HAL_RCC_I2C1_RELEASE_RESET()  do { } while (0)
+
+// -----------------------------------------------------------------------------
+// GPIO
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    volatile uint32_t IDR, ODR;
+    uint32_t od_mask;       // Pins configured as open-drain outputs (I2C recovery)
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef sim_gpioa, sim_gpiob;
+#define GPIOA  (&sim_gpioa)
+#define GPIOB  (&sim_gpiob)
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0   0x0001u
+#define GPIO_PIN_1   0x0002u
+#define GPIO_PIN_2   0x0004u
+#define GPIO_PIN_3   0x0008u
+#define GPIO_PIN_4   0x0010u
+#define GPIO_PIN_5   0x0020u
+#define GPIO_PIN_6   0x0040u
+#define GPIO_PIN_7   0x0080u
+#define GPIO_PIN_8   0x0100u
+#define GPIO_PIN_9   0x0200u
+#define GPIO_PIN_10  0x0400u
+#define GPIO_PIN_11  0x0800u
+#define GPIO_PIN_12  0x1000u
+#define GPIO_PIN_13  0x2000u
+#define GPIO_PIN_14  0x4000u
+#define GPIO_PIN_15  0x8000u
+
+#define GPIO_MODE_INPUT       0x00u
+#define GPIO_MODE_OUTPUT_PP   0x01u
+#define GPIO_MODE_OUTPUT_OD   0x11u
+#define GPIO_MODE_AF_OD       0x12u
+#define GPIO_NOPULL           0x00u
+#define GPIO_PULLUP           0x01u
+#define GPIO_SPEED_FREQ_LOW   0x00u
+
+typedef struct {
+    uint32_t Pin, Mode, Pull, Speed, Alternate;
+} GPIO_InitTypeDef;
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+
+// -----------------------------------------------------------------------------
+// Flash (a RAM array; FLASH_BASE is its address, which fits 32 bits in the non-PIE build)
+// -----------------------------------------------------------------------------
+
+extern uint8_t sim_flash[];
+#define FLASH_BASE                    ((uint32_t)(uintptr_t)sim_flash)
+#define FLASH_SIZE                    0x20000u
+#define FLASH_PAGE_SIZE               0x800u
+#define FLASH_TYPEERASE_PAGES         1u
+#define FLASH_TYPEPROGRAM_DOUBLEWORD  1u
+
+typedef struct {
+    uint32_t TypeErase, Page, NbPages;
+} FLASH_EraseInitTypeDef;
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uint32_t address, uint64_t data);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *erase, uint32_t *page_error);
+
+// -----------------------------------------------------------------------------
+// Timers
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    volatile uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR, RCR;
+    volatile uint32_t CCR1, CCR2, CCR3, CCR4;
+} TIM_TypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+extern TIM_TypeDef sim_tim16, sim_tim2;
+#define TIM16  (&sim_tim16)
+#define TIM2   (&sim_tim2)
+
+#define TIM_CR1_CEN              (1u << 0)
+#define TIM_CR1_ARPE             (1u << 7)
+#define TIM_SR_UIF               (1u << 0)
+#define TIM_DIER_UIE             (1u << 0)
+#define TIM_FLAG_UPDATE          TIM_SR_UIF
+#define TIM_IT_UPDATE            TIM_DIER_UIE
+#define TIM_EVENTSOURCE_UPDATE   (1u << 0)
+#define TIM_CHANNEL_1            0x00u
+#define TIM_CHANNEL_2            0x04u
+#define TIM_CHANNEL_3            0x08u
+#define TIM_CHANNEL_4            0x0Cu
+
+#define __HAL_TIM_SET_PRESCALER(H, V)     ((H)->Instance->PSC = (V))
+#define __HAL_TIM_SET_AUTORELOAD(H, V)    ((H)->Instance->ARR = (V))
+#define __HAL_TIM_GET_AUTORELOAD(H)       ((H)->Instance->ARR)
+#define __HAL_TIM_SET_COUNTER(H, V)       ((H)->Instance->CNT = (V))
+#define __HAL_TIM_SET_COMPARE(H, C, V)    (*(&(H)->Instance->CCR1 + ((C) >> 2)) = (V))
+#define __HAL_TIM_CLEAR_FLAG(H, F)        ((H)->Instance->SR = ~(F))
+#define __HAL_TIM_ENABLE_IT(H, I)         ((H)->Instance->DIER |= (I))
+#define __HAL_TIM_DISABLE_IT(H, I)        ((H)->Instance->DIER &= ~(I))
+
+HAL_StatusTypeDef HAL_TIM_GenerateEvent(TIM_HandleTypeDef *htim, uint32_t source);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef *htim, uint32_t channel, const uint32_t *data, uint16_t length);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t channel);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+
+// -----------------------------------------------------------------------------
+// UART
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    int Instance;
+} UART_HandleTypeDef;
+
+#define UART_FLAG_ORE      (1u << 3)
+#define UART_FLAG_RXNE     (1u << 5)
+#define UART_CLEAR_OREF    (1u << 3)
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size, uint32_t timeout);
+bool sim_uart_get_flag(UART_HandleTypeDef *huart, uint32_t flag);
+void sim_uart_clear_flag(UART_HandleTypeDef *huart, uint32_t flag);
+
+#define __HAL_UART_GET_FLAG(H, F)      sim_uart_get_flag((H), (F))
+#define __HAL_UART_CLEAR_FLAG(H, F)    sim_uart_clear_flag((H), (F))
+#define __HAL_UART_CLEAR_OREFLAG(H)    __HAL_UART_CLEAR_FLAG((H), UART_CLEAR_OREF)
+
+// -----------------------------------------------------------------------------
+// ADC
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    int Instance;
+} ADC_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *data, uint32_t length);
+
+// -----------------------------------------------------------------------------
+// I2C
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    volatile uint32_t ISR;
+} I2C_TypeDef;
+
+typedef struct {
+    I2C_TypeDef *Instance;
+    volatile uint32_t ErrorCode;
+} I2C_HandleTypeDef;
+
+extern I2C_TypeDef sim_i2c1;
+#define I2C1  (&sim_i2c1)
+
+#define I2C_ISR_BUSY            (1u << 15)
+#define I2C_FLAG_BUSY           I2C_ISR_BUSY
+#define I2C_MEMADD_SIZE_8BIT    1u
+#define I2C_TIMEOUT_BUSY        25u       // ms the HAL waits for a busy bus before giving up
+
+#define HAL_I2C_ERROR_NONE      0x00u
+#define HAL_I2C_ERROR_AF        0x04u     // NACK
+#define HAL_I2C_ERROR_TIMEOUT   0x20u
+
+#define __HAL_I2C_GET_FLAG(H, F)  ((((H)->Instance->ISR) & (F)) == (F))
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size,
+                                   uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size,
+                                    uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t address, uint32_t trials, uint32_t timeout);
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c);
+
+#endif /* SIM_STM32C0XX_HAL_H_ */
@@ -0,0 +1,18 @@
+/*
+ * tim.h (simulator)
+ *
+ * Timer handles normally defined by the STM32CubeMX-generated tim.c.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_TIM_H_
+#define SIM_TIM_H_
+
+#include "main.h"
+
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim16;
+
+#endif /* SIM_TIM_H_ */
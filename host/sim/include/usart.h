@@ -0,0 +1,17 @@
+/*
+ * usart.h (simulator)
+ *
+ * Peripheral handle normally defined by the STM32CubeMX-generated usart.c.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_USART_H_
+#define SIM_USART_H_
+
+#include "main.h"
+
+extern UART_HandleTypeDef huart2;
+
+#endif /* SIM_USART_H_ */
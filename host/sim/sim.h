@@ -0,0 +1,166 @@
+/*
+ * sim.h
+ *
+ * Internals shared by the simulator's modules. Virtual time only moves when
+ * the firmware calls into a fake peripheral: blocking operations are charged
+ * their bus or flash time, every HAL_GetTick()/PRIMASK read costs a small
+ * quantum (so polling loops make progress), and __WFI() fast-forwards to the
+ * scheduler's next deadline. Interrupts (SysTick, TIM16 update) are raised
+ * as virtual time passes and run at once unless PRIMASK masks them.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define SIM_CORE_HZ          48000000u   // HCLK = PCLK1
+#define SIM_NS_PER_MS         1000000u
+#define SIM_POLL_NS               100u   // Cost of one HAL_GetTick() or PRIMASK read
+#define SIM_UART_BAUD          115200u
+#define SIM_I2C_HZ             400000u   // Fast mode, as hi2c1 is configured (I2C_BUS_CLOCK_HZ)
+#define SIM_FLASH_ERASE_NS   22000000u   // Page erase (the CPU stalls on flash)
+#define SIM_FLASH_PROGRAM_NS    85000u   // One double word
+
+// -----------------------------------------------------------------------------
+// Clock and interrupts (sim_clock.c)
+// -----------------------------------------------------------------------------
+
+uint64_t sim_now_ns(void);
+static inline uint32_t sim_now_ms(void) { return (uint32_t)(sim_now_ns() / SIM_NS_PER_MS); }
+
+// Moves virtual time forward, raising interrupts and script events on the way
+void sim_advance_ns(uint64_t ns);
+
+// Called on entry to every fake: charges host CPU time (if scaled) and runs pending interrupts
+void sim_sync(void);
+
+// Virtual nanoseconds charged per host nanosecond of firmware code (0 = code is free)
+void sim_set_cpu_scale(double scale);
+
+// Stops the run at this time (reports are written from sim_finish())
+void sim_set_end_ms(uint32_t end_ms);
+
+// The next time something outside the firmware changes (script events); UINT64_MAX if none
+typedef uint64_t (*sim_next_event_fn)(void);
+typedef void (*sim_event_fn)(uint64_t now_ns);
+void sim_set_event_source(sim_next_event_fn next, sim_event_fn fire);
+
+// TIM16 update events (sim_periph.c)
+uint64_t sim_tim16_next_update_ns(void);
+void sim_tim16_update(void);
+bool sim_tim16_irq_pending(void);
+void sim_tim16_irq(void);
+
+// -----------------------------------------------------------------------------
+// Inputs (sim_periph.c)
+// -----------------------------------------------------------------------------
+
+void sim_button_set(int button, bool pressed);
+void sim_click_set(bool pressed);
+void sim_adc_set(uint8_t channel, uint16_t value);   // 0 = potentiometer, 1 = Y, 2 = X
+void sim_uart_rx(const char *bytes);
+uint32_t sim_uart_overruns(void);
+
+// -----------------------------------------------------------------------------
+// I2C bus and IMU (sim_i2c.c)
+// -----------------------------------------------------------------------------
+
+// Motion source: fills one raw sample (1 g = 16384) for a time
+typedef void (*sim_motion_fn)(uint64_t t_ns, int16_t xyz[3]);
+void sim_imu_set_motion(sim_motion_fn motion);
+void sim_imu_set_who_am_i(uint8_t who_am_i);   // 0x6A = LSM6DSL (default), 0x69 = LSM6DS3
+
+// Ground truth for the embedded pedometer: steps taken by a time. The model's counter
+// advances with it only while the pedometer is enabled the way the fitted variant expects
+typedef uint32_t (*sim_steps_fn)(uint64_t t_ns);
+void sim_imu_set_step_truth(sim_steps_fn steps);
+uint16_t sim_imu_pedometer_count(void);
+
+// A slave holds SDA low until it has seen 'clocks' SCL pulses (0 releases the bus at once,
+// SIM_I2C_HOLD_FOREVER never lets go)
+#define SIM_I2C_HOLD_FOREVER  0xFFFFu
+void sim_i2c_hold_sda(uint16_t clocks);
+
+typedef struct {
+    uint32_t transfers;
+    uint32_t busy_waits;        // Transfers that found the bus busy and waited out I2C_TIMEOUT_BUSY
+    uint32_t recoveries;        // SDA releases brought about by clocking SCL
+    uint64_t busy_wait_ns;
+} SimI2cStats;
+SimI2cStats sim_i2c_stats(void);
+
+// Charges the time to move 'bytes' bytes over the bus; false (after waiting) if the bus is held
+bool sim_i2c_transfer(uint32_t bytes);
+
+// The I2C pins while the firmware drives them as GPIO (bus recovery)
+void sim_i2c_pins_to_gpio(uint16_t pins);
+void sim_i2c_gpio_write(uint16_t pins, bool high);
+bool sim_i2c_gpio_read(uint16_t pin);
+
+// -----------------------------------------------------------------------------
+// Outputs (sim_periph.c, sim_display.c)
+// -----------------------------------------------------------------------------
+
+void sim_outputs_open(const char *dir);
+void sim_outputs_close(void);
+FILE* sim_timeline(void);          // t_us,source,event,value lines
+FILE* sim_display_log(void);
+FILE* sim_uart_log(void);
+
+// Latest flushed frame as text, and how many flushes reached the panel
+void sim_display_write_snapshot(FILE *out);
+uint32_t sim_display_flushes(void);
+
+// Called by the display model after every flush that reached the panel
+typedef void (*sim_flush_fn)(uint64_t now_ns);
+void sim_display_on_flush(sim_flush_fn fn);
+
+// -----------------------------------------------------------------------------
+// Flash (sim_flash.c)
+// -----------------------------------------------------------------------------
+
+// Loads the image from a file (erased if missing); sim_flash_save writes it back
+void sim_flash_load(const char *path);
+void sim_flash_save(const char *path);
+void sim_flash_erase_all(void);
+
+// Counts program and erase operations; power is lost during operation number 'op' (0-based,
+// UINT32_MAX = never): the operation is left half done and 'on_loss' is called (it must not return)
+void sim_flash_power_loss_at(uint32_t op, void (*on_loss)(void));
+uint32_t sim_flash_operations(void);
+
+// Every 'every'th double-word program (0 = none) writes only its first word and returns HAL_ERROR
+void sim_flash_fail_programs(uint32_t every);
+uint32_t sim_flash_failed_programs(void);
+
+// -----------------------------------------------------------------------------
+// Script and motion (sim_script.c)
+// -----------------------------------------------------------------------------
+
+// Loads timed input events ("<t_ms> <command> [args]", see scripts/README); false on a parse error
+bool sim_script_load(const char *path);
+
+// Replaces the scripted gait with a recorded trace ("t_ms,x,y,z" raw samples, held between rows)
+bool sim_trace_load(const char *path);
+
+// Connects the script to the clock and the IMU model
+void sim_script_install(void);
+
+// Ground truth of the scripted gait: steps completed by a time, and when step 'n' (1-based) landed
+uint32_t sim_walk_steps(uint64_t t_ns);
+uint64_t sim_walk_step_time_ns(uint32_t n);
+
+// -----------------------------------------------------------------------------
+// Run control (sim_main.c)
+// -----------------------------------------------------------------------------
+
+// Writes the reports and exits
+void sim_finish(void);
+
+#endif /* SIM_H_ */
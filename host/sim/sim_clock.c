@@ -0,0 +1,225 @@
+/*
+ * sim_clock.c
+ *
+ * Virtual clock, SysTick and interrupt masking. SysTick->VAL and uwTick follow
+ * virtual time exactly, including the window where SysTick has reloaded but
+ * its interrupt is still pending behind PRIMASK, so timebase.c sees the same
+ * register states as on the board. __WFI() fast-forwards to the scheduler's
+ * next deadline instead of waking for every idle tick.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "sim.h"
+#include "stm32c0xx_hal.h"
+#include "app.h"
+
+#include <time.h>
+
+#define CYCLES_PER_MS  (SIM_CORE_HZ / 1000u)
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+SysTick_Type sim_systick = { .CTRL = 0x7, .LOAD = CYCLES_PER_MS - 1, .VAL = CYCLES_PER_MS - 1 };
+SCB_Type sim_scb;
+volatile uint32_t uwTick = 0;
+
+static uint64_t now_ns = 0;
+static uint64_t next_systick_ns = SIM_NS_PER_MS;
+static bool systick_pending = false;
+static uint32_t primask = 0;
+static uint64_t end_ns = UINT64_MAX;
+
+static double cpu_scale = 0.0;
+static struct timespec host_mark;
+static bool host_mark_valid = false;
+
+static sim_next_event_fn next_event = NULL;
+static sim_event_fn fire_event = NULL;
+
+static bool in_interrupt = false;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+static void update_systick_registers(void) {
+    uint64_t into_ms = now_ns - (next_systick_ns - SIM_NS_PER_MS);
+    uint32_t cycles = (uint32_t)(into_ms * CYCLES_PER_MS / SIM_NS_PER_MS);
+    sim_systick.VAL = sim_systick.LOAD - cycles;
+    if (systick_pending) {
+        sim_scb.ICSR |= SCB_ICSR_PENDSTSET_Msk;
+    } else {
+        sim_scb.ICSR &= ~SCB_ICSR_PENDSTSET_Msk;
+    }
+}
+
+// Runs every pending interrupt that PRIMASK allows
+static void service_interrupts(void) {
+    if (primask || in_interrupt) return;
+
+    in_interrupt = true;
+    if (systick_pending) {
+        systick_pending = false;
+        uwTick++;
+    }
+    while (sim_tim16_irq_pending()) {
+        sim_tim16_irq();
+    }
+    in_interrupt = false;
+    update_systick_registers();
+}
+
+static uint64_t host_ns(const struct timespec *t) {
+    return (uint64_t)t->tv_sec * 1000000000u + (uint64_t)t->tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+uint64_t sim_now_ns(void) {
+    return now_ns;
+}
+
+void sim_set_cpu_scale(double scale) {
+    cpu_scale = scale;
+    host_mark_valid = false;
+}
+
+void sim_set_end_ms(uint32_t end_ms) {
+    end_ns = (uint64_t)end_ms * SIM_NS_PER_MS;
+}
+
+void sim_set_event_source(sim_next_event_fn next, sim_event_fn fire) {
+    next_event = next;
+    fire_event = fire;
+}
+
+void sim_advance_ns(uint64_t ns) {
+    uint64_t target = now_ns + ns;
+
+    while (now_ns < target || (now_ns == target && ns == 0)) {
+        uint64_t step_to = target;
+        uint64_t tim16 = sim_tim16_next_update_ns();
+        uint64_t scripted = next_event ? next_event() : UINT64_MAX;
+
+        if (next_systick_ns < step_to) step_to = next_systick_ns;
+        if (tim16 < step_to) step_to = tim16;
+        if (scripted < step_to) step_to = scripted;
+        if (end_ns < step_to) step_to = end_ns;
+        if (step_to < now_ns) step_to = now_ns;
+        now_ns = step_to;
+
+        if (now_ns >= end_ns) {
+            update_systick_registers();
+            sim_finish();
+        }
+        if (now_ns == next_systick_ns) {
+            systick_pending = true;
+            next_systick_ns += SIM_NS_PER_MS;
+        }
+        if (now_ns == tim16) {
+            sim_tim16_update();
+        }
+        if (now_ns == scripted && fire_event) {
+            fire_event(now_ns);
+        }
+        update_systick_registers();
+        service_interrupts();
+
+        if (ns == 0) break;
+    }
+}
+
+void sim_sync(void) {
+    if (cpu_scale > 0.0 && !in_interrupt) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (host_mark_valid) {
+            uint64_t spent = host_ns(&now) - host_ns(&host_mark);
+            sim_advance_ns((uint64_t)((double)spent * cpu_scale));
+        }
+        // The simulator's own work between here and the next sync is not charged
+        host_mark_valid = false;
+    }
+    service_interrupts();
+}
+
+// Restarts the host CPU stopwatch when control returns to firmware code
+static void resume_firmware(void) {
+    if (cpu_scale > 0.0) {
+        clock_gettime(CLOCK_MONOTONIC, &host_mark);
+        host_mark_valid = true;
+    }
+}
+
+uint32_t HAL_GetTick(void) {
+    sim_sync();
+    sim_advance_ns(SIM_POLL_NS);
+    resume_firmware();
+    return uwTick;
+}
+
+void HAL_Delay(uint32_t delay_ms) {
+    sim_sync();
+    sim_advance_ns((uint64_t)(delay_ms + 1) * SIM_NS_PER_MS);
+    resume_firmware();
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) {
+    return SIM_CORE_HZ;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void) {
+    return SIM_CORE_HZ;
+}
+
+void __disable_irq(void) {
+    primask = 1;
+}
+
+void __enable_irq(void) {
+    primask = 0;
+    sim_sync();
+    resume_firmware();
+}
+
+uint32_t __get_PRIMASK(void) {
+    sim_sync();
+    sim_advance_ns(SIM_POLL_NS);
+    resume_firmware();
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t value) {
+    primask = value & 1u;
+    if (!primask) {
+        sim_sync();
+        resume_firmware();
+    }
+}
+
+// Sleeps until the scheduler's next deadline. Idle ticks in between would only run
+// empty passes, so their SysTick interrupts are taken here in one go
+void __WFI(void) {
+    sim_sync();
+    if (systick_pending || sim_tim16_irq_pending()) {
+        resume_firmware();
+        return;  // A pending interrupt ends WFI at once, masked or not
+    }
+
+    uint32_t wake_tick = app_next_deadline();
+    if ((int32_t)(wake_tick - uwTick) <= 0) wake_tick = uwTick + 1;
+
+    uint32_t saved = primask;
+    primask = 0;
+    while ((int32_t)(wake_tick - uwTick) > 0) {
+        sim_advance_ns(next_systick_ns - now_ns);
+    }
+    primask = saved;
+    resume_firmware();
+}
@@ -0,0 +1,168 @@
+/*
+ * sim_display.c
+ *
+ * SSD1306 library model. Text drawn since the last fill makes up the frame;
+ * each flush is charged the library's I2C traffic (three commands and 128
+ * data bytes per page) and, if it reached the panel, becomes the displayed
+ * frame. Frames that differ from the last one are appended to display.txt
+ * as a character grid with one cell per 6x8 pixels (text starts in the
+ * cell under its cursor; wider fonts are not spread out).
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "sim.h"
+#include "ssd1306.h"
+
+#include <string.h>
+
+#define MAX_ITEMS      32
+#define MAX_TEXT       24
+#define CELL_WIDTH      6
+#define CELL_HEIGHT     8
+#define GRID_COLUMNS   (SSD1306_WIDTH / CELL_WIDTH + 1)
+#define GRID_ROWS      (SSD1306_HEIGHT / CELL_HEIGHT)
+#define PAGES           8
+#define COMMAND_BYTES   3      // Address, control byte, command
+#define PAGE_BYTES     (2 + SSD1306_WIDTH)
+#define INIT_COMMANDS  28
+
+typedef struct {
+    uint8_t x, y;
+    char text[MAX_TEXT];
+} TextItem;
+
+typedef struct {
+    TextItem items[MAX_ITEMS];
+    uint8_t count;
+} Frame;
+
+const SSD1306_FontDef Font_6x8 = { 6, 8 };
+const SSD1306_FontDef Font_7x10 = { 7, 10 };
+const SSD1306_FontDef Font_11x18 = { 11, 18 };
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static Frame drawing;           // Frame buffer being drawn
+static Frame shown;             // Last frame that reached the panel
+static uint8_t cursor_x = 0, cursor_y = 0;
+static uint32_t flushes = 0;
+static sim_flush_fn flush_hook = NULL;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+static bool frames_equal(const Frame *a, const Frame *b) {
+    if (a->count != b->count) return false;
+    for (uint8_t i = 0; i < a->count; i++) {
+        const TextItem *p = &a->items[i], *q = &b->items[i];
+        if (p->x != q->x || p->y != q->y || strcmp(p->text, q->text) != 0) return false;
+    }
+    return true;
+}
+
+static void render(const Frame *frame, FILE *out) {
+    char grid[GRID_ROWS][GRID_COLUMNS + 1];
+
+    memset(grid, ' ', sizeof(grid));
+    for (uint8_t row = 0; row < GRID_ROWS; row++) {
+        grid[row][GRID_COLUMNS] = '\0';
+    }
+    for (uint8_t i = 0; i < frame->count; i++) {
+        const TextItem *item = &frame->items[i];
+        uint8_t row = (uint8_t)((item->y + CELL_HEIGHT / 2) / CELL_HEIGHT);
+        if (row >= GRID_ROWS) row = GRID_ROWS - 1;
+        for (size_t c = 0; item->text[c]; c++) {
+            uint32_t column = (item->x + CELL_WIDTH / 2) / CELL_WIDTH + (uint32_t)c;
+            if (column < GRID_COLUMNS) grid[row][column] = item->text[c];
+        }
+    }
+
+    fprintf(out, "+%.*s+\n", GRID_COLUMNS, "------------------------------");
+    for (uint8_t row = 0; row < GRID_ROWS; row++) {
+        fprintf(out, "|%s|\n", grid[row]);
+    }
+    fprintf(out, "+%.*s+\n", GRID_COLUMNS, "------------------------------");
+}
+
+static bool send_command(void) {
+    return sim_i2c_transfer(COMMAND_BYTES);
+}
+
+// -----------------------------------------------------------------------------
+// Simulator API
+// -----------------------------------------------------------------------------
+
+void sim_display_write_snapshot(FILE *out) {
+    if (!out) return;
+    fprintf(out, "t = %.3f s, flush %lu\n", (double)sim_now_ns() / 1e9, (unsigned long)flushes);
+    render(&shown, out);
+}
+
+uint32_t sim_display_flushes(void) {
+    return flushes;
+}
+
+void sim_display_on_flush(sim_flush_fn fn) {
+    flush_hook = fn;
+}
+
+// -----------------------------------------------------------------------------
+// Library
+// -----------------------------------------------------------------------------
+
+void ssd1306_Init(void) {
+    HAL_Delay(100);
+    for (uint8_t i = 0; i < INIT_COMMANDS; i++) {
+        send_command();
+    }
+    ssd1306_Fill(Black);
+    ssd1306_UpdateScreen();
+}
+
+void ssd1306_Fill(SSD1306_COLOR color) {
+    sim_sync();
+    drawing.count = 0;
+    cursor_x = cursor_y = 0;
+}
+
+void ssd1306_SetCursor(uint8_t x, uint8_t y) {
+    cursor_x = x;
+    cursor_y = y;
+}
+
+char ssd1306_WriteString(char *str, SSD1306_FontDef font, SSD1306_COLOR color) {
+    sim_sync();
+    if (drawing.count < MAX_ITEMS) {
+        TextItem *item = &drawing.items[drawing.count++];
+        item->x = cursor_x;
+        item->y = cursor_y;
+        snprintf(item->text, sizeof(item->text), "%s", str);
+    }
+    cursor_x = (uint8_t)(cursor_x + strlen(str) * font.FontWidth);
+    return '\0';
+}
+
+// The library ignores bus errors, so a failed page simply leaves the panel stale
+void ssd1306_UpdateScreen(void) {
+    bool reached = true;
+
+    for (uint8_t page = 0; page < PAGES; page++) {
+        for (uint8_t command = 0; command < 3; command++) {
+            reached &= send_command();
+        }
+        reached &= sim_i2c_transfer(PAGE_BYTES);
+    }
+    if (!reached) return;
+
+    flushes++;
+    if (!frames_equal(&drawing, &shown)) {
+        shown = drawing;
+        sim_display_write_snapshot(sim_display_log());
+    }
+    if (flush_hook) flush_hook(sim_now_ns());
+}
@@ -0,0 +1,152 @@
+/*
+ * sim_flash.c
+ *
+ * Internal flash as a RAM array. Erase and program are charged their
+ * datasheet times (the CPU stalls on flash, so nothing else runs meanwhile).
+ * Programming a double word that is not erased fails, as on the STM32C0.
+ * For power-loss testing, operation number N can be cut short: a program
+ * then leaves only its first word written and an erase only half the page
+ * cleared, and the loss handler is called instead of returning. Programs can
+ * also be made to fail: every Nth leaves its first word written and returns
+ * HAL_ERROR, as a program error (PROGERR) mid double-word would.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "sim.h"
+#include "stm32c0xx_hal.h"
+
+#include <string.h>
+
+// Low in the address space (the simulator links without PIE), so FLASH_BASE fits 32 bits
+uint8_t sim_flash[FLASH_SIZE] __attribute__((aligned(FLASH_PAGE_SIZE)));
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static bool unlocked = false;
+static uint32_t operations = 0;
+static uint32_t loss_at = UINT32_MAX;
+static void (*loss_handler)(void) = NULL;
+static uint32_t programs = 0;
+static uint32_t fail_every = 0;         // 0 = programs never fail
+static uint32_t failed_programs = 0;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+// True if this operation is the one the power fails during
+static bool power_fails(void) {
+    return operations++ == loss_at && loss_handler != NULL;
+}
+
+static bool is_erased(const uint8_t *bytes, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (bytes[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Simulator API
+// -----------------------------------------------------------------------------
+
+void sim_flash_erase_all(void) {
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+}
+
+void sim_flash_load(const char *path) {
+    sim_flash_erase_all();
+    FILE *file = fopen(path, "rb");
+    if (!file) return;
+    size_t read = fread(sim_flash, 1, sizeof(sim_flash), file);
+    fclose(file);
+    (void)read;
+}
+
+void sim_flash_save(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return;
+    fwrite(sim_flash, 1, sizeof(sim_flash), file);
+    fclose(file);
+}
+
+void sim_flash_power_loss_at(uint32_t op, void (*on_loss)(void)) {
+    operations = 0;
+    loss_at = op;
+    loss_handler = on_loss;
+}
+
+uint32_t sim_flash_operations(void) {
+    return operations;
+}
+
+void sim_flash_fail_programs(uint32_t every) {
+    programs = 0;
+    fail_every = every;
+    failed_programs = 0;
+}
+
+uint32_t sim_flash_failed_programs(void) {
+    return failed_programs;
+}
+
+// -----------------------------------------------------------------------------
+// HAL
+// -----------------------------------------------------------------------------
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void) {
+    unlocked = true;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void) {
+    unlocked = false;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uint32_t address, uint64_t data) {
+    sim_sync();
+    uint32_t offset = address - FLASH_BASE;
+    if (!unlocked || type != FLASH_TYPEPROGRAM_DOUBLEWORD || (offset & 7u) || offset >= FLASH_SIZE) {
+        return HAL_ERROR;
+    }
+    if (!is_erased(&sim_flash[offset], sizeof(data))) return HAL_ERROR;
+
+    if (power_fails()) {
+        memcpy(&sim_flash[offset], &data, sizeof(uint32_t));
+        loss_handler();
+    }
+    sim_advance_ns(SIM_FLASH_PROGRAM_NS);
+    if (fail_every != 0 && ++programs % fail_every == 0) {
+        memcpy(&sim_flash[offset], &data, sizeof(uint32_t));
+        failed_programs++;
+        return HAL_ERROR;
+    }
+    memcpy(&sim_flash[offset], &data, sizeof(data));
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *erase, uint32_t *page_error) {
+    sim_sync();
+    *page_error = 0xFFFFFFFFu;
+    if (!unlocked) return HAL_ERROR;
+
+    for (uint32_t page = erase->Page; page < erase->Page + erase->NbPages; page++) {
+        if ((page + 1) * FLASH_PAGE_SIZE > FLASH_SIZE) {
+            *page_error = page;
+            return HAL_ERROR;
+        }
+        uint8_t *start = &sim_flash[page * FLASH_PAGE_SIZE];
+        if (power_fails()) {
+            memset(start, 0xFF, FLASH_PAGE_SIZE / 2);
+            loss_handler();
+        }
+        sim_advance_ns(SIM_FLASH_ERASE_NS);
+        memset(start, 0xFF, FLASH_PAGE_SIZE);
+    }
+    return HAL_OK;
+}
@@ -0,0 +1,422 @@
+/*
+ * sim_i2c.c
+ *
+ * I2C1 and the LSM6DS behind it. Transfers are charged their time on the
+ * wire (9 bits per byte at SIM_I2C_HZ). A slave can be made to hold SDA low
+ * until it sees a number of SCL pulses; while it does, the peripheral's BUSY
+ * flag is set and the HAL behaves as the STM32C0 HAL does: memory reads and
+ * writes wait I2C_TIMEOUT_BUSY for the bus and fail with a timeout error,
+ * IsDeviceReady returns HAL_BUSY at once. Pulsing SCL as GPIO frees the bus.
+ *
+ * The IMU model converts at the ODR written to CTRL1_XL (output registers
+ * read zero before the first conversion after power-up, and keep the last
+ * conversion across an ODR change until the new rate's first one), keeps an accelerometer FIFO in
+ * continuous mode, and runs its pedometer only when it is enabled the way
+ * the fitted variant expects: CTRL10_C FUNC_EN|PEDO_EN on the LSM6DSL,
+ * CTRL10_C FUNC_EN and TAP_CFG PEDO_EN on the LSM6DS3.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "sim.h"
+#include "i2c.h"
+#include "i2c_bus.h"
+
+#include <string.h>
+
+#define BITS_PER_BYTE        9                   // 8 data bits and the acknowledge
+#define WHO_AM_I_LSM6DS3     0x69
+#define WHO_AM_I_LSM6DSL     0x6A
+
+_Static_assert(SIM_I2C_HZ == I2C_BUS_CLOCK_HZ, "The simulated bus must run at the clock the firmware budgets for");
+
+// Registers the model gives behaviour to
+#define REG_FIFO_CTRL5       0x0A
+#define REG_WHO_AM_I         0x0F
+#define REG_CTRL1_XL         0x10
+#define REG_CTRL10_C         0x19
+#define REG_FIFO_STATUS1     0x3A
+#define REG_FIFO_STATUS2     0x3B
+#define REG_FIFO_STATUS3     0x3C
+#define REG_FIFO_STATUS4     0x3D
+#define REG_FIFO_DATA_OUT_L  0x3E
+#define REG_FIFO_DATA_OUT_H  0x3F
+#define REG_STEP_COUNTER_L   0x4B
+#define REG_STEP_COUNTER_H   0x4C
+#define REG_TAP_CFG          0x58
+#define REG_OUTX_L_XL        0x28
+#define REG_OUTZ_H_XL        0x2D
+
+#define CTRL10_FUNC_EN       0x04
+#define CTRL10_PEDO_EN_DSL   0x10
+#define TAP_CFG_PEDO_EN_DS3  0x40
+#define FIFO_MODE_MASK       0x07
+#define FIFO_MODE_CONTINUOUS 0x06
+#define FIFO_STATUS2_OVER    0x40
+#define FIFO_STATUS2_EMPTY   0x10
+#define FIFO_WORDS           2046                // 682 three-word samples
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+I2C_TypeDef sim_i2c1;
+I2C_HandleTypeDef hi2c1 = { .Instance = I2C1 };
+
+static uint16_t hold_clocks = 0;     // SCL pulses until the stuck slave lets go of SDA
+static bool pins_gpio = false;
+static bool scl_high = true, sda_high = true;
+static SimI2cStats stats;
+
+static uint8_t registers[128];
+static uint8_t who_am_i = WHO_AM_I_LSM6DSL;
+static sim_motion_fn motion = NULL;
+static sim_steps_fn step_truth = NULL;
+static uint64_t odr_since_ns = 0;    // When CTRL1_XL last changed
+static int16_t held[3];              // Last conversion at the previous ODR (kept until the next one)
+static bool held_valid = false;
+
+// FIFO of 16-bit words, filled lazily up to the current time
+static int16_t fifo[FIFO_WORDS];
+static uint16_t fifo_head = 0, fifo_count = 0;
+static uint8_t fifo_pattern = 0;     // Position of the next word to read within its sample
+static bool fifo_overrun = false;
+static uint64_t fifo_next_ns = 0;
+
+// Pedometer counter: the truth accumulated while enabled
+static uint32_t pedometer_steps = 0;
+static uint32_t pedometer_mark = 0;  // Truth when the counter last caught up
+static bool pedometer_running = false;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+static bool sda_held(void) {
+    return hold_clocks > 0;
+}
+
+static uint32_t odr_hz(uint8_t code) {
+    static const uint32_t rates[16] = { 0, 12, 26, 52, 104, 208, 416, 833, 1666, 3333, 6666, 0, 0, 0, 0, 0 };
+    return rates[(code >> 4) & 0x0F];
+}
+
+static uint64_t period_ns(uint32_t hz) {
+    return (hz == 12) ? 80000000u : 1000000000u / hz;   // 12.5 Hz
+}
+
+static void motion_at(uint64_t t_ns, int16_t xyz[3]) {
+    xyz[0] = xyz[1] = 0;
+    xyz[2] = 16384;
+    if (motion) motion(t_ns, xyz);
+}
+
+// Latest completed conversion; false before the first one since power-up.
+// An ODR change leaves the output registers holding the last conversion at the old rate
+static bool latest_conversion(int16_t xyz[3]) {
+    uint32_t hz = odr_hz(registers[REG_CTRL1_XL]);
+    uint64_t now = sim_now_ns();
+
+    if (hz == 0 || now < odr_since_ns + period_ns(hz)) {
+        if (!held_valid) return false;
+        memcpy(xyz, held, sizeof(held));
+        return true;
+    }
+    uint64_t period = period_ns(hz);
+    motion_at(now - (now - odr_since_ns) % period, xyz);
+    return true;
+}
+
+static bool fifo_enabled(void) {
+    return (registers[REG_FIFO_CTRL5] & FIFO_MODE_MASK) == FIFO_MODE_CONTINUOUS &&
+           odr_hz(registers[REG_FIFO_CTRL5] << 1) > 0 && odr_hz(registers[REG_CTRL1_XL]) > 0;
+}
+
+static void fifo_clear(void) {
+    fifo_head = fifo_count = 0;
+    fifo_pattern = 0;
+    fifo_overrun = false;
+}
+
+// Stores every sample converted since the last fill; a full FIFO drops its oldest sample
+static void fifo_fill(void) {
+    if (!fifo_enabled()) return;
+
+    uint64_t period = period_ns(odr_hz(registers[REG_FIFO_CTRL5] << 1));   // ODR_FIFO sits in bits 6:3
+    uint64_t now = sim_now_ns();
+    while (fifo_next_ns <= now) {
+        int16_t xyz[3];
+        motion_at(fifo_next_ns, xyz);
+        fifo_next_ns += period;
+
+        if (fifo_count + 3 > FIFO_WORDS) {
+            fifo_head = (uint16_t)((fifo_head + 3) % FIFO_WORDS);
+            fifo_count -= 3;
+            fifo_overrun = true;
+        }
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            fifo[(fifo_head + fifo_count) % FIFO_WORDS] = xyz[axis];
+            fifo_count++;
+        }
+    }
+}
+
+static int16_t fifo_pop(void) {
+    if (fifo_count == 0) return 0;
+    int16_t word = fifo[fifo_head];
+    fifo_head = (uint16_t)((fifo_head + 1) % FIFO_WORDS);
+    fifo_count--;
+    fifo_pattern = (uint8_t)((fifo_pattern + 1) % 3);
+    return word;
+}
+
+static bool pedometer_enabled(void) {
+    if (!(registers[REG_CTRL10_C] & CTRL10_FUNC_EN) || odr_hz(registers[REG_CTRL1_XL]) < 26) return false;
+    if (who_am_i == WHO_AM_I_LSM6DS3) {
+        return registers[REG_TAP_CFG] & TAP_CFG_PEDO_EN_DS3;
+    }
+    return registers[REG_CTRL10_C] & CTRL10_PEDO_EN_DSL;
+}
+
+// Brings the counter up to date, then starts or stops it to match the registers
+static void pedometer_update(void) {
+    uint32_t truth = step_truth ? step_truth(sim_now_ns()) : 0;
+    if (pedometer_running) pedometer_steps += truth - pedometer_mark;
+    pedometer_mark = truth;
+    pedometer_running = pedometer_enabled();
+}
+
+static uint8_t read_register(uint8_t reg) {
+    int16_t xyz[3];
+
+    switch (reg) {
+    case REG_WHO_AM_I:
+        return who_am_i;
+    case REG_FIFO_STATUS1:
+        fifo_fill();
+        return (uint8_t)fifo_count;
+    case REG_FIFO_STATUS2:
+        fifo_fill();
+        return (uint8_t)(((fifo_count >> 8) & 0x07) | (fifo_overrun ? FIFO_STATUS2_OVER : 0) |
+                         (fifo_count == 0 ? FIFO_STATUS2_EMPTY : 0));
+    case REG_FIFO_STATUS3:
+        return fifo_pattern;
+    case REG_FIFO_STATUS4:
+        return 0;
+    case REG_STEP_COUNTER_L:
+        pedometer_update();
+        return (uint8_t)pedometer_steps;
+    case REG_STEP_COUNTER_H:
+        pedometer_update();
+        return (uint8_t)(pedometer_steps >> 8);
+    default:
+        break;
+    }
+
+    if (reg >= REG_OUTX_L_XL && reg <= REG_OUTZ_H_XL) {
+        if (!latest_conversion(xyz)) return 0;
+        int16_t value = xyz[(reg - REG_OUTX_L_XL) / 2];
+        return (uint8_t)(((reg - REG_OUTX_L_XL) & 1) ? (uint16_t)value >> 8 : (uint16_t)value & 0xFF);
+    }
+    return registers[reg & 0x7F];
+}
+
+static void write_register(uint8_t reg, uint8_t value) {
+    pedometer_update();
+    fifo_fill();
+
+    reg &= 0x7F;
+    uint8_t previous = registers[reg];
+    registers[reg] = value;
+
+    if (reg == REG_CTRL1_XL && (previous & 0xF0) != (value & 0xF0)) {
+        registers[reg] = previous;
+        held_valid = latest_conversion(held);
+        registers[reg] = value;
+        odr_since_ns = sim_now_ns();
+    }
+    if (reg == REG_FIFO_CTRL5 || reg == REG_CTRL1_XL) {
+        if (!fifo_enabled()) {
+            fifo_clear();   // Bypass mode (or a stopped sensor) empties the FIFO
+        } else if ((previous & FIFO_MODE_MASK) != FIFO_MODE_CONTINUOUS || reg == REG_CTRL1_XL) {
+            fifo_next_ns = sim_now_ns() + period_ns(odr_hz(registers[REG_FIFO_CTRL5] << 1));
+        }
+    }
+    pedometer_update();
+}
+
+static void reset_registers(void) {
+    memset(registers, 0, sizeof(registers));
+    held_valid = false;
+    if (who_am_i == WHO_AM_I_LSM6DS3) {
+        registers[REG_CTRL10_C] = 0x38;   // Gyro axes enabled at reset on the LSM6DS3
+    }
+}
+
+// Charges the bus time; first waits out I2C_TIMEOUT_BUSY if a slave holds the bus
+static bool wire(uint32_t bytes) {
+    sim_sync();
+    if (sim_i2c1.ISR & I2C_ISR_BUSY) {
+        uint64_t start = sim_now_ns();
+        uint32_t tick = HAL_GetTick();
+        while (HAL_GetTick() - tick <= I2C_TIMEOUT_BUSY) {
+            sim_advance_ns(1000);
+        }
+        stats.busy_waits++;
+        stats.busy_wait_ns += sim_now_ns() - start;
+        return false;
+    }
+    stats.transfers++;
+    sim_advance_ns((uint64_t)bytes * BITS_PER_BYTE * 1000000000u / SIM_I2C_HZ);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Simulator API
+// -----------------------------------------------------------------------------
+
+void sim_imu_set_motion(sim_motion_fn fn) {
+    motion = fn;
+}
+
+void sim_imu_set_who_am_i(uint8_t value) {
+    who_am_i = value;
+    reset_registers();
+}
+
+void sim_imu_set_step_truth(sim_steps_fn steps) {
+    step_truth = steps;
+    pedometer_mark = steps ? steps(sim_now_ns()) : 0;
+}
+
+uint16_t sim_imu_pedometer_count(void) {
+    pedometer_update();
+    return (uint16_t)pedometer_steps;
+}
+
+void sim_i2c_hold_sda(uint16_t clocks) {
+    hold_clocks = clocks;
+    if (clocks > 0) sim_i2c1.ISR |= I2C_ISR_BUSY;   // SDA falling with SCL high reads as a START
+}
+
+SimI2cStats sim_i2c_stats(void) {
+    return stats;
+}
+
+bool sim_i2c_transfer(uint32_t bytes) {
+    return wire(bytes);
+}
+
+void sim_i2c_pins_to_gpio(uint16_t pins) {
+    pins_gpio = true;
+}
+
+void sim_i2c_gpio_write(uint16_t pins, bool high) {
+    if (!pins_gpio) return;
+    if (pins & I2C1_SDA_Pin) sda_high = high;
+    if (pins & I2C1_SCL_Pin) {
+        bool rising = high && !scl_high;
+        scl_high = high;
+        if (rising && sda_held() && hold_clocks != SIM_I2C_HOLD_FOREVER && --hold_clocks == 0) {
+            stats.recoveries++;
+        }
+    }
+}
+
+bool sim_i2c_gpio_read(uint16_t pin) {
+    if (pin & I2C1_SDA_Pin) return sda_high && !sda_held();
+    return scl_high;
+}
+
+// -----------------------------------------------------------------------------
+// HAL
+// -----------------------------------------------------------------------------
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c) {
+    sim_sync();
+    pins_gpio = false;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    if (sda_held()) {
+        sim_i2c1.ISR |= I2C_ISR_BUSY;
+    } else {
+        sim_i2c1.ISR &= ~I2C_ISR_BUSY;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c) {
+    sim_sync();
+    return HAL_OK;
+}
+
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c) {
+    return hi2c->ErrorCode;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size,
+                                   uint8_t *data, uint16_t size, uint32_t timeout) {
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    if (!wire((uint32_t)size + 3)) {
+        hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+        return HAL_ERROR;
+    }
+    if (address != LSM6DS_I2C_ADDRESS) {
+        hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+        return HAL_ERROR;
+    }
+
+    // The address auto-increments, except that FIFO_DATA_OUT rolls back from _H to _L
+    uint8_t at = (uint8_t)reg;
+    for (uint16_t i = 0; i < size; i++) {
+        if (at == REG_FIFO_DATA_OUT_L || at == REG_FIFO_DATA_OUT_H) {
+            static int16_t word;
+            fifo_fill();
+            if (at == REG_FIFO_DATA_OUT_L) {
+                word = (fifo_count > 0) ? fifo[fifo_head] : 0;
+                data[i] = (uint8_t)((uint16_t)word & 0xFF);
+                at = REG_FIFO_DATA_OUT_H;
+            } else {
+                data[i] = (uint8_t)((uint16_t)word >> 8);
+                fifo_pop();
+                at = REG_FIFO_DATA_OUT_L;
+            }
+            continue;
+        }
+        data[i] = read_register(at);
+        at = (uint8_t)((at + 1) & 0x7F);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size,
+                                    uint8_t *data, uint16_t size, uint32_t timeout) {
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    if (!wire((uint32_t)size + 2)) {
+        hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+        return HAL_ERROR;
+    }
+    if (address == SSD1306_I2C_ADDRESS) return HAL_OK;
+    if (address != LSM6DS_I2C_ADDRESS) {
+        hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+        return HAL_ERROR;
+    }
+
+    for (uint16_t i = 0; i < size; i++) {
+        if (reg + i != REG_WHO_AM_I) write_register((uint8_t)(reg + i), data[i]);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t address, uint32_t trials, uint32_t timeout) {
+    sim_sync();
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    if (sim_i2c1.ISR & I2C_ISR_BUSY) return HAL_BUSY;
+
+    wire(1);
+    if (address != LSM6DS_I2C_ADDRESS && address != SSD1306_I2C_ADDRESS) {
+        hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
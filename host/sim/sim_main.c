@@ -0,0 +1,330 @@
+/*
+ * sim_main.c
+ *
+ * Runs the firmware's app_main() on a virtual clock. The firmware runs on its
+ * own stack (a static array bounded by the _end/_estack symbols, so the stack
+ * monitor measures it), and the run ends when virtual time reaches the end of
+ * the script: sim_finish() then writes the reports and exits.
+ *
+ * Measurements come from wrapping monitor_task_begin/end (scheduler lateness
+ * and busy time per task) and distance_add_steps (when each step was
+ * counted), and from the display model's flush hook (when the step screen
+ * showed it). Each count is paired with the latest step of the scripted
+ * gait that has landed, if that step is unpaired and landed within
+ * MATCH_WINDOW_NS; steps passed over are missed, counts left without a step
+ * are false. Busy time is virtual: bus, UART and flash time, plus host CPU
+ * time times --cpu-scale if given.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "sim.h"
+#include "app.h"
+#include "monitor.h"
+#include "fsm.h"
+#include "step_detection.h"
+#include "i2c_bus.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+#define STACK_BYTES       (128 * 1024)
+#define DEFAULT_END_MS    60000u
+#define LATE_BUCKET_US    10           // Lateness histogram resolution
+#define LATE_BUCKETS      10000        // Up to 100 ms; later runs land in the last bucket
+#define MAX_STEPS         100000u
+#define MATCH_WINDOW_NS   (2000u * SIM_NS_PER_MS)
+
+typedef struct {
+    uint32_t runs;
+    uint64_t late_sum_us;
+    uint32_t late_max_us;
+    uint32_t late_histogram[LATE_BUCKETS];
+    uint64_t busy_sum_ns;
+    uint64_t busy_max_ns;
+    uint64_t started_ns;
+} TaskRecord;
+
+typedef struct {
+    uint32_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint32_t histogram[LATE_BUCKETS];   // 1 ms buckets
+} Latency;
+
+// The firmware's stack; the stack monitor paints it from sim_stack_bottom up to the stack pointer
+uint8_t sim_stack[STACK_BYTES] __attribute__((aligned(16)));
+__asm__(".globl sim_stack_bottom\n.set sim_stack_bottom, sim_stack\n"
+        ".globl sim_stack_top\n.set sim_stack_top, sim_stack + " "131072");
+_Static_assert(STACK_BYTES == 131072, "the asm above repeats STACK_BYTES");
+
+void __real_monitor_task_begin(monitor_task_t task, uint32_t late_us);
+void __real_monitor_task_end(monitor_task_t task);
+void __real_distance_add_steps(uint32_t steps);
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static ucontext_t host_context, firmware_context;
+static const char *out_dir = "sim_out";
+static const char *flash_path = NULL;
+static double cpu_scale = 0.0;
+static bool ground_truth = true;             // False when a recorded trace drives the IMU
+static struct timespec host_start;
+
+static TaskRecord tasks[NUM_MONITOR_TASKS];
+static uint64_t *count_times = NULL;         // When count n (index n - 1) happened
+static uint64_t *landed_times = NULL;        // When its step landed (UINT64_MAX for a false count)
+static uint32_t counted = 0, shown = 0;
+static uint32_t last_paired = 0;             // Latest scripted step paired with a count
+static uint32_t paired = 0, false_counts = 0;
+static Latency step_to_count, count_to_display, step_to_display;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+static void latency_add(Latency *latency, uint64_t ns) {
+    uint64_t bucket = ns / SIM_NS_PER_MS;
+    latency->count++;
+    latency->sum_ns += ns;
+    if (ns > latency->max_ns) latency->max_ns = ns;
+    latency->histogram[bucket < LATE_BUCKETS ? bucket : LATE_BUCKETS - 1]++;
+}
+
+// Smallest bucket below which 'share' of the entries fall
+static uint32_t percentile(const uint32_t *histogram, uint32_t count, double share) {
+    uint32_t wanted = (uint32_t)(count * share + 0.5), seen = 0;
+    for (uint32_t bucket = 0; bucket < LATE_BUCKETS; bucket++) {
+        seen += histogram[bucket];
+        if (seen >= wanted && seen > 0) return bucket;
+    }
+    return LATE_BUCKETS;
+}
+
+static void print_latency(FILE *out, const char *name, const Latency *latency) {
+    if (latency->count == 0) {
+        fprintf(out, "  %-18s no samples\n", name);
+        return;
+    }
+    fprintf(out, "  %-18s %6lu steps  mean %7.1f ms  p95 < %4lu ms  max %7.1f ms\n", name,
+            (unsigned long)latency->count, (double)latency->sum_ns / latency->count / 1e6,
+            (unsigned long)percentile(latency->histogram, latency->count, 0.95) + 1,
+            (double)latency->max_ns / 1e6);
+}
+
+static void write_report(FILE *out) {
+    double seconds = (double)sim_now_ns() / 1e9;
+    struct timespec host_end;
+    clock_gettime(CLOCK_MONOTONIC, &host_end);
+    double host_seconds = (double)(host_end.tv_sec - host_start.tv_sec) + (host_end.tv_nsec - host_start.tv_nsec) / 1e9;
+
+    fprintf(out, "Simulated %.3f s in %.2f s of host time (cpu scale %g)\n\n", seconds, host_seconds, cpu_scale);
+
+    fprintf(out, "Scheduler (lateness = start after the due tick; busy = virtual time in the task)\n");
+    fprintf(out, "  task    runs   late mean   p99 <    max    busy mean     max   load\n");
+    uint64_t busy_total = 0;
+    for (uint8_t task = 0; task < NUM_MONITOR_TASKS; task++) {
+        const TaskRecord *record = &tasks[task];
+        busy_total += record->busy_sum_ns;
+        if (record->runs == 0) {
+            fprintf(out, "  %-5s %6u\n", monitor_task_name(task), 0);
+            continue;
+        }
+        fprintf(out, "  %-5s %6lu %8.1f us %5lu us %6lu us %8.1f us %6.1f ms %5.1f%%\n",
+                monitor_task_name(task), (unsigned long)record->runs,
+                (double)record->late_sum_us / record->runs,
+                (unsigned long)(percentile(record->late_histogram, record->runs, 0.99) + 1) * LATE_BUCKET_US,
+                (unsigned long)record->late_max_us,
+                (double)record->busy_sum_ns / record->runs / 1e3, (double)record->busy_max_ns / 1e6,
+                seconds > 0 ? (double)record->busy_sum_ns / 1e7 / seconds : 0.0);
+    }
+    fprintf(out, "  total load %.1f%%\n", seconds > 0 ? (double)busy_total / 1e7 / seconds : 0.0);
+
+    MonitorStats monitor = monitor_get_stats();
+    fprintf(out, "  firmware monitor: load %u.%u%%, peak %u.%u%%, stack %lu of %lu bytes (host frames)\n\n",
+            monitor.load_permille / 10, monitor.load_permille % 10,
+            monitor.peak_load_permille / 10, monitor.peak_load_permille % 10,
+            (unsigned long)monitor.stack_used, (unsigned long)monitor.stack_size);
+
+    fprintf(out, "Steps\n");
+    uint32_t walked = sim_walk_steps(sim_now_ns());
+    if (!ground_truth) {
+        fprintf(out, "  counted %lu, shown %lu (a recorded trace has no ground truth)\n",
+                (unsigned long)get_steps(), (unsigned long)shown);
+    } else {
+        fprintf(out, "  walked %lu, counted %lu (%lu missed, %lu false), shown %lu, IMU pedometer %u\n",
+                (unsigned long)walked, (unsigned long)get_steps(), (unsigned long)(walked - paired),
+                (unsigned long)false_counts, (unsigned long)shown, sim_imu_pedometer_count());
+    }
+    print_latency(out, "step -> count", &step_to_count);
+    print_latency(out, "count -> display", &count_to_display);
+    print_latency(out, "step -> display", &step_to_display);
+
+    SimI2cStats bus = sim_i2c_stats();
+    fprintf(out, "\nI2C\n  %lu transfers, %lu waits on a busy bus (%.1f ms), %lu releases by clocking SCL\n",
+            (unsigned long)bus.transfers, (unsigned long)bus.busy_waits, (double)bus.busy_wait_ns / 1e6,
+            (unsigned long)bus.recoveries);
+    for (uint8_t device = 0; device < NUM_I2C_DEVICES; device++) {
+        I2cDeviceStats stats = i2c_bus_get_stats(device);
+        fprintf(out, "  %-8s transactions %lu, errors %lu, retries %lu, timeouts %lu, skipped %lu, worst %lu us\n",
+                i2c_bus_device_name(device), (unsigned long)stats.transactions, (unsigned long)stats.errors,
+                (unsigned long)stats.retries, (unsigned long)stats.timeouts, (unsigned long)stats.skipped,
+                (unsigned long)stats.worst_us);
+    }
+    fprintf(out, "  bus recoveries run by the firmware: %lu\n", (unsigned long)i2c_bus_recoveries());
+    fprintf(out, "\nDisplay: %lu flushes\n", (unsigned long)sim_display_flushes());
+    fprintf(out, "UART: %lu receive overruns\n", (unsigned long)sim_uart_overruns());
+}
+
+// Every step the step screen shows for the first time: how long since it was counted, and since it landed
+static void on_flush(uint64_t now_ns) {
+    if (fsm_get_current_state() != DISPLAY_STEPS) return;
+
+    uint32_t steps = get_steps();
+    for (uint32_t n = shown + 1; n <= steps && n <= counted; n++) {
+        latency_add(&count_to_display, now_ns - count_times[n - 1]);
+        if (landed_times[n - 1] != UINT64_MAX) latency_add(&step_to_display, now_ns - landed_times[n - 1]);
+    }
+    if (steps > shown) shown = steps;
+}
+
+static void run_firmware(void) {
+    app_main();
+}
+
+static void usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [--script FILE] [--imu TRACE.csv] [--out DIR] [--end MS] [--cpu-scale X]\n"
+            "          [--flash IMAGE] [--who-am-i 0x69|0x6A]\n", program);
+    exit(2);
+}
+
+// -----------------------------------------------------------------------------
+// Instrumentation (linked with --wrap)
+// -----------------------------------------------------------------------------
+
+void __wrap_monitor_task_begin(monitor_task_t task, uint32_t late_us) {
+    if (task < NUM_MONITOR_TASKS) {
+        TaskRecord *record = &tasks[task];
+        uint32_t bucket = late_us / LATE_BUCKET_US;
+        record->runs++;
+        record->late_sum_us += late_us;
+        if (late_us > record->late_max_us) record->late_max_us = late_us;
+        record->late_histogram[bucket < LATE_BUCKETS ? bucket : LATE_BUCKETS - 1]++;
+        record->started_ns = sim_now_ns();
+    }
+    __real_monitor_task_begin(task, late_us);
+}
+
+void __wrap_monitor_task_end(monitor_task_t task) {
+    __real_monitor_task_end(task);
+    sim_sync();   // Charge the task's own code before reading the clock
+    if (task < NUM_MONITOR_TASKS) {
+        TaskRecord *record = &tasks[task];
+        uint64_t busy = sim_now_ns() - record->started_ns;
+        record->busy_sum_ns += busy;
+        if (busy > record->busy_max_ns) record->busy_max_ns = busy;
+    }
+}
+
+// Called with the step count already raised
+void __wrap_distance_add_steps(uint32_t steps) {
+    __real_distance_add_steps(steps);
+
+    uint64_t now = sim_now_ns();
+    uint32_t total = get_steps();
+    for (uint32_t n = counted + 1; n <= total && n <= MAX_STEPS; n++) {
+        uint32_t latest = sim_walk_steps(now);
+        uint64_t landed = sim_walk_step_time_ns(latest);
+
+        count_times[n - 1] = now;
+        landed_times[n - 1] = UINT64_MAX;
+        if (latest > last_paired && landed != UINT64_MAX && now - landed <= MATCH_WINDOW_NS) {
+            landed_times[n - 1] = landed;
+            latency_add(&step_to_count, now - landed);
+            last_paired = latest;
+            paired++;
+        } else {
+            false_counts++;
+        }
+    }
+    if (total > counted) counted = (total < MAX_STEPS) ? total : MAX_STEPS;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+uint32_t __get_MSP(void) {
+    return (uint32_t)(uintptr_t)__builtin_frame_address(0);
+}
+
+void sim_finish(void) {
+    static bool finishing = false;
+    if (finishing) return;
+    finishing = true;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/report.txt", out_dir);
+    FILE *report = fopen(path, "w");
+    if (report) {
+        write_report(report);
+        fclose(report);
+    }
+    write_report(stdout);
+
+    if (flash_path) sim_flash_save(flash_path);
+    sim_outputs_close();
+    exit(0);
+}
+
+int main(int argc, char **argv) {
+    const char *script = NULL, *trace = NULL;
+    long end_ms = -1;
+    int who_am_i = -1;
+
+    for (int i = 1; i < argc; i++) {
+        const char *option = argv[i];
+        if (i + 1 >= argc) usage(argv[0]);
+        const char *value = argv[++i];
+
+        if (strcmp(option, "--script") == 0) script = value;
+        else if (strcmp(option, "--imu") == 0) trace = value;
+        else if (strcmp(option, "--out") == 0) out_dir = value;
+        else if (strcmp(option, "--end") == 0) end_ms = strtol(value, NULL, 0);
+        else if (strcmp(option, "--cpu-scale") == 0) cpu_scale = strtod(value, NULL);
+        else if (strcmp(option, "--flash") == 0) flash_path = value;
+        else if (strcmp(option, "--who-am-i") == 0) who_am_i = (int)strtol(value, NULL, 0);
+        else usage(argv[0]);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &host_start);
+    count_times = calloc(MAX_STEPS, sizeof(*count_times));
+    landed_times = calloc(MAX_STEPS, sizeof(*landed_times));
+    sim_set_end_ms(DEFAULT_END_MS);
+    if (script && !sim_script_load(script)) return 1;
+    if (trace && !sim_trace_load(trace)) return 1;
+    ground_truth = (trace == NULL);
+    if (end_ms >= 0) sim_set_end_ms((uint32_t)end_ms);
+    if (who_am_i >= 0) sim_imu_set_who_am_i((uint8_t)who_am_i);
+
+    if (flash_path) sim_flash_load(flash_path); else sim_flash_erase_all();
+    sim_outputs_open(out_dir);
+    sim_script_install();
+    sim_display_on_flush(on_flush);
+    sim_set_cpu_scale(cpu_scale);
+
+    getcontext(&firmware_context);
+    firmware_context.uc_stack.ss_sp = sim_stack;
+    firmware_context.uc_stack.ss_size = sizeof(sim_stack);
+    firmware_context.uc_link = &host_context;
+    makecontext(&firmware_context, run_firmware, 0);
+    swapcontext(&host_context, &firmware_context);
+
+    return 1;   // app_main() never returns
+}
@@ -0,0 +1,475 @@
+/*
+ * sim_periph.c
+ *
+ * Buttons, joystick ADC and click pin, UART, RGB LEDs, TIM16 (buzzer) and
+ * TIM2 (DS3 PWM). Inputs come from the script; outputs go to the UART log and
+ * the LED/buzzer timeline. TIM16 models ARR/CCR preload and raises its update
+ * interrupt on the virtual clock, so melodies play through the firmware's
+ * own interrupt handler.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "sim.h"
+#include "main.h"
+#include "adc.h"
+#include "tim.h"
+#include "usart.h"
+#include "i2c.h"
+#include "buttons.h"
+#include "rgb.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define UART_RX_QUEUE  256
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+GPIO_TypeDef sim_gpioa, sim_gpiob;
+TIM_TypeDef sim_tim16, sim_tim2;
+TIM_HandleTypeDef htim16 = { .Instance = TIM16 };
+TIM_HandleTypeDef htim2 = { .Instance = TIM2 };
+UART_HandleTypeDef huart2;
+ADC_HandleTypeDef hadc1;
+
+static bool power_on_flag = true;
+
+// Buttons: level from the script, and an edge latched until the firmware reads it
+static bool button_level[NUM_BUTTONS];
+static bool button_seen[NUM_BUTTONS];
+static bool button_edge[NUM_BUTTONS];
+static bool click_level = false;
+
+// Potentiometer, Y, X (joystick at rest)
+static uint16_t adc_values[3] = { 2000, 2265, 2185 };
+
+// UART receiver: characters in flight with their arrival times, and the one-byte RDR.
+// A character arriving while the RDR is full sets ORE, and nothing more is received
+// until the firmware clears it, as on the USART.
+static char rx_queue[UART_RX_QUEUE];
+static uint64_t rx_arrival_ns[UART_RX_QUEUE];
+static uint16_t rx_head = 0, rx_tail = 0;
+static uint64_t rx_last_arrival_ns = 0;
+static uint8_t rx_rdr;
+static bool rx_rdr_full = false;
+static bool rx_overrun = false;
+static uint32_t rx_overruns = 0;
+static bool tx_line_start = true;
+
+// TIM16 output stage: registers in use since the last update event
+static uint32_t tim16_arr = 0, tim16_ccr = 0;
+static uint64_t tim16_next_ns = UINT64_MAX;
+static uint32_t logged_hz = 0, logged_duty = 0;
+static bool logged_sounding = false;
+
+static FILE *timeline_file = NULL;
+static FILE *display_file = NULL;
+static FILE *uart_file = NULL;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+static void timeline(const char *source, const char *event, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#include <stdarg.h>
+static void timeline(const char *source, const char *event, const char *fmt, ...) {
+    if (!timeline_file) return;
+
+    fprintf(timeline_file, "%llu,%s,%s", (unsigned long long)(sim_now_ns() / 1000), source, event);
+    if (fmt) {
+        va_list args;
+        va_start(args, fmt);
+        fputc(',', timeline_file);
+        vfprintf(timeline_file, fmt, args);
+        va_end(args);
+    }
+    fputc('\n', timeline_file);
+}
+
+static uint64_t tim16_period_ns(void) {
+    uint64_t counts = (uint64_t)(sim_tim16.PSC + 1) * (tim16_arr + 1);
+    return counts * 1000000000u / SIM_CORE_HZ;
+}
+
+static void tim16_load_shadows(void) {
+    tim16_arr = sim_tim16.ARR;
+    tim16_ccr = sim_tim16.CCR1;
+}
+
+// Logs the buzzer's tone whenever frequency, duty or on/off changes
+static void tim16_log_output(void) {
+    bool sounding = (sim_tim16.CR1 & TIM_CR1_CEN) && (sim_tim16.CCER & 1u) && tim16_ccr > 0;
+    uint32_t hz = sounding ? (uint32_t)(SIM_CORE_HZ / ((uint64_t)(sim_tim16.PSC + 1) * (tim16_arr + 1))) : 0;
+    uint32_t duty = sounding ? (uint32_t)((uint64_t)tim16_ccr * 1000 / (tim16_arr + 1)) : 0;
+
+    if (sounding == logged_sounding && hz == logged_hz && duty == logged_duty) return;
+    if (sounding) {
+        timeline("buzzer", "tone", "%lu,%lu", (unsigned long)hz, (unsigned long)duty);
+    } else {
+        timeline("buzzer", "off", NULL);
+    }
+    logged_sounding = sounding;
+    logged_hz = hz;
+    logged_duty = duty;
+}
+
+static uint8_t channel_index(uint32_t channel) {
+    return (uint8_t)(channel >> 2);
+}
+
+// -----------------------------------------------------------------------------
+// Outputs
+// -----------------------------------------------------------------------------
+
+static FILE* open_output(const char *dir, const char *name) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "sim: cannot write %s: %s\n", path, strerror(errno));
+    }
+    return file;
+}
+
+void sim_outputs_open(const char *dir) {
+    char path[512];
+
+    // mkdir -p
+    snprintf(path, sizeof(path), "%s", dir);
+    for (char *slash = strchr(path + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        mkdir(path, 0777);
+        *slash = '/';
+    }
+    mkdir(path, 0777);
+    timeline_file = open_output(dir, "timeline.csv");
+    display_file = open_output(dir, "display.txt");
+    uart_file = open_output(dir, "uart.log");
+    if (timeline_file) fprintf(timeline_file, "t_us,source,event,values\n");
+}
+
+void sim_outputs_close(void) {
+    if (timeline_file) fclose(timeline_file);
+    if (display_file) fclose(display_file);
+    if (uart_file) fclose(uart_file);
+    timeline_file = display_file = uart_file = NULL;
+}
+
+FILE* sim_timeline(void) {
+    return timeline_file;
+}
+
+FILE* sim_display_log(void) {
+    return display_file;
+}
+
+FILE* sim_uart_log(void) {
+    return uart_file;
+}
+
+// -----------------------------------------------------------------------------
+// Inputs
+// -----------------------------------------------------------------------------
+
+void sim_button_set(int button, bool pressed) {
+    if (button >= 0 && button < NUM_BUTTONS) button_level[button] = pressed;
+}
+
+void sim_click_set(bool pressed) {
+    click_level = pressed;
+}
+
+void sim_adc_set(uint8_t channel, uint16_t value) {
+    if (channel < 3) adc_values[channel] = value;
+}
+
+// Characters arrive back to back at SIM_UART_BAUD (8N1)
+void sim_uart_rx(const char *bytes) {
+    uint64_t arrival = (rx_last_arrival_ns > sim_now_ns()) ? rx_last_arrival_ns : sim_now_ns();
+    for (; *bytes; bytes++) {
+        uint16_t next = (uint16_t)((rx_head + 1) % UART_RX_QUEUE);
+        if (next == rx_tail) break;
+        arrival += 10u * 1000000000u / SIM_UART_BAUD;
+        rx_queue[rx_head] = *bytes;
+        rx_arrival_ns[rx_head] = arrival;
+        rx_head = next;
+    }
+    rx_last_arrival_ns = arrival;
+}
+
+uint32_t sim_uart_overruns(void) {
+    return rx_overruns;
+}
+
+// -----------------------------------------------------------------------------
+// RCC and reset
+// -----------------------------------------------------------------------------
+
+int sim_rcc_get_flag(int flag) {
+    return (flag == RCC_FLAG_PWRRST && power_on_flag) ? 1 : 0;
+}
+
+void sim_rcc_clear_flags(void) {
+    power_on_flag = false;
+}
+
+void NVIC_SystemReset(void) {
+    timeline("mcu", "reset", NULL);
+    sim_finish();
+}
+
+// -----------------------------------------------------------------------------
+// GPIO
+// -----------------------------------------------------------------------------
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init) {
+    sim_sync();
+    if (port == GPIOB && init->Mode == GPIO_MODE_OUTPUT_OD) {
+        port->od_mask |= init->Pin;
+        sim_i2c_pins_to_gpio((uint16_t)init->Pin);
+    }
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state) {
+    sim_sync();
+    if (state == GPIO_PIN_SET) {
+        port->ODR |= pin;
+    } else {
+        port->ODR &= ~(uint32_t)pin;
+    }
+    if (port == GPIOB && (pin & port->od_mask)) {
+        sim_i2c_gpio_write(pin & port->od_mask, state == GPIO_PIN_SET);
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin) {
+    sim_sync();
+    if (port == JOYSTICK_CLICK_GPIO_Port && pin == JOYSTICK_CLICK_Pin) {
+        return click_level ? GPIO_PIN_SET : GPIO_PIN_RESET;
+    }
+    if (port == GPIOB && (pin & port->od_mask)) {
+        return sim_i2c_gpio_read(pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+    }
+    return (port->ODR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+// -----------------------------------------------------------------------------
+// Buttons and RGB LEDs
+// -----------------------------------------------------------------------------
+
+void buttons_init(void) {
+    for (int i = 0; i < NUM_BUTTONS; i++) {
+        button_seen[i] = button_level[i];
+        button_edge[i] = false;
+    }
+}
+
+void buttons_update(void) {
+    sim_sync();
+    for (int i = 0; i < NUM_BUTTONS; i++) {
+        if (button_level[i] != button_seen[i]) {
+            button_seen[i] = button_level[i];
+            button_edge[i] = true;
+        }
+    }
+}
+
+butState_t buttons_checkButton(button_t button) {
+    if (button >= NUM_BUTTONS || !button_edge[button]) return NO_CHANGE;
+    button_edge[button] = false;
+    return button_seen[button] ? PUSHED : RELEASED;
+}
+
+static const char *const rgb_names[NUM_RGB_LEDS] = { "right", "down", "left" };
+
+void rgb_led_on(rgb_led_t led) {
+    sim_sync();
+    if (led < NUM_RGB_LEDS) timeline("rgb", rgb_names[led], "on");
+}
+
+void rgb_led_off(rgb_led_t led) {
+    sim_sync();
+    if (led < NUM_RGB_LEDS) timeline("rgb", rgb_names[led], "off");
+}
+
+void rgb_colour_all_on(void) {
+    for (rgb_led_t led = 0; led < NUM_RGB_LEDS; led++) {
+        rgb_led_on(led);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// ADC and UART
+// -----------------------------------------------------------------------------
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc) {
+    return HAL_OK;
+}
+
+// The DMA moves half-words; the conversion is taken as finished by the next read
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *data, uint32_t length) {
+    uint16_t *out = (uint16_t*)data;
+    sim_sync();
+    for (uint32_t i = 0; i < length && i < 3; i++) {
+        out[i] = adc_values[i];
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size, uint32_t timeout) {
+    sim_sync();
+    for (uint16_t i = 0; i < size; i++) {
+        if (uart_file) {
+            if (tx_line_start) {
+                fprintf(uart_file, "[%10.3f] ", (double)sim_now_ns() / SIM_NS_PER_MS);
+                tx_line_start = false;
+            }
+            if (data[i] != '\r') fputc(data[i], uart_file);
+        }
+        if (data[i] == '\n') tx_line_start = true;
+    }
+    sim_advance_ns((uint64_t)size * 10u * 1000000000u / SIM_UART_BAUD);  // 8N1
+    return HAL_OK;
+}
+
+// Moves the characters that have arrived by now into the RDR, or loses them to an overrun
+static void uart_receive_arrived(void) {
+    while (rx_tail != rx_head && rx_arrival_ns[rx_tail] <= sim_now_ns()) {
+        if (rx_overrun) {
+            // Reception is stopped until ORE is cleared
+        } else if (rx_rdr_full) {
+            rx_overrun = true;
+            rx_overruns++;
+            timeline("uart", "overrun", "lost '%c'", rx_queue[rx_tail]);
+        } else {
+            rx_rdr = (uint8_t)rx_queue[rx_tail];
+            rx_rdr_full = true;
+        }
+        rx_tail = (uint16_t)((rx_tail + 1) % UART_RX_QUEUE);
+    }
+}
+
+// Blocking receive as the HAL does it: with a zero timeout it gives up before it looks at ORE
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size, uint32_t timeout) {
+    sim_sync();
+    for (uint16_t i = 0; i < size; i++) {
+        uart_receive_arrived();
+        if (!rx_rdr_full) return HAL_TIMEOUT;
+        data[i] = rx_rdr;
+        rx_rdr_full = false;
+    }
+    return HAL_OK;
+}
+
+bool sim_uart_get_flag(UART_HandleTypeDef *huart, uint32_t flag) {
+    sim_sync();
+    uart_receive_arrived();
+    if (flag == UART_FLAG_ORE) return rx_overrun;
+    if (flag == UART_FLAG_RXNE) return rx_rdr_full;
+    return false;
+}
+
+void sim_uart_clear_flag(UART_HandleTypeDef *huart, uint32_t flag) {
+    if (flag & UART_CLEAR_OREF) rx_overrun = false;
+}
+
+// -----------------------------------------------------------------------------
+// Timers
+// -----------------------------------------------------------------------------
+
+uint64_t sim_tim16_next_update_ns(void) {
+    return (sim_tim16.CR1 & TIM_CR1_CEN) ? tim16_next_ns : UINT64_MAX;
+}
+
+void sim_tim16_update(void) {
+    if (sim_tim16.CR1 & TIM_CR1_ARPE) tim16_load_shadows();
+    sim_tim16.SR |= TIM_SR_UIF;
+    tim16_next_ns += tim16_period_ns();
+    tim16_log_output();
+}
+
+bool sim_tim16_irq_pending(void) {
+    return (sim_tim16.SR & TIM_SR_UIF) && (sim_tim16.DIER & TIM_DIER_UIE);
+}
+
+void sim_tim16_irq(void) {
+    sim_tim16.SR &= ~TIM_SR_UIF;
+    HAL_TIM_PeriodElapsedCallback(&htim16);
+    if (!(sim_tim16.CR1 & TIM_CR1_ARPE)) tim16_load_shadows();
+    tim16_log_output();
+}
+
+HAL_StatusTypeDef HAL_TIM_GenerateEvent(TIM_HandleTypeDef *htim, uint32_t source) {
+    sim_sync();
+    if (htim->Instance == TIM16 && (source & TIM_EVENTSOURCE_UPDATE)) {
+        tim16_load_shadows();
+        sim_tim16.CNT = 0;
+        sim_tim16.SR |= TIM_SR_UIF;
+        tim16_next_ns = sim_now_ns() + tim16_period_ns();
+        tim16_log_output();
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t channel) {
+    sim_sync();
+    TIM_TypeDef *tim = htim->Instance;
+    bool was_counting = tim->CR1 & TIM_CR1_CEN;
+
+    tim->CCER |= 1u << (channel_index(channel) * 4);
+    tim->CR1 |= TIM_CR1_CEN;
+
+    if (tim == TIM16) {
+        if (!(tim->CR1 & TIM_CR1_ARPE)) tim16_load_shadows();
+        if (!was_counting) tim16_next_ns = sim_now_ns() + tim16_period_ns();
+        tim16_log_output();
+    } else if (tim == TIM2 && channel == TIM_CHANNEL_3) {
+        timeline("ds3", "duty", "%lu", (unsigned long)(tim->CCR3 * 1000 / (tim->ARR + 1)));
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t channel) {
+    sim_sync();
+    TIM_TypeDef *tim = htim->Instance;
+
+    tim->CCER &= ~(1u << (channel_index(channel) * 4));
+    if ((tim->CCER & 0x1111u) == 0) tim->CR1 &= ~TIM_CR1_CEN;
+    if (tim == TIM16) tim16_log_output();
+    return HAL_OK;
+}
+
+// DS3's waveform: one compare value per PWM cycle, repeated (circular DMA of half-words)
+HAL_StatusTypeDef HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef *htim, uint32_t channel, const uint32_t *data, uint16_t length) {
+    sim_sync();
+    TIM_TypeDef *tim = htim->Instance;
+    const uint16_t *frames = (const uint16_t*)data;
+    uint32_t low = UINT32_MAX, high = 0;
+    uint64_t sum = 0;
+
+    tim->CCER |= 1u << (channel_index(channel) * 4);
+    tim->CR1 |= TIM_CR1_CEN;
+    for (uint16_t i = 0; i < length; i++) {
+        if (frames[i] < low) low = frames[i];
+        if (frames[i] > high) high = frames[i];
+        sum += frames[i];
+    }
+
+    uint32_t period = tim->ARR + 1;
+    uint64_t cycle_us = (uint64_t)length * (tim->PSC + 1) * period * 1000000u / SIM_CORE_HZ;
+    timeline("ds3", "wave", "%u,%lu,%lu,%lu,%llu", length,
+             (unsigned long)(low * 1000 / period), (unsigned long)(high * 1000 / period),
+             (unsigned long)(length ? sum * 1000 / period / length : 0), (unsigned long long)cycle_us);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t channel) {
+    return HAL_TIM_PWM_Stop(htim, channel);
+}
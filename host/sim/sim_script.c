@@ -0,0 +1,360 @@
+/*
+ * sim_script.c
+ *
+ * Scripted inputs and the IMU's motion source. A script is a list of timed
+ * events, one per line ("<t_ms> <command> [args]", '#' starts a comment):
+ *
+ *   press|release|click UP|DOWN|LEFT|RIGHT   (click = press, release 100 ms later)
+ *   jclick 0|1           joystick button
+ *   joy <x> <y>          joystick ADC counts (rest is 2185 2265)
+ *   pot <counts>         potentiometer ADC counts
+ *   uart <text>          characters arriving on the UART (\r, \n escapes)
+ *   walk <spm> <amp_mg> <noise_mg>   gait from this time on
+ *   still [noise_mg]     stand still from this time on
+ *   i2c_hold <clocks>|forever        a slave holds SDA until clocked
+ *   snapshot             append the displayed frame to display.txt
+ *   end                  stop the run
+ *
+ * The gait is a vertical bounce on top of gravity, sin(2*pi*phase) plus a
+ * 0.3 second harmonic, with the phase advancing continuously at the cadence
+ * so changes of pace do not jump. A step lands each time the phase passes a
+ * whole number (the foot strike, where the bounce starts to rise); that is
+ * the ground truth for the pedometer model and the latency report. A recorded trace can replace the
+ * gait; it has no ground truth.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "sim.h"
+#include "buttons.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_EVENTS     1024
+#define MAX_SEGMENTS    256
+#define LINE_LENGTH     256
+#define CLICK_MS        100
+#define RAW_PER_G     16384
+#define NOISE_QUANTUM_NS  100000u
+
+typedef enum {
+    EVENT_BUTTON = 0,
+    EVENT_JCLICK,
+    EVENT_ADC,
+    EVENT_UART,
+    EVENT_I2C_HOLD,
+    EVENT_SNAPSHOT
+} event_type_t;
+
+typedef struct {
+    uint64_t t_ns;
+    event_type_t type;
+    int32_t a, b;
+    char *text;
+} Event;
+
+typedef struct {
+    uint64_t t_ns;
+    double phase;        // Phase at t_ns
+    double cadence_spm;
+    double amplitude;    // Raw counts
+    double noise;        // Raw counts, peak
+} Segment;
+
+typedef struct {
+    uint32_t t_ms;
+    int16_t xyz[3];
+} TraceRow;
+
+// -----------------------------------------------------------------------------
+// State
+// -----------------------------------------------------------------------------
+
+static Event events[MAX_EVENTS];
+static uint16_t event_count = 0, next_event = 0;
+
+static Segment segments[MAX_SEGMENTS] = { { 0, 0.0, 0.0, 0.0, 0.0 } };
+static uint16_t segment_count = 1;
+
+static TraceRow *trace = NULL;
+static size_t trace_rows = 0;
+
+// -----------------------------------------------------------------------------
+// Internal Utility Functions
+// -----------------------------------------------------------------------------
+
+static double phase_at(const Segment *segment, uint64_t t_ns) {
+    return segment->phase + (double)(t_ns - segment->t_ns) * 1e-9 * segment->cadence_spm / 60.0;
+}
+
+static const Segment* segment_at(uint64_t t_ns) {
+    uint16_t i = segment_count;
+    while (i > 1 && segments[i - 1].t_ns > t_ns) i--;
+    return &segments[i - 1];
+}
+
+// Starts a new gait segment; segments must be added in time order
+static bool add_segment(uint64_t t_ns, double spm, double amplitude_mg, double noise_mg) {
+    if (segment_count == MAX_SEGMENTS) return false;
+    const Segment *last = &segments[segment_count - 1];
+    if (t_ns < last->t_ns) return false;
+
+    segments[segment_count++] = (Segment){
+        .t_ns = t_ns,
+        .phase = phase_at(last, t_ns),
+        .cadence_spm = spm,
+        .amplitude = amplitude_mg * RAW_PER_G / 1000.0,
+        .noise = noise_mg * RAW_PER_G / 1000.0,
+    };
+    return true;
+}
+
+// Deterministic noise in [-1, 1] for a time and axis (splitmix64)
+static double noise_at(uint64_t t_ns, uint8_t axis) {
+    uint64_t z = t_ns / NOISE_QUANTUM_NS * 4 + axis + 0x9E3779B97F4A7C15u;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+    z ^= z >> 31;
+    return (double)(z >> 11) / (double)(1ull << 52) - 1.0;
+}
+
+static int16_t saturate(double value) {
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return (int16_t)lrint(value);
+}
+
+static void gait_motion(uint64_t t_ns, int16_t xyz[3]) {
+    const Segment *segment = segment_at(t_ns);
+    double phase = phase_at(segment, t_ns);
+    double bounce = segment->amplitude * (sin(2.0 * M_PI * phase) + 0.3 * sin(4.0 * M_PI * phase));
+
+    xyz[0] = saturate(segment->noise * noise_at(t_ns, 0));
+    xyz[1] = saturate(segment->noise * noise_at(t_ns, 1));
+    xyz[2] = saturate(RAW_PER_G + bounce + segment->noise * noise_at(t_ns, 2));
+}
+
+static void trace_motion(uint64_t t_ns, int16_t xyz[3]) {
+    uint32_t t_ms = (uint32_t)(t_ns / SIM_NS_PER_MS);
+    size_t low = 0, high = trace_rows;
+
+    // Last row at or before t (the first row before the trace starts)
+    while (high - low > 1) {
+        size_t mid = (low + high) / 2;
+        if (trace[mid].t_ms <= t_ms) low = mid; else high = mid;
+    }
+    memcpy(xyz, trace[low].xyz, sizeof(trace[low].xyz));
+}
+
+static int button_named(const char *name) {
+    static const char *const names[NUM_BUTTONS] = { "UP", "DOWN", "LEFT", "RIGHT" };
+    for (int i = 0; i < NUM_BUTTONS; i++) {
+        if (strcmp(name, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static char* unescape(const char *text) {
+    char *out = malloc(strlen(text) + 1);
+    char *o = out;
+    for (const char *p = text; *p; p++) {
+        if (*p == '\\' && p[1]) {
+            p++;
+            *o++ = (*p == 'r') ? '\r' : (*p == 'n') ? '\n' : *p;
+        } else {
+            *o++ = *p;
+        }
+    }
+    *o = '\0';
+    return out;
+}
+
+static bool add_event(uint64_t t_ns, event_type_t type, int32_t a, int32_t b, char *text) {
+    if (event_count == MAX_EVENTS) return false;
+    events[event_count++] = (Event){ t_ns, type, a, b, text };
+    return true;
+}
+
+static int compare_events(const void *x, const void *y) {
+    const Event *a = x, *b = y;
+    if (a->t_ns != b->t_ns) return (a->t_ns < b->t_ns) ? -1 : 1;
+    return (a < b) ? -1 : 1;   // qsort is not stable; keep file order within a millisecond
+}
+
+static bool parse_line(char *line) {
+    char command[32], argument[LINE_LENGTH];
+    double t_ms, x = 0, y = 0, z = 0;
+    int consumed = 0;
+
+    char *comment = strchr(line, '#');
+    if (comment) *comment = '\0';
+    if (sscanf(line, " %lf %31s %n", &t_ms, command, &consumed) < 2) {
+        return sscanf(line, " %31s", command) < 1;   // Blank lines are fine
+    }
+    uint64_t t_ns = (uint64_t)(t_ms * SIM_NS_PER_MS);
+    char *rest = line + consumed;
+    rest[strcspn(rest, "\r\n")] = '\0';
+
+    if (strcmp(command, "press") == 0 || strcmp(command, "release") == 0 || strcmp(command, "click") == 0) {
+        int button = (sscanf(rest, "%31s", argument) == 1) ? button_named(argument) : -1;
+        if (button < 0) return false;
+        if (command[0] == 'c') {
+            return add_event(t_ns, EVENT_BUTTON, button, 1, NULL) &&
+                   add_event(t_ns + CLICK_MS * SIM_NS_PER_MS, EVENT_BUTTON, button, 0, NULL);
+        }
+        return add_event(t_ns, EVENT_BUTTON, button, command[0] == 'p', NULL);
+    }
+    if (strcmp(command, "jclick") == 0 && sscanf(rest, "%lf", &x) == 1) {
+        return add_event(t_ns, EVENT_JCLICK, x != 0, 0, NULL);
+    }
+    if (strcmp(command, "joy") == 0 && sscanf(rest, "%lf %lf", &x, &y) == 2) {
+        return add_event(t_ns, EVENT_ADC, 2, (int32_t)x, NULL) && add_event(t_ns, EVENT_ADC, 1, (int32_t)y, NULL);
+    }
+    if (strcmp(command, "pot") == 0 && sscanf(rest, "%lf", &x) == 1) {
+        return add_event(t_ns, EVENT_ADC, 0, (int32_t)x, NULL);
+    }
+    if (strcmp(command, "uart") == 0) {
+        return add_event(t_ns, EVENT_UART, 0, 0, unescape(rest));
+    }
+    if (strcmp(command, "walk") == 0 && sscanf(rest, "%lf %lf %lf", &x, &y, &z) == 3) {
+        return add_segment(t_ns, x, y, z);
+    }
+    if (strcmp(command, "still") == 0) {
+        sscanf(rest, "%lf", &z);
+        return add_segment(t_ns, 0.0, 0.0, z);
+    }
+    if (strcmp(command, "i2c_hold") == 0 && sscanf(rest, "%31s", argument) == 1) {
+        int32_t clocks = (strcmp(argument, "forever") == 0) ? SIM_I2C_HOLD_FOREVER : atoi(argument);
+        return add_event(t_ns, EVENT_I2C_HOLD, clocks, 0, NULL);
+    }
+    if (strcmp(command, "snapshot") == 0) {
+        return add_event(t_ns, EVENT_SNAPSHOT, 0, 0, NULL);
+    }
+    if (strcmp(command, "end") == 0) {
+        sim_set_end_ms((uint32_t)t_ms);
+        return true;
+    }
+    return false;
+}
+
+static uint64_t next_event_time(void) {
+    return (next_event < event_count) ? events[next_event].t_ns : UINT64_MAX;
+}
+
+static void fire_events(uint64_t now_ns) {
+    while (next_event < event_count && events[next_event].t_ns <= now_ns) {
+        const Event *event = &events[next_event++];
+        switch (event->type) {
+        case EVENT_BUTTON:
+            sim_button_set(event->a, event->b != 0);
+            break;
+        case EVENT_JCLICK:
+            sim_click_set(event->a != 0);
+            break;
+        case EVENT_ADC:
+            sim_adc_set((uint8_t)event->a, (uint16_t)event->b);
+            break;
+        case EVENT_UART:
+            sim_uart_rx(event->text);
+            break;
+        case EVENT_I2C_HOLD:
+            sim_i2c_hold_sda((uint16_t)event->a);
+            break;
+        case EVENT_SNAPSHOT:
+            if (sim_display_log()) fprintf(sim_display_log(), "snapshot: ");
+            sim_display_write_snapshot(sim_display_log());
+            break;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Simulator API
+// -----------------------------------------------------------------------------
+
+bool sim_script_load(const char *path) {
+    char line[LINE_LENGTH];
+    unsigned number = 0;
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "sim: cannot open script %s\n", path);
+        return false;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        number++;
+        if (!parse_line(line)) {
+            fprintf(stderr, "sim: %s:%u: cannot parse this line\n", path, number);
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+    qsort(events, event_count, sizeof(events[0]), compare_events);
+    return true;
+}
+
+bool sim_trace_load(const char *path) {
+    char line[LINE_LENGTH];
+    size_t capacity = 0;
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "sim: cannot open trace %s\n", path);
+        return false;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        TraceRow row;
+        int x, y, z;
+        if (line[0] == '#' || sscanf(line, "%u,%d,%d,%d", &row.t_ms, &x, &y, &z) != 4) continue;
+        row.xyz[0] = (int16_t)x;
+        row.xyz[1] = (int16_t)y;
+        row.xyz[2] = (int16_t)z;
+        if (trace_rows == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            trace = realloc(trace, capacity * sizeof(*trace));
+        }
+        trace[trace_rows++] = row;
+    }
+    fclose(file);
+    if (trace_rows == 0) {
+        fprintf(stderr, "sim: no samples in trace %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+void sim_script_install(void) {
+    sim_set_event_source(next_event_time, fire_events);
+    if (trace_rows > 0) {
+        sim_imu_set_motion(trace_motion);
+        sim_imu_set_step_truth(NULL);
+    } else {
+        sim_imu_set_motion(gait_motion);
+        sim_imu_set_step_truth(sim_walk_steps);
+    }
+}
+
+uint32_t sim_walk_steps(uint64_t t_ns) {
+    if (trace_rows > 0) return 0;
+    double phase = phase_at(segment_at(t_ns), t_ns);
+    return (uint32_t)ceil(phase);
+}
+
+uint64_t sim_walk_step_time_ns(uint32_t n) {
+    if (trace_rows > 0 || n == 0) return UINT64_MAX;
+    double target = (double)(n - 1);
+
+    for (uint16_t i = 0; i < segment_count; i++) {
+        const Segment *segment = &segments[i];
+        bool last = (i + 1 == segment_count);
+        double end_phase = last ? INFINITY : segments[i + 1].phase;
+        if (segment->cadence_spm > 0.0 && target >= segment->phase && target < end_phase) {
+            return segment->t_ns + (uint64_t)((target - segment->phase) * 60.0 / segment->cadence_spm * 1e9);
+        }
+    }
+    return UINT64_MAX;
+}
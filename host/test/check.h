@@ -0,0 +1,37 @@
+/*
+ * check.h
+ *
+ * Minimal assertions for the host tests: each failed CHECK prints its location
+ * and the test exits non-zero at the end.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <stdio.h>
+
+static unsigned check_failures;
+
+#define CHECK(COND, ...) do { \
+        if (!(COND)) { \
+            check_failures++; \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed: ", __FILE__, __LINE__, #COND); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+        } \
+    } while (0)
+
+// Prints the verdict and returns the process exit status
+static inline int check_report(const char *name) {
+    if (check_failures == 0) {
+        printf("%s: OK\n", name);
+        return 0;
+    }
+    printf("%s: %u FAILED\n", name, check_failures);
+    return 1;
+}
+
+#endif /* CHECK_H_ */
@@ -0,0 +1,90 @@
+/*
+ * test_cadence.c
+ *
+ * Host test of the Goertzel cadence bank (cadence.c) fed the way the firmware
+ * feeds it: each synthetic sample goes through the step core's gravity
+ * tracker, and its vertical dynamic acceleration from before the averaging
+ * window is pushed into the bank. A sweep of sinusoidal walks from 60 to 210
+ * steps/min at each profile's sampling rate must read back within a few
+ * steps/min, and standing still must read 0.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "check.h"
+#include "walk.h"
+#include "cadence.h"
+#include "timebase.h"
+
+#include <stdlib.h>
+
+#define WALK_SECONDS         13     // Three 4 s windows after a second for gravity to settle
+#define SWEEP_MIN_SPM        60
+#define SWEEP_MAX_SPM       210
+#define SWEEP_STEP_SPM        5
+#define TOLERANCE_SPM         4     // Bins are 6 steps/min apart
+#define AMPLITUDE          3300     // ~0.2 g bounce, a gentle walk
+#define NOISE               330
+
+static StepCoreSample samples[WALK_SECONDS * 60];
+
+uint32_t timebase_cycles(void) {
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+// Runs a fresh core and bank over a walk at rate_hz, as accelerometer.c feeds them, and returns
+// the final estimate
+static uint16_t estimate(uint16_t rate_hz, uint16_t cadence_spm, uint16_t amplitude) {
+    WalkSegment walk = { WALK_SECONDS * 1000, cadence_spm, amplitude, NOISE };
+    StepCore core;
+    uint32_t n = walk_generate(samples, sizeof(samples) / sizeof(samples[0]), rate_hz, 0, &walk, 1, cadence_spm, NULL);
+
+    step_core_init(&core);
+    step_core_configure_sampling(&core, rate_hz);
+    cadence_configure(rate_hz * 100u);
+
+    for (uint32_t i = 0; i < n; i++) {
+        step_core_track_gravity(&core, samples[i].x, samples[i].y, samples[i].z);
+        cadence_push(step_core_raw_vertical(&core, samples[i].x, samples[i].y, samples[i].z));
+        step_core_filter(&core, samples[i].x, samples[i].y, samples[i].z);
+    }
+    return cadence_get_spm();
+}
+
+// -----------------------------------------------------------------------------
+// Tests
+// -----------------------------------------------------------------------------
+
+// Every cadence the bank spans reads back at every profile rate
+static void test_sweep(void) {
+    static const uint16_t rates_hz[] = { 60, 50, 25 };     // The three profiles
+
+    for (uint8_t r = 0; r < sizeof(rates_hz) / sizeof(rates_hz[0]); r++) {
+        uint16_t worst = 0;
+        for (uint16_t spm = SWEEP_MIN_SPM; spm <= SWEEP_MAX_SPM; spm += SWEEP_STEP_SPM) {
+            uint16_t got = estimate(rates_hz[r], spm, AMPLITUDE);
+            uint16_t error = (uint16_t)abs((int)got - (int)spm);
+            if (error > worst) worst = error;
+            CHECK(error <= TOLERANCE_SPM, "%u Hz, %u steps/min: read %u", rates_hz[r], spm, got);
+        }
+        printf("cadence sweep at %u Hz: %u-%u steps/min, worst error %u\n", rates_hz[r],
+               SWEEP_MIN_SPM, SWEEP_MAX_SPM, worst);
+    }
+}
+
+// Noise alone has no rhythm to lock onto
+static void test_still(void) {
+    uint16_t got = estimate(60, 0, 0);
+    CHECK(got == 0, "still trace read %u steps/min", got);
+}
+
+int main(void) {
+    test_sweep();
+    test_still();
+    return check_report("test_cadence");
+}
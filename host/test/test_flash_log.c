@@ -0,0 +1,378 @@
+/*
+ * test_flash_log.c
+ *
+ * Power-loss test of flash_log.c on the simulator's flash model. A reference
+ * run saves records through several rounds of the page ring while the wearer
+ * alternates between walking and standing still. The run is then repeated
+ * once for every flash operation it makes, with power lost during that
+ * operation (a program leaves only its first word, an erase half the page).
+ * After each loss a fresh process boots from the torn image and checks that
+ * flash_log_init() restores the newest complete record, that no complete
+ * record was lost, and that the log keeps saving afterwards. The reference
+ * run also checks that no page erase starts while the wearer is walking.
+ * Completed history blocks are logged between the state records; every boot
+ * must restore exactly the blocks that are complete in flash and still fit
+ * the ring of minutes, oldest first. A last run makes every 7th double-word
+ * program fail and checks that each record is retried in the next free slot.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "check.h"
+#include "sim.h"
+#include "stm32c0xx_hal.h"
+#include "flash_log.h"
+#include "checksum.h"
+#include "step_detection.h"
+#include "goal_tracker.h"
+#include "distance.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define RUN_CALLS         30000   // Accelerometer task runs in the reference run (~8.5 min at 60 Hz)
+#define RESUME_CALLS       3000   // Runs after a reboot, to show the log still saves
+#define MS_PER_CALL          17
+#define PHASE_CALLS         600   // Walking for three phases, then still for one
+#define GOAL_CALLS           40   // The goal changes this often, so every change is a save
+#define STEP_CALLS           30
+#define BLOCK_CALLS         150   // A history block completes this often while walking
+#define FAIL_EVERY            7   // Program errors in the last run
+#define LOG_BASE          (FLASH_LOG_FIRST_PAGE * FLASH_PAGE_SIZE)
+#define LOG_RECORDS       (FLASH_LOG_PAGES * (FLASH_PAGE_SIZE / FLASH_LOG_RECORD_SIZE))
+
+typedef struct {
+    uint8_t image[FLASH_SIZE];
+    bool lost;
+    uint32_t call;                // Task run the power failed in
+    uint32_t programs;            // Double words programmed before the loss
+} LossReport;
+
+// -----------------------------------------------------------------------------
+// Device state the log saves (stubs of the modules flash_log.c reads)
+// -----------------------------------------------------------------------------
+
+static uint32_t call = 0;
+static uint32_t steps = 0;
+static uint16_t goal = 1000;
+static uint16_t stride_mm = 700;
+static bool restored = false;
+static uint32_t restored_steps = 0;
+
+static uint32_t blocks_completed = 0, blocks_taken = 0;
+static uint32_t restored_minutes[HISTORY_BLOCKS];
+static uint32_t restored_blocks = 0;
+static bool restored_bins_ok = true;
+
+static uint64_t now_ns = 0;
+static uint32_t erases = 0, programs = 0, erases_while_walking = 0;
+static LossReport *report;
+
+uint32_t get_steps(void) { return steps; }
+void set_step_count(uint32_t count) { steps = count; restored = true; restored_steps = count; }
+uint16_t get_goal(void) { return goal; }
+void set_goal(uint16_t new_goal) { goal = new_goal; }
+bool check_set_goal_state(void) { return false; }
+uint16_t distance_get_stride_mm(void) { return stride_mm; }
+void distance_set_stride_mm(uint16_t stride, uint32_t at_steps) { stride_mm = stride; (void)at_steps; }
+uint32_t HAL_GetTick(void) { return (uint32_t)(now_ns / SIM_NS_PER_MS); }
+
+// Block n starts at minute 15n and holds a pattern the restore can check
+static void block_bins(uint32_t first_minute, uint8_t bins[HISTORY_BLOCK_MINUTES]) {
+    for (uint8_t i = 0; i < HISTORY_BLOCK_MINUTES; i++) bins[i] = (uint8_t)(first_minute * 7 + i);
+}
+
+bool step_history_next_completed_block(uint32_t *first_minute, uint8_t bins[HISTORY_BLOCK_MINUTES]) {
+    if (blocks_taken == blocks_completed) return false;
+    *first_minute = blocks_taken++ * HISTORY_BLOCK_MINUTES;
+    block_bins(*first_minute, bins);
+    return true;
+}
+
+void step_history_restore_block(uint32_t first_minute, const uint8_t bins[HISTORY_BLOCK_MINUTES]) {
+    uint8_t expected[HISTORY_BLOCK_MINUTES];
+    block_bins(first_minute, expected);
+    if (memcmp(bins, expected, sizeof(expected)) != 0) restored_bins_ok = false;
+    if (restored_blocks < HISTORY_BLOCKS) restored_minutes[restored_blocks] = first_minute;
+    restored_blocks++;
+}
+
+static bool walking(uint32_t at) {
+    return (at / PHASE_CALLS) % 4 != 3;
+}
+
+// The flash model charges its time here, which tells erases from programs
+void sim_sync(void) {
+}
+
+void sim_advance_ns(uint64_t ns) {
+    now_ns += ns;
+    if (ns == SIM_FLASH_ERASE_NS) {
+        erases++;
+        if (walking(call)) erases_while_walking++;
+    } else if (ns == SIM_FLASH_PROGRAM_NS) {
+        programs++;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+// One accelerometer task run: the device state moves on, then the log gets its slot
+static void run_call(void) {
+    now_ns = (uint64_t)call * MS_PER_CALL * SIM_NS_PER_MS;
+    if (walking(call) && call % STEP_CALLS == 0) steps++;
+    if (walking(call) && call % BLOCK_CALLS == 0) blocks_completed++;
+    if (call % GOAL_CALLS == 0) goal = (uint16_t)(1000 + (call / GOAL_CALLS) % 500);
+
+    flash_log_execute(!walking(call));
+    call++;
+}
+
+static bool slot_valid(const uint8_t *image, uint32_t i, FlashLogRecord *record) {
+    memcpy(record, &image[LOG_BASE + i * FLASH_LOG_RECORD_SIZE], sizeof(*record));
+    return record->sequence != 0xFFFFFFFFu && record->crc == crc16_ccitt(record, offsetof(FlashLogRecord, crc));
+}
+
+// The newest record of a type that passes its CRC, found by scanning every slot (type 0: any)
+static bool newest_record(const uint8_t *image, uint16_t type, FlashLogRecord *newest) {
+    bool found = false;
+
+    for (uint32_t i = 0; i < LOG_RECORDS; i++) {
+        FlashLogRecord record;
+        if (!slot_valid(image, i, &record) || (type != 0 && record.type != type)) continue;
+        if (!found || record.sequence > newest->sequence) {
+            *newest = record;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// The history blocks a boot should restore: every complete one within the ring of minutes of
+// the newest; returns how many, with their first minutes in ascending order
+static uint32_t expected_history(const uint8_t *image, uint32_t *minutes) {
+    static bool logged[(RUN_CALLS + RESUME_CALLS) / BLOCK_CALLS + 2];
+    uint32_t newest_minute = 0, count = 0;
+    bool any = false;
+
+    memset(logged, 0, sizeof(logged));
+    for (uint32_t i = 0; i < LOG_RECORDS; i++) {
+        FlashLogRecord record;
+        if (!slot_valid(image, i, &record) || record.type != FLASH_LOG_TYPE_HISTORY) continue;
+        uint32_t minute = ((const FlashLogHistoryRecord*)&record)->first_minute;
+        logged[minute / HISTORY_BLOCK_MINUTES] = true;
+        if (!any || minute > newest_minute) newest_minute = minute;
+        any = true;
+    }
+    if (!any) return 0;
+
+    for (uint32_t minute = 0; minute <= newest_minute; minute += HISTORY_BLOCK_MINUTES) {
+        if (newest_minute - minute < HISTORY_MINUTES - HISTORY_BLOCK_MINUTES && logged[minute / HISTORY_BLOCK_MINUTES]) {
+            minutes[count++] = minute;
+        }
+    }
+    return count;
+}
+
+static void check_history_restored(const uint8_t *image, uint32_t op) {
+    uint32_t expected[HISTORY_BLOCKS];
+    uint32_t count = expected_history(image, expected);
+
+    CHECK(restored_bins_ok, "op %u: a restored block holds the wrong bins", op);
+    CHECK(restored_blocks == count, "op %u: %u history blocks restored, %u complete in flash", op,
+          restored_blocks, count);
+    for (uint32_t i = 0; i < count && i < restored_blocks; i++) {
+        if (restored_minutes[i] != expected[i]) {
+            CHECK(false, "op %u: restored block %u starts at minute %u, expected %u", op, i,
+                  restored_minutes[i], expected[i]);
+            break;
+        }
+    }
+}
+
+// After a full run every block the ring of minutes holds must come back, however often the
+// log wrapped over the pages that first held them
+static void check_every_block_kept(void) {
+    uint32_t kept = (blocks_completed < HISTORY_BLOCKS - 1) ? blocks_completed : HISTORY_BLOCKS - 1;
+    CHECK(restored_blocks == kept, "%u history blocks restored, expected %u", restored_blocks, kept);
+}
+
+static void on_power_loss(void) {
+    memcpy(report->image, sim_flash, sizeof(report->image));
+    report->lost = true;
+    report->call = call;
+    report->programs = programs;
+    _exit(0);
+}
+
+// Runs the scenario with power lost during flash operation 'op'; false once 'op' is past its end
+static bool lose_power_at(uint32_t op) {
+    report->lost = false;
+    pid_t pid = fork();
+    if (pid == 0) {
+        sim_flash_erase_all();
+        sim_flash_power_loss_at(op, on_power_loss);
+        flash_log_init();
+        while (call < RUN_CALLS) run_call();
+        _exit(0);
+    }
+    waitpid(pid, NULL, 0);
+    return report->lost;
+}
+
+// Boots from the torn image in a fresh process; returns the number of failed checks
+static unsigned boot_after_loss(uint32_t op) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        FlashLogRecord before, after;
+        FlashLogRecord newest_any;
+        bool had_record = newest_record(report->image, FLASH_LOG_TYPE_STATE, &before);
+        bool had_any = newest_record(report->image, 0, &newest_any);
+
+        memcpy(sim_flash, report->image, sizeof(report->image));
+        steps = 0;
+        flash_log_init();
+
+        // Every record is four programs; all those finished before the loss must survive it
+        uint32_t complete = report->programs / 4;
+        CHECK(complete == 0 || (had_any && newest_any.sequence + 1 >= complete),
+              "op %u: %u records were complete, newest surviving is %d", op, complete,
+              had_any ? (int)newest_any.sequence : -1);
+        check_history_restored(report->image, op);
+        CHECK(restored == had_record && (!had_record || restored_steps == before.steps),
+              "op %u: restored %u steps, newest record holds %u", op, restored_steps,
+              had_record ? before.steps : 0);
+        CHECK(!had_record || goal == before.goal, "op %u: goal %u, record %u", op, goal, before.goal);
+
+        // The log must carry on from the torn state; history resumes after the blocks restored
+        call = report->call;
+        blocks_completed = blocks_taken = restored_blocks;
+        for (uint32_t i = 0; i < RESUME_CALLS; i++) run_call();
+        // Finish in a still spell, well clear of the last goal change, so the log has caught up
+        while (walking(call) || call % GOAL_CALLS != GOAL_CALLS / 2) run_call();
+        CHECK(newest_record(sim_flash, FLASH_LOG_TYPE_STATE, &after) && (!had_record || after.sequence > before.sequence) &&
+              after.goal == goal, "op %u: no new record saved after the reboot", op);
+
+        _exit(check_failures == 0 ? 0 : 1);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------
+// Tests
+// -----------------------------------------------------------------------------
+
+// Every run gets its own process, so each boot starts from flash_log.c's zeroed state
+static void test_reference_run(void) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        FlashLogRecord newest;
+
+        sim_flash_erase_all();
+        flash_log_init();
+        while (call < RUN_CALLS) run_call();
+
+        CHECK(programs / 4 > LOG_RECORDS && erases > 0, "the ring never wrapped");
+        CHECK(erases_while_walking == 0, "%u page erases started while walking", erases_while_walking);
+        CHECK(newest_record(sim_flash, FLASH_LOG_TYPE_STATE, &newest) && newest.goal == goal,
+              "newest record does not hold the last goal");
+        CHECK(blocks_taken == blocks_completed, "%u of %u history blocks logged", blocks_taken, blocks_completed);
+
+        restored_blocks = 0;
+        flash_log_init();
+        check_history_restored(sim_flash, 0);
+        check_every_block_kept();
+        printf("reference run: %u records (%u history), %u erases, %u flash operations\n",
+               programs / 4, blocks_taken, erases, sim_flash_operations());
+        fflush(stdout);
+        _exit(check_failures == 0 ? 0 : 1);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "reference run failed");
+}
+
+static void test_power_loss(void) {
+    uint32_t op = 0, failed = 0;
+
+    report = mmap(NULL, sizeof(*report), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    CHECK(report != MAP_FAILED, "mmap");
+    if (report == MAP_FAILED) return;
+
+    for (; lose_power_at(op); op++) {
+        failed += boot_after_loss(op);
+    }
+    CHECK(op > 0 && failed == 0, "%u of %u power-loss points failed", failed, op);
+    printf("power loss: %u points checked\n", op);
+}
+
+// Failed programs tear their slot; the record must start again in the next one and still land
+static void test_program_errors(void) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        FlashLogRecord newest;
+
+        sim_flash_erase_all();
+        sim_flash_fail_programs(FAIL_EVERY);
+        flash_log_init();
+        while (call < RUN_CALLS) run_call();
+        while (walking(call) || call % GOAL_CALLS != GOAL_CALLS / 2 || blocks_taken < blocks_completed) run_call();
+
+        uint32_t failed = sim_flash_failed_programs();
+        CHECK(failed > 0, "no program failed");
+        CHECK(newest_record(sim_flash, FLASH_LOG_TYPE_STATE, &newest) && newest.goal == goal && newest.steps == steps,
+              "after %u failed programs the newest record holds goal %u, steps %u (live %u, %u)",
+              failed, newest.goal, newest.steps, goal, steps);
+        CHECK(blocks_taken == blocks_completed, "%u of %u history blocks logged", blocks_taken, blocks_completed);
+
+        // Torn slots must never leave a blank one ahead of a written one, or boot would stop short
+        for (uint32_t i = 1; i < LOG_RECORDS; i++) {
+            const uint8_t *slot = &sim_flash[LOG_BASE + i * FLASH_LOG_RECORD_SIZE];
+            const uint8_t *before = slot - FLASH_LOG_RECORD_SIZE;
+            bool blank = true, before_blank = true;
+            for (uint8_t b = 0; b < FLASH_LOG_RECORD_SIZE; b++) {
+                blank &= slot[b] == 0xFF;
+                before_blank &= before[b] == 0xFF;
+            }
+            if (i % (FLASH_PAGE_SIZE / FLASH_LOG_RECORD_SIZE) != 0 && before_blank && !blank) {
+                CHECK(false, "slot %u is written after a blank one", i);
+                break;
+            }
+        }
+
+        // A fresh boot restores the newest record and every block still in the ring of minutes
+        uint32_t saved_steps = steps;
+        steps = 0;
+        restored_blocks = 0;
+        sim_flash_fail_programs(0);
+        flash_log_init();
+        CHECK(restored_steps == saved_steps, "rebooted with %u steps, saved %u", restored_steps, saved_steps);
+        check_history_restored(sim_flash, 0);
+        check_every_block_kept();
+        printf("program errors: %u of %u programs failed\n", failed, programs);
+        fflush(stdout);
+        _exit(check_failures == 0 ? 0 : 1);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "program error run failed");
+}
+
+int main(void) {
+    test_reference_run();
+    test_power_loss();
+    test_program_errors();
+    return check_report("test_flash_log");
+}
@@ -0,0 +1,193 @@
+/*
+ * test_gait_gen.c
+ *
+ * Host test of the gait generator (gait_gen.c) on a virtual timebase:
+ * - the signal: gravity of GAIT_RAW_PER_G along each orientation's "up" axis,
+ *   noise within its bound, and one bounce cycle per step at the cadence
+ * - the ramp: rates rise by a quarter per second, samples that overflow the
+ *   emulated FIFO are counted as dropped, and the ramp stops at the first
+ *   step that drops, reporting the rate before it as the maximum
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "check.h"
+#include "gait_gen.h"
+#include "timebase.h"
+
+#include <stdlib.h>
+
+#define POLL_US          100000u  // A pipeline that drains the FIFO every 100 ms
+#define SIGNAL_SECONDS        5
+
+static uint64_t now_us = 0;
+
+uint64_t timebase_us(void) {
+    return now_us;
+}
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    uint32_t taken;
+    int64_t sums[3];
+    int32_t min[3], max[3];
+    uint32_t upward_crossings;      // Of the vertical bounce through gravity (FLAT: Z is vertical)
+} DrainStats;
+
+// Polls the generator every POLL_US and drains every due sample, accounting each as processed
+static void drain_for(uint64_t duration_us, DrainStats *stats) {
+    static const uint32_t no_cycles[NUM_GAIT_STAGES] = { 0 };
+    int32_t previous = 0;
+
+    *stats = (DrainStats){ .min = { INT32_MAX, INT32_MAX, INT32_MAX }, .max = { INT32_MIN, INT32_MIN, INT32_MIN } };
+    for (uint64_t elapsed = 0; elapsed < duration_us && gait_gen_is_running(); elapsed += POLL_US) {
+        now_us += POLL_US;
+        for (uint16_t due = gait_gen_due(); due > 0; due--) {
+            int16_t axis[3];
+            gait_gen_sample(&axis[0], &axis[1], &axis[2]);
+            gait_gen_account(no_cycles);
+            stats->taken++;
+            for (uint8_t i = 0; i < 3; i++) {
+                stats->sums[i] += axis[i];
+                if (axis[i] < stats->min[i]) stats->min[i] = axis[i];
+                if (axis[i] > stats->max[i]) stats->max[i] = axis[i];
+            }
+            int32_t bounce = axis[2] - GAIT_RAW_PER_G;
+            if (previous < 0 && bounce >= 0) stats->upward_crossings++;
+            previous = bounce;
+        }
+    }
+}
+
+// Drops the results and the end report of a ramp a test stopped early
+static void discard_ramp(void) {
+    GaitStepResult result;
+    while (gait_gen_next_result(&result)) {
+    }
+    gait_gen_take_ramp_end();
+}
+
+// -----------------------------------------------------------------------------
+// Tests
+// -----------------------------------------------------------------------------
+
+// Without bounce or noise every sample is gravity along the orientation's "up" axis
+static void test_gravity(void) {
+    static const struct {
+        gait_orientation_t orientation;
+        int32_t expected[3];
+    } cases[] = {
+        { GAIT_ORIENT_FLAT,    { 0, 0, GAIT_RAW_PER_G } },
+        { GAIT_ORIENT_UPRIGHT, { 0, GAIT_RAW_PER_G, 0 } },
+        { GAIT_ORIENT_TILTED,  { 0, 11585, 11585 } },      // 16384 / sqrt(2)
+        { GAIT_ORIENT_SIDE,    { GAIT_RAW_PER_G, 0, 0 } },
+    };
+
+    for (uint8_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        GaitParams params = { .cadence_spm = 120, .amplitude_mg = 0, .noise_mg = 0,
+                              .orientation = cases[c].orientation };
+        DrainStats stats;
+
+        gait_gen_start_ramp(&params);
+        drain_for(SIGNAL_SECONDS * 1000000u, &stats);
+        gait_gen_stop();
+        discard_ramp();
+
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            CHECK(stats.min[axis] == cases[c].expected[axis] && stats.max[axis] == cases[c].expected[axis],
+                  "orientation %u axis %u: %d..%d, expected %d", cases[c].orientation, axis,
+                  stats.min[axis], stats.max[axis], cases[c].expected[axis]);
+        }
+    }
+}
+
+// Noise stays within ±noise_mg of gravity on every axis and averages out
+static void test_noise(void) {
+    GaitParams params = { .cadence_spm = 120, .amplitude_mg = 0, .noise_mg = 100,
+                          .orientation = GAIT_ORIENT_FLAT };
+    const int32_t half = 100 * GAIT_RAW_PER_G / 1000;
+    DrainStats stats;
+
+    gait_gen_start_ramp(&params);
+    drain_for(SIGNAL_SECONDS * 1000000u, &stats);
+    gait_gen_stop();
+    discard_ramp();
+
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        int32_t gravity = (axis == 2) ? GAIT_RAW_PER_G : 0;
+        int32_t mean = (int32_t)(stats.sums[axis] / (int64_t)stats.taken);
+        CHECK(stats.min[axis] >= gravity - half && stats.max[axis] <= gravity + half,
+              "axis %u: noise spans %d..%d around %d, limit ±%d", axis, stats.min[axis], stats.max[axis],
+              gravity, half);
+        CHECK(stats.max[axis] - stats.min[axis] > half, "axis %u: noise spans only %d", axis,
+              stats.max[axis] - stats.min[axis]);
+        CHECK(labs((long)(mean - gravity)) < half / 10, "axis %u: noise mean %d off gravity", axis, mean - gravity);
+    }
+}
+
+// One upward crossing of gravity per step: the harmonic never adds a crossing
+static void test_cadence(void) {
+    static const uint16_t cadences[] = { 60, 110, 150 };
+
+    for (uint8_t c = 0; c < sizeof(cadences) / sizeof(cadences[0]); c++) {
+        GaitParams params = { .cadence_spm = cadences[c], .amplitude_mg = 500, .noise_mg = 0,
+                              .orientation = GAIT_ORIENT_FLAT };
+        DrainStats stats;
+
+        gait_gen_start_ramp(&params);
+        drain_for(SIGNAL_SECONDS * 1000000u, &stats);
+        gait_gen_stop();
+        discard_ramp();
+
+        // Each ramp step ends a poll early (the step closes before that poll's samples)
+        uint32_t expected = cadences[c] * SIGNAL_SECONDS * 9 / 10 / 60;
+        CHECK(stats.upward_crossings + 1 >= expected && stats.upward_crossings <= expected + 1,
+              "%u spm: %u steps in the signal, expected about %u", cadences[c], stats.upward_crossings, expected);
+    }
+}
+
+// A pipeline that drains every 100 ms keeps up while a poll's samples fit the FIFO
+static void test_ramp(void) {
+    GaitParams params = gait_gen_default_params();
+    GaitStepResult result;
+    DrainStats stats;
+    uint32_t steps = 0, last_clean = 0, expected_rate = GAIT_RAMP_START_HZ;
+
+    gait_gen_start_ramp(&params);
+    drain_for(UINT64_MAX - POLL_US, &stats);
+    CHECK(!gait_gen_is_running(), "the ramp did not stop");
+
+    while (gait_gen_next_result(&result)) {
+        uint32_t per_poll = result.rate_hz * (POLL_US / 1000) / 1000;
+        bool overflows = per_poll > GAIT_FIFO_SAMPLES;
+        uint32_t made = result.samples + result.dropped;
+        uint32_t expected_made = result.rate_hz * 9 / 10;    // Nine polls' worth per one-second step
+
+        CHECK(result.rate_hz == expected_rate, "step %u at %u Hz, expected %u Hz", steps, result.rate_hz,
+              expected_rate);
+        CHECK(made + 1 >= expected_made && made <= expected_made + 1, "%u Hz: %u samples made, expected %u",
+              result.rate_hz, made, expected_made);
+        CHECK((result.dropped > 0) == overflows, "%u Hz: %u samples per poll, %u dropped", result.rate_hz,
+              per_poll, result.dropped);
+        if (result.dropped == 0) last_clean = result.rate_hz;
+        expected_rate += expected_rate / 4;
+        steps++;
+    }
+
+    CHECK(steps > 1 && gait_gen_max_rate_hz() == last_clean, "max rate %u Hz, last clean step %u Hz",
+          gait_gen_max_rate_hz(), last_clean);
+    CHECK(gait_gen_take_ramp_end() && !gait_gen_take_ramp_end(), "the ramp end must be reported exactly once");
+    printf("ramp: %u steps, sustains %u Hz draining every %u ms\n", steps, gait_gen_max_rate_hz(), POLL_US / 1000);
+}
+
+int main(void) {
+    test_gravity();
+    test_noise();
+    test_cadence();
+    test_ramp();
+    return check_report("test_gait_gen");
+}
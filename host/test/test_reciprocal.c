@@ -0,0 +1,118 @@
+/*
+ * test_reciprocal.c
+ *
+ * Checks of the reciprocal multiplies that replace division, against integer
+ * division: tri_divide() in step_core.c for every window length and every sum
+ * a window of int16 samples can hold, and the distance.c conversions either
+ * side of every point where one of their outputs steps. A rounded-up
+ * reciprocal errs most just below such a step, so this covers the 32-bit
+ * accumulator; "--exhaustive" checks every millimetre value instead (about a
+ * minute). Both sources are included so their static helpers and state are in reach.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "check.h"
+#include "step_core.c"
+#include "distance.c"
+
+#include <inttypes.h>
+#include <string.h>
+
+// Reports at most this many mismatches per check
+#define MAX_REPORTS  5
+
+static void test_tri_divide(void) {
+    for (uint8_t length = 1; length <= STEP_CORE_MAX_FILTER_LENGTH; length++) {
+        TriAxisFilter filter;
+        uint32_t mismatches = 0;
+
+        step_core_tri_filter_init(&filter, length);
+        CHECK(filter.reciprocal == ((1u << RECIPROCAL_SHIFT) + length - 1) / length,
+              "length %u: reciprocal %" PRIu32, length, filter.reciprocal);
+
+        for (int32_t sum = INT16_MIN * length; sum <= INT16_MAX * length; sum++) {
+            int16_t expected = (int16_t)(sum / length);
+            int16_t actual = tri_divide(&filter, sum);
+            if (actual != expected && ++mismatches <= MAX_REPORTS) {
+                CHECK(actual == expected, "length %u, sum %" PRId32 ": %d != %d", length, sum, actual, expected);
+            }
+        }
+        CHECK(mismatches == 0, "length %u: %" PRIu32 " mismatches", length, mismatches);
+    }
+}
+
+// Every conversion for one accumulator value; returns false on the first wrong one
+static bool conversions_exact(uint32_t mm) {
+    uint32_t km, miles;
+    uint16_t metres, thousandths;
+    uint32_t millimiles = (uint32_t)((uint64_t)mm * 125 / MM_PER_125_MILLIMILES);
+
+    distance_mm = mm;
+    distance_get_km(&km, &metres);
+    distance_get_miles(&miles, &thousandths);
+
+    return distance_get_metres() == mm / 1000 &&
+           distance_get_yards() == (uint32_t)((uint64_t)mm * 5 / MM_PER_5_YARDS) &&
+           km == mm / 1000000 && metres == (mm / 1000) % 1000 &&
+           miles == millimiles / 1000 && thousandths == millimiles % 1000;
+}
+
+// Checks mm - 1 and mm for every mm = ceil(k * num / den) up to the accumulator limit
+static uint32_t check_steps_of(uint32_t num, uint32_t den) {
+    uint32_t mismatches = 0;
+
+    for (uint64_t k = 1;; k++) {
+        uint64_t mm = (k * num + den - 1) / den;
+        if (mm > UINT32_MAX) break;
+        for (uint64_t n = mm - 1; n <= mm; n++) {
+            if (!conversions_exact((uint32_t)n) && ++mismatches <= MAX_REPORTS) {
+                CHECK(false, "mm %" PRIu64 " converts wrongly", n);
+            }
+        }
+    }
+    return mismatches;
+}
+
+static void test_distance_conversions(bool exhaustive) {
+    uint32_t mismatches = 0;
+
+    if (exhaustive) {
+        uint32_t mm = 0;
+        do {
+            if (!conversions_exact(mm) && ++mismatches <= MAX_REPORTS) {
+                CHECK(false, "mm %" PRIu32 " converts wrongly", mm);
+            }
+        } while (mm++ != UINT32_MAX);
+    } else {
+        mismatches += check_steps_of(1000, 1);                      // Metres (and with them km)
+        mismatches += check_steps_of(MM_PER_5_YARDS, 5);            // Yards
+        mismatches += check_steps_of(MM_PER_125_MILLIMILES, 125);   // Thousandths of a mile
+        mismatches += conversions_exact(UINT32_MAX) ? 0 : 1;
+    }
+    CHECK(mismatches == 0, "%" PRIu32 " mismatches over the accumulator range", mismatches);
+}
+
+// The accumulator saturates instead of wrapping, at both the multiply and the add
+static void test_distance_saturates(void) {
+    distance_set_stride_mm(MAX_STRIDE_MM, UINT32_MAX);
+    CHECK(distance_get_mm() == UINT32_MAX, "set_steps gave %" PRIu32, distance_get_mm());
+
+    distance_set_stride_mm(MAX_STRIDE_MM, UINT32_MAX / MAX_STRIDE_MM);
+    distance_add_steps(2);
+    CHECK(distance_get_mm() == UINT32_MAX, "add_steps gave %" PRIu32, distance_get_mm());
+
+    distance_set_stride_mm(1, 10);
+    CHECK(distance_get_stride_mm() == MIN_STRIDE_MM, "stride clamped to %u", distance_get_stride_mm());
+    CHECK(distance_get_mm() == 10u * MIN_STRIDE_MM, "distance %" PRIu32, distance_get_mm());
+}
+
+int main(int argc, char **argv) {
+    bool exhaustive = (argc > 1 && strcmp(argv[1], "--exhaustive") == 0);
+
+    test_tri_divide();
+    test_distance_conversions(exhaustive);
+    test_distance_saturates();
+    return check_report("test_reciprocal");
+}
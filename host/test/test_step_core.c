@@ -0,0 +1,171 @@
+/*
+ * test_step_core.c
+ *
+ * Smoke test of libstep_core.a: the batch pipeline counts a synthetic walk,
+ * stays at zero while standing still, and the tri-axis filter matches three
+ * scalar reference filters for every window length.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "check.h"
+#include "walk.h"
+#include "step_core.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SAMPLE_HZ     60
+#define DETECT_EVERY  10    // Step task at 6 Hz, as in the firmware's default profile
+#define MAX_SAMPLES   (SAMPLE_HZ * 120)
+
+static StepCoreSample samples[MAX_SAMPLES];
+static StepCoreEvent events[MAX_SAMPLES];
+
+// Runs a fresh core over the trace and returns the steps it counted
+static uint32_t count_steps(uint32_t n, bool adaptive) {
+    StepCore core;
+    uint32_t steps = 0;
+
+    step_core_init(&core);
+    step_core_configure_sampling(&core, SAMPLE_HZ);
+    step_core_configure_detector(&core, SAMPLE_HZ / DETECT_EVERY, STEP_DYNAMIC_THRESHOLD);
+    step_core_set_adaptive(&core, adaptive, 0, 0);
+    step_core_set_detect_decimation(&core, DETECT_EVERY);
+
+    for (uint32_t i = 0; i < n; i += UINT16_MAX) {
+        uint16_t chunk = (n - i > UINT16_MAX) ? UINT16_MAX : (uint16_t)(n - i);
+        steps += step_core_process(&core, samples + i, chunk, events);
+    }
+    return steps;
+}
+
+static void test_walk_is_counted(void) {
+    const WalkSegment walk[] = {
+        { .duration_ms = 2000, .cadence_spm = 0, .amplitude = 0, .noise = 100 },
+        { .duration_ms = 60000, .cadence_spm = 120, .amplitude = 4000, .noise = 150 },
+    };
+    uint32_t expected;
+    uint32_t n = walk_generate(samples, MAX_SAMPLES, SAMPLE_HZ, 0, walk, 2, 1, &expected);
+
+    for (int adaptive = 0; adaptive <= 1; adaptive++) {
+        uint32_t counted = count_steps(n, adaptive);
+        CHECK(labs((long)counted - (long)expected) * 10 <= (long)expected,
+              "%s detector counted %u of %u steps", adaptive ? "adaptive" : "fixed", counted, expected);
+    }
+}
+
+static void test_standing_still_counts_nothing(void) {
+    const WalkSegment still = { .duration_ms = 60000, .cadence_spm = 0, .amplitude = 0, .noise = 200 };
+    uint32_t n = walk_generate(samples, MAX_SAMPLES, SAMPLE_HZ, 0, &still, 1, 2, NULL);
+
+    for (int adaptive = 0; adaptive <= 1; adaptive++) {
+        uint32_t counted = count_steps(n, adaptive);
+        CHECK(counted == 0, "%s detector counted %u steps while still", adaptive ? "adaptive" : "fixed", counted);
+    }
+}
+
+static void test_tri_filter_matches_scalar(void) {
+    static int16_t in[512][3], out[512][3];
+    uint32_t seed = 12345;
+
+    for (uint16_t i = 0; i < 512; i++) {
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            seed = seed * 1664525u + 1013904223u;
+            in[i][axis] = (int16_t)(seed >> 16);
+        }
+    }
+
+    for (uint8_t length = 1; length <= STEP_CORE_MAX_FILTER_LENGTH; length++) {
+        TriAxisFilter tri;
+        AveragingFilter scalar[3] = {0};
+        uint32_t mismatches = 0;
+
+        step_core_tri_filter_init(&tri, length);
+        step_core_tri_filter_batch(&tri, (const int16_t (*)[3])in, out, 512);
+        for (uint16_t i = 0; i < 512; i++) {
+            for (uint8_t axis = 0; axis < 3; axis++) {
+                if (step_core_filter_apply(&scalar[axis], length, in[i][axis]) != out[i][axis]) mismatches++;
+            }
+        }
+        CHECK(mismatches == 0, "length %u: %u mismatches", length, mismatches);
+    }
+}
+
+// The batch path (offsets applied ahead of step_core_tri_filter_batch) matches the firmware's
+// sample-at-a-time path, including across a turn that makes the tracker change the offsets
+static void test_process_matches_per_sample(void) {
+    static StepCoreEvent reference[MAX_SAMPLES];
+    const WalkSegment walk = { .duration_ms = 30000, .cadence_spm = 110, .amplitude = 4000, .noise = 300 };
+    uint32_t n = walk_generate(samples, MAX_SAMPLES, SAMPLE_HZ, 0, &walk, 1, 3, NULL);
+
+    // Lie the device on its side halfway through
+    for (uint32_t i = n / 2; i < n; i++) {
+        int16_t z = samples[i].z;
+        samples[i].z = samples[i].x;
+        samples[i].x = z;
+    }
+
+    for (int adaptive = 0; adaptive <= 1; adaptive++) {
+        StepCore batch, single;
+        uint32_t expected = 0, mismatches = 0;
+
+        step_core_init(&batch);
+        step_core_configure_sampling(&batch, SAMPLE_HZ);
+        step_core_configure_detector(&batch, SAMPLE_HZ / DETECT_EVERY, STEP_DYNAMIC_THRESHOLD);
+        step_core_set_adaptive(&batch, adaptive, 0, 0);
+        step_core_set_detect_decimation(&batch, DETECT_EVERY);
+        single = batch;
+
+        for (uint32_t i = 0; i < n; i++) {
+            step_core_track_gravity(&single, samples[i].x, samples[i].y, samples[i].z);
+            FilteredAcceleration output = step_core_filter(&single, samples[i].x, samples[i].y, samples[i].z);
+            if ((i + 1) % DETECT_EVERY != 0 || !step_core_is_ready(&single)) continue;
+            if (step_core_detect(&single, output.dynamic_magnitude_square, samples[i].t_ms)) {
+                reference[expected++].sample = (uint16_t)i;
+            }
+        }
+
+        uint16_t counted = step_core_process(&batch, samples, (uint16_t)n, events);
+        for (uint16_t i = 0; i < counted && i < expected; i++) {
+            if (events[i].sample != reference[i].sample) mismatches++;
+        }
+        CHECK(counted == expected && mismatches == 0, "%s: batch counted %u (%u misplaced), per sample %u",
+              adaptive ? "adaptive" : "fixed", counted, mismatches, expected);
+        CHECK(batch.latest.dynamic_magnitude_square == single.latest.dynamic_magnitude_square &&
+              batch.latest.vertical_dynamic == single.latest.vertical_dynamic &&
+              memcmp(batch.gravity_acc, single.gravity_acc, sizeof(batch.gravity_acc)) == 0 &&
+              memcmp(batch.offset, single.offset, sizeof(batch.offset)) == 0,
+              "%s: batch and per-sample state differ after the trace", adaptive ? "adaptive" : "fixed");
+    }
+}
+
+// Every accepted rate gets the full 333 ms window; a rate whose window does not fit is refused
+static void test_window_follows_rate(void) {
+    StepCore core;
+
+    step_core_init(&core);
+    for (uint16_t hz = 1; hz <= 4 * STEP_CORE_MAX_SAMPLE_HZ; hz++) {
+        uint8_t before = core.filter.length;
+        uint32_t wanted = STEP_CORE_MS_TO_SAMPLES(STEP_CORE_FILTER_WINDOW_MS, hz);
+        bool accepted = step_core_configure_sampling(&core, hz);
+
+        if (hz <= STEP_CORE_MAX_SAMPLE_HZ) {
+            CHECK(accepted && core.filter.length == wanted, "%u Hz: window %u slots, wanted %u", hz,
+                  core.filter.length, wanted);
+        } else if (wanted > STEP_CORE_MAX_FILTER_LENGTH) {
+            CHECK(!accepted && core.filter.length == before, "%u Hz accepted with a %u-slot window", hz,
+                  core.filter.length);
+        }
+    }
+}
+
+int main(void) {
+    test_walk_is_counted();
+    test_standing_still_counts_nothing();
+    test_tri_filter_matches_scalar();
+    test_process_matches_per_sample();
+    test_window_follows_rate();
+    return check_report("test_step_core");
+}
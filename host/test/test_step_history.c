@@ -0,0 +1,216 @@
+/*
+ * test_step_history.c
+ *
+ * Host test of step_history.c against a brute-force model that keeps every
+ * minute ever recorded. Over 40 hours of bursty walking (more than a lap of
+ * the 32-hour ring) it checks, at every minute, window totals, peaks and
+ * active minutes for windows either side of a block and up to the longest
+ * query, plus hourly totals and the raw bins the UART dump reads. Bins must
+ * saturate at HISTORY_BIN_MAX without the excess reaching any total.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "check.h"
+#include "stm32c0xx_hal.h"
+#include "step_history.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define RUN_MINUTES     (40 * 60)
+#define MS_PER_MINUTE   60000
+
+static uint32_t now_ms = 0;
+static uint8_t model[RUN_MINUTES + 2];     // Every minute's bin, by absolute minute
+
+uint32_t HAL_GetTick(void) {
+    return now_ms;
+}
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+// The window a query covers, as the module clamps it
+static uint16_t model_window(uint32_t head, uint16_t n) {
+    uint32_t available = head + 1;
+    if (available > HISTORY_MAX_QUERY_MINUTES) available = HISTORY_MAX_QUERY_MINUTES;
+    return (n > available) ? (uint16_t)available : n;
+}
+
+static void model_scan(uint32_t head, uint16_t n, uint32_t *total, uint8_t *peak, uint16_t *active) {
+    *total = 0;
+    *peak = 0;
+    *active = 0;
+    for (uint32_t m = head + 1 - model_window(head, n); m <= head; m++) {
+        *total += model[m];
+        if (model[m] > *peak) *peak = model[m];
+        if (model[m] >= ACTIVE_MINUTE_STEPS) (*active)++;
+    }
+}
+
+// Steps for one record call: walking spells of a few minutes to an hour, some of them saturating
+static uint16_t next_steps(uint32_t minute) {
+    uint32_t spell = (minute / 7) % 11;
+    if (spell < 4) return 0;                        // Still
+    if (spell == 10) return (uint16_t)(40 + rand() % 60);   // Brisk enough to saturate a bin
+    return (uint16_t)(rand() % 25);
+}
+
+// -----------------------------------------------------------------------------
+// Tests
+// -----------------------------------------------------------------------------
+
+static void test_saturation(void) {
+    now_ms = 0;
+    step_history_init();
+
+    step_history_record(200);
+    step_history_record(200);
+    CHECK(step_history_last_minutes(1) == HISTORY_BIN_MAX, "saturated minute holds %lu",
+          (unsigned long)step_history_last_minutes(1));
+    CHECK(step_history_peak(1) == HISTORY_BIN_MAX, "saturated peak %u", step_history_peak(1));
+    CHECK(step_history_active_minutes(1) == 1, "saturated minute not counted active once");
+
+    now_ms += MS_PER_MINUTE;
+    step_history_record(ACTIVE_MINUTE_STEPS - 1);
+    CHECK(step_history_active_minutes(2) == 1, "a minute below %u steps counted active", ACTIVE_MINUTE_STEPS);
+    step_history_record(1);
+    CHECK(step_history_active_minutes(2) == 2, "a minute reaching %u steps not counted active", ACTIVE_MINUTE_STEPS);
+    CHECK(step_history_last_minutes(2) == HISTORY_BIN_MAX + ACTIVE_MINUTE_STEPS, "two-minute total %lu",
+          (unsigned long)step_history_last_minutes(2));
+}
+
+// Every window, peak, active count and hour against the model, at every minute of the run
+static void test_windows(void) {
+    static const uint16_t windows[] = {
+        1, 2, 14, 15, 16, 29, 30, 31, 60, 61, 119, 600, 899, 900, 901, 1800,
+        HISTORY_MAX_QUERY_MINUTES - 1, HISTORY_MAX_QUERY_MINUTES, HISTORY_MINUTES,
+    };
+    uint32_t mismatches = 0;
+
+    srand(27);
+    now_ms = 0;
+    step_history_init();
+
+    for (uint32_t minute = 0; minute <= RUN_MINUTES; minute++) {
+        // A few record calls spread through the minute
+        for (uint8_t call = 0; call < 4; call++) {
+            uint16_t steps = next_steps(minute);
+            step_history_record(steps);
+            uint16_t sum = model[minute] + steps;
+            model[minute] = (sum > HISTORY_BIN_MAX) ? HISTORY_BIN_MAX : (uint8_t)sum;
+            now_ms += MS_PER_MINUTE / 4;
+        }
+        now_ms -= 1;    // Still inside the minute for the queries
+        CHECK(step_history_current_minute() == minute, "minute %lu reported as %lu", (unsigned long)minute,
+              (unsigned long)step_history_current_minute());
+
+        for (uint8_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+            uint32_t total;
+            uint8_t peak;
+            uint16_t active;
+            model_scan(minute, windows[w], &total, &peak, &active);
+
+            bool ok = step_history_last_minutes(windows[w]) == total && step_history_peak(windows[w]) == peak &&
+                      step_history_active_minutes(windows[w]) == active;
+            if (!ok && ++mismatches <= 5) {
+                CHECK(ok, "minute %lu, last %u: total %lu/%lu peak %u/%u active %u/%u", (unsigned long)minute,
+                      windows[w], (unsigned long)step_history_last_minutes(windows[w]), (unsigned long)total,
+                      step_history_peak(windows[w]), peak, step_history_active_minutes(windows[w]), active);
+            }
+        }
+
+        // Hours still inside the longest query window
+        for (uint32_t hour = 0; hour * 60 <= minute; hour++) {
+            uint32_t got;
+            bool retained = minute - hour * 60 < HISTORY_MAX_QUERY_MINUTES;
+            if (step_history_hour_total(hour, &got) != retained) {
+                if (++mismatches <= 5) CHECK(false, "minute %lu: hour %lu retention wrong", (unsigned long)minute,
+                                             (unsigned long)hour);
+                continue;
+            }
+            if (!retained) continue;
+            uint32_t expected = 0;
+            for (uint32_t m = hour * 60; m < hour * 60 + 60 && m <= minute; m++) expected += model[m];
+            if (got != expected && ++mismatches <= 5) {
+                CHECK(got == expected, "minute %lu, hour %lu: %lu, expected %lu", (unsigned long)minute,
+                      (unsigned long)hour, (unsigned long)got, (unsigned long)expected);
+            }
+        }
+        now_ms += 1;
+    }
+    CHECK(mismatches == 0, "%lu mismatches", (unsigned long)mismatches);
+
+    // The dump reads the retained bins oldest first (the head is now a fresh, empty minute)
+    static uint8_t bins[HISTORY_MINUTES];
+    uint16_t length = step_history_length();
+    uint16_t count = step_history_read(0, bins, HISTORY_MINUTES);
+    uint32_t oldest = step_history_current_minute() + 1 - length;
+    CHECK(length == HISTORY_MINUTES && count == length, "retained %u, read %u", length, count);
+    for (uint16_t i = 0; i < count; i++) {
+        if (bins[i] != model[oldest + i]) {
+            CHECK(false, "bin of minute %lu reads %u, expected %u", (unsigned long)(oldest + i), bins[i],
+                  model[oldest + i]);
+            break;
+        }
+    }
+}
+
+// A warm reset mid-minute, with the last completed block not yet handed to flash: restoring
+// the flash blocks and then the recent minutes gives back every bin and the minute's phase
+static void test_warm_restore(void) {
+    static uint8_t flash_bins[8][HISTORY_BLOCK_MINUTES];
+    static uint32_t flash_first[8];
+    static uint8_t before[HISTORY_MINUTES], after[HISTORY_MINUTES];
+    StepHistoryRecent recent;
+    uint8_t saved = 0;
+
+    srand(29);
+    now_ms = 0;
+    step_history_init();
+
+    // 37 minutes and a half: blocks 0 and 1 complete, only block 0 saved
+    for (uint32_t minute = 0; minute < 37; minute++) {
+        step_history_record((uint16_t)(10 + rand() % 80));
+        now_ms += MS_PER_MINUTE;
+        if (minute == 20 && step_history_next_completed_block(&flash_first[saved], flash_bins[saved])) saved++;
+    }
+    step_history_record(7);
+    now_ms += MS_PER_MINUTE / 2;
+
+    uint16_t length = step_history_read(0, before, HISTORY_MINUTES);
+    uint32_t total = step_history_last_minutes(HISTORY_MAX_QUERY_MINUTES);
+    step_history_save_recent(&recent);
+    CHECK(recent.minutes == 23, "recent snapshot holds %u minutes, expected 23", recent.minutes);
+
+    // Reboot: the tick restarts, flash restores first
+    now_ms = 5;
+    step_history_init();
+    for (uint8_t i = 0; i < saved; i++) step_history_restore_block(flash_first[i], flash_bins[i]);
+    step_history_restore_recent(&recent);
+
+    uint16_t restored = step_history_read(0, after, HISTORY_MINUTES);
+    CHECK(restored == length && memcmp(before, after, length) == 0, "restored %u bins of %u, contents %s",
+          restored, length, memcmp(before, after, length) == 0 ? "match" : "differ");
+    CHECK(step_history_last_minutes(HISTORY_MAX_QUERY_MINUTES) == total, "total %lu after restore, expected %lu",
+          (unsigned long)step_history_last_minutes(HISTORY_MAX_QUERY_MINUTES), (unsigned long)total);
+    CHECK(step_history_current_minute() == 37, "resumed in minute %lu", (unsigned long)step_history_current_minute());
+
+    // Block 1 still reaches flash, and the minute ends half a minute after the reset
+    uint32_t first;
+    uint8_t block[HISTORY_BLOCK_MINUTES];
+    CHECK(step_history_next_completed_block(&first, block) && first == 15, "unsaved block not handed out again");
+    now_ms += MS_PER_MINUTE / 2;
+    CHECK(step_history_current_minute() == 38, "minute phase lost: minute %lu after half a minute",
+          (unsigned long)step_history_current_minute());
+}
+
+int main(void) {
+    test_saturation();
+    test_windows();
+    test_warm_restore();
+    return check_report("test_step_history");
+}
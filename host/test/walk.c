@@ -0,0 +1,85 @@
+/*
+ * walk.c
+ *
+ * Synthetic walking traces: gravity on +z, a vertical bounce at the cadence
+ * with a heel-strike harmonic, and LCG noise on every axis.
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#include "walk.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#define WALK_PI  3.14159265358979323846
+
+static uint32_t lcg_state;
+
+// Uniform noise in [-peak, peak]
+static int32_t noise(uint16_t peak) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    if (peak == 0) return 0;
+    return (int32_t)((lcg_state >> 8) % (2u * peak + 1)) - peak;
+}
+
+static int16_t clamp16(int32_t value) {
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return (int16_t)value;
+}
+
+uint32_t walk_generate(StepCoreSample *samples, uint32_t max, uint16_t rate_hz, uint32_t start_ms,
+                       const WalkSegment *segments, uint8_t count, uint32_t seed, uint32_t *steps_out) {
+    uint32_t written = 0;
+    uint32_t steps = 0;
+    double phase = 0.0;     // In steps; a peak falls on every quarter past a whole step
+    double t_ms = start_ms;
+
+    lcg_state = seed;
+    for (uint8_t s = 0; s < count; s++) {
+        uint32_t n = (uint32_t)((uint64_t)segments[s].duration_ms * rate_hz / 1000);
+        double advance = segments[s].cadence_spm / 60.0 / rate_hz;
+
+        for (uint32_t i = 0; i < n && written < max; i++) {
+            double bounce = sin(2.0 * WALK_PI * phase) + 0.3 * sin(4.0 * WALK_PI * phase);
+            int32_t vertical = (int32_t)lround(segments[s].amplitude * bounce);
+
+            samples[written].t_ms = (uint32_t)t_ms;
+            samples[written].x = clamp16(noise(segments[s].noise));
+            samples[written].y = clamp16(noise(segments[s].noise));
+            samples[written].z = clamp16(WALK_RAW_PER_G + vertical + noise(segments[s].noise));
+            written++;
+
+            double next = phase + advance;
+            if (floor(next - 0.25) > floor(phase - 0.25)) steps++;
+            phase = next;
+            t_ms += 1000.0 / rate_hz;
+        }
+    }
+
+    if (steps_out) *steps_out = steps;
+    return written;
+}
+
+int32_t walk_load_csv(const char *path, StepCoreSample *samples, uint32_t max) {
+    FILE *file = fopen(path, "r");
+    char line[128];
+    int32_t count = 0;
+
+    if (!file) return -1;
+    while ((uint32_t)count < max && fgets(line, sizeof(line), file)) {
+        unsigned long t_ms;
+        int x, y, z;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%lu,%d,%d,%d", &t_ms, &x, &y, &z) != 4) continue;
+        samples[count].t_ms = (uint32_t)t_ms;
+        samples[count].x = clamp16(x);
+        samples[count].y = clamp16(y);
+        samples[count].z = clamp16(z);
+        count++;
+    }
+    fclose(file);
+    return count;
+}
@@ -0,0 +1,37 @@
+/*
+ * walk.h
+ *
+ * Synthetic walking traces and recorded-trace loading for the host tests and
+ * replays. A trace is an array of StepCoreSample, ready for step_core_process().
+ *
+ * Created on: Oct 19, 2026
+ * Author: eaz11 & gjo77
+ */
+
+#ifndef WALK_H_
+#define WALK_H_
+
+#include <stdint.h>
+#include "step_core.h"
+
+#define WALK_RAW_PER_G  16384  // Raw units at 1 g (+/-2 g full scale), as in the firmware
+
+// One stretch of a synthetic trace
+typedef struct {
+    uint32_t duration_ms;
+    uint16_t cadence_spm;   // Steps per minute; 0 = standing still
+    uint16_t amplitude;     // Peak vertical bounce (raw units)
+    uint16_t noise;         // Peak uniform noise on every axis (raw units)
+} WalkSegment;
+
+// Fills samples at rate_hz with the given segments back to back, gravity on +z, starting at
+// start_ms. Returns the number of samples written (at most max). Every bounce peak is one step,
+// and *steps_out (if not NULL) receives how many peaks the trace holds
+uint32_t walk_generate(StepCoreSample *samples, uint32_t max, uint16_t rate_hz, uint32_t start_ms,
+                       const WalkSegment *segments, uint8_t count, uint32_t seed, uint32_t *steps_out);
+
+// Loads a recorded trace: one "t_ms,x,y,z" line per sample, '#' lines ignored.
+// Returns the number of samples read, or -1 if the file cannot be opened
+int32_t walk_load_csv(const char *path, StepCoreSample *samples, uint32_t max);
+
+#endif /* WALK_H_ */
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""
+trace2json.py
+
+Converts a `T` serial trace dump into Chrome trace JSON, which opens in
+chrome://tracing or ui.perfetto.dev.
+
+Usage: trace2json.py [uart_log] > trace.json
+Reads the last complete >TRACE:BEGIN ... >TRACE:END block in the log (stdin
+when no file is given).
+
+Created on: Oct 19, 2026
+Author: eaz11 & gjo77
+"""
+
+import json
+import sys
+
+RECORD_HEX = 16                 # stamp(8) event(2) phase(2) arg(4)
+STAMP_WRAP = 1 << 32
+
+# Name of each event's argument in the viewer; tasks carry how late they started
+ARG_NAMES = {
+    "i2c_read": "bytes",
+    "uart_tx": "bytes",
+    "display_flush": None,
+    "step": "count",
+    "profile": "id",
+    "screen": "state",
+    "step_source": "source",
+    "detector": "mode",
+    "activity": "state",
+}
+TASK_ARG = "late_us"
+
+
+def last_dump(lines):
+    """Returns (clock_khz, dropped, names, hex records) of the last complete dump."""
+    dump = None
+    current = None
+    for line in lines:
+        line = line.strip()
+        if not line.startswith(">TRACE:"):
+            continue
+        body = line[len(">TRACE:"):]
+        if body.startswith("BEGIN,"):
+            fields = body.split(",")
+            current = {
+                "clock_khz": int(fields[2].split(":")[1]),
+                "dropped": int(fields[3].split(":")[1]),
+                "names": [],
+                "records": [],
+            }
+        elif current is None:
+            continue
+        elif body.startswith("EVENTS:"):
+            current["names"] = body[len("EVENTS:"):].split(",")
+        elif body == "END":
+            dump = current
+            current = None
+        else:
+            _, data = body.split(":", 1)
+            current["records"].extend(data[i:i + RECORD_HEX] for i in range(0, len(data), RECORD_HEX))
+    if dump is None:
+        sys.exit("no complete >TRACE:BEGIN ... >TRACE:END block found")
+    return dump
+
+
+def convert(dump):
+    events = []
+    open_spans = {}
+    previous = None
+    first = None
+    base = 0
+    khz = dump["clock_khz"]
+
+    for record in dump["records"]:
+        stamp = int(record[0:8], 16)
+        event = int(record[8:10], 16)
+        phase = chr(int(record[10:12], 16))
+        arg = int(record[12:16], 16)
+
+        # Records are in time order, so a smaller stamp means the 32-bit cycle counter wrapped
+        if previous is not None and stamp < previous:
+            base += STAMP_WRAP
+        previous = stamp
+        if first is None:
+            first = stamp
+
+        name = dump["names"][event] if event < len(dump["names"]) else "event_%d" % event
+        arg_name = ARG_NAMES.get(name, TASK_ARG)
+
+        # The oldest records may end spans whose begin was overwritten; drop those
+        if phase == "B":
+            open_spans[name] = open_spans.get(name, 0) + 1
+        elif phase == "E":
+            if open_spans.get(name, 0) == 0:
+                continue
+            open_spans[name] -= 1
+
+        entry = {
+            "name": name,
+            "ph": phase,
+            "ts": (base + stamp - first) * 1000.0 / khz,    # cycles since the oldest record -> µs
+            "pid": 1,
+            "tid": 1,
+        }
+        if phase == "i":
+            entry["s"] = "t"
+        if arg_name is not None and phase != "E":
+            entry["args"] = {arg_name: arg}
+        events.append(entry)
+
+    return {
+        "traceEvents": events,
+        "displayTimeUnit": "ms",
+        "otherData": {"clock_khz": khz, "dropped_records": dump["dropped"]},
+    }
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], errors="replace") as log:
+            dump = last_dump(log)
+    else:
+        dump = last_dump(sys.stdin)
+    json.dump(convert(dump), sys.stdout, indent=1)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()